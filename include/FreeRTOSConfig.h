@@ -53,10 +53,22 @@ extern uint32_t SystemCoreClock;
 #define configUSE_DAEMON_TASK_STARTUP_HOOK 0
 
 /* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS 0
+#define configGENERATE_RUN_TIME_STATS 1
 #define configUSE_TRACE_FACILITY 1
 #define configUSE_STATS_FORMATTING_FUNCTIONS 1
 
+/* Run time is counted on the free-running 1 MHz system timer (time_us_32),
+   which needs no setup; see runtime_faults.c. */
+extern uint32_t runtime_stats_timer_us(void);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE() runtime_stats_timer_us()
+
+/* Scheduling timeline for /api/sys/trace; see services/sys_trace.c. */
+extern void sys_trace_task_switched_in(void);
+extern void sys_trace_task_created(void *task);
+#define traceTASK_SWITCHED_IN() sys_trace_task_switched_in()
+#define traceTASK_CREATE(pxNewTCB) sys_trace_task_created(pxNewTCB)
+
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES 0
 #define configMAX_CO_ROUTINE_PRIORITIES 1
@@ -88,7 +100,7 @@ extern uint32_t SystemCoreClock;
 #define INCLUDE_xTaskGetSchedulerState 1
 #define INCLUDE_xTaskGetCurrentTaskHandle 1
 #define INCLUDE_uxTaskGetStackHighWaterMark 1
-#define INCLUDE_xTaskGetIdleTaskHandle 0
+#define INCLUDE_xTaskGetIdleTaskHandle 1
 #define INCLUDE_eTaskGetState 1
 #define INCLUDE_xEventGroupSetBitFromISR 1
 #define INCLUDE_xTimerPendFunctionCall 1
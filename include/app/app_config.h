@@ -15,10 +15,67 @@
 #define APP_ENABLE_ADP910_TASK 1
 #endif
 
+#ifndef APP_ENABLE_LOG_TASK
+#define APP_ENABLE_LOG_TASK 1
+#endif
+
+#ifndef APP_ENABLE_WATCHDOG_TASK
+#define APP_ENABLE_WATCHDOG_TASK 1
+#endif
+
 #ifndef APP_ENABLE_DEBUG_HTTP_ROUTES
 #define APP_ENABLE_DEBUG_HTTP_ROUTES 0
 #endif
 
+#ifndef APP_ENABLE_PROFILER
+#define APP_ENABLE_PROFILER 1
+#endif
+
+#ifndef APP_PROFILER_LOG_EVERY_N_CYCLES
+#define APP_PROFILER_LOG_EVERY_N_CYCLES 500u
+#endif
+
+#ifndef APP_ENABLE_TRACE
+#define APP_ENABLE_TRACE 1
+#endif
+
+#ifndef APP_TRACE_BUFFER_EVENTS
+#define APP_TRACE_BUFFER_EVENTS 2048u
+#endif
+
+#ifndef APP_CRASH_REBOOT_DELAY_MS
+#define APP_CRASH_REBOOT_DELAY_MS 100u
+#endif
+
+#ifndef APP_WATCHDOG_TIMEOUT_MS
+#define APP_WATCHDOG_TIMEOUT_MS 2000u
+#endif
+
+#ifndef APP_WATCHDOG_CHECK_PERIOD_MS
+#define APP_WATCHDOG_CHECK_PERIOD_MS 100u
+#endif
+
+/* Well inside the ~71.6 min wrap of the 32-bit run-time counter. */
+#ifndef APP_TASK_STATS_REFRESH_PERIOD_MS
+#define APP_TASK_STATS_REFRESH_PERIOD_MS 60000u
+#endif
+
+#ifndef APP_WIFI_HEARTBEAT_DEADLINE_MS
+#define APP_WIFI_HEARTBEAT_DEADLINE_MS 60000u
+#endif
+
+#ifndef APP_DIMMER_HEARTBEAT_DEADLINE_MS
+#define APP_DIMMER_HEARTBEAT_DEADLINE_MS 1000u
+#endif
+
+#ifndef APP_ADP910_HEARTBEAT_DEADLINE_MS
+#define APP_ADP910_HEARTBEAT_DEADLINE_MS 2000u
+#endif
+
+#ifndef APP_LOG_HEARTBEAT_DEADLINE_MS
+#define APP_LOG_HEARTBEAT_DEADLINE_MS 5000u
+#endif
+
 #ifndef APP_FIRMWARE_VERSION
 #define APP_FIRMWARE_VERSION "0.0.0-dev"
 #endif
@@ -35,6 +92,18 @@
 #define APP_ADP910_TASK_STACK_WORDS 2048u
 #endif
 
+#ifndef APP_LOG_TASK_STACK_WORDS
+#define APP_LOG_TASK_STACK_WORDS 1024u
+#endif
+
+#ifndef APP_WATCHDOG_TASK_STACK_WORDS
+#define APP_WATCHDOG_TASK_STACK_WORDS 1024u
+#endif
+
+#ifndef APP_SSE_TASK_STACK_WORDS
+#define APP_SSE_TASK_STACK_WORDS 2048u
+#endif
+
 #ifndef APP_WIFI_TASK_PRIORITY
 #define APP_WIFI_TASK_PRIORITY 2u
 #endif
@@ -47,6 +116,26 @@
 #define APP_ADP910_TASK_PRIORITY 1u
 #endif
 
+#ifndef APP_LOG_TASK_PRIORITY
+#define APP_LOG_TASK_PRIORITY 0u
+#endif
+
+#ifndef APP_WATCHDOG_TASK_PRIORITY
+#define APP_WATCHDOG_TASK_PRIORITY 4u
+#endif
+
+#ifndef APP_LOG_RING_ENTRIES
+#define APP_LOG_RING_ENTRIES 64u
+#endif
+
+#ifndef APP_LOG_DRAIN_PERIOD_MS
+#define APP_LOG_DRAIN_PERIOD_MS 20u
+#endif
+
+#ifndef APP_LOG_DRAIN_MAX_RECORDS
+#define APP_LOG_DRAIN_MAX_RECORDS 16u
+#endif
+
 #ifndef APP_ADP910_SAMPLE_PERIOD_MS
 #define APP_ADP910_SAMPLE_PERIOD_MS 20u
 #endif
@@ -247,6 +336,70 @@
 #define APP_CONTROL_INTEGRAL_DECAY_ON_SIGN_FLIP 0.55f
 #endif
 
+#ifndef APP_CONTROL_FEEDFORWARD_MAP_MERGE_PA
+#define APP_CONTROL_FEEDFORWARD_MAP_MERGE_PA 3.0f
+#endif
+
+#ifndef APP_CONTROL_FEEDFORWARD_MAP_ALPHA
+#define APP_CONTROL_FEEDFORWARD_MAP_ALPHA 0.5f
+#endif
+
+#ifndef APP_CONTROL_FEEDFORWARD_MAP_MIN_CHANGE_PERCENT
+#define APP_CONTROL_FEEDFORWARD_MAP_MIN_CHANGE_PERCENT 0.5f
+#endif
+
+#ifndef APP_CONTROL_FEEDFORWARD_MAP_EXTRAPOLATE_PA
+#define APP_CONTROL_FEEDFORWARD_MAP_EXTRAPOLATE_PA 15.0f
+#endif
+
+#ifndef APP_CONTROL_PREDICTIVE_IDENT_STEP_PERCENT
+#define APP_CONTROL_PREDICTIVE_IDENT_STEP_PERCENT 35.0f
+#endif
+
+#ifndef APP_CONTROL_PREDICTIVE_IDENT_MIN_MS
+#define APP_CONTROL_PREDICTIVE_IDENT_MIN_MS 1500u
+#endif
+
+#ifndef APP_CONTROL_PREDICTIVE_IDENT_TIMEOUT_MS
+#define APP_CONTROL_PREDICTIVE_IDENT_TIMEOUT_MS 12000u
+#endif
+
+#ifndef APP_CONTROL_PREDICTIVE_IDENT_SETTLE_WINDOW_MS
+#define APP_CONTROL_PREDICTIVE_IDENT_SETTLE_WINDOW_MS 1000u
+#endif
+
+#ifndef APP_CONTROL_PREDICTIVE_IDENT_SETTLE_PA
+#define APP_CONTROL_PREDICTIVE_IDENT_SETTLE_PA 0.4f
+#endif
+
+#ifndef APP_CONTROL_PREDICTIVE_IDENT_SETTLE_CYCLES
+#define APP_CONTROL_PREDICTIVE_IDENT_SETTLE_CYCLES 25u
+#endif
+
+#ifndef APP_CONTROL_PREDICTIVE_IDENT_MIN_RESPONSE_PA
+#define APP_CONTROL_PREDICTIVE_IDENT_MIN_RESPONSE_PA 3.0f
+#endif
+
+#ifndef APP_CONTROL_PREDICTIVE_IDENT_ABORT_RATIO
+#define APP_CONTROL_PREDICTIVE_IDENT_ABORT_RATIO 1.25f
+#endif
+
+#ifndef APP_CONTROL_PREDICTIVE_LAMBDA_RATIO
+#define APP_CONTROL_PREDICTIVE_LAMBDA_RATIO 0.5f
+#endif
+
+#ifndef APP_CONTROL_PREDICTIVE_PLANT_EXPONENT
+#define APP_CONTROL_PREDICTIVE_PLANT_EXPONENT 1.5f
+#endif
+
+#ifndef APP_CONTROL_PREDICTIVE_MAX_STEP_UP_PERCENT
+#define APP_CONTROL_PREDICTIVE_MAX_STEP_UP_PERCENT 1.5f
+#endif
+
+#ifndef APP_CONTROL_PREDICTIVE_MAX_STEP_DOWN_PERCENT
+#define APP_CONTROL_PREDICTIVE_MAX_STEP_DOWN_PERCENT 2.0f
+#endif
+
 #ifndef APP_OTA_STAGING_OFFSET_BYTES
 #define APP_OTA_STAGING_OFFSET_BYTES (2u * 1024u * 1024u)
 #endif
@@ -271,6 +424,65 @@
 #define APP_OTA_APPLY_DELAY_MS 500u
 #endif
 
+#ifndef APP_CONTROL_FEEDFORWARD_STORAGE_OFFSET_BYTES
+#define APP_CONTROL_FEEDFORWARD_STORAGE_OFFSET_BYTES \
+  (APP_OTA_STAGING_OFFSET_BYTES + APP_OTA_STAGING_SIZE_BYTES)
+#endif
+
+#ifndef APP_CONTROL_FEEDFORWARD_STORAGE_SIZE_BYTES
+#define APP_CONTROL_FEEDFORWARD_STORAGE_SIZE_BYTES (4u * 1024u)
+#endif
+
+#ifndef APP_CONTROL_PARAMS_STORAGE_OFFSET_BYTES
+#define APP_CONTROL_PARAMS_STORAGE_OFFSET_BYTES \
+  (APP_CONTROL_FEEDFORWARD_STORAGE_OFFSET_BYTES + \
+   APP_CONTROL_FEEDFORWARD_STORAGE_SIZE_BYTES)
+#endif
+
+#ifndef APP_CONTROL_PARAMS_STORAGE_SIZE_BYTES
+#define APP_CONTROL_PARAMS_STORAGE_SIZE_BYTES (4u * 1024u)
+#endif
+
+#ifndef APP_PERSISTENT_STORAGE_OFFSET_BYTES
+#define APP_PERSISTENT_STORAGE_OFFSET_BYTES \
+  (APP_CONTROL_PARAMS_STORAGE_OFFSET_BYTES + \
+   APP_CONTROL_PARAMS_STORAGE_SIZE_BYTES)
+#endif
+
+#ifndef APP_PERSISTENT_STORAGE_SIZE_BYTES
+#define APP_PERSISTENT_STORAGE_SIZE_BYTES (8u * 1024u)
+#endif
+
+#ifndef APP_TEST_REPORT_LOG_OFFSET_BYTES
+#define APP_TEST_REPORT_LOG_OFFSET_BYTES \
+  (APP_PERSISTENT_STORAGE_OFFSET_BYTES + APP_PERSISTENT_STORAGE_SIZE_BYTES)
+#endif
+
+#ifndef APP_TEST_REPORT_LOG_SIZE_BYTES
+#define APP_TEST_REPORT_LOG_SIZE_BYTES (256u * 1024u)
+#endif
+
+#ifndef APP_TEST_SAMPLE_LOG_OFFSET_BYTES
+#define APP_TEST_SAMPLE_LOG_OFFSET_BYTES \
+  (APP_TEST_REPORT_LOG_OFFSET_BYTES + APP_TEST_REPORT_LOG_SIZE_BYTES)
+#endif
+
+#ifndef APP_TEST_SAMPLE_LOG_SIZE_BYTES
+#define APP_TEST_SAMPLE_LOG_SIZE_BYTES (192u * 1024u)
+#endif
+
+#ifndef APP_TEST_SAMPLE_CAPTURE_STAGING_PAGES
+#define APP_TEST_SAMPLE_CAPTURE_STAGING_PAGES 96u
+#endif
+
+#ifndef APP_TEST_SAMPLE_CAPTURE_DECIMATION
+#define APP_TEST_SAMPLE_CAPTURE_DECIMATION 5u
+#endif
+
+#ifndef APP_DIMMER_TIMING_BIN_US
+#define APP_DIMMER_TIMING_BIN_US 4u
+#endif
+
 #ifndef APP_LINE_SYNC_TIMEOUT_US
 #define APP_LINE_SYNC_TIMEOUT_US 100000u
 #endif
@@ -287,6 +499,14 @@
 #define APP_FAN_DIAMETER_M 0.31f
 #endif
 
+#ifndef APP_FAN_OPEN_MIN_PRESSURE_PA
+#define APP_FAN_OPEN_MIN_PRESSURE_PA 2.0f
+#endif
+
+#ifndef APP_FAN_OPEN_MAX_PRESSURE_PA
+#define APP_FAN_OPEN_MAX_PRESSURE_PA 500.0f
+#endif
+
 #ifndef APP_ALTITUDE_M
 #define APP_ALTITUDE_M 650.0f
 #endif
@@ -303,4 +523,8 @@
 #define APP_REFERENCE_PRESSURE_PA 101325.0f
 #endif
 
+#ifndef APP_FLOW_CORRECTION_TEMPERATURE_STEP_C
+#define APP_FLOW_CORRECTION_TEMPERATURE_STEP_C 0.1f
+#endif
+
 #endif
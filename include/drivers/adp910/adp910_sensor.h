@@ -25,18 +25,53 @@ typedef struct {
   float differential_pressure_pa;
   float corrected_pressure_pa;
   float temperature_c;
+  /* time_us_32() when the frame was read, for latency tracing. */
+  uint32_t capture_time_us;
 } adp910_sample_t;
 
+/*
+ * Bus recovery and the power-up sequence run as a state machine that
+ * adp910_sensor_poll() advances by at most one step per call, without
+ * sleeping; delays between steps are deadlines on time_us_32(). A step
+ * costs one I2C transfer or a ~150 us bit-banged bus clear, so a faulty
+ * sensor never stalls the other channel sampled by the same task.
+ */
+typedef enum {
+  ADP910_SENSOR_STEP_RECOVER_BUS = 0,
+  ADP910_SENSOR_STEP_START_CONTINUOUS,
+  ADP910_SENSOR_STEP_STABILIZE,
+  ADP910_SENSOR_STEP_READY,
+} adp910_sensor_step_t;
+
 typedef struct {
   adp910_port_config_t port_config;
   float pressure_offset_pa;
-  bool is_initialized;
   int last_bus_result;
+  adp910_sensor_step_t step;
+  /* time_us_32() from which the pending step may run. */
+  uint32_t step_due_us;
+  /* After RECOVER_BUS, redo the power-up sequence instead of resuming. */
+  bool restart_pending;
+  uint8_t stabilization_reads;
 } adp910_sensor_t;
 
-adp910_status_t adp910_sensor_initialize(adp910_sensor_t *sensor,
-                                         const adp910_port_config_t *port_config);
+/* Stores the port and schedules a full init; no bus traffic. */
+adp910_status_t adp910_sensor_begin(adp910_sensor_t *sensor,
+                                    const adp910_port_config_t *port_config);
+/*
+ * Runs the pending step if due. Returns OK while ready, NOT_READY while
+ * a step is pending, or the error of a failed init step once; the
+ * sequence then restarts a second later.
+ */
+adp910_status_t adp910_sensor_poll(adp910_sensor_t *sensor);
+/* Drops readiness and schedules bus recovery plus a full init. */
+void adp910_sensor_restart(adp910_sensor_t *sensor);
+bool adp910_sensor_is_ready(const adp910_sensor_t *sensor);
 adp910_status_t adp910_sensor_start_continuous_mode(adp910_sensor_t *sensor);
+/*
+ * One transfer, no retries. A bus error schedules a bus recovery that
+ * the next poll performs; reads return NOT_READY until it has run.
+ */
 adp910_status_t adp910_sensor_read_sample(adp910_sensor_t *sensor,
                                           adp910_sample_t *out_sample);
 void adp910_sensor_set_pressure_offset(adp910_sensor_t *sensor,
@@ -66,6 +66,8 @@
 
 #define SYS_LIGHTWEIGHT_PROT 1
 #define LWIP_NETCONN 1
+#define LWIP_SO_RCVTIMEO 1
+#define LWIP_SO_SNDTIMEO 1
 #define LWIP_SOCKET 1
 
 // Mailbox sizes for Netconn API (must be > 0 when using NO_SYS=0)
@@ -1,7 +1,12 @@
 #ifndef RUNTIME_FAULTS_H
 #define RUNTIME_FAULTS_H
 
+#include <stdint.h>
+
 void runtime_install_fault_handlers(void);
 void runtime_panic(const char *message);
 
+/* FreeRTOS run-time stats clock (portGET_RUN_TIME_COUNTER_VALUE). */
+uint32_t runtime_stats_timer_us(void);
+
 #endif
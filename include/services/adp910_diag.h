@@ -0,0 +1,44 @@
+#ifndef ADP910_DIAG_H
+#define ADP910_DIAG_H
+
+#include "drivers/adp910/adp910_sensor.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Per-channel ADP910 result counters. The sampling task records every
+ * init and read status; other tasks read them lock-free for the serial
+ * [ADP910][diag] line and /metrics. Counters only grow.
+ */
+
+typedef enum {
+  ADP910_DIAG_CHANNEL_FAN = 0,
+  ADP910_DIAG_CHANNEL_ENVELOPE,
+  ADP910_DIAG_CHANNEL_COUNT,
+} adp910_diag_channel_t;
+
+typedef struct {
+  bool ready;
+  uint32_t ok;
+  uint32_t invalid_argument;
+  uint32_t bus_error;
+  uint32_t not_ready;
+  uint32_t crc_mismatch;
+  uint32_t other;
+  adp910_status_t last_status;
+} adp910_diag_t;
+
+/* Sampling task only. */
+void adp910_diag_record(adp910_diag_channel_t channel,
+                        adp910_status_t status);
+void adp910_diag_set_ready(adp910_diag_channel_t channel, bool ready);
+
+/* Each field is exact; fields may straddle one concurrent update. */
+void adp910_diag_get(adp910_diag_channel_t channel, adp910_diag_t *out_diag);
+
+/* "fan" / "envelope", as used for metric labels. */
+const char *adp910_diag_channel_name(adp910_diag_channel_t channel);
+
+const char *adp910_status_name(adp910_status_t status);
+
+#endif
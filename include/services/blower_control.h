@@ -4,10 +4,13 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#define BLOWER_CONTROL_COMMAND_QUEUE_DEPTH 16u
+
 typedef enum {
   BLOWER_CONTROL_MODE_MANUAL_PERCENT = 0,
   BLOWER_CONTROL_MODE_SEMI_AUTO_TARGET = 1,
   BLOWER_CONTROL_MODE_AUTO_TEST = 2,
+  BLOWER_CONTROL_MODE_PREDICTIVE_TARGET = 3,
 } blower_control_mode_t;
 
 typedef struct {
@@ -23,18 +26,34 @@ typedef struct {
   float pd_max_step_percent;
   bool line_sync;
   float line_frequency_hz;
+  bool model_valid;
+  float model_gain_pa_per_percent;
+  float model_time_constant_s;
+  float model_dead_time_s;
+  uint32_t dropped_commands;
 } blower_control_snapshot_t;
 
+/*
+ * The controller state is owned by the control task: initialize, step,
+ * update_line_feedback and persist_pending must only be called from it.
+ * Setters may be called from any task; they queue a command that the next
+ * step applies and return false when it was rejected (invalid or queue
+ * full). Relay-off and release bypass the queue through a latch and are
+ * never dropped. Snapshots are lock-free reads of the last published state.
+ */
 void blower_control_initialize(void);
-void blower_control_set_manual_pwm_percent(uint8_t pwm_percent);
-void blower_control_set_mode(blower_control_mode_t mode);
-void blower_control_set_auto_hold_enabled(bool enabled);
-void blower_control_set_relay_enabled(bool enabled);
-void blower_control_set_target_pressure_pa(float target_pressure_pa);
+bool blower_control_set_manual_pwm_percent(uint8_t pwm_percent);
+bool blower_control_set_mode(blower_control_mode_t mode);
+bool blower_control_set_auto_hold_enabled(bool enabled);
+bool blower_control_set_relay_enabled(bool enabled);
+bool blower_control_set_target_pressure_pa(float target_pressure_pa);
+/* Relay off, manual mode, 0 % manual power. */
+void blower_control_release(void);
 
 uint8_t blower_control_step(float envelope_pressure_pa, bool measurement_valid,
                             uint32_t now_tick_ms);
 void blower_control_update_line_feedback(bool line_sync, float line_frequency_hz);
+void blower_control_persist_pending(bool fan_running);
 void blower_control_get_snapshot(blower_control_snapshot_t *out_snapshot);
 
 #endif
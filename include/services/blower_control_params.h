@@ -0,0 +1,107 @@
+#ifndef BLOWER_CONTROL_PARAMS_H
+#define BLOWER_CONTROL_PARAMS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Bump whenever the layout of blower_control_params_t changes. */
+#define BLOWER_CONTROL_PARAMS_SCHEMA_VERSION 1u
+
+typedef struct {
+  uint32_t revision;
+  float deadband_pa;
+  float kp;
+  float ki;
+  float kd;
+  float max_step_up_percent;
+  float max_step_down_percent;
+  float filter_alpha;
+  float derivative_clamp_pa_per_s;
+  float step_near_target_ratio;
+  float step_far_error_pa;
+  uint32_t learning_window_ms;
+  uint32_t learning_stable_cycles;
+  float learning_settle_band_pa;
+  float learning_max_derivative_pa_per_s;
+  float learning_feedforward_alpha;
+  float learning_step_up_percent;
+  float learning_step_down_percent;
+  float gain_scale_min;
+  float gain_scale_max;
+  float gain_scale_growth;
+  float gain_scale_shrink;
+  float integral_limit_pa_s;
+  float integral_decay_on_sign_flip;
+  uint32_t startup_min_hold_ms;
+  uint32_t startup_full_power_hold_ms;
+  float startup_target_ratio;
+  float startup_max_overshoot_ratio;
+  float predictive_ident_step_percent;
+  float predictive_max_step_up_percent;
+  float predictive_max_step_down_percent;
+} blower_control_params_t;
+
+typedef enum {
+  BLOWER_CONTROL_PARAM_TYPE_FLOAT = 0,
+  BLOWER_CONTROL_PARAM_TYPE_UINT32 = 1,
+} blower_control_param_type_t;
+
+typedef struct {
+  const char *name;
+  size_t offset;
+  blower_control_param_type_t type;
+  float min_value;
+  float max_value;
+} blower_control_param_field_t;
+
+typedef enum {
+  BLOWER_CONTROL_PARAMS_OK = 0,
+  BLOWER_CONTROL_PARAMS_INVALID,
+  BLOWER_CONTROL_PARAMS_STALE_REVISION,
+  BLOWER_CONTROL_PARAMS_BUSY,
+} blower_control_params_result_t;
+
+void blower_control_params_defaults(blower_control_params_t *out_params);
+
+/*
+ * Range-checks every field plus the cross-field constraints. On failure the
+ * offending field name is returned through out_field (may be NULL).
+ */
+bool blower_control_params_validate(const blower_control_params_t *params,
+                                    const char **out_field);
+
+size_t blower_control_params_field_count(void);
+const blower_control_param_field_t *blower_control_params_field(size_t index);
+float blower_control_params_field_get(const blower_control_params_t *params,
+                                      const blower_control_param_field_t *field);
+void blower_control_params_field_set(blower_control_params_t *params,
+                                     const blower_control_param_field_t *field,
+                                     float value);
+
+/* Loads the persisted set (or defaults) and publishes it. Control task. */
+void blower_control_params_service_init(void);
+
+/* Latest published set; safe from any task. */
+void blower_control_params_service_get(blower_control_params_t *out_params);
+
+/*
+ * Validates and publishes a new set. expected_revision must match the
+ * current revision unless it is 0; the stored revision is bumped on success.
+ */
+blower_control_params_result_t blower_control_params_service_set(
+    const blower_control_params_t *params, uint32_t expected_revision,
+    const char **out_invalid_field);
+
+/*
+ * Control-task side of the swap: copies the published set into out_params
+ * when it changed since *inout_generation. Never blocks; a set that is
+ * republished mid-copy is picked up on the next call instead.
+ */
+bool blower_control_params_service_acquire(uint32_t *inout_generation,
+                                           blower_control_params_t *out_params);
+
+/* Writes the latest set to flash if it changed. Control task, fan off. */
+void blower_control_params_service_persist_pending(void);
+
+#endif
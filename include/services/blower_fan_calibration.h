@@ -0,0 +1,87 @@
+#ifndef BLOWER_FAN_CALIBRATION_H
+#define BLOWER_FAN_CALIBRATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Fan calibration ranges, one per flow ring. A range is either a power law
+ * Q = C * dP^n or a table of calibrated (dP, Q) points interpolated in
+ * log-log space, and is only trusted between min_pressure_pa and
+ * max_pressure_pa. A range is compiled once into a lookup table uniform in
+ * sqrt(dP), where both kinds are close to linear, so a sample costs one
+ * sqrtf and a linear interpolation. The curvature in sqrt(dP) grows as
+ * dP falls, so the table starts where a power law with the range's
+ * steepest exponent stays within BLOWER_FAN_CALIBRATION_LUT_MAX_ERROR;
+ * below that start the exact model is evaluated. Outside the valid span
+ * the exact model is evaluated and the sample flagged. No RTOS
+ * dependencies.
+ */
+
+#define BLOWER_FAN_CALIBRATION_MAX_RANGES 4u
+#define BLOWER_FAN_CALIBRATION_MAX_TABLE_POINTS 8u
+#define BLOWER_FAN_CALIBRATION_LUT_SIZE 65u
+/* Relative interpolation error bound for power-law ranges. */
+#define BLOWER_FAN_CALIBRATION_LUT_MAX_ERROR 1.0e-3f
+
+typedef enum {
+  BLOWER_FAN_CALIBRATION_POWER_LAW = 0,
+  BLOWER_FAN_CALIBRATION_TABLE = 1,
+} blower_fan_calibration_kind_t;
+
+typedef struct {
+  uint8_t kind;
+  uint8_t table_count;
+  float min_pressure_pa;
+  float max_pressure_pa;
+  float c;
+  float n;
+  /* Ascending pressure after normalization. */
+  float table_pressure_pa[BLOWER_FAN_CALIBRATION_MAX_TABLE_POINTS];
+  float table_flow_m3h[BLOWER_FAN_CALIBRATION_MAX_TABLE_POINTS];
+} blower_fan_calibration_range_t;
+
+typedef struct {
+  blower_fan_calibration_range_t range;
+  /* Start of the table; the exact model is used below it. */
+  float lut_min_pa;
+  float sqrt_min_pa;
+  float inverse_step;
+  float lut_m3h[BLOWER_FAN_CALIBRATION_LUT_SIZE];
+  bool valid;
+} blower_fan_calibration_curve_t;
+
+/* Checks a range and sorts its table; false when it cannot be used. */
+bool blower_fan_calibration_range_normalize(
+    blower_fan_calibration_range_t *range);
+
+bool blower_fan_calibration_range_equal(
+    const blower_fan_calibration_range_t *a,
+    const blower_fan_calibration_range_t *b);
+
+/* Exact model at a pressure magnitude (powf); used to build tables. */
+float blower_fan_calibration_model_m3h(
+    const blower_fan_calibration_range_t *range, float pressure_pa);
+
+void blower_fan_calibration_compile(const blower_fan_calibration_range_t *range,
+                                    blower_fan_calibration_curve_t *out_curve);
+
+/* Standard-density flow; the sign of the pressure is ignored. */
+float blower_fan_calibration_evaluate(
+    const blower_fan_calibration_curve_t *curve, float pressure_pa,
+    bool *out_in_range);
+
+/*
+ * Range that should be mounted for a flow. current_index when its valid
+ * span covers the flow; otherwise the most restrictive covering range
+ * (lowest maximum flow, i.e. highest fan pressure), or failing that the
+ * range whose span is closest.
+ */
+uint8_t blower_fan_calibration_suggest_range(
+    const blower_fan_calibration_range_t *ranges, uint8_t range_count,
+    uint8_t current_index, float flow_m3h);
+
+const char *blower_fan_calibration_kind_name(
+    blower_fan_calibration_kind_t kind);
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef BLOWER_FEEDFORWARD_MAP_H
+#define BLOWER_FEEDFORWARD_MAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BLOWER_FEEDFORWARD_MAP_CAPACITY 12u
+
+typedef enum {
+  BLOWER_FEEDFORWARD_DIRECTION_PRESSURIZATION = 0,
+  BLOWER_FEEDFORWARD_DIRECTION_DEPRESSURIZATION = 1,
+  BLOWER_FEEDFORWARD_DIRECTION_COUNT = 2,
+} blower_feedforward_direction_t;
+
+typedef struct {
+  float target_pressure_pa;
+  float pwm_percent;
+} blower_feedforward_map_entry_t;
+
+typedef struct {
+  uint8_t entry_count[BLOWER_FEEDFORWARD_DIRECTION_COUNT];
+  blower_feedforward_map_entry_t
+      entries[BLOWER_FEEDFORWARD_DIRECTION_COUNT]
+             [BLOWER_FEEDFORWARD_MAP_CAPACITY];
+} blower_feedforward_map_t;
+
+void blower_feedforward_map_reset(blower_feedforward_map_t *map);
+
+/*
+ * Estimates the steady-state output for a target by interpolating between
+ * the learned points of the given direction. Returns false when the
+ * direction has no learned points yet.
+ */
+bool blower_feedforward_map_lookup(const blower_feedforward_map_t *map,
+                                   blower_feedforward_direction_t direction,
+                                   float target_pressure_pa,
+                                   float *out_pwm_percent);
+
+/*
+ * Folds a settled (target, output) observation into the map. Returns true
+ * when the stored table changed enough to be worth persisting.
+ */
+bool blower_feedforward_map_record(blower_feedforward_map_t *map,
+                                   blower_feedforward_direction_t direction,
+                                   float target_pressure_pa,
+                                   float pwm_percent);
+
+bool blower_feedforward_map_load(blower_feedforward_map_t *out_map);
+bool blower_feedforward_map_store(const blower_feedforward_map_t *map);
+
+#endif
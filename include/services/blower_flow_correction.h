@@ -0,0 +1,65 @@
+#ifndef BLOWER_FLOW_CORRECTION_H
+#define BLOWER_FLOW_CORRECTION_H
+
+#include "services/blower_fan_calibration.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Air density and fan flow correction shared by /api/status, the SSE
+ * stream (both in wifi_task.c) and the test service. The site settings (altitude, mounted fan range) are folded
+ * into constants and a compiled calibration curve once when they change;
+ * each caller then keeps its own blower_flow_correction_t, which is only
+ * recomputed when the settings change or the temperature moves by more
+ * than APP_FLOW_CORRECTION_TEMPERATURE_STEP_C. Flow and density use the
+ * fan sensor temperature, i.e. the air actually passing the fan orifice.
+ */
+
+typedef struct {
+  float altitude_m;
+  blower_fan_calibration_range_t fan_range;
+} blower_flow_correction_settings_t;
+
+typedef struct {
+  uint32_t generation;
+  float temperature_c;
+  float density_kg_m3;
+  float density_factor;
+  blower_fan_calibration_curve_t curve;
+  bool valid;
+} blower_flow_correction_t;
+
+/*
+ * Publishes new site settings and compiles the fan range. Calls must be
+ * serialized (the test service holds its mutex); identical settings keep
+ * the current generation so per-caller caches stay valid. Until the first
+ * call every flow reads 0.
+ */
+void blower_flow_correction_configure(
+    const blower_flow_correction_settings_t *settings);
+
+void blower_flow_correction_reset(blower_flow_correction_t *state);
+
+/*
+ * Brings a cache up to date for the given temperature. A non-finite
+ * temperature keeps the last value (20 C on a fresh cache).
+ */
+void blower_flow_correction_refresh(blower_flow_correction_t *state,
+                                    float temperature_c);
+
+/*
+ * Fan flow for a fan differential pressure; sign is ignored. out_in_range
+ * (optional) reports whether the pressure is inside the range's valid span.
+ */
+float blower_flow_correction_flow_m3h(const blower_flow_correction_t *state,
+                                      float fan_pressure_pa,
+                                      bool *out_in_range);
+
+/* Pitot air speed for a fan differential pressure. */
+float blower_flow_correction_pitot_speed_ms(
+    const blower_flow_correction_t *state, float fan_pressure_pa);
+
+/* One-off density at the configured altitude, for report summaries. */
+float blower_flow_correction_density_kg_m3(float temperature_c);
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef BLOWER_FOPDT_PREDICTOR_H
+#define BLOWER_FOPDT_PREDICTOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * First-order-plus-dead-time plant model identified from an open-loop step,
+ * driving a Smith-predictor PI loop. The loop itself runs in Q16.16 fixed
+ * point; floats only appear at the API boundary and when the model is fitted.
+ */
+
+#define BLOWER_FOPDT_IDENT_CAPACITY 128u
+#define BLOWER_FOPDT_DELAY_CAPACITY 96u
+
+typedef enum {
+  BLOWER_FOPDT_STATE_IDLE = 0,
+  BLOWER_FOPDT_STATE_IDENTIFYING,
+  BLOWER_FOPDT_STATE_TRACKING,
+  BLOWER_FOPDT_STATE_FAILED,
+} blower_fopdt_state_t;
+
+typedef struct {
+  float gain_pa_per_percent;
+  float time_constant_s;
+  float dead_time_s;
+  float static_output_percent;
+  float static_pressure_pa;
+  bool valid;
+} blower_fopdt_model_t;
+
+typedef struct {
+  blower_fopdt_state_t state;
+  blower_fopdt_model_t model;
+
+  uint32_t ident_start_tick_ms;
+  uint16_t ident_count;
+  uint16_t ident_decimation;
+  uint16_t ident_cycles;
+  uint16_t ident_quiet_cycles;
+  float ident_base_output_percent;
+  float ident_step_output_percent;
+  float ident_base_pressure_pa;
+  float ident_abort_pressure_pa;
+  int16_t ident_samples_cpa[BLOWER_FOPDT_IDENT_CAPACITY];
+
+  int32_t gain_q16;
+  int32_t model_alpha_q16;
+  int32_t kc_q16;
+  int32_t ki_q16;
+  uint8_t delay_steps;
+  uint8_t delay_head;
+  int32_t delay_line_q16[BLOWER_FOPDT_DELAY_CAPACITY];
+  int32_t model_output_q16;
+  int32_t base_output_q16;
+  int32_t output_q16;
+  int32_t last_error_q16;
+  bool has_last_error;
+  bool tracking_primed;
+} blower_fopdt_predictor_t;
+
+/* Drops the identified model; the next engagement re-identifies the plant. */
+void blower_fopdt_predictor_reset(blower_fopdt_predictor_t *predictor);
+
+/*
+ * Keeps the identified model but restarts the predictor and PI state from
+ * the current output. An identification in progress is abandoned.
+ */
+void blower_fopdt_predictor_restart(blower_fopdt_predictor_t *predictor);
+
+/*
+ * The open-loop step is abandoned (state FAILED, base output restored)
+ * as soon as the pressure reaches abort_pressure_pa.
+ */
+void blower_fopdt_predictor_begin_identification(
+    blower_fopdt_predictor_t *predictor, float base_output_percent,
+    float base_pressure_pa, float step_output_percent,
+    float abort_pressure_pa, uint32_t now_tick_ms);
+
+/*
+ * Feeds one loop sample of the open-loop step. Returns the output to hold;
+ * the state leaves IDENTIFYING once the response settled, timed out or
+ * overshot the abort pressure.
+ */
+float blower_fopdt_predictor_identify(blower_fopdt_predictor_t *predictor,
+                                      float measured_pressure_pa,
+                                      uint32_t now_tick_ms);
+
+/*
+ * Steady output the identified model expects for a target, extrapolated
+ * from the identified operating point along the fan-law exponent.
+ */
+bool blower_fopdt_predictor_steady_output(
+    const blower_fopdt_predictor_t *predictor, float target_pressure_pa,
+    float *out_output_percent);
+
+/*
+ * One Smith-predictor PI step. After a restart the loop is primed from the
+ * current output and jumps to feedforward_output_percent when it is >= 0.
+ */
+float blower_fopdt_predictor_control(blower_fopdt_predictor_t *predictor,
+                                     float target_pressure_pa,
+                                     float measured_pressure_pa,
+                                     float current_output_percent,
+                                     float feedforward_output_percent,
+                                     float max_step_up_percent,
+                                     float max_step_down_percent);
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef BLOWER_LEAKAGE_FIT_H
+#define BLOWER_LEAKAGE_FIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Fits the building leakage curve Q = C * dP^n in log-log space. Pure
+ * computation with no RTOS or hardware dependencies, so the same file can
+ * be compiled on a host and checked against reference datasets.
+ */
+
+#define BLOWER_LEAKAGE_FIT_MAX_POINTS 16u
+#define BLOWER_LEAKAGE_FIT_MAX_PAIRS                                         \
+  ((BLOWER_LEAKAGE_FIT_MAX_POINTS * (BLOWER_LEAKAGE_FIT_MAX_POINTS - 1u)) / \
+   2u)
+
+typedef enum {
+  /* Unweighted least squares, ISO 9972 Annex C. */
+  BLOWER_LEAKAGE_FIT_OLS = 0,
+  /* Weighted by the per-point variance of ln Q. */
+  BLOWER_LEAKAGE_FIT_WLS = 1,
+  /* WLS with Huber reweighting (IRLS) of large residuals. */
+  BLOWER_LEAKAGE_FIT_HUBER = 2,
+  /* Median of pairwise slopes; CI on n from Kendall's S. */
+  BLOWER_LEAKAGE_FIT_THEIL_SEN = 3,
+} blower_leakage_fit_method_t;
+
+typedef struct {
+  float pressure_pa;
+  float flow_m3h;
+  /* Standard errors of the point means; 0 when unknown. */
+  float pressure_std_error_pa;
+  float flow_std_error_m3h;
+} blower_leakage_fit_point_t;
+
+/*
+ * Scratch memory for one fit (about 1 KB). Owned by the caller so the fit
+ * keeps no state between calls; two fits must not share one concurrently.
+ */
+typedef struct {
+  float x[BLOWER_LEAKAGE_FIT_MAX_POINTS];
+  float y[BLOWER_LEAKAGE_FIT_MAX_POINTS];
+  float base_weight[BLOWER_LEAKAGE_FIT_MAX_POINTS];
+  float weight[BLOWER_LEAKAGE_FIT_MAX_POINTS];
+  float scratch[BLOWER_LEAKAGE_FIT_MAX_POINTS];
+  float slopes[BLOWER_LEAKAGE_FIT_MAX_PAIRS];
+  uint8_t count;
+} blower_leakage_fit_workspace_t;
+
+typedef struct {
+  bool valid;
+  blower_leakage_fit_method_t method;
+  uint8_t point_count;
+  uint8_t downweighted_count;
+  float c;
+  float n;
+  /*
+   * Pearson r for the least-squares methods. For Theil-Sen it is
+   * sign(n) * sqrt(1 - SSE / Syy) over the Theil-Sen residuals.
+   */
+  float correlation_r;
+  /*
+   * 95% CI: n +/- n_ci95, C in [c_ci95_low, c_ci95_high]. For Theil-Sen
+   * the C and flow intervals use the Theil-Sen residual variance with the
+   * least-squares leverage, a normal-theory approximation.
+   */
+  float n_ci95;
+  float c_ci95_low;
+  float c_ci95_high;
+  /* Terms needed for the CI of a predicted flow. */
+  float residual_variance;
+  float weight_sum;
+  float x_mean;
+  float sxx;
+  float t95;
+} blower_leakage_fit_result_t;
+
+bool blower_leakage_fit(const blower_leakage_fit_point_t *points,
+                        uint8_t point_count,
+                        blower_leakage_fit_method_t method,
+                        blower_leakage_fit_workspace_t *workspace,
+                        blower_leakage_fit_result_t *out_result);
+
+/* Predicted flow at a pressure with its 95% confidence interval. */
+bool blower_leakage_fit_flow_ci95(const blower_leakage_fit_result_t *fit,
+                                  float pressure_pa, float *out_flow_m3h,
+                                  float *out_low_m3h, float *out_high_m3h);
+
+const char *blower_leakage_fit_method_name(blower_leakage_fit_method_t method);
+
+#endif
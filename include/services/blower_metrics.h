@@ -41,6 +41,9 @@ typedef struct {
   float estimated_air_leakage_units;
   bool fan_sample_valid;
   bool envelope_sample_valid;
+  /* Capture times of the samples above (adp910_sample_t). */
+  uint32_t fan_sample_time_us;
+  uint32_t envelope_sample_time_us;
   uint32_t update_sequence;
   uint32_t last_update_tick;
   blower_calibration_state_t calibration_state;
@@ -0,0 +1,58 @@
+#ifndef BLOWER_REPORT_LOG_H
+#define BLOWER_REPORT_LOG_H
+
+#include "services/blower_test_service.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Append-only log of completed test reports in APP_TEST_REPORT_LOG_*.
+ * Each report is one CRC-checked, page-aligned record; sectors are used
+ * round-robin and the oldest sector is erased ahead of the write head, so
+ * wear is spread evenly and a new report only programs its own pages. The
+ * slot index lives in RAM and is rebuilt from flash at boot.
+ */
+
+#define BLOWER_REPORT_LOG_QUEUE_CAPACITY 2u
+
+/* Scans the log and rebuilds the index. Control task, before first use. */
+void blower_report_log_init(void);
+
+/* False when the configured flash region is unusable; appends then fail. */
+bool blower_report_log_is_available(void);
+
+/*
+ * Queues a report for writing. Never blocks; returns false when the log is
+ * busy or the queue is full so the caller can retry on its next step.
+ */
+bool blower_report_log_append(const blower_test_report_t *report);
+
+/*
+ * Performs at most one flash operation (one sector erase or one page
+ * program) so interrupts are never off for longer than that. Control task,
+ * fan off. Returns true when flash was touched.
+ */
+bool blower_report_log_persist_step(void);
+
+/*
+ * Reports stored or queued, and the minimum the log keeps before the
+ * oldest sector is recycled.
+ */
+uint32_t blower_report_log_count(void);
+uint32_t blower_report_log_capacity(void);
+
+/* Highest report id stored or queued; 0 when the log is empty. */
+uint32_t blower_report_log_newest_id(void);
+
+/*
+ * Report ids, newest first, strictly older than before_report_id (0 starts
+ * at the newest). Queued reports are included. Returns the number written.
+ */
+size_t blower_report_log_list(uint32_t before_report_id, uint32_t *out_ids,
+                              size_t max_ids);
+
+bool blower_report_log_read(uint32_t report_id,
+                            blower_test_report_t *out_report);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef BLOWER_RUNNING_STATS_H
+#define BLOWER_RUNNING_STATS_H
+
+#include <stdint.h>
+
+/*
+ * Constant-memory streaming statistics (Welford). The mean and the sum of
+ * squared deviations carry Kahan compensation terms so long float windows
+ * do not drift as the sample count grows.
+ */
+typedef struct {
+  uint32_t count;
+  float mean;
+  float mean_compensation;
+  float m2;
+  float m2_compensation;
+  float min_value;
+  float max_value;
+} blower_running_stats_t;
+
+void blower_running_stats_reset(blower_running_stats_t *stats);
+void blower_running_stats_push(blower_running_stats_t *stats, float value);
+
+/* Sample variance (n - 1); 0 with fewer than two samples. */
+float blower_running_stats_variance(const blower_running_stats_t *stats);
+float blower_running_stats_stddev(const blower_running_stats_t *stats);
+
+/* Standard error of the mean; 0 with fewer than two samples. */
+float blower_running_stats_std_error(const blower_running_stats_t *stats);
+
+/* Two-sided 95% Student t quantile. */
+float blower_running_stats_t95(uint32_t degrees_of_freedom);
+
+#endif
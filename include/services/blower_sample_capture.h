@@ -0,0 +1,75 @@
+#ifndef BLOWER_SAMPLE_CAPTURE_H
+#define BLOWER_SAMPLE_CAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Raw sample capture for the measuring windows of a test, kept for
+ * post-hoc reanalysis. Samples are stored in fixed point and delta/varint
+ * encoded into self-contained 256-byte pages tagged with the report id,
+ * direction and point. Pages are staged in RAM while the fan runs and
+ * moved into the APP_TEST_SAMPLE_LOG_* flash ring once it is off; the
+ * oldest sector is erased ahead of the write head.
+ */
+
+typedef struct {
+  uint32_t report_id;
+  uint32_t tick_ms;
+  int32_t envelope_pressure_cpa;
+  int32_t fan_pressure_cpa;
+  int32_t fan_temperature_cc;
+  int32_t envelope_temperature_cc;
+  int32_t power_permille;
+  uint8_t direction;
+  uint8_t point_index;
+} blower_sample_capture_sample_t;
+
+typedef struct {
+  uint32_t captured_samples;
+  uint32_t dropped_samples;
+  uint32_t staged_pages;
+  uint32_t staging_capacity_pages;
+} blower_sample_capture_stats_t;
+
+/* Returns false to stop the walk. */
+typedef bool (*blower_sample_capture_visitor_fn)(
+    const blower_sample_capture_sample_t *sample, void *context);
+
+/* Scans the flash ring for its head. Control task, before first use. */
+void blower_sample_capture_init(void);
+
+/*
+ * Producer side, called by the test service under its own lock. A window
+ * keeps every APP_TEST_SAMPLE_CAPTURE_DECIMATION-th pushed sample; a page
+ * that finds the staging ring full is dropped and its samples counted.
+ */
+void blower_sample_capture_begin_window(uint32_t report_id, uint8_t direction,
+                                        uint8_t point_index);
+void blower_sample_capture_push(uint32_t tick_ms, float envelope_pressure_pa,
+                                float fan_pressure_pa,
+                                float fan_temperature_c,
+                                float envelope_temperature_c,
+                                float power_percent);
+void blower_sample_capture_end_window(void);
+
+/*
+ * Moves staged pages to flash, one sector erase or one page program per
+ * call. Control task, fan off. Returns true when flash was touched.
+ */
+bool blower_sample_capture_persist_step(void);
+
+/*
+ * Visits the samples of a report oldest first, staged pages included.
+ * Pages are copied out one at a time, so the visitor runs unlocked and may
+ * block. Returns the number of samples visited.
+ */
+uint32_t blower_sample_capture_for_each(
+    uint32_t report_id, blower_sample_capture_visitor_fn visitor,
+    void *context);
+
+bool blower_sample_capture_has_report(uint32_t report_id);
+
+void blower_sample_capture_get_stats(blower_sample_capture_stats_t *out_stats);
+
+#endif
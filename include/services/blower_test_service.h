@@ -2,13 +2,13 @@
 #define BLOWER_TEST_SERVICE_H
 
 #include "services/blower_control.h"
+#include "services/blower_fan_calibration.h"
 #include "services/blower_metrics.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #define BLOWER_TEST_MAX_PRESSURE_POINTS 12u
-#define BLOWER_TEST_HISTORY_CAPACITY 4u
 
 typedef enum {
   BLOWER_TEST_MODE_PRESSURIZATION = 0,
@@ -24,9 +24,12 @@ typedef enum {
 
 typedef enum {
   BLOWER_TEST_STATE_IDLE = 0,
+  BLOWER_TEST_STATE_BASELINE_PRE,
   BLOWER_TEST_STATE_PREPARING,
   BLOWER_TEST_STATE_STABILIZING,
   BLOWER_TEST_STATE_MEASURING,
+  BLOWER_TEST_STATE_RING_CHANGE,
+  BLOWER_TEST_STATE_BASELINE_POST,
   BLOWER_TEST_STATE_COMPLETED,
   BLOWER_TEST_STATE_ABORTED,
   BLOWER_TEST_STATE_ERROR,
@@ -43,31 +46,85 @@ typedef struct {
   float fan_curve_c;
   float fan_curve_n;
   float target_tolerance_pa;
+  /*
+   * Fixed windows, and the upper bounds when adaptive_windows is set: a
+   * point then settles once min_settle_time_s is on target with low drift
+   * and stops measuring once the 95% CI of the mean pressure is within
+   * target_ci_pa (after at least min_measure_time_s).
+   */
   uint16_t settle_time_s;
   uint16_t measure_time_s;
+  bool adaptive_windows;
+  uint16_t min_settle_time_s;
+  uint16_t min_measure_time_s;
+  float target_ci_pa;
+  float max_drift_pa_s;
+  /*
+   * Zero-flow baseline sampled with the fan off before and after the
+   * points (0 disables it). Its mean is subtracted from every point; a
+   * baseline beyond max_baseline_pa fails the ISO 9972 check.
+   */
+  uint16_t baseline_time_s;
+  float max_baseline_pa;
   uint8_t reference_pressure_pa;
   uint8_t min_points_required;
   bool enforce_iso_9972_rules;
+  /* blower_leakage_fit_method_t; OLS is the plain ISO 9972 Annex C fit. */
+  uint8_t fit_method;
+  /* Keeps the raw samples of every measuring window (sample capture). */
+  bool capture_raw_samples;
   uint8_t pressure_points_count;
   float pressure_points_pa[BLOWER_TEST_MAX_PRESSURE_POINTS];
+  /*
+   * Fan calibration registry, one range per flow ring, and the ring that
+   * is mounted. Without ranges the open fan uses fan_curve_c/n scaled to
+   * fan_aperture_cm. With two or more, a fan pressure that stays outside
+   * the mounted range pauses the test in RING_CHANGE until a ring is
+   * selected.
+   */
+  uint8_t fan_range_count;
+  uint8_t fan_range_index;
+  blower_fan_calibration_range_t fan_ranges[BLOWER_FAN_CALIBRATION_MAX_RANGES];
 } blower_test_config_t;
 
 typedef struct {
   float target_pressure_pa;
+  /* Baseline-corrected; raw_avg_pressure_pa is the mean as measured. */
   float avg_pressure_pa;
+  float raw_avg_pressure_pa;
+  /* Sign of the measured envelope pressure, +1 or -1. */
+  int8_t pressure_sign;
+  float pressure_stddev_pa;
+  float pressure_std_error_pa;
+  float pressure_min_pa;
+  float pressure_max_pa;
   float avg_fan_flow_m3h;
+  float flow_stddev_m3h;
+  float flow_std_error_m3h;
   float avg_fan_temperature_c;
   float avg_envelope_temperature_c;
   float avg_pwm_percent;
+  uint32_t settle_duration_ms;
+  uint32_t measure_duration_ms;
   uint16_t sample_count;
+  /* Fan range used; fan_in_range when at most 10% of samples left it. */
+  uint8_t fan_range_index;
+  bool fan_in_range;
   bool valid;
 } blower_test_point_result_t;
 
 typedef struct {
+  uint8_t fit_method;
+  uint8_t downweighted_points;
   float cl_m3h_pan;
+  float cl_ci95_low_m3h_pan;
+  float cl_ci95_high_m3h_pan;
   float exponent_n;
+  float exponent_n_ci95;
   float correlation_r;
   float q_ref_m3h;
+  float q_ref_ci95_low_m3h;
+  float q_ref_ci95_high_m3h;
   float ach_ref_h1;
   float w_ref_m3h_m2;
   float q_ref_envelope_m3h_m2;
@@ -75,6 +132,7 @@ typedef struct {
   float eqla10_cm2_per_m2_envelope;
   float lbl_ela4_cm2;
   float lbl_ela4_cm2_per_m2_envelope;
+  float noise_uncertainty_pct;
   float uncertainty_pct;
   bool valid;
 } blower_test_curve_summary_t;
@@ -86,10 +144,25 @@ typedef struct {
   blower_test_curve_summary_t summary;
 } blower_test_direction_report_t;
 
+typedef struct {
+  float pre_pa;
+  float pre_std_error_pa;
+  uint16_t pre_sample_count;
+  float post_pa;
+  float post_std_error_pa;
+  uint16_t post_sample_count;
+  /* Mean of both phases, subtracted from the signed point pressures. */
+  float bias_pa;
+  float bias_std_error_pa;
+  bool valid;
+  bool stable;
+} blower_test_baseline_t;
+
 typedef struct {
   uint32_t report_id;
   uint32_t completed_tick_ms;
   uint8_t reference_pressure_pa;
+  blower_test_baseline_t baseline;
   bool has_pressurization;
   bool has_depressurization;
   blower_test_direction_report_t pressurization;
@@ -109,9 +182,16 @@ typedef struct {
   float current_measured_flow_m3h;
   uint32_t state_elapsed_ms;
   uint16_t active_sample_count;
+  float current_ci95_pa;
+  uint8_t fan_range_index;
+  bool fan_in_range;
+  /* Ring to mount while in RING_CHANGE. */
+  uint8_t suggested_fan_range;
   bool report_ready;
   uint32_t latest_report_id;
   float latest_ach_ref_h1;
+  /* Fresh samples lost to a busy test mutex since the test started. */
+  uint32_t dropped_samples;
 } blower_test_runtime_status_t;
 
 void blower_test_service_init(void);
@@ -123,9 +203,28 @@ void blower_test_service_reset_config_to_defaults(void);
 bool blower_test_service_start(blower_test_mode_t mode);
 void blower_test_service_stop(void);
 
-void blower_test_service_update(const blower_metrics_snapshot_t *metrics_snapshot,
-                                const blower_control_snapshot_t *control_snapshot,
-                                uint32_t now_tick_ms);
+/*
+ * Records which fan range is mounted. Allowed while idle, and in
+ * RING_CHANGE, where it resumes the interrupted point.
+ */
+bool blower_test_service_select_fan_range(uint8_t range_index);
+
+/*
+ * Control task only, once per fresh metrics snapshot. Never blocks: when a
+ * reader holds the test state it returns false without consuming the
+ * sample, and the caller retries with its next snapshot. A sample that is
+ * superseded before a retry gets in is counted in dropped_samples. Control
+ * requests are issued after the test mutex is released.
+ */
+bool blower_test_service_update(
+    const blower_metrics_snapshot_t *metrics_snapshot,
+    const blower_control_snapshot_t *control_snapshot, uint32_t now_tick_ms);
+
+/*
+ * Writes a config change, or advances the report log or the sample log by
+ * one flash operation. Control task, fan off.
+ */
+void blower_test_service_persist_pending(bool fan_running);
 
 void blower_test_service_get_runtime(blower_test_runtime_status_t *out_runtime);
 bool blower_test_service_get_latest_report(blower_test_report_t *out_report);
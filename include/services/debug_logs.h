@@ -6,13 +6,20 @@
 #include <stdint.h>
 
 #ifndef DEBUG_LOG_BUFFER_SIZE
-#define DEBUG_LOG_BUFFER_SIZE 1024u
+#define DEBUG_LOG_BUFFER_SIZE 4096u
 #endif
 
 #ifndef DEBUG_LOG_TAIL_CHARS
 #define DEBUG_LOG_TAIL_CHARS 192u
 #endif
 
+/*
+ * Text log for the debug HTTP routes and the status payload tail, kept
+ * in a circular byte ring. Appends come from tasks only (they suspend
+ * the scheduler briefly, never masking interrupts); readers copy
+ * lock-free.
+ */
+
 void debug_logs_clear(void);
 void debug_logs_append(const char *line);
 void debug_logs_copy(char *out_buffer, size_t out_buffer_size);
@@ -6,4 +6,10 @@
 void dimmer_control_set_power_percent(uint8_t power_percent);
 uint8_t dimmer_control_get_power_percent(void);
 
+/*
+ * Drives the TRIAC gate low and pins the power at 0 until reset; later
+ * set_power_percent calls are ignored. Safe from fault handlers.
+ */
+void dimmer_control_force_off(void);
+
 #endif
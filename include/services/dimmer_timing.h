@@ -0,0 +1,55 @@
+#ifndef DIMMER_TIMING_H
+#define DIMMER_TIMING_H
+
+#include "services/sys_histogram.h"
+#include <stdint.h>
+
+/*
+ * Timing statistics of the dimmer ISRs, to see whether Wi-Fi or flash
+ * activity shakes the TRIAC timing:
+ * - zero-cross period and its deviation from the running mean period;
+ * - zero-cross IRQ entry relative to the predicted edge, i.e. the last
+ *   tracked edge plus the mean period. The GPIO edge has no hardware
+ *   timestamp, so this is entry jitter, not absolute latency;
+ * - gate fire lateness: alarm callback entry minus the scheduled time.
+ *
+ * Each ISR is the only writer of its own group and updates it in O(1)
+ * inside a sequence counter; readers copy and retry, never masking
+ * interrupts. Resets are requests the ISRs apply on their next update.
+ */
+
+#define DIMMER_TIMING_BIN_COUNT 32u
+
+/* Signed values in APP_DIMMER_TIMING_BIN_US bins centred on zero. */
+typedef struct {
+  uint32_t count;
+  int32_t min_us;
+  int32_t max_us;
+  uint32_t underflow;
+  uint32_t overflow;
+  uint32_t bins[DIMMER_TIMING_BIN_COUNT];
+} dimmer_timing_jitter_t;
+
+typedef struct {
+  uint32_t period_mean_us;
+  uint32_t period_min_us;
+  uint32_t period_max_us;
+  /* Edges after a sync loss or an implausible period restart tracking. */
+  uint32_t resyncs;
+  dimmer_timing_jitter_t period_deviation;
+  dimmer_timing_jitter_t edge_phase;
+  /* Microseconds, log2 buckets. */
+  sys_histogram_t gate_lateness;
+} dimmer_timing_snapshot_t;
+
+/* Zero-cross ISR, with the time_us_32() taken on entry. */
+void dimmer_timing_record_zero_cross(uint32_t entry_us);
+
+/* Gate alarm ISR: scheduled and actual callback entry times. */
+void dimmer_timing_record_gate(uint32_t scheduled_us, uint32_t entry_us);
+
+void dimmer_timing_get_snapshot(dimmer_timing_snapshot_t *out_snapshot);
+
+void dimmer_timing_reset(void);
+
+#endif
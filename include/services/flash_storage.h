@@ -0,0 +1,42 @@
+#ifndef FLASH_STORAGE_H
+#define FLASH_STORAGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Helpers shared by the services that keep records in on-board flash:
+ * CRC-32 (IEEE, reflected), region layout checks, erased-range checks and
+ * a single-image erase/program/verify. Offsets are relative to the start
+ * of flash, as for flash_range_erase().
+ */
+
+#define FLASH_STORAGE_ERASED_BYTE 0xffu
+#define FLASH_STORAGE_CRC32_INIT 0xffffffffu
+
+/* Raw update; start from FLASH_STORAGE_CRC32_INIT, finish with ~crc. */
+uint32_t flash_storage_crc32_update(uint32_t crc, const uint8_t *data,
+                                    size_t data_len);
+
+uint32_t flash_storage_crc32(const void *data, size_t data_len);
+
+/*
+ * Non-empty, sector aligned, inside the flash and not below min_offset
+ * (the end of the region it must not overlap; 0 for none).
+ */
+bool flash_storage_region_is_valid(uint32_t offset, uint32_t size,
+                                   uint32_t min_offset);
+
+bool flash_storage_range_is_erased(uint32_t offset, uint32_t length);
+
+/*
+ * Pads data with erased bytes into image (a whole number of pages), then
+ * erases the sectors it covers, programs it with interrupts off and reads
+ * it back. False when the read-back differs.
+ */
+bool flash_storage_write_image(uint32_t offset, uint8_t *image,
+                               size_t image_size, const void *data,
+                               size_t data_size);
+
+#endif
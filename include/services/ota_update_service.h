@@ -35,6 +35,11 @@ typedef struct {
   uint32_t expected_crc32;
   uint32_t computed_crc32;
   bool apply_task_active;
+  /* From begin to the latest accepted chunk of the current image. */
+  uint32_t receive_elapsed_ms;
+  /* Accepted since boot, across all uploads. */
+  uint32_t total_received_bytes;
+  uint32_t total_chunks;
   char staged_version[OTA_UPDATE_VERSION_LABEL_MAX_LEN];
   char last_error[OTA_UPDATE_ERROR_TEXT_MAX_LEN];
 } ota_update_status_t;
@@ -0,0 +1,86 @@
+#ifndef SYS_CRASH_H
+#define SYS_CRASH_H
+
+#include "services/sys_trace.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Post-mortem crash dump. The fault handlers, FreeRTOS fatal hooks and
+ * the task watchdog supervisor fill one record in RAM that the C runtime
+ * does not zero, then reboot through the watchdog. sys_crash_init() on
+ * the next boot adopts a record
+ * with a valid magic and checksum, so it is served at /api/sys/crash
+ * until cleared; scripts/crash_decode.py resolves its code addresses
+ * against the matching ELF.
+ */
+
+#define SYS_CRASH_STACK_WORDS 64u
+#define SYS_CRASH_TRACE_EVENTS 32u
+#define SYS_CRASH_LOG_TAIL_CHARS 256u
+#define SYS_CRASH_TEXT_LEN 48u
+
+typedef enum {
+  SYS_CRASH_NONE = 0,
+  SYS_CRASH_HARD_FAULT,
+  SYS_CRASH_MEM_MANAGE,
+  SYS_CRASH_BUS_FAULT,
+  SYS_CRASH_USAGE_FAULT,
+  SYS_CRASH_SECURE_FAULT,
+  SYS_CRASH_STACK_OVERFLOW,
+  SYS_CRASH_MALLOC_FAILED,
+  SYS_CRASH_PANIC,
+  SYS_CRASH_WATCHDOG,
+  SYS_CRASH_REASON_COUNT,
+} sys_crash_reason_t;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t reason;
+  uint32_t uptime_us;
+  char firmware_version[SYS_CRASH_TEXT_LEN];
+  char task_name[SYS_CRASH_TEXT_LEN];
+  char message[SYS_CRASH_TEXT_LEN];
+  /* Exception frame stacked by the core; has_frame false otherwise. */
+  bool has_frame;
+  uint32_t r0;
+  uint32_t r1;
+  uint32_t r2;
+  uint32_t r3;
+  uint32_t r12;
+  uint32_t lr;
+  uint32_t pc;
+  uint32_t xpsr;
+  uint32_t exc_return;
+  uint32_t cfsr;
+  uint32_t hfsr;
+  uint32_t mmfar;
+  uint32_t bfar;
+  /* Words from stack_address up: the frame, then the caller's stack. */
+  uint32_t stack_address;
+  uint32_t stack_word_count;
+  uint32_t stack[SYS_CRASH_STACK_WORDS];
+  uint32_t trace_count;
+  sys_trace_event_t trace[SYS_CRASH_TRACE_EVENTS];
+  char log_tail[SYS_CRASH_LOG_TAIL_CHARS];
+  uint32_t checksum;
+} sys_crash_record_t;
+
+/* First thing in main(): adopts and invalidates the previous dump. */
+void sys_crash_init(void);
+
+/*
+ * Fault context: fills the dump. frame points at the stacked r0..xPSR
+ * and may be NULL for software failures; message may be NULL.
+ */
+void sys_crash_capture(sys_crash_reason_t reason, const uint32_t *frame,
+                       uint32_t exc_return, const char *message);
+
+/* False when the previous boot left no dump (or it was cleared). */
+bool sys_crash_get_last(sys_crash_record_t *out_record);
+
+void sys_crash_clear(void);
+
+const char *sys_crash_reason_name(sys_crash_reason_t reason);
+
+#endif
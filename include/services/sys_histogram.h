@@ -0,0 +1,34 @@
+#ifndef SYS_HISTOGRAM_H
+#define SYS_HISTOGRAM_H
+
+#include <stdint.h>
+
+/*
+ * Constant-size log2 histogram of unsigned durations: bucket b holds
+ * values of bit length b (2^(b-1)..2^b-1), bucket 0 holds zero. Count,
+ * min, max and sum are exact; percentiles are bucket upper bounds capped
+ * at the max. No locking: writers and readers serialize themselves.
+ */
+
+#define SYS_HISTOGRAM_BUCKET_COUNT 33u
+
+typedef struct {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+  uint32_t buckets[SYS_HISTOGRAM_BUCKET_COUNT];
+} sys_histogram_t;
+
+void sys_histogram_clear(sys_histogram_t *histogram);
+
+void sys_histogram_add(sys_histogram_t *histogram, uint32_t value);
+
+/* Mean of the added values; 0 when empty. */
+uint32_t sys_histogram_mean(const sys_histogram_t *histogram);
+
+/* Smallest bucket bound covering the fraction of samples; 0 when empty. */
+uint32_t sys_histogram_percentile(const sys_histogram_t *histogram,
+                                  float fraction);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef SYS_LATENCY_H
+#define SYS_LATENCY_H
+
+#include "services/sys_histogram.h"
+#include <stdint.h>
+
+/*
+ * Sensor-to-actuation latency. Each ADP910 sample carries its I2C capture
+ * time (time_us_32) through the metrics snapshot and the control step;
+ * the dimmer task tags the power command computed from a new sample and
+ * the gate-fire ISR closes the trace on the first TRIAC pulse after it.
+ * Only a command with power > 0 can fire; a trace still open when the
+ * next one starts is counted as superseded.
+ */
+
+typedef enum {
+  SYS_LATENCY_SAMPLE_TO_COMMAND = 0,
+  SYS_LATENCY_COMMAND_TO_GATE,
+  SYS_LATENCY_SAMPLE_TO_GATE,
+  SYS_LATENCY_STAGE_COUNT,
+} sys_latency_stage_t;
+
+typedef struct {
+  /* Microseconds. */
+  sys_histogram_t stages[SYS_LATENCY_STAGE_COUNT];
+  uint32_t superseded;
+} sys_latency_snapshot_t;
+
+/*
+ * Dimmer task: a power command derived from the sample captured at
+ * sample_time_us was just handed to the ISR side.
+ */
+void sys_latency_trace_command(uint32_t sample_time_us, uint8_t power_percent);
+
+/* Gate-fire ISR: the TRIAC was just triggered. */
+void sys_latency_trace_gate(void);
+
+void sys_latency_get_snapshot(sys_latency_snapshot_t *out_snapshot);
+
+void sys_latency_reset(void);
+
+const char *sys_latency_stage_name(sys_latency_stage_t stage);
+
+#endif
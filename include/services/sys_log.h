@@ -0,0 +1,77 @@
+#ifndef SYS_LOG_H
+#define SYS_LOG_H
+
+#include "app/app_config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Deferred logging. A call site stores a message id and its raw argument
+ * words in a lock-free ring of APP_LOG_RING_ENTRIES records; the
+ * idle-priority log task formats and prints them later, so neither
+ * printf formatting nor USB/UART output runs on the caller. A full ring
+ * drops the new record and counts it.
+ *
+ * Arguments are one word each: SYS_LOG_U32/I32 for integers, SYS_LOG_F32
+ * for floats and SYS_LOG_STR for strings with static storage (literals,
+ * name tables) only, since the pointer is read after the call returns.
+ *
+ * With APP_ENABLE_LOG_TASK 0 sys_log_write formats and prints at once.
+ */
+
+#define SYS_LOG_MAX_ARGS 16u
+#define SYS_LOG_LINE_MAX 256u
+
+typedef enum {
+  SYS_LOG_ADP910_INIT_FAIL = 0,
+  SYS_LOG_ADP910_INIT_OK,
+  SYS_LOG_ADP910_READ_FAIL,
+  SYS_LOG_ADP910_DIAG,
+  SYS_LOG_PROFILER_PROBE,
+  SYS_LOG_ID_COUNT,
+} sys_log_id_t;
+
+typedef uintptr_t sys_log_arg_t;
+
+typedef struct {
+  uint32_t timestamp_us;
+  uint16_t id;
+  uint8_t arg_count;
+  sys_log_arg_t args[SYS_LOG_MAX_ARGS];
+} sys_log_record_t;
+
+static inline sys_log_arg_t sys_log_f32(float value) {
+  uint32_t bits = 0u;
+
+  memcpy(&bits, &value, sizeof(bits));
+  return (sys_log_arg_t)bits;
+}
+
+#define SYS_LOG_U32(value) ((sys_log_arg_t)(uint32_t)(value))
+#define SYS_LOG_I32(value) ((sys_log_arg_t)(uint32_t)(int32_t)(value))
+#define SYS_LOG_F32(value) sys_log_f32((float)(value))
+#define SYS_LOG_STR(value) ((sys_log_arg_t)(const char *)(value))
+
+/* SYS_LOG(id, SYS_LOG_U32(a), SYS_LOG_STR(b), ...); at least one arg. */
+#define SYS_LOG(id, ...)                                                       \
+  sys_log_write((id), (const sys_log_arg_t[]){__VA_ARGS__},                    \
+                sizeof((const sys_log_arg_t[]){__VA_ARGS__}) /                 \
+                    sizeof(sys_log_arg_t))
+
+/* Safe from tasks and ISRs; false when the record was dropped. */
+bool sys_log_write(sys_log_id_t id, const sys_log_arg_t *args,
+                   size_t arg_count);
+
+/* Single consumer (the log task): pops the oldest complete record. */
+bool sys_log_read(sys_log_record_t *out_record);
+
+/* printf-style expansion of a record, without a trailing newline. */
+size_t sys_log_format(const sys_log_record_t *record, char *out,
+                      size_t out_size);
+
+/* Records dropped on a full ring since boot. */
+uint32_t sys_log_dropped(void);
+
+#endif
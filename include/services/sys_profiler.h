@@ -0,0 +1,79 @@
+#ifndef SYS_PROFILER_H
+#define SYS_PROFILER_H
+
+#include "app/app_config.h"
+#include "services/sys_histogram.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#if APP_ENABLE_PROFILER
+#include "hardware/structs/m33.h"
+#endif
+
+/*
+ * Cycle-accurate hot-path probes on the Cortex-M33 DWT cycle counter.
+ * Each probe keeps a sys_histogram_t of its durations in cycles, from
+ * which p50/p99 are read as log2 bucket upper bounds. Recording masks
+ * interrupts for a handful of instructions, so probes may sit in tasks
+ * and ISRs alike.
+ *
+ * With APP_ENABLE_PROFILER 0 the SYS_PROFILE_* macros expand to nothing
+ * and snapshots report enabled = false.
+ */
+
+typedef enum {
+  SYS_PROFILE_CONTROL_STEP = 0,
+  SYS_PROFILE_METRICS_UPDATE,
+  SYS_PROFILE_ADP910_READ,
+  SYS_PROFILE_STATUS_JSON,
+  SYS_PROFILE_ZERO_CROSS_ISR,
+  SYS_PROFILE_PROBE_COUNT,
+} sys_profile_probe_t;
+
+typedef struct {
+  bool enabled;
+  /* False when the core reports no cycle counter (DWT_CTRL.NOCYCCNT). */
+  bool cycle_counter;
+  uint32_t cpu_hz;
+  sys_histogram_t probes[SYS_PROFILE_PROBE_COUNT];
+} sys_profiler_snapshot_t;
+
+#if APP_ENABLE_PROFILER
+
+static inline uint32_t sys_profiler_cycles(void) {
+  return m33_hw->dwt_cyccnt;
+}
+
+void sys_profiler_record(sys_profile_probe_t probe, uint32_t cycles);
+
+/* Probes must pair within one block; nesting different probes is fine. */
+#define SYS_PROFILE_BEGIN(probe)                                               \
+  const uint32_t sys_profile_start_##probe = sys_profiler_cycles()
+#define SYS_PROFILE_END(probe)                                                 \
+  sys_profiler_record((probe),                                                 \
+                      sys_profiler_cycles() - sys_profile_start_##probe)
+
+#else
+
+#define SYS_PROFILE_BEGIN(probe)                                               \
+  do {                                                                         \
+  } while (0)
+#define SYS_PROFILE_END(probe)                                                 \
+  do {                                                                         \
+  } while (0)
+
+#endif
+
+/* Enables the DWT cycle counter. Call once before the scheduler starts. */
+void sys_profiler_init(void);
+
+void sys_profiler_get_snapshot(sys_profiler_snapshot_t *out_snapshot);
+
+void sys_profiler_reset(void);
+
+const char *sys_profiler_probe_name(sys_profile_probe_t probe);
+
+/* One line per probe with samples, in microseconds, on the deferred log. */
+void sys_profiler_print(void);
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef SYS_TASK_STATS_H
+#define SYS_TASK_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Per-task CPU share, stack high-water marks and heap_4 statistics, for
+ * sizing task stacks and the heap from measurements instead of guesses.
+ * Run time comes from configGENERATE_RUN_TIME_STATS on the 1 MHz system
+ * timer; CPU share is computed over the window since the previous
+ * collect, so the 32-bit counter wrapping (~71 min) does not matter.
+ * Cumulative run time is folded into 64-bit per-task totals on every
+ * snapshot and sys_task_stats_refresh(), which therefore has to run more
+ * often than the counter wraps.
+ */
+
+#define SYS_TASK_STATS_MAX_TASKS 16u
+#define SYS_TASK_STATS_NAME_LEN 16u
+
+typedef struct {
+  char name[SYS_TASK_STATS_NAME_LEN];
+  uint32_t number;
+  uint8_t state;
+  uint8_t priority;
+  uint8_t base_priority;
+  bool idle;
+  /* 0 when the task was not created by this firmware. */
+  uint32_t stack_size_words;
+  uint32_t stack_high_water_words;
+  /* Raw kernel counter, wraps every ~71.6 min. */
+  uint32_t run_time_us;
+  /* Since the task was created; does not wrap. */
+  uint64_t total_run_time_us;
+  uint16_t cpu_permille;
+} sys_task_stats_task_t;
+
+typedef struct {
+  uint32_t total_bytes;
+  uint32_t free_bytes;
+  uint32_t min_ever_free_bytes;
+  uint32_t largest_free_block_bytes;
+  uint32_t smallest_free_block_bytes;
+  uint32_t free_blocks;
+  uint32_t allocations;
+  uint32_t frees;
+  /* 1 - largest free block / free bytes. */
+  uint16_t fragmentation_permille;
+} sys_task_stats_heap_t;
+
+typedef struct {
+  uint32_t window_us;
+  uint16_t cpu_load_permille;
+  uint32_t task_count;
+  /* Tasks beyond SYS_TASK_STATS_MAX_TASKS are not reported. */
+  bool truncated;
+  sys_task_stats_task_t tasks[SYS_TASK_STATS_MAX_TASKS];
+  sys_task_stats_heap_t heap;
+} sys_task_stats_snapshot_t;
+
+/*
+ * Fills a snapshot and starts the next CPU window. Keeps the previous
+ * counters in static storage: call from one task only (the web server).
+ */
+void sys_task_stats_collect(sys_task_stats_snapshot_t *out_snapshot);
+
+/*
+ * Same snapshot without starting a new window, for consumers that only
+ * need cumulative run time, stacks and heap (/metrics). CPU shares are
+ * over the still-open window. Same single-task rule.
+ */
+void sys_task_stats_read(sys_task_stats_snapshot_t *out_snapshot);
+
+/*
+ * Folds the run-time counters into the 64-bit totals without building a
+ * snapshot. The web server calls it every APP_TASK_STATS_REFRESH_PERIOD_MS
+ * so the totals hold between scrapes. Same single-task rule.
+ */
+void sys_task_stats_refresh(void);
+
+const char *sys_task_stats_state_name(uint8_t state);
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef SYS_TRACE_H
+#define SYS_TRACE_H
+
+#include "app/app_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Binary event trace for scheduling timelines. Fixed 8-byte records go
+ * into a RAM ring of APP_TRACE_BUFFER_EVENTS entries, overwriting the
+ * oldest: task switches from the FreeRTOS traceTASK_SWITCHED_IN hook,
+ * dimmer ISR entry/exit and custom spans and instants with a 16-bit
+ * payload. Writers claim a slot with one atomic increment, so tasks,
+ * PendSV and ISRs record without masking interrupts.
+ *
+ * GET /api/sys/trace freezes the ring and downloads it;
+ * scripts/trace_to_perfetto.py converts the dump to Chrome/Perfetto JSON.
+ * The ids below are part of that format: append only, and mirror new
+ * names in the script.
+ *
+ * With APP_ENABLE_TRACE 0 the SYS_TRACE_* macros expand to nothing and
+ * the hooks return at once.
+ */
+
+#define SYS_TRACE_MAGIC "BDTR"
+#define SYS_TRACE_FORMAT_VERSION 1u
+#define SYS_TRACE_MAX_TASKS 16u
+#define SYS_TRACE_TASK_NAME_LEN 16u
+
+typedef enum {
+  /*
+   * payload: task number, unique from 1, assigned by
+   * sys_trace_task_created with vTaskSetTaskNumber.
+   */
+  SYS_TRACE_TYPE_TASK_SWITCH = 1,
+  SYS_TRACE_TYPE_ISR_ENTER,
+  SYS_TRACE_TYPE_ISR_EXIT,
+  SYS_TRACE_TYPE_SPAN_BEGIN,
+  SYS_TRACE_TYPE_SPAN_END,
+  SYS_TRACE_TYPE_INSTANT,
+} sys_trace_type_t;
+
+typedef enum {
+  SYS_TRACE_ISR_ZERO_CROSS = 0,
+  SYS_TRACE_ISR_GATE_ALARM,
+} sys_trace_isr_t;
+
+typedef enum {
+  SYS_TRACE_SPAN_CONTROL_STEP = 0,
+  SYS_TRACE_SPAN_ADP910_READ,
+  SYS_TRACE_SPAN_METRICS_UPDATE,
+  SYS_TRACE_SPAN_HTTP_REQUEST,
+  SYS_TRACE_SPAN_SSE_PUSH,
+} sys_trace_span_t;
+
+typedef enum {
+  /* payload: power percent handed to the dimmer ISRs. */
+  SYS_TRACE_INSTANT_POWER_COMMAND = 0,
+} sys_trace_instant_t;
+
+typedef struct {
+  uint32_t timestamp_us;
+  uint8_t type;
+  uint8_t id;
+  uint16_t payload;
+} sys_trace_event_t;
+
+typedef struct {
+  uint32_t number;
+  char name[SYS_TRACE_TASK_NAME_LEN];
+} sys_trace_task_t;
+
+/* Frozen ring, oldest event first, split where the ring wraps. */
+typedef struct {
+  bool enabled;
+  uint32_t now_us;
+  /* Events lost to wrap-around and while frozen since the last reset. */
+  uint32_t overwritten;
+  uint32_t missed;
+  const sys_trace_event_t *segments[2];
+  uint32_t segment_counts[2];
+  uint32_t task_count;
+  sys_trace_task_t tasks[SYS_TRACE_MAX_TASKS];
+} sys_trace_dump_t;
+
+#if APP_ENABLE_TRACE
+
+void sys_trace_record(sys_trace_type_t type, uint8_t id, uint16_t payload);
+
+#define SYS_TRACE_ISR_ENTER(isr)                                               \
+  sys_trace_record(SYS_TRACE_TYPE_ISR_ENTER, (isr), 0u)
+#define SYS_TRACE_ISR_EXIT(isr)                                                \
+  sys_trace_record(SYS_TRACE_TYPE_ISR_EXIT, (isr), 0u)
+#define SYS_TRACE_SPAN_BEGIN(span)                                             \
+  sys_trace_record(SYS_TRACE_TYPE_SPAN_BEGIN, (span), 0u)
+#define SYS_TRACE_SPAN_END(span)                                               \
+  sys_trace_record(SYS_TRACE_TYPE_SPAN_END, (span), 0u)
+#define SYS_TRACE_INSTANT(instant, payload)                                    \
+  sys_trace_record(SYS_TRACE_TYPE_INSTANT, (instant), (uint16_t)(payload))
+
+#else
+
+#define SYS_TRACE_ISR_ENTER(isr)                                               \
+  do {                                                                         \
+  } while (0)
+#define SYS_TRACE_ISR_EXIT(isr)                                                \
+  do {                                                                         \
+  } while (0)
+#define SYS_TRACE_SPAN_BEGIN(span)                                             \
+  do {                                                                         \
+  } while (0)
+#define SYS_TRACE_SPAN_END(span)                                               \
+  do {                                                                         \
+  } while (0)
+#define SYS_TRACE_INSTANT(instant, payload)                                    \
+  do {                                                                         \
+  } while (0)
+
+#endif
+
+/* FreeRTOS trace hooks, wired up in FreeRTOSConfig.h. */
+void sys_trace_task_switched_in(void);
+void sys_trace_task_created(void *task);
+
+/*
+ * Stops recording, waits briefly for writers already inside
+ * sys_trace_record and describes the ring. The segments stay valid
+ * until sys_trace_thaw().
+ */
+void sys_trace_freeze(sys_trace_dump_t *out_dump);
+
+void sys_trace_thaw(void);
+
+/*
+ * Copies up to max_events of the newest events, oldest first, without
+ * freezing or blocking; for fault handlers. Returns the number copied.
+ */
+uint32_t sys_trace_copy_recent(sys_trace_event_t *out_events,
+                               uint32_t max_events);
+
+/* Drops all recorded events; task names are kept. */
+void sys_trace_reset(void);
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef SYS_WATCHDOG_H
+#define SYS_WATCHDOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Task supervision on the RP2350 hardware watchdog. Each supervised task
+ * owns a slot with a heartbeat deadline (from the task_bootstrap.c table)
+ * and calls sys_watchdog_heartbeat() once per loop. WatchdogTask polls
+ * the slots and feeds the hardware watchdog only while every deadline
+ * holds. On the first miss it forces the TRIAC gate off, records a crash
+ * dump naming the stalled task and stops feeding, so the chip resets
+ * APP_WATCHDOG_TIMEOUT_MS later. Miss counts survive those resets.
+ */
+
+typedef enum {
+  SYS_WATCHDOG_SLOT_WIFI = 0,
+  SYS_WATCHDOG_SLOT_DIMMER,
+  SYS_WATCHDOG_SLOT_ADP910,
+  SYS_WATCHDOG_SLOT_LOG,
+  SYS_WATCHDOG_SLOT_COUNT,
+} sys_watchdog_slot_t;
+
+typedef struct {
+  const char *name;
+  bool registered;
+  uint32_t deadline_ms;
+  uint32_t last_beat_age_ms;
+  /* Longest interval between two heartbeats since registration. */
+  uint32_t max_gap_ms;
+  /* Since power-on, carried across watchdog resets. */
+  uint32_t deadline_misses;
+} sys_watchdog_task_snapshot_t;
+
+typedef struct {
+  bool running;
+  bool tripped;
+  bool released;
+  bool reset_by_watchdog;
+  uint32_t timeout_ms;
+  uint32_t check_period_ms;
+  uint32_t feeds;
+  uint32_t trips;
+  sys_watchdog_task_snapshot_t tasks[SYS_WATCHDOG_SLOT_COUNT];
+} sys_watchdog_snapshot_t;
+
+/* Before the scheduler: keeps or clears the miss counts of the last boot. */
+void sys_watchdog_init(void);
+
+/* Starts supervising slot; deadline_ms 0 leaves it unsupervised. */
+void sys_watchdog_register(sys_watchdog_slot_t slot, const char *name,
+                           uint32_t deadline_ms);
+
+/* For deliberate task exits (vTaskDelete), which are not hangs. */
+void sys_watchdog_unregister(sys_watchdog_slot_t slot);
+
+void sys_watchdog_heartbeat(sys_watchdog_slot_t slot);
+
+/* WatchdogTask: arms the hardware watchdog, then one poll per period. */
+void sys_watchdog_start(void);
+bool sys_watchdog_poll(void);
+
+/*
+ * Disarms the hardware watchdog for good, for work that runs with
+ * interrupts off and ends in its own reboot (OTA image copy).
+ */
+void sys_watchdog_release(void);
+
+void sys_watchdog_get_snapshot(sys_watchdog_snapshot_t *out_snapshot);
+
+#endif
@@ -4,5 +4,7 @@
 void wifi_task_entry(void *params);
 void dimmer_task_entry(void *params);
 void adp910_sampling_task_entry(void *params);
+void log_task_entry(void *params);
+void watchdog_task_entry(void *params);
 
 #endif
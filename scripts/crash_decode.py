@@ -0,0 +1,247 @@
+#!/usr/bin/env python3
+
+from __future__ import annotations
+
+import argparse
+import json
+import pathlib
+import shutil
+import subprocess
+import sys
+import urllib.error
+import urllib.request
+
+from trace_to_perfetto import (
+    INSTANT_NAMES,
+    ISR_NAMES,
+    SPAN_NAMES,
+    TYPE_INSTANT,
+    TYPE_ISR_ENTER,
+    TYPE_ISR_EXIT,
+    TYPE_SPAN_BEGIN,
+    TYPE_SPAN_END,
+    TYPE_TASK_SWITCH,
+    name_of,
+)
+
+# RP2350 XIP flash window; only addresses in it can be code.
+FLASH_START = 0x10000000
+FLASH_END = 0x10400000
+
+CFSR_BITS = {
+    0: "IACCVIOL",
+    1: "DACCVIOL",
+    3: "MUNSTKERR",
+    4: "MSTKERR",
+    5: "MLSPERR",
+    7: "MMARVALID",
+    8: "IBUSERR",
+    9: "PRECISERR",
+    10: "IMPRECISERR",
+    11: "UNSTKERR",
+    12: "STKERR",
+    13: "LSPERR",
+    15: "BFARVALID",
+    16: "UNDEFINSTR",
+    17: "INVSTATE",
+    18: "INVPC",
+    19: "NOCP",
+    20: "STKOF",
+    24: "UNALIGNED",
+    25: "DIVBYZERO",
+}
+HFSR_BITS = {1: "VECTTBL", 30: "FORCED", 31: "DEBUGEVT"}
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(
+        description="Decode a Blower Pico /api/sys/crash dump against the firmware ELF"
+    )
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument(
+        "--host",
+        help="Target host or URL to fetch the dump from (example: 192.168.0.31)",
+    )
+    source.add_argument(
+        "--file",
+        help="JSON previously saved from /api/sys/crash",
+    )
+    parser.add_argument(
+        "--elf",
+        help="Firmware ELF of the crashed build (example: build/blower_pico_c.elf)",
+    )
+    parser.add_argument(
+        "--addr2line",
+        default="arm-none-eabi-addr2line",
+        help="addr2line binary (default: arm-none-eabi-addr2line)",
+    )
+    parser.add_argument(
+        "--clear",
+        action="store_true",
+        help="Clear the dump on the target after fetching it",
+    )
+    parser.add_argument(
+        "--timeout",
+        type=float,
+        default=15.0,
+        help="HTTP timeout in seconds (default: 15)",
+    )
+    return parser.parse_args()
+
+
+def normalize_base_url(host: str) -> str:
+    value = host.strip()
+    if value.startswith("http://") or value.startswith("https://"):
+        return value.rstrip("/")
+    return f"http://{value.rstrip('/')}"
+
+
+def fetch_json(base_url: str, path: str, method: str, timeout: float) -> dict:
+    request = urllib.request.Request(f"{base_url}{path}", method=method)
+    with urllib.request.urlopen(request, timeout=timeout) as response:
+        return json.loads(response.read().decode("utf-8", errors="replace"))
+
+
+def decode_bits(value: int, names: dict[int, str]) -> str:
+    flags = [name for bit, name in names.items() if value & (1 << bit)]
+    return " ".join(flags) if flags else "-"
+
+
+def is_code_address(value: int) -> bool:
+    return FLASH_START <= value < FLASH_END
+
+
+def resolve(addr2line: str, elf: str | None, addresses: list[int]) -> dict[int, str]:
+    if not elf or not addresses or shutil.which(addr2line) is None:
+        return {}
+    # Clear the Thumb bit; return addresses point after the call.
+    queries = [f"0x{address & ~1:08x}" for address in addresses]
+    result = subprocess.run(
+        [addr2line, "-e", elf, "-f", "-C", "-p", *queries],
+        check=False,
+        capture_output=True,
+        text=True,
+    )
+    lines = result.stdout.splitlines()
+    return {address: line for address, line in zip(addresses, lines)}
+
+
+def describe_trace_event(event: dict) -> str:
+    event_type = event.get("type", 0)
+    event_id = event.get("id", 0)
+    payload = event.get("payload", 0)
+    if event_type == TYPE_TASK_SWITCH:
+        return f"task_switch task={payload}"
+    if event_type in (TYPE_ISR_ENTER, TYPE_ISR_EXIT):
+        edge = "enter" if event_type == TYPE_ISR_ENTER else "exit"
+        return f"isr_{edge} {name_of(ISR_NAMES, 'isr', event_id)}"
+    if event_type in (TYPE_SPAN_BEGIN, TYPE_SPAN_END):
+        edge = "begin" if event_type == TYPE_SPAN_BEGIN else "end"
+        return f"span_{edge} {name_of(SPAN_NAMES, 'span', event_id)}"
+    if event_type == TYPE_INSTANT:
+        return f"{name_of(INSTANT_NAMES, 'instant', event_id)} value={payload}"
+    return f"type={event_type} id={event_id} payload={payload}"
+
+
+def print_report(dump: dict, addr2line: str, elf: str | None) -> None:
+    registers = {key: int(value, 16) for key, value in dump.get("registers", {}).items()}
+    fault_status = {
+        key: int(value, 16) for key, value in dump.get("fault_status", {}).items()
+    }
+    stack = [int(word, 16) for word in dump.get("stack", [])]
+    stack_address = int(dump.get("stack_address", "0x0"), 16)
+
+    code_addresses = sorted(
+        {
+            value
+            for value in [registers.get("pc", 0), registers.get("lr", 0), *stack]
+            if is_code_address(value)
+        }
+    )
+    symbols = resolve(addr2line, elf, code_addresses)
+
+    def symbol(value: int) -> str:
+        return f"  {symbols[value]}" if value in symbols else ""
+
+    print(f"Reason:   {dump.get('reason')} ({dump.get('message', '')})")
+    print(f"Task:     {dump.get('task') or '-'}")
+    print(f"Firmware: {dump.get('firmware_version')}")
+    print(f"Uptime:   {dump.get('uptime_us', 0) / 1e6:.3f} s")
+    if elf is None:
+        print("(pass --elf of the same firmware version to resolve symbols)")
+    elif not symbols and code_addresses:
+        print(f"(symbols unavailable: is {addr2line} installed?)")
+
+    if dump.get("has_frame"):
+        print("\nRegisters:")
+        for name in ("pc", "lr", "r0", "r1", "r2", "r3", "r12", "xpsr", "exc_return"):
+            value = registers.get(name, 0)
+            print(f"  {name:<10} 0x{value:08x}{symbol(value)}")
+    else:
+        print("\nNo exception frame (software failure).")
+
+    cfsr = fault_status.get("cfsr", 0)
+    hfsr = fault_status.get("hfsr", 0)
+    print("\nFault status:")
+    print(f"  CFSR  0x{cfsr:08x}  {decode_bits(cfsr, CFSR_BITS)}")
+    print(f"  HFSR  0x{hfsr:08x}  {decode_bits(hfsr, HFSR_BITS)}")
+    if cfsr & (1 << 7):
+        print(f"  MMFAR 0x{fault_status.get('mmfar', 0):08x}")
+    if cfsr & (1 << 15):
+        print(f"  BFAR  0x{fault_status.get('bfar', 0):08x}")
+
+    if stack:
+        print(f"\nStack at 0x{stack_address:08x} (code addresses are call candidates):")
+        for index, word in enumerate(stack):
+            if is_code_address(word):
+                print(f"  +0x{index * 4:03x}  0x{word:08x}{symbol(word)}")
+
+    trace = dump.get("trace", [])
+    if trace:
+        last = trace[-1].get("t_us", 0)
+        print("\nLast trace events (µs before the last one):")
+        for event in trace:
+            delta = (last - event.get("t_us", 0)) & 0xFFFFFFFF
+            print(f"  -{delta:>8}  {describe_trace_event(event)}")
+
+    log_tail = dump.get("log_tail", "")
+    if log_tail:
+        print("\nLog tail:")
+        for line in log_tail.splitlines():
+            print(f"  {line}")
+
+
+def main() -> int:
+    args = parse_args()
+
+    try:
+        if args.host:
+            base_url = normalize_base_url(args.host)
+            dump = fetch_json(base_url, "/api/sys/crash", "GET", args.timeout)
+        else:
+            dump = json.loads(pathlib.Path(args.file).expanduser().read_text(encoding="utf-8"))
+    except urllib.error.HTTPError as exc:
+        error_body = exc.read().decode("utf-8", errors="replace")
+        print(f"Error: HTTP {exc.code} on {exc.url}: {error_body}", file=sys.stderr)
+        return 1
+    except (urllib.error.URLError, OSError, json.JSONDecodeError) as exc:
+        print(f"Error: cannot read crash dump: {exc}", file=sys.stderr)
+        return 1
+
+    if not dump.get("present"):
+        print("No crash dump recorded on the previous boot.")
+        return 0
+
+    print_report(dump, args.addr2line, args.elf)
+
+    if args.host and args.clear:
+        try:
+            fetch_json(base_url, "/api/sys/crash/clear", "POST", args.timeout)
+            print("\nDump cleared on target.")
+        except urllib.error.URLError as exc:
+            print(f"Warning: clear failed: {exc}", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,312 @@
+#!/usr/bin/env python3
+
+from __future__ import annotations
+
+import argparse
+import json
+import pathlib
+import struct
+import sys
+import urllib.error
+import urllib.request
+
+# Mirrors include/services/sys_trace.h; ids are append only.
+TRACE_MAGIC = b"BDTR"
+TRACE_FORMAT_VERSION = 1
+HEADER_FORMAT = "<4sHHIIIIHHI"
+EVENT_FORMAT = "<IBBH"
+
+TYPE_TASK_SWITCH = 1
+TYPE_ISR_ENTER = 2
+TYPE_ISR_EXIT = 3
+TYPE_SPAN_BEGIN = 4
+TYPE_SPAN_END = 5
+TYPE_INSTANT = 6
+
+ISR_NAMES = ["zero_cross", "gate_alarm"]
+SPAN_NAMES = [
+    "control_step",
+    "adp910_read",
+    "metrics_update",
+    "http_request",
+    "sse_push",
+]
+INSTANT_NAMES = ["power_command"]
+
+PID = 1
+CPU_TID = 1
+ISR_TID = 2
+TASK_TID_BASE = 100
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(
+        description="Convert a Blower Pico /api/sys/trace dump to Chrome/Perfetto JSON"
+    )
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument(
+        "--host",
+        help="Target host or URL to download the trace from (example: 192.168.0.31)",
+    )
+    source.add_argument(
+        "--file",
+        help="Binary dump previously saved from /api/sys/trace",
+    )
+    parser.add_argument(
+        "--output",
+        default="trace.json",
+        help="Chrome trace JSON to write (default: trace.json)",
+    )
+    parser.add_argument(
+        "--save-raw",
+        help="Also keep the downloaded binary dump at this path",
+    )
+    parser.add_argument(
+        "--timeout",
+        type=float,
+        default=15.0,
+        help="HTTP timeout in seconds (default: 15)",
+    )
+    return parser.parse_args()
+
+
+def normalize_base_url(host: str) -> str:
+    value = host.strip()
+    if value.startswith("http://") or value.startswith("https://"):
+        return value.rstrip("/")
+    return f"http://{value.rstrip('/')}"
+
+
+def download_dump(base_url: str, timeout: float) -> bytes:
+    request = urllib.request.Request(f"{base_url}/api/sys/trace", method="GET")
+    with urllib.request.urlopen(request, timeout=timeout) as response:
+        return response.read()
+
+
+def name_of(names: list[str], kind: str, index: int) -> str:
+    if index < len(names):
+        return names[index]
+    return f"{kind}_{index}"
+
+
+def parse_dump(data: bytes) -> tuple[dict, dict[int, str], list[tuple]]:
+    header_size = struct.calcsize(HEADER_FORMAT)
+    if len(data) < header_size:
+        raise ValueError("dump shorter than its header")
+    (
+        magic,
+        version,
+        event_size,
+        event_count,
+        overwritten,
+        missed,
+        now_us,
+        task_count,
+        task_size,
+        capacity,
+    ) = struct.unpack_from(HEADER_FORMAT, data, 0)
+    if magic != TRACE_MAGIC:
+        raise ValueError(f"bad magic {magic!r}")
+    if version != TRACE_FORMAT_VERSION:
+        raise ValueError(f"unsupported trace format version {version}")
+    if event_size != struct.calcsize(EVENT_FORMAT):
+        raise ValueError(f"unexpected event size {event_size}")
+
+    offset = header_size
+    tasks: dict[int, str] = {}
+    for _ in range(task_count):
+        (number,) = struct.unpack_from("<I", data, offset)
+        raw_name = data[offset + 4 : offset + task_size]
+        name = raw_name.split(b"\0", 1)[0].decode("ascii", "replace")
+        # Tracks are keyed by number; a repeat would merge two tasks.
+        if number == 0 or number in tasks:
+            raise ValueError(
+                f"task {name!r} has number {number}, already used or unset"
+            )
+        tasks[number] = name
+        offset += task_size
+
+    if len(data) < offset + event_count * event_size:
+        raise ValueError("dump truncated")
+    events = [
+        struct.unpack_from(EVENT_FORMAT, data, offset + index * event_size)
+        for index in range(event_count)
+    ]
+    info = {
+        "event_count": event_count,
+        "overwritten": overwritten,
+        "missed": missed,
+        "now_us": now_us,
+        "capacity": capacity,
+    }
+    return info, tasks, events
+
+
+def convert(tasks: dict[int, str], events: list[tuple]) -> list[dict]:
+    output: list[dict] = []
+    open_spans: dict[tuple[int, str], int] = {}
+    isr_depth: dict[str, int] = {}
+    seen_tids: dict[int, str] = {CPU_TID: "CPU (running task)", ISR_TID: "ISR"}
+    current_task: int | None = None
+    switch_ts = 0
+    previous_raw: int | None = None
+    ts = 0
+
+    def task_name(number: int) -> str:
+        return tasks.get(number, f"task_{number}")
+
+    def task_tid(number: int | None) -> int:
+        if number is None:
+            return CPU_TID
+        tid = TASK_TID_BASE + number
+        seen_tids.setdefault(tid, task_name(number))
+        return tid
+
+    for raw_ts, event_type, event_id, payload in events:
+        # 32-bit microsecond counter; the ring spans far less than a wrap.
+        if previous_raw is not None:
+            ts += (raw_ts - previous_raw) & 0xFFFFFFFF
+        previous_raw = raw_ts
+
+        if event_type == TYPE_TASK_SWITCH:
+            if current_task is not None and ts > switch_ts:
+                output.append(
+                    {
+                        "name": task_name(current_task),
+                        "ph": "X",
+                        "ts": switch_ts,
+                        "dur": ts - switch_ts,
+                        "pid": PID,
+                        "tid": CPU_TID,
+                    }
+                )
+            current_task = payload
+            switch_ts = ts
+        elif event_type in (TYPE_ISR_ENTER, TYPE_ISR_EXIT):
+            name = name_of(ISR_NAMES, "isr", event_id)
+            depth = isr_depth.get(name, 0)
+            if event_type == TYPE_ISR_EXIT and depth == 0:
+                continue
+            isr_depth[name] = depth + (1 if event_type == TYPE_ISR_ENTER else -1)
+            output.append(
+                {
+                    "name": name,
+                    "ph": "B" if event_type == TYPE_ISR_ENTER else "E",
+                    "ts": ts,
+                    "pid": PID,
+                    "tid": ISR_TID,
+                }
+            )
+        elif event_type in (TYPE_SPAN_BEGIN, TYPE_SPAN_END):
+            # Spans run in task context: the task switched in last owns them.
+            tid = task_tid(current_task)
+            name = name_of(SPAN_NAMES, "span", event_id)
+            depth = open_spans.get((tid, name), 0)
+            if event_type == TYPE_SPAN_END and depth == 0:
+                continue
+            open_spans[(tid, name)] = depth + (
+                1 if event_type == TYPE_SPAN_BEGIN else -1
+            )
+            output.append(
+                {
+                    "name": name,
+                    "ph": "B" if event_type == TYPE_SPAN_BEGIN else "E",
+                    "ts": ts,
+                    "pid": PID,
+                    "tid": tid,
+                }
+            )
+        elif event_type == TYPE_INSTANT:
+            output.append(
+                {
+                    "name": name_of(INSTANT_NAMES, "instant", event_id),
+                    "ph": "i",
+                    "s": "t",
+                    "ts": ts,
+                    "pid": PID,
+                    "tid": task_tid(current_task),
+                    "args": {"value": payload},
+                }
+            )
+
+    if current_task is not None and ts > switch_ts:
+        output.append(
+            {
+                "name": task_name(current_task),
+                "ph": "X",
+                "ts": switch_ts,
+                "dur": ts - switch_ts,
+                "pid": PID,
+                "tid": CPU_TID,
+            }
+        )
+    for name, depth in isr_depth.items():
+        output.extend(
+            {"name": name, "ph": "E", "ts": ts, "pid": PID, "tid": ISR_TID}
+            for _ in range(depth)
+        )
+    for (tid, name), depth in open_spans.items():
+        output.extend(
+            {"name": name, "ph": "E", "ts": ts, "pid": PID, "tid": tid}
+            for _ in range(depth)
+        )
+
+    output.append(
+        {"name": "process_name", "ph": "M", "pid": PID, "args": {"name": "RP2350"}}
+    )
+    for tid, name in seen_tids.items():
+        output.append(
+            {
+                "name": "thread_name",
+                "ph": "M",
+                "pid": PID,
+                "tid": tid,
+                "args": {"name": name},
+            }
+        )
+    return output
+
+
+def main() -> int:
+    args = parse_args()
+
+    try:
+        if args.host:
+            data = download_dump(normalize_base_url(args.host), args.timeout)
+            if args.save_raw:
+                pathlib.Path(args.save_raw).expanduser().write_bytes(data)
+        else:
+            data = pathlib.Path(args.file).expanduser().read_bytes()
+    except urllib.error.HTTPError as exc:
+        error_body = exc.read().decode("utf-8", errors="replace")
+        print(f"Error: HTTP {exc.code} on {exc.url}: {error_body}", file=sys.stderr)
+        return 1
+    except (urllib.error.URLError, OSError) as exc:
+        print(f"Error: cannot read trace: {exc}", file=sys.stderr)
+        return 1
+
+    try:
+        info, tasks, events = parse_dump(data)
+    except (ValueError, struct.error) as exc:
+        print(f"Error: invalid trace dump: {exc}", file=sys.stderr)
+        return 1
+
+    trace = {
+        "traceEvents": convert(tasks, events),
+        "displayTimeUnit": "ms",
+        "metadata": info,
+    }
+    output_path = pathlib.Path(args.output).expanduser()
+    output_path.write_text(json.dumps(trace, separators=(",", ":")), encoding="utf-8")
+
+    print(
+        f"Events: {info['event_count']}/{info['capacity']} "
+        f"(overwritten {info['overwritten']}, missed {info['missed']})"
+    )
+    print(f"Tasks: {', '.join(tasks.values()) or 'none'}")
+    print(f"Wrote {output_path} (open in https://ui.perfetto.dev)")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -1,6 +1,7 @@
 #include "app/task_bootstrap.h"
 
 #include "app/app_config.h"
+#include "services/sys_watchdog.h"
 #include "tasks/task_entries.h"
 #include "task.h"
 #include <stddef.h>
@@ -11,6 +12,9 @@ typedef struct {
   configSTACK_DEPTH_TYPE stack_depth_words;
   UBaseType_t priority;
   void *parameters;
+  /* sys_watchdog deadline for heartbeat_slot; 0 leaves it unsupervised. */
+  uint32_t heartbeat_deadline_ms;
+  sys_watchdog_slot_t heartbeat_slot;
 } app_task_definition_t;
 
 static const app_task_definition_t k_default_tasks[] = {
@@ -21,6 +25,8 @@ static const app_task_definition_t k_default_tasks[] = {
         .stack_depth_words = APP_WIFI_TASK_STACK_WORDS,
         .priority = APP_WIFI_TASK_PRIORITY,
         .parameters = NULL,
+        .heartbeat_deadline_ms = APP_WIFI_HEARTBEAT_DEADLINE_MS,
+        .heartbeat_slot = SYS_WATCHDOG_SLOT_WIFI,
     },
 #endif
 #if APP_ENABLE_DIMMER_TASK
@@ -30,6 +36,8 @@ static const app_task_definition_t k_default_tasks[] = {
         .stack_depth_words = APP_DIMMER_TASK_STACK_WORDS,
         .priority = APP_DIMMER_TASK_PRIORITY,
         .parameters = NULL,
+        .heartbeat_deadline_ms = APP_DIMMER_HEARTBEAT_DEADLINE_MS,
+        .heartbeat_slot = SYS_WATCHDOG_SLOT_DIMMER,
     },
 #endif
 #if APP_ENABLE_ADP910_TASK
@@ -39,6 +47,30 @@ static const app_task_definition_t k_default_tasks[] = {
         .stack_depth_words = APP_ADP910_TASK_STACK_WORDS,
         .priority = APP_ADP910_TASK_PRIORITY,
         .parameters = NULL,
+        .heartbeat_deadline_ms = APP_ADP910_HEARTBEAT_DEADLINE_MS,
+        .heartbeat_slot = SYS_WATCHDOG_SLOT_ADP910,
+    },
+#endif
+#if APP_ENABLE_LOG_TASK
+    {
+        .entry_point = log_task_entry,
+        .task_name = "LogTask",
+        .stack_depth_words = APP_LOG_TASK_STACK_WORDS,
+        .priority = APP_LOG_TASK_PRIORITY,
+        .parameters = NULL,
+        .heartbeat_deadline_ms = APP_LOG_HEARTBEAT_DEADLINE_MS,
+        .heartbeat_slot = SYS_WATCHDOG_SLOT_LOG,
+    },
+#endif
+#if APP_ENABLE_WATCHDOG_TASK
+    {
+        .entry_point = watchdog_task_entry,
+        .task_name = "WatchdogTask",
+        .stack_depth_words = APP_WATCHDOG_TASK_STACK_WORDS,
+        .priority = APP_WATCHDOG_TASK_PRIORITY,
+        .parameters = NULL,
+        .heartbeat_deadline_ms = 0u,
+        .heartbeat_slot = SYS_WATCHDOG_SLOT_COUNT,
     },
 #endif
 };
@@ -49,6 +81,10 @@ BaseType_t app_create_default_tasks(void) {
 
   for (index = 0; index < task_count; ++index) {
     const app_task_definition_t *definition = &k_default_tasks[index];
+    if (definition->heartbeat_deadline_ms > 0u) {
+      sys_watchdog_register(definition->heartbeat_slot, definition->task_name,
+                            definition->heartbeat_deadline_ms);
+    }
     if (xTaskCreate(definition->entry_point, definition->task_name,
                     definition->stack_depth_words, definition->parameters,
                     definition->priority, NULL) != pdPASS) {
@@ -13,11 +13,10 @@
 #define ADP910_FIRST_SAMPLE_DELAY_MS 20u
 #define ADP910_STABILIZATION_SAMPLE_COUNT 3u
 #define ADP910_STABILIZATION_DELAY_MS 10u
-#define ADP910_IO_RETRY_COUNT 3u
+#define ADP910_INIT_RETRY_DELAY_MS 1000u
 #define ADP910_IO_TIMEOUT_MIN_US 5000u
 #define ADP910_IO_TIMEOUT_MAX_US 60000u
 #define ADP910_IO_TIMEOUT_MARGIN_US 2000u
-#define ADP910_RETRY_DELAY_MS 2u
 
 static uint8_t adp910_crc8(const uint8_t *data, uint8_t length) {
   uint8_t crc = 0xFFu;
@@ -107,7 +106,7 @@ static void adp910_recover_bus(const adp910_sensor_t *sensor) {
   gpio_set_dir(scl, GPIO_OUT);
   gpio_pull_up(scl);
   gpio_put(scl, true);
-  sleep_us(10u);
+  busy_wait_us_32(10u);
 
   /*
    * Clock SCL up to 9 times.  A stuck slave will shift out the rest
@@ -118,9 +117,9 @@ static void adp910_recover_bus(const adp910_sensor_t *sensor) {
       break; /* SDA released — bus is free */
     }
     gpio_put(scl, false);
-    sleep_us(5u);
+    busy_wait_us_32(5u);
     gpio_put(scl, true);
-    sleep_us(5u);
+    busy_wait_us_32(5u);
   }
 
   /*
@@ -129,20 +128,21 @@ static void adp910_recover_bus(const adp910_sensor_t *sensor) {
    */
   gpio_set_dir(sda, GPIO_OUT);
   gpio_put(sda, false);
-  sleep_us(5u);
+  busy_wait_us_32(5u);
   gpio_put(scl, true);
-  sleep_us(5u);
+  busy_wait_us_32(5u);
   gpio_put(sda, true);
-  sleep_us(10u);
+  busy_wait_us_32(10u);
 
-  /* Re-initialise the hardware I2C peripheral. */
+  /*
+   * Re-initialise the hardware I2C peripheral. Its next transfer is at
+   * least one poll later, so no settle delay is needed here.
+   */
   adp910_apply_i2c_config(sensor);
-  sleep_us(50u);
 }
 
 static int adp910_bus_write(adp910_sensor_t *sensor, const uint8_t *data,
                             size_t length) {
-  uint8_t attempt = 0u;
   int result = PICO_ERROR_GENERIC;
 
   if (sensor == NULL || data == NULL || length == 0u ||
@@ -150,26 +150,15 @@ static int adp910_bus_write(adp910_sensor_t *sensor, const uint8_t *data,
     return PICO_ERROR_GENERIC;
   }
 
-  for (attempt = 0u; attempt <= ADP910_IO_RETRY_COUNT; ++attempt) {
-    const uint32_t timeout_us = adp910_transfer_timeout_us(sensor, length);
-    result = i2c_write_timeout_us(sensor->port_config.i2c_instance,
-                                  sensor->port_config.i2c_address, data, length,
-                                  false, timeout_us);
-    sensor->last_bus_result = result;
-    if (result == (int)length) {
-      return result;
-    }
-    if (attempt < ADP910_IO_RETRY_COUNT) {
-      adp910_recover_bus(sensor);
-      sleep_ms(ADP910_RETRY_DELAY_MS);
-    }
-  }
-
+  result = i2c_write_timeout_us(sensor->port_config.i2c_instance,
+                                sensor->port_config.i2c_address, data, length,
+                                false,
+                                adp910_transfer_timeout_us(sensor, length));
+  sensor->last_bus_result = result;
   return result;
 }
 
 static int adp910_bus_read(adp910_sensor_t *sensor, uint8_t *data, size_t length) {
-  uint8_t attempt = 0u;
   int result = PICO_ERROR_GENERIC;
 
   if (sensor == NULL || data == NULL || length == 0u ||
@@ -177,21 +166,11 @@ static int adp910_bus_read(adp910_sensor_t *sensor, uint8_t *data, size_t length
     return PICO_ERROR_GENERIC;
   }
 
-  for (attempt = 0u; attempt <= ADP910_IO_RETRY_COUNT; ++attempt) {
-    const uint32_t timeout_us = adp910_transfer_timeout_us(sensor, length);
-    result = i2c_read_timeout_us(sensor->port_config.i2c_instance,
-                                 sensor->port_config.i2c_address, data, length,
-                                 false, timeout_us);
-    sensor->last_bus_result = result;
-    if (result == (int)length) {
-      return result;
-    }
-    if (attempt < ADP910_IO_RETRY_COUNT) {
-      adp910_recover_bus(sensor);
-      sleep_ms(ADP910_RETRY_DELAY_MS);
-    }
-  }
-
+  result = i2c_read_timeout_us(sensor->port_config.i2c_instance,
+                               sensor->port_config.i2c_address, data, length,
+                               false,
+                               adp910_transfer_timeout_us(sensor, length));
+  sensor->last_bus_result = result;
   return result;
 }
 
@@ -208,12 +187,39 @@ static adp910_status_t adp910_write_command(adp910_sensor_t *sensor,
              : ADP910_STATUS_BUS_ERROR;
 }
 
-static adp910_status_t adp910_read_raw_frame(adp910_sensor_t *sensor,
-                                             uint8_t *raw_frame,
-                                             size_t frame_length) {
-  return adp910_bus_read(sensor, raw_frame, frame_length) == (int)frame_length
-             ? ADP910_STATUS_OK
-             : ADP910_STATUS_BUS_ERROR;
+static adp910_status_t adp910_read_frame_sample(adp910_sensor_t *sensor,
+                                                adp910_sample_t *out_sample) {
+  uint8_t raw_frame[ADP910_SAMPLE_FRAME_SIZE];
+  int16_t raw_pressure = 0;
+  int16_t raw_temperature = 0;
+
+  if (adp910_bus_read(sensor, raw_frame, sizeof(raw_frame)) !=
+      (int)sizeof(raw_frame)) {
+    return ADP910_STATUS_BUS_ERROR;
+  }
+  out_sample->capture_time_us = time_us_32();
+
+  if (adp910_crc8(raw_frame, 2u) != raw_frame[2] ||
+      adp910_crc8(raw_frame + 3u, 2u) != raw_frame[5]) {
+    return ADP910_STATUS_CRC_MISMATCH;
+  }
+
+  raw_pressure = (int16_t)(((uint16_t)raw_frame[0] << 8u) | raw_frame[1]);
+  raw_temperature = (int16_t)(((uint16_t)raw_frame[3] << 8u) | raw_frame[4]);
+
+  out_sample->differential_pressure_pa = (float)raw_pressure / 60.0f;
+  out_sample->corrected_pressure_pa =
+      out_sample->differential_pressure_pa - sensor->pressure_offset_pa;
+  out_sample->temperature_c = (float)raw_temperature / 200.0f;
+
+  return ADP910_STATUS_OK;
+}
+
+static void adp910_schedule_step(adp910_sensor_t *sensor,
+                                 adp910_sensor_step_t step,
+                                 uint32_t delay_ms) {
+  sensor->step = step;
+  sensor->step_due_us = time_us_32() + (delay_ms * 1000u);
 }
 
 adp910_status_t adp910_sensor_start_continuous_mode(adp910_sensor_t *sensor) {
@@ -224,76 +230,117 @@ adp910_status_t adp910_sensor_start_continuous_mode(adp910_sensor_t *sensor) {
   return adp910_write_command(sensor, ADP910_CMD_START_CONTINUOUS);
 }
 
-adp910_status_t adp910_sensor_initialize(
-    adp910_sensor_t *sensor, const adp910_port_config_t *port_config) {
-  uint8_t sample_index = 0u;
-
-  if (sensor == NULL || port_config == NULL || port_config->i2c_instance == NULL ||
-      port_config->i2c_frequency_hz == 0u ||
-      !adp910_port_pins_match_bus(port_config)) {
+adp910_status_t adp910_sensor_begin(adp910_sensor_t *sensor,
+                                    const adp910_port_config_t *port_config) {
+  if (sensor == NULL || port_config == NULL) {
     return ADP910_STATUS_INVALID_ARGUMENT;
   }
 
   *sensor = (adp910_sensor_t){
       .port_config = *port_config,
       .pressure_offset_pa = 0.0f,
-      .is_initialized = false,
       .last_bus_result = 0,
+      .step = ADP910_SENSOR_STEP_RECOVER_BUS,
+      .step_due_us = time_us_32(),
+      .restart_pending = true,
+      .stabilization_reads = 0u,
   };
+  return ADP910_STATUS_OK;
+}
 
-  adp910_recover_bus(sensor);
-  sleep_ms(ADP910_STARTUP_DELAY_MS);
-
-  if (adp910_sensor_start_continuous_mode(sensor) != ADP910_STATUS_OK) {
-    return ADP910_STATUS_BUS_ERROR;
+void adp910_sensor_restart(adp910_sensor_t *sensor) {
+  if (sensor == NULL) {
+    return;
   }
 
-  sleep_ms(ADP910_FIRST_SAMPLE_DELAY_MS);
-  sensor->is_initialized = true;
+  sensor->restart_pending = true;
+  adp910_schedule_step(sensor, ADP910_SENSOR_STEP_RECOVER_BUS, 0u);
+}
+
+bool adp910_sensor_is_ready(const adp910_sensor_t *sensor) {
+  return sensor != NULL && sensor->step == ADP910_SENSOR_STEP_READY;
+}
+
+adp910_status_t adp910_sensor_poll(adp910_sensor_t *sensor) {
+  adp910_sample_t discarded_sample;
 
-  for (sample_index = 0u; sample_index < ADP910_STABILIZATION_SAMPLE_COUNT;
-       ++sample_index) {
-    adp910_sample_t discarded_sample;
-    (void)adp910_sensor_read_sample(sensor, &discarded_sample);
-    sleep_ms(ADP910_STABILIZATION_DELAY_MS);
+  if (sensor == NULL) {
+    return ADP910_STATUS_INVALID_ARGUMENT;
+  }
+  if (sensor->step == ADP910_SENSOR_STEP_READY) {
+    return ADP910_STATUS_OK;
+  }
+  if ((int32_t)(time_us_32() - sensor->step_due_us) < 0) {
+    return ADP910_STATUS_NOT_READY;
   }
 
-  return ADP910_STATUS_OK;
+  switch (sensor->step) {
+  case ADP910_SENSOR_STEP_RECOVER_BUS:
+    if (sensor->port_config.i2c_instance == NULL ||
+        sensor->port_config.i2c_frequency_hz == 0u ||
+        !adp910_port_pins_match_bus(&sensor->port_config)) {
+      sensor->restart_pending = true;
+      adp910_schedule_step(sensor, ADP910_SENSOR_STEP_RECOVER_BUS,
+                           ADP910_INIT_RETRY_DELAY_MS);
+      return ADP910_STATUS_INVALID_ARGUMENT;
+    }
+    adp910_recover_bus(sensor);
+    if (!sensor->restart_pending) {
+      /* Recovery after a failed read: the sensor is still streaming. */
+      sensor->step = ADP910_SENSOR_STEP_READY;
+      return ADP910_STATUS_OK;
+    }
+    adp910_schedule_step(sensor, ADP910_SENSOR_STEP_START_CONTINUOUS,
+                         ADP910_STARTUP_DELAY_MS);
+    return ADP910_STATUS_NOT_READY;
+
+  case ADP910_SENSOR_STEP_START_CONTINUOUS:
+    if (adp910_sensor_start_continuous_mode(sensor) != ADP910_STATUS_OK) {
+      adp910_schedule_step(sensor, ADP910_SENSOR_STEP_RECOVER_BUS,
+                           ADP910_INIT_RETRY_DELAY_MS);
+      return ADP910_STATUS_BUS_ERROR;
+    }
+    sensor->stabilization_reads = 0u;
+    adp910_schedule_step(sensor, ADP910_SENSOR_STEP_STABILIZE,
+                         ADP910_FIRST_SAMPLE_DELAY_MS);
+    return ADP910_STATUS_NOT_READY;
+
+  case ADP910_SENSOR_STEP_STABILIZE:
+    /* The first frames after start-up are discarded, good or not. */
+    (void)adp910_read_frame_sample(sensor, &discarded_sample);
+    sensor->stabilization_reads += 1u;
+    if (sensor->stabilization_reads < ADP910_STABILIZATION_SAMPLE_COUNT) {
+      adp910_schedule_step(sensor, ADP910_SENSOR_STEP_STABILIZE,
+                           ADP910_STABILIZATION_DELAY_MS);
+      return ADP910_STATUS_NOT_READY;
+    }
+    sensor->restart_pending = false;
+    sensor->step = ADP910_SENSOR_STEP_READY;
+    return ADP910_STATUS_OK;
+
+  default:
+    adp910_sensor_restart(sensor);
+    return ADP910_STATUS_NOT_READY;
+  }
 }
 
 adp910_status_t adp910_sensor_read_sample(adp910_sensor_t *sensor,
                                           adp910_sample_t *out_sample) {
-  uint8_t raw_frame[ADP910_SAMPLE_FRAME_SIZE];
-  int16_t raw_pressure = 0;
-  int16_t raw_temperature = 0;
+  adp910_status_t status = ADP910_STATUS_OK;
 
   if (sensor == NULL || out_sample == NULL) {
     return ADP910_STATUS_INVALID_ARGUMENT;
   }
 
-  if (!sensor->is_initialized) {
+  if (sensor->step != ADP910_SENSOR_STEP_READY) {
     return ADP910_STATUS_NOT_READY;
   }
 
-  if (adp910_read_raw_frame(sensor, raw_frame, sizeof(raw_frame)) !=
-      ADP910_STATUS_OK) {
-    return ADP910_STATUS_BUS_ERROR;
-  }
-
-  if (adp910_crc8(raw_frame, 2u) != raw_frame[2] ||
-      adp910_crc8(raw_frame + 3u, 2u) != raw_frame[5]) {
-    return ADP910_STATUS_CRC_MISMATCH;
+  status = adp910_read_frame_sample(sensor, out_sample);
+  if (status == ADP910_STATUS_BUS_ERROR) {
+    adp910_schedule_step(sensor, ADP910_SENSOR_STEP_RECOVER_BUS, 0u);
   }
-
-  raw_pressure = (int16_t)(((uint16_t)raw_frame[0] << 8u) | raw_frame[1]);
-  raw_temperature = (int16_t)(((uint16_t)raw_frame[3] << 8u) | raw_frame[4]);
-
-  out_sample->differential_pressure_pa = (float)raw_pressure / 60.0f;
-  out_sample->corrected_pressure_pa =
-      out_sample->differential_pressure_pa - sensor->pressure_offset_pa;
-  out_sample->temperature_c = (float)raw_temperature / 200.0f;
-
-  return ADP910_STATUS_OK;
+  return status;
 }
 
 void adp910_sensor_set_pressure_offset(adp910_sensor_t *sensor,
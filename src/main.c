@@ -2,10 +2,17 @@
 #include "app/task_bootstrap.h"
 #include "pico/stdlib.h"
 #include "platform/runtime_faults.h"
+#include "services/sys_crash.h"
+#include "services/sys_profiler.h"
+#include "services/sys_watchdog.h"
 #include "task.h"
 #include <stdio.h>
 
 int main(void) {
+  static sys_crash_record_t last_crash;
+
+  sys_crash_init();
+  sys_watchdog_init();
   stdio_init_all();
 
   for (volatile int spin = 0; spin < 8000000; ++spin) {
@@ -14,10 +21,19 @@ int main(void) {
 
   printf("\n\n--- Blower Pico (RP2350) Initializing ---\n");
   printf("Target: RP2350 (Cortex-M33)\n");
+  if (sys_crash_get_last(&last_crash)) {
+    printf("[CRASH] previous boot: %s task=%s pc=0x%08lx lr=0x%08lx "
+           "(GET /api/sys/crash)\n",
+           sys_crash_reason_name((sys_crash_reason_t)last_crash.reason),
+           last_crash.task_name, (unsigned long)last_crash.pc,
+           (unsigned long)last_crash.lr);
+  }
 
   runtime_install_fault_handlers();
   printf("Runtime handlers installed.\n");
 
+  sys_profiler_init();
+
   if (app_create_default_tasks() != pdPASS) {
     runtime_panic("Task creation failed");
   }
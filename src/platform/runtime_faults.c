@@ -1,8 +1,13 @@
 #include "platform/runtime_faults.h"
 
 #include "FreeRTOS.h"
+#include "app/app_config.h"
 #include "hardware/exception.h"
 #include "hardware/structs/scb.h"
+#include "hardware/timer.h"
+#include "hardware/watchdog.h"
+#include "services/dimmer_control.h"
+#include "services/sys_crash.h"
 #include "task.h"
 #include <stdint.h>
 #include <stdio.h>
@@ -13,7 +18,51 @@ extern void SVC_Handler(void);
 extern void PendSV_Handler(void);
 extern void SysTick_Handler(void);
 
-static void runtime_dump_fault_registers(const char *fault_name) {
+/* Naked fault entry: pass the stacked frame (MSP or PSP) and EXC_RETURN. */
+#define RUNTIME_FAULT_HANDLER(handler_name, crash_reason)                      \
+  static void __attribute__((naked)) handler_name(void) {                      \
+    __asm volatile("tst lr, #4\n"                                              \
+                   "ite eq\n"                                                  \
+                   "mrseq r0, msp\n"                                           \
+                   "mrsne r0, psp\n"                                           \
+                   "mov r1, lr\n"                                              \
+                   "movs r2, #%c0\n"                                           \
+                   "b runtime_fault_capture\n"                                 \
+                   :                                                           \
+                   : "i"(crash_reason));                                       \
+  }
+
+void runtime_fault_capture(const uint32_t *frame, uint32_t exc_return,
+                           uint32_t reason) __attribute__((used));
+
+/*
+ * Cuts the TRIAC gate, records the dump and arms the watchdog reboot
+ * before any printf, so a wedged stdio still ends in a reboot rather than
+ * a hung controller with the fan running.
+ */
+static void runtime_crash_begin(sys_crash_reason_t reason,
+                                const uint32_t *frame, uint32_t exc_return,
+                                const char *message) {
+  dimmer_control_force_off();
+  sys_crash_capture(reason, frame, exc_return, message);
+#if APP_CRASH_REBOOT_DELAY_MS > 0
+  watchdog_reboot(0u, 0u, APP_CRASH_REBOOT_DELAY_MS);
+#endif
+}
+
+static void runtime_crash_halt(void) {
+  fflush(stdout);
+  while (1) {
+#if APP_CRASH_REBOOT_DELAY_MS > 0
+    __asm("nop");
+#else
+    __asm("bkpt #0");
+#endif
+  }
+}
+
+static void runtime_dump_fault_registers(const char *fault_name,
+                                         const uint32_t *frame) {
   printf("\n[FAULT] %s\n", fault_name);
   printf("  VTOR=0x%08lx\n", (unsigned long)scb_hw->vtor);
   printf("  CFSR=0x%08lx HFSR=0x%08lx DFSR=0x%08lx\n",
@@ -21,35 +70,29 @@ static void runtime_dump_fault_registers(const char *fault_name) {
          (unsigned long)scb_hw->dfsr);
   printf("  MMFAR=0x%08lx BFAR=0x%08lx\n", (unsigned long)scb_hw->mmfar,
          (unsigned long)scb_hw->bfar);
-  fflush(stdout);
-}
-
-static void runtime_fault_and_halt(const char *fault_name) {
-  runtime_dump_fault_registers(fault_name);
-  while (1) {
-    __asm("bkpt #0");
+  if (frame != NULL) {
+    printf("  PC=0x%08lx LR=0x%08lx xPSR=0x%08lx\n", (unsigned long)frame[6],
+           (unsigned long)frame[5], (unsigned long)frame[7]);
   }
+  fflush(stdout);
 }
 
-static void runtime_hardfault_handler(void) {
-  runtime_fault_and_halt("HardFault");
-}
-
-static void runtime_memmanage_handler(void) {
-  runtime_fault_and_halt("MemManage");
-}
-
-static void runtime_busfault_handler(void) {
-  runtime_fault_and_halt("BusFault");
-}
+void runtime_fault_capture(const uint32_t *frame, uint32_t exc_return,
+                           uint32_t reason) {
+  const char *fault_name =
+      sys_crash_reason_name((sys_crash_reason_t)reason);
 
-static void runtime_usagefault_handler(void) {
-  runtime_fault_and_halt("UsageFault");
+  runtime_crash_begin((sys_crash_reason_t)reason, frame, exc_return,
+                      fault_name);
+  runtime_dump_fault_registers(fault_name, frame);
+  runtime_crash_halt();
 }
 
-static void runtime_securefault_handler(void) {
-  runtime_fault_and_halt("SecureFault");
-}
+RUNTIME_FAULT_HANDLER(runtime_hardfault_handler, SYS_CRASH_HARD_FAULT)
+RUNTIME_FAULT_HANDLER(runtime_memmanage_handler, SYS_CRASH_MEM_MANAGE)
+RUNTIME_FAULT_HANDLER(runtime_busfault_handler, SYS_CRASH_BUS_FAULT)
+RUNTIME_FAULT_HANDLER(runtime_usagefault_handler, SYS_CRASH_USAGE_FAULT)
+RUNTIME_FAULT_HANDLER(runtime_securefault_handler, SYS_CRASH_SECURE_FAULT)
 
 void runtime_install_fault_handlers(void) {
   scb_hw->shcsr |= (1u << 16) | (1u << 17) | (1u << 18);
@@ -70,28 +113,26 @@ void runtime_install_fault_handlers(void) {
 }
 
 void runtime_panic(const char *message) {
+  runtime_crash_begin(SYS_CRASH_PANIC, NULL, 0u, message);
   printf("\n[!! PANIC !!] %s\n", message);
-  fflush(stdout);
-  while (1) {
-    __asm("bkpt #0");
-  }
+  runtime_crash_halt();
 }
 
 void vApplicationStackOverflowHook(TaskHandle_t task_handle,
                                    char *task_name) {
   (void)task_handle;
+  runtime_crash_begin(SYS_CRASH_STACK_OVERFLOW, NULL, 0u, task_name);
   printf("\nFATAL: Stack overflow in task %s\n", task_name);
-  while (1) {
-    __asm("bkpt #0");
-  }
+  runtime_crash_halt();
 }
 
 void vApplicationMallocFailedHook(void) {
+  runtime_crash_begin(SYS_CRASH_MALLOC_FAILED, NULL, 0u, NULL);
   printf("\nFATAL: Malloc failed\n");
-  while (1) {
-    __asm("bkpt #0");
-  }
+  runtime_crash_halt();
 }
 
+uint32_t runtime_stats_timer_us(void) { return time_us_32(); }
+
 void vApplicationIdleHook(void) {}
 void vApplicationTickHook(void) {}
@@ -0,0 +1,123 @@
+#include "services/adp910_diag.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+typedef struct {
+  atomic_bool ready;
+  atomic_uint ok;
+  atomic_uint invalid_argument;
+  atomic_uint bus_error;
+  atomic_uint not_ready;
+  atomic_uint crc_mismatch;
+  atomic_uint other;
+  atomic_uint last_status;
+} adp910_diag_counters_t;
+
+static adp910_diag_counters_t g_adp910_diag[ADP910_DIAG_CHANNEL_COUNT];
+
+static void adp910_diag_increment(atomic_uint *counter) {
+  /* Single writer: a load and a store, no read-modify-write needed. */
+  atomic_store_explicit(
+      counter, atomic_load_explicit(counter, memory_order_relaxed) + 1u,
+      memory_order_relaxed);
+}
+
+void adp910_diag_record(adp910_diag_channel_t channel,
+                        adp910_status_t status) {
+  adp910_diag_counters_t *counters = NULL;
+
+  if (channel >= ADP910_DIAG_CHANNEL_COUNT) {
+    return;
+  }
+
+  counters = &g_adp910_diag[channel];
+  atomic_store_explicit(&counters->last_status, (unsigned int)status,
+                        memory_order_relaxed);
+
+  switch (status) {
+  case ADP910_STATUS_OK:
+    adp910_diag_increment(&counters->ok);
+    break;
+  case ADP910_STATUS_INVALID_ARGUMENT:
+    adp910_diag_increment(&counters->invalid_argument);
+    break;
+  case ADP910_STATUS_BUS_ERROR:
+    adp910_diag_increment(&counters->bus_error);
+    break;
+  case ADP910_STATUS_NOT_READY:
+    adp910_diag_increment(&counters->not_ready);
+    break;
+  case ADP910_STATUS_CRC_MISMATCH:
+    adp910_diag_increment(&counters->crc_mismatch);
+    break;
+  default:
+    adp910_diag_increment(&counters->other);
+    break;
+  }
+}
+
+void adp910_diag_set_ready(adp910_diag_channel_t channel, bool ready) {
+  if (channel >= ADP910_DIAG_CHANNEL_COUNT) {
+    return;
+  }
+  atomic_store_explicit(&g_adp910_diag[channel].ready, ready,
+                        memory_order_relaxed);
+}
+
+void adp910_diag_get(adp910_diag_channel_t channel, adp910_diag_t *out_diag) {
+  const adp910_diag_counters_t *counters = NULL;
+
+  if (out_diag == NULL) {
+    return;
+  }
+  if (channel >= ADP910_DIAG_CHANNEL_COUNT) {
+    *out_diag = (adp910_diag_t){.last_status = ADP910_STATUS_OK};
+    return;
+  }
+
+  counters = &g_adp910_diag[channel];
+  *out_diag = (adp910_diag_t){
+      .ready = atomic_load_explicit(&counters->ready, memory_order_relaxed),
+      .ok = atomic_load_explicit(&counters->ok, memory_order_relaxed),
+      .invalid_argument = atomic_load_explicit(&counters->invalid_argument,
+                                               memory_order_relaxed),
+      .bus_error =
+          atomic_load_explicit(&counters->bus_error, memory_order_relaxed),
+      .not_ready =
+          atomic_load_explicit(&counters->not_ready, memory_order_relaxed),
+      .crc_mismatch =
+          atomic_load_explicit(&counters->crc_mismatch, memory_order_relaxed),
+      .other = atomic_load_explicit(&counters->other, memory_order_relaxed),
+      .last_status = (adp910_status_t)atomic_load_explicit(
+          &counters->last_status, memory_order_relaxed),
+  };
+}
+
+const char *adp910_diag_channel_name(adp910_diag_channel_t channel) {
+  switch (channel) {
+  case ADP910_DIAG_CHANNEL_FAN:
+    return "fan";
+  case ADP910_DIAG_CHANNEL_ENVELOPE:
+    return "envelope";
+  default:
+    return "unknown";
+  }
+}
+
+const char *adp910_status_name(adp910_status_t status) {
+  switch (status) {
+  case ADP910_STATUS_OK:
+    return "ok";
+  case ADP910_STATUS_INVALID_ARGUMENT:
+    return "invalid_argument";
+  case ADP910_STATUS_BUS_ERROR:
+    return "bus_error";
+  case ADP910_STATUS_NOT_READY:
+    return "not_ready";
+  case ADP910_STATUS_CRC_MISMATCH:
+    return "crc_mismatch";
+  default:
+    return "unknown";
+  }
+}
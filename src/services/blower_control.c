@@ -1,26 +1,32 @@
 #include "services/blower_control.h"
 
 #include "app/app_config.h"
-#include "hardware/sync.h"
+#include "services/blower_control_params.h"
+#include "services/blower_feedforward_map.h"
+#include "services/blower_fopdt_predictor.h"
 #include <math.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+/* Fraction of the target the envelope must reach to fix the direction. */
+#define BLOWER_CONTROL_DIRECTION_MIN_TARGET_RATIO 0.25f
 
 typedef struct {
   bool initialized;
   uint8_t manual_pwm_percent;
   uint8_t output_pwm_percent;
+  float output_pwm_exact;
   blower_control_mode_t mode;
   bool auto_hold_enabled;
   bool relay_enabled;
   float target_pressure_pa;
-  float pd_kp;
-  float pid_ki;
-  float pd_kd;
-  float pd_deadband_pa;
-  float pd_max_step_percent;
-  float pd_max_step_down_percent;
+  blower_control_params_t params;
+  uint32_t params_generation;
   float integral_error_pa_s;
   float gain_scale;
   float last_error_pa;
+  /* Before the deadband, so settle detection sees a fast pass-through. */
+  float last_raw_error_pa;
   uint32_t last_tick_ms;
   bool has_last_error;
   float filtered_pressure_pa;
@@ -30,13 +36,62 @@ typedef struct {
   uint16_t learning_stable_cycles;
   float learned_feedforward_pwm;
   bool has_learned_feedforward_pwm;
+  blower_feedforward_map_t feedforward_map;
+  blower_feedforward_direction_t feedforward_direction;
+  bool feedforward_direction_known;
+  bool feedforward_seed_checked;
+  bool feedforward_map_dirty;
+  blower_fopdt_predictor_t predictor;
   bool startup_boost_active;
   uint32_t startup_boost_start_tick_ms;
   bool line_sync;
   float line_frequency_hz;
 } blower_control_state_t;
 
+typedef enum {
+  BLOWER_CONTROL_COMMAND_SET_MANUAL_PWM = 0,
+  BLOWER_CONTROL_COMMAND_SET_MODE,
+  BLOWER_CONTROL_COMMAND_SET_AUTO_HOLD,
+  BLOWER_CONTROL_COMMAND_SET_RELAY,
+  BLOWER_CONTROL_COMMAND_SET_TARGET_PRESSURE,
+} blower_control_command_type_t;
+
+typedef struct {
+  blower_control_command_type_t type;
+  union {
+    uint8_t pwm_percent;
+    blower_control_mode_t mode;
+    bool enabled;
+    float target_pressure_pa;
+  } value;
+} blower_control_command_t;
+
+typedef struct {
+  atomic_uint ready;
+  blower_control_command_t command;
+} blower_control_command_slot_t;
+
+typedef struct {
+  blower_control_command_slot_t slots[BLOWER_CONTROL_COMMAND_QUEUE_DEPTH];
+  atomic_uint head;
+  atomic_uint tail;
+  atomic_uint dropped;
+} blower_control_command_queue_t;
+
+/* Safety requests latched outside the queue so they can never be dropped. */
+#define BLOWER_CONTROL_LATCH_RELAY_OFF 0x1u
+#define BLOWER_CONTROL_LATCH_RELEASE 0x2u
+
+typedef struct {
+  atomic_uint sequence;
+  blower_control_snapshot_t copies[2];
+} blower_control_published_snapshot_t;
+
+/* Owned by the control task; other tasks go through the queue/snapshot. */
 static blower_control_state_t g_state;
+static blower_control_command_queue_t g_command_queue;
+static atomic_uint g_safety_latch;
+static blower_control_published_snapshot_t g_published;
 
 static float blower_control_clampf(float value, float min_value,
                                    float max_value) {
@@ -56,13 +111,14 @@ static float blower_control_lerpf(float from, float to, float ratio) {
 static void blower_control_reset_pd_terms(blower_control_state_t *state) {
   state->integral_error_pa_s = 0.0f;
   state->last_error_pa = 0.0f;
+  state->last_raw_error_pa = 0.0f;
   state->last_tick_ms = 0u;
   state->has_last_error = false;
 }
 
 static void blower_control_reset_pd_state(blower_control_state_t *state) {
   const float gain_scale_min =
-      blower_control_clampf(APP_CONTROL_GAIN_SCALE_MIN, 0.05f, 1.0f);
+      blower_control_clampf(state->params.gain_scale_min, 0.05f, 1.0f);
 
   blower_control_reset_pd_terms(state);
   state->filtered_pressure_pa = 0.0f;
@@ -73,12 +129,49 @@ static void blower_control_reset_pd_state(blower_control_state_t *state) {
   state->learning_stable_cycles = 0u;
   state->learned_feedforward_pwm = (float)state->output_pwm_percent;
   state->has_learned_feedforward_pwm = false;
+  state->feedforward_seed_checked = false;
+  blower_fopdt_predictor_restart(&state->predictor);
+}
+
+/*
+ * The map is kept per direction, and the direction is only known once
+ * this engagement has seen a pressure beyond the deadband; until then
+ * nothing is looked up or recorded.
+ */
+static bool blower_control_lookup_feedforward(
+    const blower_control_state_t *state, float *out_pwm) {
+  return state->feedforward_direction_known &&
+         blower_feedforward_map_lookup(&state->feedforward_map,
+                                       state->feedforward_direction,
+                                       state->target_pressure_pa, out_pwm);
+}
+
+static void blower_control_seed_feedforward(blower_control_state_t *state) {
+  float seeded_pwm = 0.0f;
+
+  if (!state->feedforward_direction_known) {
+    return;
+  }
+
+  state->feedforward_seed_checked = true;
+  if (state->has_learned_feedforward_pwm ||
+      !blower_control_lookup_feedforward(state, &seeded_pwm)) {
+    return;
+  }
+
+  /*
+   * Start from the remembered steady-state power instead of ramping there
+   * through the step limiter; learning still refines it from here.
+   */
+  state->learned_feedforward_pwm = seeded_pwm;
+  state->has_learned_feedforward_pwm = true;
+  state->output_pwm_percent = (uint8_t)(seeded_pwm + 0.5f);
 }
 
 static float blower_control_filter_pressure(blower_control_state_t *state,
                                             float measured_pressure_pa) {
   const float alpha =
-      blower_control_clampf(APP_CONTROL_MEASUREMENT_FILTER_ALPHA, 0.01f, 1.0f);
+      blower_control_clampf(state->params.filter_alpha, 0.01f, 1.0f);
 
   if (!state->has_filtered_pressure) {
     state->filtered_pressure_pa = measured_pressure_pa;
@@ -91,12 +184,13 @@ static float blower_control_filter_pressure(blower_control_state_t *state,
   return state->filtered_pressure_pa;
 }
 
-static float blower_control_compute_step_scale(float error_pa) {
-  const float far_error_pa = APP_CONTROL_STEP_FAR_ERROR_PA > 0.1f
-                                 ? APP_CONTROL_STEP_FAR_ERROR_PA
+static float blower_control_compute_step_scale(
+    const blower_control_params_t *params, float error_pa) {
+  const float far_error_pa = params->step_far_error_pa > 0.1f
+                                 ? params->step_far_error_pa
                                  : 0.1f;
   const float near_ratio = blower_control_clampf(
-      APP_CONTROL_STEP_NEAR_TARGET_RATIO, 0.05f, 1.0f);
+      params->step_near_target_ratio, 0.05f, 1.0f);
   const float normalized_error = fabsf(error_pa) / far_error_pa;
 
   return blower_control_lerpf(near_ratio, 1.0f, normalized_error);
@@ -107,15 +201,17 @@ static void blower_control_update_learning_state(blower_control_state_t *state,
                                                  float derivative_pa_per_s,
                                                  uint32_t now_tick_ms) {
   const float settle_band =
-      blower_control_clampf(APP_CONTROL_LEARNING_SETTLE_BAND_PA, 0.5f, 10.0f);
+      blower_control_clampf(state->params.learning_settle_band_pa, 0.5f,
+                            10.0f);
   const float max_settle_derivative = blower_control_clampf(
-      APP_CONTROL_LEARNING_MAX_DERIVATIVE_PA_PER_S, 0.5f, 20.0f);
+      state->params.learning_max_derivative_pa_per_s, 0.5f, 20.0f);
   const float gain_scale_min =
-      blower_control_clampf(APP_CONTROL_GAIN_SCALE_MIN, 0.05f, 1.0f);
+      blower_control_clampf(state->params.gain_scale_min, 0.05f, 1.0f);
   const float gain_scale_max =
-      blower_control_clampf(APP_CONTROL_GAIN_SCALE_MAX, gain_scale_min, 2.0f);
+      blower_control_clampf(state->params.gain_scale_max, gain_scale_min,
+                            2.0f);
   const float gain_growth = blower_control_clampf(
-      APP_CONTROL_GAIN_SCALE_GROWTH, 0.0001f, 0.05f);
+      state->params.gain_scale_growth, 0.0001f, 0.05f);
   const bool in_settle_zone =
       fabsf(error_pa) <= settle_band &&
       fabsf(derivative_pa_per_s) <= max_settle_derivative;
@@ -134,11 +230,19 @@ static void blower_control_update_learning_state(blower_control_state_t *state,
         state->has_learned_feedforward_pwm = true;
       } else {
         const float ff_alpha = blower_control_clampf(
-            APP_CONTROL_LEARNING_FEEDFORWARD_ALPHA, 0.01f, 0.5f);
+            state->params.learning_feedforward_alpha, 0.01f, 0.5f);
         state->learned_feedforward_pwm +=
             ff_alpha *
             ((float)state->output_pwm_percent - state->learned_feedforward_pwm);
       }
+      if (state->learning_stable_cycles ==
+              state->params.learning_stable_cycles &&
+          state->feedforward_direction_known &&
+          blower_feedforward_map_record(
+              &state->feedforward_map, state->feedforward_direction,
+              state->target_pressure_pa, state->learned_feedforward_pwm)) {
+        state->feedforward_map_dirty = true;
+      }
       state->gain_scale += gain_growth * 2.0f;
     } else {
       state->learning_stable_cycles = 0u;
@@ -146,11 +250,28 @@ static void blower_control_update_learning_state(blower_control_state_t *state,
     }
 
     if ((now_tick_ms - state->learning_start_tick_ms) >=
-            APP_CONTROL_LEARNING_WINDOW_MS ||
-        state->learning_stable_cycles >= APP_CONTROL_LEARNING_STABLE_CYCLES) {
+            state->params.learning_window_ms ||
+        state->learning_stable_cycles >= state->params.learning_stable_cycles) {
       state->learning_active = false;
     }
   } else {
+    /*
+     * A slow plant may only settle after the learning window; map the
+     * power that holds the target once it has held for as long.
+     */
+    if (!in_settle_zone) {
+      state->learning_stable_cycles = 0u;
+    } else if (state->learning_stable_cycles < 65535u) {
+      state->learning_stable_cycles += 1u;
+    }
+    if (state->learning_stable_cycles ==
+            state->params.learning_stable_cycles &&
+        state->feedforward_direction_known &&
+        blower_feedforward_map_record(
+            &state->feedforward_map, state->feedforward_direction,
+            state->target_pressure_pa, state->output_pwm_exact)) {
+      state->feedforward_map_dirty = true;
+    }
     state->gain_scale += gain_growth;
   }
 
@@ -163,19 +284,16 @@ static void blower_control_initialize_defaults(blower_control_state_t *state) {
       .initialized = true,
       .manual_pwm_percent = 0u,
       .output_pwm_percent = 0u,
+      .output_pwm_exact = 0.0f,
       .mode = BLOWER_CONTROL_MODE_MANUAL_PERCENT,
       .auto_hold_enabled = false,
       .relay_enabled = false,
       .target_pressure_pa = APP_CONTROL_TARGET_PRESSURE_PA,
-      .pd_kp = APP_CONTROL_PD_KP,
-      .pid_ki = APP_CONTROL_PID_KI,
-      .pd_kd = APP_CONTROL_PD_KD,
-      .pd_deadband_pa = APP_CONTROL_PD_DEADBAND_PA,
-      .pd_max_step_percent = APP_CONTROL_MAX_STEP_UP_PERCENT,
-      .pd_max_step_down_percent = APP_CONTROL_MAX_STEP_DOWN_PERCENT,
       .integral_error_pa_s = 0.0f,
       .gain_scale = APP_CONTROL_GAIN_SCALE_MIN,
+      .params_generation = 0u,
       .last_error_pa = 0.0f,
+      .last_raw_error_pa = 0.0f,
       .last_tick_ms = 0u,
       .has_last_error = false,
       .filtered_pressure_pa = 0.0f,
@@ -185,21 +303,83 @@ static void blower_control_initialize_defaults(blower_control_state_t *state) {
       .learning_stable_cycles = 0u,
       .learned_feedforward_pwm = 0.0f,
       .has_learned_feedforward_pwm = false,
+      .feedforward_direction = BLOWER_FEEDFORWARD_DIRECTION_PRESSURIZATION,
+      .feedforward_direction_known = false,
+      .feedforward_seed_checked = false,
+      .feedforward_map_dirty = false,
+      .predictor = {0},
       .startup_boost_active = true,
       .startup_boost_start_tick_ms = 0u,
       .line_sync = false,
       .line_frequency_hz = 0.0f,
   };
+  blower_control_params_defaults(&state->params);
 }
 
-static void blower_control_ensure_initialized_locked(void) {
-  if (!g_state.initialized) {
-    blower_control_initialize_defaults(&g_state);
+static bool blower_control_mode_is_valid(blower_control_mode_t mode) {
+  return mode == BLOWER_CONTROL_MODE_MANUAL_PERCENT ||
+         mode == BLOWER_CONTROL_MODE_SEMI_AUTO_TARGET ||
+         mode == BLOWER_CONTROL_MODE_AUTO_TEST ||
+         mode == BLOWER_CONTROL_MODE_PREDICTIVE_TARGET;
+}
+
+/*
+ * Predictive mode: an open-loop step identifies the FOPDT plant the first
+ * time the loop engages, then a Smith-predictor PI holds the target.
+ * Returns false when no usable model could be fitted so the caller falls
+ * back to the adaptive PID path.
+ */
+static bool blower_control_step_predictive(blower_control_state_t *state,
+                                           float measured_abs_pressure,
+                                           uint32_t now_tick_ms) {
+  blower_fopdt_predictor_t *predictor = &state->predictor;
+  float next_output = (float)state->output_pwm_percent;
+
+  if (predictor->state == BLOWER_FOPDT_STATE_FAILED) {
+    return false;
+  }
+
+  if (predictor->state == BLOWER_FOPDT_STATE_IDLE) {
+    float step_pwm = state->params.predictive_ident_step_percent;
+    const float abort_pressure_pa = fmaxf(
+        state->target_pressure_pa * APP_CONTROL_PREDICTIVE_IDENT_ABORT_RATIO,
+        state->target_pressure_pa +
+            2.0f * APP_CONTROL_PREDICTIVE_IDENT_MIN_RESPONSE_PA);
+
+    (void)blower_control_lookup_feedforward(state, &step_pwm);
+    blower_fopdt_predictor_begin_identification(
+        predictor, (float)state->output_pwm_percent, measured_abs_pressure,
+        step_pwm, abort_pressure_pa, now_tick_ms);
   }
+
+  if (predictor->state == BLOWER_FOPDT_STATE_IDENTIFYING) {
+    next_output = blower_fopdt_predictor_identify(
+        predictor, measured_abs_pressure, now_tick_ms);
+  } else if (predictor->state == BLOWER_FOPDT_STATE_TRACKING) {
+    float seeded_pwm = -1.0f;
+
+    if (!predictor->tracking_primed &&
+        !blower_control_lookup_feedforward(state, &seeded_pwm) &&
+        !blower_fopdt_predictor_steady_output(
+            predictor, state->target_pressure_pa, &seeded_pwm)) {
+      seeded_pwm = -1.0f;
+    }
+    next_output = blower_fopdt_predictor_control(
+        predictor, state->target_pressure_pa, measured_abs_pressure,
+        (float)state->output_pwm_percent, seeded_pwm,
+        state->params.predictive_max_step_up_percent,
+        state->params.predictive_max_step_down_percent);
+  } else {
+    return false;
+  }
+
+  next_output = blower_control_clampf(next_output, 0.0f, 100.0f);
+  state->output_pwm_percent = (uint8_t)(next_output + 0.5f);
+  return true;
 }
 
-static void blower_control_apply_mode_locked(blower_control_state_t *state,
-                                             blower_control_mode_t mode) {
+static void blower_control_apply_mode(blower_control_state_t *state,
+                                      blower_control_mode_t mode) {
   const bool auto_hold_enabled = mode != BLOWER_CONTROL_MODE_MANUAL_PERCENT;
   const bool mode_changed = state->mode != mode;
   const bool auto_hold_changed = state->auto_hold_enabled != auto_hold_enabled;
@@ -210,6 +390,9 @@ static void blower_control_apply_mode_locked(blower_control_state_t *state,
 
   state->mode = mode;
   state->auto_hold_enabled = auto_hold_enabled;
+  if (mode == BLOWER_CONTROL_MODE_PREDICTIVE_TARGET) {
+    blower_fopdt_predictor_reset(&state->predictor);
+  }
   blower_control_reset_pd_state(state);
   state->startup_boost_active = auto_hold_enabled;
   state->startup_boost_start_tick_ms = 0u;
@@ -223,99 +406,15 @@ static void blower_control_apply_mode_locked(blower_control_state_t *state,
   }
 }
 
-void blower_control_initialize(void) {
-  uint32_t irq_state = save_and_disable_interrupts();
-  blower_control_initialize_defaults(&g_state);
-  restore_interrupts(irq_state);
-}
-
-void blower_control_set_manual_pwm_percent(uint8_t pwm_percent) {
-  uint32_t irq_state = save_and_disable_interrupts();
-  blower_control_ensure_initialized_locked();
-  g_state.manual_pwm_percent = pwm_percent <= 100u ? pwm_percent : 100u;
-  if (!g_state.auto_hold_enabled && g_state.relay_enabled) {
-    g_state.output_pwm_percent = g_state.manual_pwm_percent;
-  }
-  restore_interrupts(irq_state);
-}
-
-void blower_control_set_mode(blower_control_mode_t mode) {
-  uint32_t irq_state = save_and_disable_interrupts();
-  blower_control_ensure_initialized_locked();
-
-  if (mode != BLOWER_CONTROL_MODE_MANUAL_PERCENT &&
-      mode != BLOWER_CONTROL_MODE_SEMI_AUTO_TARGET &&
-      mode != BLOWER_CONTROL_MODE_AUTO_TEST) {
-    restore_interrupts(irq_state);
-    return;
-  }
-
-  blower_control_apply_mode_locked(&g_state, mode);
-  restore_interrupts(irq_state);
-}
-
-void blower_control_set_auto_hold_enabled(bool enabled) {
-  uint32_t irq_state = save_and_disable_interrupts();
-  blower_control_mode_t mode = BLOWER_CONTROL_MODE_MANUAL_PERCENT;
-  blower_control_ensure_initialized_locked();
-
-  if (enabled) {
-    mode = g_state.mode == BLOWER_CONTROL_MODE_AUTO_TEST
-               ? BLOWER_CONTROL_MODE_AUTO_TEST
-               : BLOWER_CONTROL_MODE_SEMI_AUTO_TARGET;
-  }
-
-  blower_control_apply_mode_locked(&g_state, mode);
-  restore_interrupts(irq_state);
-}
-
-void blower_control_set_relay_enabled(bool enabled) {
-  uint32_t irq_state = save_and_disable_interrupts();
-  blower_control_ensure_initialized_locked();
-
-  g_state.relay_enabled = enabled;
-  if (!enabled) {
-    g_state.output_pwm_percent = 0u;
-    blower_control_reset_pd_state(&g_state);
-    g_state.startup_boost_active = true;
-    g_state.startup_boost_start_tick_ms = 0u;
-  } else if (!g_state.auto_hold_enabled) {
-    g_state.output_pwm_percent = g_state.manual_pwm_percent;
-  } else {
-    g_state.startup_boost_active = true;
-    g_state.startup_boost_start_tick_ms = 0u;
-    g_state.learned_feedforward_pwm = (float)g_state.output_pwm_percent;
-    g_state.has_learned_feedforward_pwm = false;
-  }
-
-  restore_interrupts(irq_state);
-}
-
-void blower_control_set_target_pressure_pa(float target_pressure_pa) {
-  uint32_t irq_state = save_and_disable_interrupts();
-  blower_control_ensure_initialized_locked();
-
-  if (!isnan(target_pressure_pa) && target_pressure_pa >= 0.0f &&
-      target_pressure_pa <= 200.0f) {
-    g_state.target_pressure_pa = target_pressure_pa;
-    blower_control_reset_pd_state(&g_state);
-  }
-
-  restore_interrupts(irq_state);
-}
-
-uint8_t blower_control_step(float envelope_pressure_pa, bool measurement_valid,
-                            uint32_t now_tick_ms) {
-  uint32_t irq_state = save_and_disable_interrupts();
-  blower_control_state_t *state = &g_state;
+static uint8_t blower_control_compute_output(blower_control_state_t *state,
+                                             float envelope_pressure_pa,
+                                             bool measurement_valid,
+                                             uint32_t now_tick_ms) {
   float next_output = 0.0f;
 
-  blower_control_ensure_initialized_locked();
-
   if (!state->relay_enabled) {
     state->output_pwm_percent = 0u;
     blower_control_reset_pd_state(state);
-    restore_interrupts(irq_state);
     return 0u;
   }
 
@@ -324,7 +423,6 @@ uint8_t blower_control_step(float envelope_pressure_pa, bool measurement_valid,
     blower_control_reset_pd_state(state);
     state->startup_boost_active = true;
     state->startup_boost_start_tick_ms = 0u;
-    restore_interrupts(irq_state);
     return state->output_pwm_percent;
   }
 
@@ -334,15 +432,36 @@ uint8_t blower_control_step(float envelope_pressure_pa, bool measurement_valid,
     const float measured_abs_pressure = fabsf(filtered_pressure_pa);
     const bool target_reached =
         measured_abs_pressure >=
-        (state->target_pressure_pa * APP_CONTROL_STARTUP_TARGET_RATIO);
+        (state->target_pressure_pa * state->params.startup_target_ratio);
     const bool startup_overshoot_reached =
         measured_abs_pressure >=
-        (state->target_pressure_pa * APP_CONTROL_STARTUP_MAX_OVERSHOOT_RATIO);
+        (state->target_pressure_pa *
+         state->params.startup_max_overshoot_ratio);
     float error_pa = state->target_pressure_pa - measured_abs_pressure;
+    const float raw_error_pa = error_pa;
     float derivative_pa_per_s = 0.0f;
+    float raw_derivative_pa_per_s = 0.0f;
     float dt_s = (float)APP_CONTROL_LOOP_PERIOD_MS / 1000.0f;
     float control_base_pwm = 0.0f;
 
+    /* Readings near 0 Pa carry the wind, not the fan's direction. */
+    if (measured_abs_pressure >
+        fmaxf(state->params.deadband_pa,
+              state->target_pressure_pa *
+                  BLOWER_CONTROL_DIRECTION_MIN_TARGET_RATIO)) {
+      state->feedforward_direction =
+          filtered_pressure_pa >= 0.0f
+              ? BLOWER_FEEDFORWARD_DIRECTION_PRESSURIZATION
+              : BLOWER_FEEDFORWARD_DIRECTION_DEPRESSURIZATION;
+      state->feedforward_direction_known = true;
+    }
+
+    if (state->mode == BLOWER_CONTROL_MODE_PREDICTIVE_TARGET &&
+        blower_control_step_predictive(state, measured_abs_pressure,
+                                       now_tick_ms)) {
+      return state->output_pwm_percent;
+    }
+
     if (state->startup_boost_start_tick_ms == 0u) {
       state->startup_boost_start_tick_ms = now_tick_ms;
     }
@@ -351,10 +470,10 @@ uint8_t blower_control_step(float envelope_pressure_pa, bool measurement_valid,
       const uint32_t boost_elapsed_ms =
           now_tick_ms - state->startup_boost_start_tick_ms;
       const bool min_hold_elapsed =
-          boost_elapsed_ms >= APP_CONTROL_STARTUP_MIN_HOLD_MS;
+          boost_elapsed_ms >= state->params.startup_min_hold_ms;
       const bool max_hold_elapsed =
           (now_tick_ms - state->startup_boost_start_tick_ms) >=
-          APP_CONTROL_STARTUP_FULL_POWER_HOLD_MS;
+          state->params.startup_full_power_hold_ms;
       state->output_pwm_percent = 100u;
 
       if ((target_reached && min_hold_elapsed) || startup_overshoot_reached ||
@@ -365,12 +484,15 @@ uint8_t blower_control_step(float envelope_pressure_pa, bool measurement_valid,
         state->learning_start_tick_ms = now_tick_ms;
         state->learning_stable_cycles = 0u;
       } else {
-        restore_interrupts(irq_state);
         return state->output_pwm_percent;
       }
     }
 
-    if (fabsf(error_pa) < state->pd_deadband_pa) {
+    if (!state->feedforward_seed_checked) {
+      blower_control_seed_feedforward(state);
+    }
+
+    if (fabsf(error_pa) < state->params.deadband_pa) {
       error_pa = 0.0f;
     }
 
@@ -378,22 +500,24 @@ uint8_t blower_control_step(float envelope_pressure_pa, bool measurement_valid,
       dt_s = (float)(now_tick_ms - state->last_tick_ms) / 1000.0f;
       if (dt_s > 0.0001f) {
         derivative_pa_per_s = (error_pa - state->last_error_pa) / dt_s;
+        raw_derivative_pa_per_s =
+            (raw_error_pa - state->last_raw_error_pa) / dt_s;
       }
     }
 
     derivative_pa_per_s = blower_control_clampf(
-        derivative_pa_per_s, -APP_CONTROL_DERIVATIVE_CLAMP_PA_PER_S,
-        APP_CONTROL_DERIVATIVE_CLAMP_PA_PER_S);
+        derivative_pa_per_s, -state->params.derivative_clamp_pa_per_s,
+        state->params.derivative_clamp_pa_per_s);
 
     if (state->has_last_error &&
         (error_pa * state->last_error_pa) < 0.0f &&
-        fabsf(error_pa) > state->pd_deadband_pa) {
+        fabsf(error_pa) > state->params.deadband_pa) {
       const float decay = blower_control_clampf(
-          APP_CONTROL_INTEGRAL_DECAY_ON_SIGN_FLIP, 0.1f, 1.0f);
+          state->params.integral_decay_on_sign_flip, 0.1f, 1.0f);
       const float gain_scale_min =
-          blower_control_clampf(APP_CONTROL_GAIN_SCALE_MIN, 0.05f, 1.0f);
+          blower_control_clampf(state->params.gain_scale_min, 0.05f, 1.0f);
       const float gain_scale_shrink = blower_control_clampf(
-          APP_CONTROL_GAIN_SCALE_SHRINK, 0.0001f, 0.2f);
+          state->params.gain_scale_shrink, 0.0001f, 0.2f);
 
       state->integral_error_pa_s *= decay;
       state->gain_scale -= gain_scale_shrink;
@@ -407,90 +531,396 @@ uint8_t blower_control_step(float envelope_pressure_pa, bool measurement_valid,
       state->integral_error_pa_s *= 0.98f;
     } else {
       const float integral_limit =
-          blower_control_clampf(APP_CONTROL_INTEGRAL_LIMIT_PA_S, 5.0f, 500.0f);
+          blower_control_clampf(state->params.integral_limit_pa_s, 5.0f,
+                                500.0f);
       state->integral_error_pa_s = blower_control_clampf(
           state->integral_error_pa_s + (error_pa * dt_s), -integral_limit,
           integral_limit);
     }
 
-    blower_control_update_learning_state(state, error_pa, derivative_pa_per_s,
-                                         now_tick_ms);
+    /*
+     * The deadbanded error reads flat while the pressure sweeps through
+     * the band, so settling is judged on the raw error's slope; otherwise
+     * the startup pass-through is learned (and mapped) as steady state.
+     */
+    blower_control_update_learning_state(state, error_pa,
+                                         raw_derivative_pa_per_s, now_tick_ms);
+
+    /*
+     * Step limits are fractions of a percent per cycle, so ramp on the
+     * unrounded output; resync whenever another path rewrote the output.
+     */
+    if (fabsf(state->output_pwm_exact - (float)state->output_pwm_percent) >=
+        0.5f) {
+      state->output_pwm_exact = (float)state->output_pwm_percent;
+    }
 
     control_base_pwm = state->has_learned_feedforward_pwm
                            ? state->learned_feedforward_pwm
-                           : (float)state->output_pwm_percent;
+                           : state->output_pwm_exact;
 
     {
-      const float step_scale = blower_control_compute_step_scale(error_pa);
-      float max_step_up = state->pd_max_step_percent * step_scale;
-      float max_step_down = state->pd_max_step_down_percent * step_scale;
-      const float kp_eff = state->pd_kp * state->gain_scale;
-      const float ki_eff = state->pid_ki * state->gain_scale;
-      const float kd_eff = state->pd_kd * state->gain_scale;
+      const float step_scale =
+          blower_control_compute_step_scale(&state->params, error_pa);
+      float max_step_up = state->params.max_step_up_percent * step_scale;
+      float max_step_down = state->params.max_step_down_percent * step_scale;
+      const float kp_eff = state->params.kp * state->gain_scale;
+      const float ki_eff = state->params.ki * state->gain_scale;
+      const float kd_eff = state->params.kd * state->gain_scale;
 
       if (state->learning_active) {
-        max_step_up = fminf(max_step_up, APP_CONTROL_LEARNING_STEP_UP_PERCENT);
+        max_step_up =
+            fminf(max_step_up, state->params.learning_step_up_percent);
         max_step_down =
-            fminf(max_step_down, APP_CONTROL_LEARNING_STEP_DOWN_PERCENT);
+            fminf(max_step_down, state->params.learning_step_down_percent);
       }
 
       next_output = control_base_pwm + (kp_eff * error_pa) +
                     (ki_eff * state->integral_error_pa_s) +
                     (kd_eff * derivative_pa_per_s);
 
-      if (next_output > (float)state->output_pwm_percent + max_step_up) {
-        next_output = (float)state->output_pwm_percent + max_step_up;
-      } else if (next_output <
-                 (float)state->output_pwm_percent - max_step_down) {
-        next_output = (float)state->output_pwm_percent - max_step_down;
+      if (next_output > state->output_pwm_exact + max_step_up) {
+        next_output = state->output_pwm_exact + max_step_up;
+      } else if (next_output < state->output_pwm_exact - max_step_down) {
+        next_output = state->output_pwm_exact - max_step_down;
       }
     }
 
     next_output = blower_control_clampf(next_output, 0.0f, 100.0f);
+    state->output_pwm_exact = next_output;
     state->output_pwm_percent = (uint8_t)(next_output + 0.5f);
     state->last_error_pa = error_pa;
+    state->last_raw_error_pa = raw_error_pa;
     state->last_tick_ms = now_tick_ms;
     state->has_last_error = true;
   }
 
-  restore_interrupts(irq_state);
-  return g_state.output_pwm_percent;
+  return state->output_pwm_percent;
+}
+
+static void blower_control_apply_command(
+    blower_control_state_t *state, const blower_control_command_t *command) {
+  switch (command->type) {
+  case BLOWER_CONTROL_COMMAND_SET_MANUAL_PWM:
+    state->manual_pwm_percent = command->value.pwm_percent <= 100u
+                                    ? command->value.pwm_percent
+                                    : 100u;
+    if (!state->auto_hold_enabled && state->relay_enabled) {
+      state->output_pwm_percent = state->manual_pwm_percent;
+    }
+    break;
+
+  case BLOWER_CONTROL_COMMAND_SET_MODE:
+    blower_control_apply_mode(state, command->value.mode);
+    break;
+
+  case BLOWER_CONTROL_COMMAND_SET_AUTO_HOLD: {
+    blower_control_mode_t mode = BLOWER_CONTROL_MODE_MANUAL_PERCENT;
+
+    if (command->value.enabled) {
+      mode = state->mode == BLOWER_CONTROL_MODE_AUTO_TEST ||
+                     state->mode == BLOWER_CONTROL_MODE_PREDICTIVE_TARGET
+                 ? state->mode
+                 : BLOWER_CONTROL_MODE_SEMI_AUTO_TARGET;
+    }
+    blower_control_apply_mode(state, mode);
+    break;
+  }
+
+  case BLOWER_CONTROL_COMMAND_SET_RELAY:
+    state->relay_enabled = command->value.enabled;
+    if (!state->relay_enabled) {
+      /* The fan may be turned around before the next run. */
+      state->feedforward_direction_known = false;
+      state->output_pwm_percent = 0u;
+      blower_control_reset_pd_state(state);
+      state->startup_boost_active = true;
+      state->startup_boost_start_tick_ms = 0u;
+    } else if (!state->auto_hold_enabled) {
+      state->output_pwm_percent = state->manual_pwm_percent;
+    } else {
+      state->startup_boost_active = true;
+      state->startup_boost_start_tick_ms = 0u;
+      state->learned_feedforward_pwm = (float)state->output_pwm_percent;
+      state->has_learned_feedforward_pwm = false;
+      state->feedforward_seed_checked = false;
+    }
+    break;
+
+  case BLOWER_CONTROL_COMMAND_SET_TARGET_PRESSURE:
+    if (!isnan(command->value.target_pressure_pa) &&
+        command->value.target_pressure_pa >= 0.0f &&
+        command->value.target_pressure_pa <= 200.0f) {
+      state->target_pressure_pa = command->value.target_pressure_pa;
+      blower_control_reset_pd_state(state);
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+/*
+ * Multi-producer, single-consumer: producers claim a slot by CAS on the
+ * tail and mark it ready; only the control task advances the head.
+ */
+static bool blower_control_enqueue_command(
+    const blower_control_command_t *command) {
+  blower_control_command_queue_t *queue = &g_command_queue;
+  unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+  for (;;) {
+    const unsigned int head =
+        atomic_load_explicit(&queue->head, memory_order_acquire);
+
+    if ((tail - head) >= BLOWER_CONTROL_COMMAND_QUEUE_DEPTH) {
+      atomic_fetch_add_explicit(&queue->dropped, 1u, memory_order_relaxed);
+      return false;
+    }
+    if (atomic_compare_exchange_weak_explicit(&queue->tail, &tail, tail + 1u,
+                                              memory_order_acq_rel,
+                                              memory_order_relaxed)) {
+      break;
+    }
+  }
+
+  {
+    blower_control_command_slot_t *slot =
+        &queue->slots[tail % BLOWER_CONTROL_COMMAND_QUEUE_DEPTH];
+    slot->command = *command;
+    atomic_store_explicit(&slot->ready, 1u, memory_order_release);
+  }
+  return true;
+}
+
+static void blower_control_drain_commands(blower_control_state_t *state) {
+  blower_control_command_queue_t *queue = &g_command_queue;
+  unsigned int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+  for (;;) {
+    blower_control_command_slot_t *slot =
+        &queue->slots[head % BLOWER_CONTROL_COMMAND_QUEUE_DEPTH];
+    blower_control_command_t command;
+
+    /* A claimed but unfinished slot stalls the queue until the next step. */
+    if (atomic_load_explicit(&slot->ready, memory_order_acquire) == 0u) {
+      break;
+    }
+
+    command = slot->command;
+    atomic_store_explicit(&slot->ready, 0u, memory_order_relaxed);
+    head += 1u;
+    atomic_store_explicit(&queue->head, head, memory_order_release);
+    blower_control_apply_command(state, &command);
+  }
+}
+
+/*
+ * Runs after the queue is drained, so a relay-off or release always wins
+ * over anything queued in the same step.
+ */
+static void blower_control_apply_safety_latch(blower_control_state_t *state) {
+  const blower_control_command_t relay_off = {
+      .type = BLOWER_CONTROL_COMMAND_SET_RELAY,
+      .value.enabled = false,
+  };
+  const unsigned int latch =
+      atomic_exchange_explicit(&g_safety_latch, 0u, memory_order_acquire);
+
+  if (latch == 0u) {
+    return;
+  }
+
+  if ((latch & BLOWER_CONTROL_LATCH_RELEASE) != 0u) {
+    blower_control_apply_mode(state, BLOWER_CONTROL_MODE_MANUAL_PERCENT);
+    state->manual_pwm_percent = 0u;
+  }
+  blower_control_apply_command(state, &relay_off);
+}
+
+static void blower_control_fill_snapshot(
+    const blower_control_state_t *state,
+    blower_control_snapshot_t *out_snapshot) {
+  *out_snapshot = (blower_control_snapshot_t){
+      .manual_pwm_percent = state->manual_pwm_percent,
+      .output_pwm_percent = state->output_pwm_percent,
+      .mode = state->mode,
+      .auto_hold_enabled = state->auto_hold_enabled,
+      .relay_enabled = state->relay_enabled,
+      .target_pressure_pa = state->target_pressure_pa,
+      .pd_kp = state->params.kp,
+      .pd_kd = state->params.kd,
+      .pd_deadband_pa = state->params.deadband_pa,
+      .pd_max_step_percent = state->params.max_step_up_percent,
+      .line_sync = state->line_sync,
+      .line_frequency_hz = state->line_frequency_hz,
+      .model_valid = state->predictor.model.valid,
+      .model_gain_pa_per_percent = state->predictor.model.gain_pa_per_percent,
+      .model_time_constant_s = state->predictor.model.time_constant_s,
+      .model_dead_time_s = state->predictor.model.dead_time_s,
+      .dropped_commands =
+          atomic_load_explicit(&g_command_queue.dropped, memory_order_relaxed),
+  };
+}
+
+/*
+ * Latch-style seqlock: the sequence parity selects the copy readers use,
+ * and the writer only ever rewrites the other one, so a reader that
+ * preempts the control task mid-publish still finds a stable copy.
+ */
+static void blower_control_publish_snapshot(
+    const blower_control_state_t *state) {
+  blower_control_snapshot_t snapshot;
+  const unsigned int sequence =
+      atomic_load_explicit(&g_published.sequence, memory_order_relaxed);
+
+  blower_control_fill_snapshot(state, &snapshot);
+
+  atomic_store_explicit(&g_published.sequence, sequence + 1u,
+                        memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  g_published.copies[0] = snapshot;
+  atomic_store_explicit(&g_published.sequence, sequence + 2u,
+                        memory_order_release);
+  g_published.copies[1] = snapshot;
+}
+
+static void blower_control_ensure_initialized(void) {
+  if (!g_state.initialized) {
+    blower_control_initialize_defaults(&g_state);
+    blower_fopdt_predictor_reset(&g_state.predictor);
+  }
+}
+
+void blower_control_initialize(void) {
+  blower_feedforward_map_t stored_map;
+  const bool has_stored_map = blower_feedforward_map_load(&stored_map);
+
+  blower_control_initialize_defaults(&g_state);
+  blower_fopdt_predictor_reset(&g_state.predictor);
+  if (has_stored_map) {
+    g_state.feedforward_map = stored_map;
+  }
+  blower_control_params_service_init();
+  (void)blower_control_params_service_acquire(&g_state.params_generation,
+                                              &g_state.params);
+
+  blower_control_publish_snapshot(&g_state);
+}
+
+bool blower_control_set_manual_pwm_percent(uint8_t pwm_percent) {
+  return blower_control_enqueue_command(&(blower_control_command_t){
+      .type = BLOWER_CONTROL_COMMAND_SET_MANUAL_PWM,
+      .value.pwm_percent = pwm_percent,
+  });
+}
+
+bool blower_control_set_mode(blower_control_mode_t mode) {
+  if (!blower_control_mode_is_valid(mode)) {
+    return false;
+  }
+
+  return blower_control_enqueue_command(&(blower_control_command_t){
+      .type = BLOWER_CONTROL_COMMAND_SET_MODE,
+      .value.mode = mode,
+  });
+}
+
+bool blower_control_set_auto_hold_enabled(bool enabled) {
+  return blower_control_enqueue_command(&(blower_control_command_t){
+      .type = BLOWER_CONTROL_COMMAND_SET_AUTO_HOLD,
+      .value.enabled = enabled,
+  });
+}
+
+bool blower_control_set_relay_enabled(bool enabled) {
+  if (!enabled) {
+    atomic_fetch_or_explicit(&g_safety_latch, BLOWER_CONTROL_LATCH_RELAY_OFF,
+                             memory_order_release);
+    return true;
+  }
+
+  return blower_control_enqueue_command(&(blower_control_command_t){
+      .type = BLOWER_CONTROL_COMMAND_SET_RELAY,
+      .value.enabled = true,
+  });
+}
+
+bool blower_control_set_target_pressure_pa(float target_pressure_pa) {
+  return blower_control_enqueue_command(&(blower_control_command_t){
+      .type = BLOWER_CONTROL_COMMAND_SET_TARGET_PRESSURE,
+      .value.target_pressure_pa = target_pressure_pa,
+  });
+}
+
+void blower_control_release(void) {
+  atomic_fetch_or_explicit(&g_safety_latch, BLOWER_CONTROL_LATCH_RELEASE,
+                           memory_order_release);
+}
+
+uint8_t blower_control_step(float envelope_pressure_pa, bool measurement_valid,
+                            uint32_t now_tick_ms) {
+  uint8_t output_pwm_percent = 0u;
+
+  blower_control_ensure_initialized();
+  blower_control_drain_commands(&g_state);
+  blower_control_apply_safety_latch(&g_state);
+  /* Parameter sets only change between steps, never inside one. */
+  (void)blower_control_params_service_acquire(&g_state.params_generation,
+                                              &g_state.params);
+  output_pwm_percent = blower_control_compute_output(
+      &g_state, envelope_pressure_pa, measurement_valid, now_tick_ms);
+  blower_control_publish_snapshot(&g_state);
+
+  return output_pwm_percent;
 }
 
 void blower_control_update_line_feedback(bool line_sync, float line_frequency_hz) {
-  uint32_t irq_state = save_and_disable_interrupts();
-  blower_control_ensure_initialized_locked();
+  blower_control_ensure_initialized();
 
   g_state.line_sync = line_sync;
   g_state.line_frequency_hz = line_frequency_hz >= 0.0f ? line_frequency_hz : 0.0f;
 
-  restore_interrupts(irq_state);
+  blower_control_publish_snapshot(&g_state);
 }
 
-void blower_control_get_snapshot(blower_control_snapshot_t *out_snapshot) {
-  uint32_t irq_state = 0u;
+void blower_control_persist_pending(bool fan_running) {
+  blower_control_ensure_initialized();
 
-  if (out_snapshot == NULL) {
+  /*
+   * Flash programming masks interrupts, so only write while the fan is
+   * off: no relay request here and no power left in the TRIAC ISR.
+   */
+  if (fan_running || g_state.relay_enabled) {
     return;
   }
 
-  irq_state = save_and_disable_interrupts();
-  blower_control_ensure_initialized_locked();
+  if (g_state.feedforward_map_dirty) {
+    g_state.feedforward_map_dirty = false;
+    (void)blower_feedforward_map_store(&g_state.feedforward_map);
+  }
+  blower_control_params_service_persist_pending();
+}
 
-  *out_snapshot = (blower_control_snapshot_t){
-      .manual_pwm_percent = g_state.manual_pwm_percent,
-      .output_pwm_percent = g_state.output_pwm_percent,
-      .mode = g_state.mode,
-      .auto_hold_enabled = g_state.auto_hold_enabled,
-      .relay_enabled = g_state.relay_enabled,
-      .target_pressure_pa = g_state.target_pressure_pa,
-      .pd_kp = g_state.pd_kp,
-      .pd_kd = g_state.pd_kd,
-      .pd_deadband_pa = g_state.pd_deadband_pa,
-      .pd_max_step_percent = g_state.pd_max_step_percent,
-      .line_sync = g_state.line_sync,
-      .line_frequency_hz = g_state.line_frequency_hz,
-  };
+void blower_control_get_snapshot(blower_control_snapshot_t *out_snapshot) {
+  unsigned int sequence = 0u;
 
-  restore_interrupts(irq_state);
+  if (out_snapshot == NULL) {
+    return;
+  }
+
+  do {
+    sequence = atomic_load_explicit(&g_published.sequence, memory_order_acquire);
+    if (sequence == 0u) {
+      /* Nothing published yet: report the power-on defaults. */
+      blower_control_state_t defaults;
+      blower_control_initialize_defaults(&defaults);
+      blower_control_fill_snapshot(&defaults, out_snapshot);
+      return;
+    }
+    *out_snapshot = g_published.copies[sequence & 1u];
+    atomic_thread_fence(memory_order_acquire);
+  } while (atomic_load_explicit(&g_published.sequence, memory_order_relaxed) !=
+           sequence);
 }
@@ -0,0 +1,422 @@
+#include "services/blower_control_params.h"
+
+#include "app/app_config.h"
+#include "hardware/flash.h"
+#include "hardware/regs/addressmap.h"
+#include "services/flash_storage.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#define BLOWER_CONTROL_PARAMS_STORAGE_MAGIC 0x42435052u /* BCPR */
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t payload_size;
+  blower_control_params_t params;
+  uint32_t crc32;
+} blower_control_params_persistent_blob_t;
+
+#define BLOWER_CONTROL_PARAMS_STORAGE_IMAGE_SIZE                               \
+  (((sizeof(blower_control_params_persistent_blob_t) + FLASH_PAGE_SIZE - 1u) / \
+    FLASH_PAGE_SIZE) *                                                         \
+   FLASH_PAGE_SIZE)
+
+_Static_assert(BLOWER_CONTROL_PARAMS_STORAGE_IMAGE_SIZE <=
+                   APP_CONTROL_PARAMS_STORAGE_SIZE_BYTES,
+               "Control parameter blob is larger than its storage region");
+
+#define BLOWER_CONTROL_PARAM_FLOAT(field_name, member, min, max)               \
+  {                                                                            \
+    .name = field_name, .offset = offsetof(blower_control_params_t, member),   \
+    .type = BLOWER_CONTROL_PARAM_TYPE_FLOAT, .min_value = (min),               \
+    .max_value = (max)                                                         \
+  }
+
+#define BLOWER_CONTROL_PARAM_UINT32(field_name, member, min, max)              \
+  {                                                                            \
+    .name = field_name, .offset = offsetof(blower_control_params_t, member),   \
+    .type = BLOWER_CONTROL_PARAM_TYPE_UINT32, .min_value = (min),              \
+    .max_value = (max)                                                         \
+  }
+
+/* JSON keys are matched by wifi_task helpers, so keep names under 30 chars. */
+static const blower_control_param_field_t k_param_fields[] = {
+    BLOWER_CONTROL_PARAM_FLOAT("deadband_pa", deadband_pa, 0.0f, 10.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("kp", kp, 0.0f, 5.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("ki", ki, 0.0f, 1.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("kd", kd, 0.0f, 1.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("max_step_up_pct", max_step_up_percent, 0.01f,
+                               20.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("max_step_down_pct", max_step_down_percent,
+                               0.01f, 20.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("filter_alpha", filter_alpha, 0.01f, 1.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("derivative_clamp_pa_s",
+                               derivative_clamp_pa_per_s, 1.0f, 500.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("step_near_target_ratio",
+                               step_near_target_ratio, 0.05f, 1.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("step_far_error_pa", step_far_error_pa, 0.1f,
+                               200.0f),
+    BLOWER_CONTROL_PARAM_UINT32("learning_window_ms", learning_window_ms,
+                                500.0f, 120000.0f),
+    BLOWER_CONTROL_PARAM_UINT32("learning_stable_cycles",
+                                learning_stable_cycles, 1.0f, 10000.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("learning_settle_band_pa",
+                               learning_settle_band_pa, 0.5f, 10.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("learning_max_derivative_pa_s",
+                               learning_max_derivative_pa_per_s, 0.5f, 20.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("learning_ff_alpha", learning_feedforward_alpha,
+                               0.01f, 0.5f),
+    BLOWER_CONTROL_PARAM_FLOAT("learning_step_up_pct", learning_step_up_percent,
+                               0.01f, 10.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("learning_step_down_pct",
+                               learning_step_down_percent, 0.01f, 10.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("gain_scale_min", gain_scale_min, 0.05f, 1.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("gain_scale_max", gain_scale_max, 0.05f, 2.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("gain_scale_growth", gain_scale_growth, 0.0001f,
+                               0.05f),
+    BLOWER_CONTROL_PARAM_FLOAT("gain_scale_shrink", gain_scale_shrink, 0.0001f,
+                               0.2f),
+    BLOWER_CONTROL_PARAM_FLOAT("integral_limit_pa_s", integral_limit_pa_s, 5.0f,
+                               500.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("integral_decay_on_flip",
+                               integral_decay_on_sign_flip, 0.1f, 1.0f),
+    BLOWER_CONTROL_PARAM_UINT32("startup_min_hold_ms", startup_min_hold_ms,
+                                0.0f, 5000.0f),
+    BLOWER_CONTROL_PARAM_UINT32("startup_full_power_hold_ms",
+                                startup_full_power_hold_ms, 0.0f, 10000.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("startup_target_ratio", startup_target_ratio,
+                               0.1f, 1.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("startup_max_overshoot_ratio",
+                               startup_max_overshoot_ratio, 0.5f, 2.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("predictive_ident_step_pct",
+                               predictive_ident_step_percent, 5.0f, 100.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("predictive_step_up_pct",
+                               predictive_max_step_up_percent, 0.05f, 20.0f),
+    BLOWER_CONTROL_PARAM_FLOAT("predictive_step_down_pct",
+                               predictive_max_step_down_percent, 0.05f, 20.0f),
+};
+
+/*
+ * Two published copies: the writer fills the one readers are not using and
+ * then bumps the generation, whose parity selects the live copy.
+ */
+static blower_control_params_t g_published_params[2];
+static atomic_uint g_published_generation;
+static atomic_flag g_writer_busy = ATOMIC_FLAG_INIT;
+static atomic_bool g_persist_pending;
+static uint8_t g_storage_image_buffer[BLOWER_CONTROL_PARAMS_STORAGE_IMAGE_SIZE];
+
+static uint32_t blower_control_params_crc32_for_blob(
+    const blower_control_params_persistent_blob_t *blob) {
+  return flash_storage_crc32(
+      blob, offsetof(blower_control_params_persistent_blob_t, crc32));
+}
+
+static bool blower_control_params_storage_layout_is_valid(void) {
+  return flash_storage_region_is_valid(
+      APP_CONTROL_PARAMS_STORAGE_OFFSET_BYTES,
+      APP_CONTROL_PARAMS_STORAGE_SIZE_BYTES,
+      APP_CONTROL_FEEDFORWARD_STORAGE_OFFSET_BYTES +
+          APP_CONTROL_FEEDFORWARD_STORAGE_SIZE_BYTES);
+}
+
+static bool blower_control_params_load(blower_control_params_t *out_params) {
+  blower_control_params_persistent_blob_t loaded_blob = {0};
+
+  if (!blower_control_params_storage_layout_is_valid()) {
+    return false;
+  }
+
+  memcpy(&loaded_blob,
+         (const void *)(XIP_BASE + APP_CONTROL_PARAMS_STORAGE_OFFSET_BYTES),
+         sizeof(loaded_blob));
+
+  if (loaded_blob.magic != BLOWER_CONTROL_PARAMS_STORAGE_MAGIC ||
+      loaded_blob.version != BLOWER_CONTROL_PARAMS_SCHEMA_VERSION ||
+      loaded_blob.payload_size != sizeof(loaded_blob)) {
+    return false;
+  }
+
+  if (blower_control_params_crc32_for_blob(&loaded_blob) != loaded_blob.crc32 ||
+      !blower_control_params_validate(&loaded_blob.params, NULL)) {
+    return false;
+  }
+
+  *out_params = loaded_blob.params;
+  return true;
+}
+
+static bool blower_control_params_store(const blower_control_params_t *params) {
+  blower_control_params_persistent_blob_t blob = {0};
+
+  if (!blower_control_params_storage_layout_is_valid()) {
+    return false;
+  }
+
+  blob.magic = BLOWER_CONTROL_PARAMS_STORAGE_MAGIC;
+  blob.version = BLOWER_CONTROL_PARAMS_SCHEMA_VERSION;
+  blob.payload_size = sizeof(blob);
+  blob.params = *params;
+  blob.crc32 = blower_control_params_crc32_for_blob(&blob);
+
+  return flash_storage_write_image(
+      APP_CONTROL_PARAMS_STORAGE_OFFSET_BYTES, g_storage_image_buffer,
+      sizeof(g_storage_image_buffer), &blob, sizeof(blob));
+}
+
+/* Caller holds g_writer_busy. */
+static void blower_control_params_publish(const blower_control_params_t *params) {
+  const unsigned int generation =
+      atomic_load_explicit(&g_published_generation, memory_order_relaxed);
+
+  g_published_params[(generation + 1u) & 1u] = *params;
+  atomic_store_explicit(&g_published_generation, generation + 1u,
+                        memory_order_release);
+}
+
+static bool blower_control_params_read_published(
+    unsigned int *out_generation, blower_control_params_t *out_params) {
+  const unsigned int generation =
+      atomic_load_explicit(&g_published_generation, memory_order_acquire);
+
+  if (generation == 0u) {
+    blower_control_params_defaults(out_params);
+    *out_generation = 0u;
+    return true;
+  }
+
+  *out_params = g_published_params[generation & 1u];
+  atomic_thread_fence(memory_order_acquire);
+  *out_generation = generation;
+  return atomic_load_explicit(&g_published_generation, memory_order_relaxed) ==
+         generation;
+}
+
+void blower_control_params_defaults(blower_control_params_t *out_params) {
+  if (out_params == NULL) {
+    return;
+  }
+
+  *out_params = (blower_control_params_t){
+      .revision = 1u,
+      .deadband_pa = APP_CONTROL_PD_DEADBAND_PA,
+      .kp = APP_CONTROL_PD_KP,
+      .ki = APP_CONTROL_PID_KI,
+      .kd = APP_CONTROL_PD_KD,
+      .max_step_up_percent = APP_CONTROL_MAX_STEP_UP_PERCENT,
+      .max_step_down_percent = APP_CONTROL_MAX_STEP_DOWN_PERCENT,
+      .filter_alpha = APP_CONTROL_MEASUREMENT_FILTER_ALPHA,
+      .derivative_clamp_pa_per_s = APP_CONTROL_DERIVATIVE_CLAMP_PA_PER_S,
+      .step_near_target_ratio = APP_CONTROL_STEP_NEAR_TARGET_RATIO,
+      .step_far_error_pa = APP_CONTROL_STEP_FAR_ERROR_PA,
+      .learning_window_ms = APP_CONTROL_LEARNING_WINDOW_MS,
+      .learning_stable_cycles = APP_CONTROL_LEARNING_STABLE_CYCLES,
+      .learning_settle_band_pa = APP_CONTROL_LEARNING_SETTLE_BAND_PA,
+      .learning_max_derivative_pa_per_s =
+          APP_CONTROL_LEARNING_MAX_DERIVATIVE_PA_PER_S,
+      .learning_feedforward_alpha = APP_CONTROL_LEARNING_FEEDFORWARD_ALPHA,
+      .learning_step_up_percent = APP_CONTROL_LEARNING_STEP_UP_PERCENT,
+      .learning_step_down_percent = APP_CONTROL_LEARNING_STEP_DOWN_PERCENT,
+      .gain_scale_min = APP_CONTROL_GAIN_SCALE_MIN,
+      .gain_scale_max = APP_CONTROL_GAIN_SCALE_MAX,
+      .gain_scale_growth = APP_CONTROL_GAIN_SCALE_GROWTH,
+      .gain_scale_shrink = APP_CONTROL_GAIN_SCALE_SHRINK,
+      .integral_limit_pa_s = APP_CONTROL_INTEGRAL_LIMIT_PA_S,
+      .integral_decay_on_sign_flip = APP_CONTROL_INTEGRAL_DECAY_ON_SIGN_FLIP,
+      .startup_min_hold_ms = APP_CONTROL_STARTUP_MIN_HOLD_MS,
+      .startup_full_power_hold_ms = APP_CONTROL_STARTUP_FULL_POWER_HOLD_MS,
+      .startup_target_ratio = APP_CONTROL_STARTUP_TARGET_RATIO,
+      .startup_max_overshoot_ratio = APP_CONTROL_STARTUP_MAX_OVERSHOOT_RATIO,
+      .predictive_ident_step_percent = APP_CONTROL_PREDICTIVE_IDENT_STEP_PERCENT,
+      .predictive_max_step_up_percent =
+          APP_CONTROL_PREDICTIVE_MAX_STEP_UP_PERCENT,
+      .predictive_max_step_down_percent =
+          APP_CONTROL_PREDICTIVE_MAX_STEP_DOWN_PERCENT,
+  };
+}
+
+bool blower_control_params_validate(const blower_control_params_t *params,
+                                    const char **out_field) {
+  size_t index = 0u;
+
+  if (params == NULL) {
+    return false;
+  }
+
+  for (index = 0u; index < blower_control_params_field_count(); ++index) {
+    const blower_control_param_field_t *field = &k_param_fields[index];
+    const float value = blower_control_params_field_get(params, field);
+
+    if (!isfinite(value) || value < field->min_value ||
+        value > field->max_value) {
+      if (out_field != NULL) {
+        *out_field = field->name;
+      }
+      return false;
+    }
+  }
+
+  if (params->gain_scale_min > params->gain_scale_max) {
+    if (out_field != NULL) {
+      *out_field = "gain_scale_max";
+    }
+    return false;
+  }
+  if (params->startup_min_hold_ms > params->startup_full_power_hold_ms) {
+    if (out_field != NULL) {
+      *out_field = "startup_full_power_hold_ms";
+    }
+    return false;
+  }
+
+  return true;
+}
+
+size_t blower_control_params_field_count(void) {
+  return sizeof(k_param_fields) / sizeof(k_param_fields[0]);
+}
+
+const blower_control_param_field_t *blower_control_params_field(size_t index) {
+  if (index >= blower_control_params_field_count()) {
+    return NULL;
+  }
+
+  return &k_param_fields[index];
+}
+
+float blower_control_params_field_get(const blower_control_params_t *params,
+                                      const blower_control_param_field_t *field) {
+  const uint8_t *base = (const uint8_t *)params;
+
+  if (params == NULL || field == NULL) {
+    return NAN;
+  }
+
+  if (field->type == BLOWER_CONTROL_PARAM_TYPE_UINT32) {
+    uint32_t value = 0u;
+    memcpy(&value, base + field->offset, sizeof(value));
+    return (float)value;
+  }
+
+  {
+    float value = 0.0f;
+    memcpy(&value, base + field->offset, sizeof(value));
+    return value;
+  }
+}
+
+void blower_control_params_field_set(blower_control_params_t *params,
+                                     const blower_control_param_field_t *field,
+                                     float value) {
+  uint8_t *base = (uint8_t *)params;
+
+  if (params == NULL || field == NULL) {
+    return;
+  }
+
+  if (field->type == BLOWER_CONTROL_PARAM_TYPE_UINT32) {
+    /* Out-of-range values are left for validation to reject. */
+    const uint32_t rounded =
+        (isfinite(value) && value >= 0.0f && value <= 4294967040.0f)
+            ? (uint32_t)(value + 0.5f)
+            : 0xffffffffu;
+    memcpy(base + field->offset, &rounded, sizeof(rounded));
+    return;
+  }
+
+  memcpy(base + field->offset, &value, sizeof(value));
+}
+
+void blower_control_params_service_init(void) {
+  blower_control_params_t params;
+
+  if (!blower_control_params_load(&params)) {
+    blower_control_params_defaults(&params);
+  }
+
+  while (atomic_flag_test_and_set_explicit(&g_writer_busy,
+                                           memory_order_acquire)) {
+    /* Only contended by an HTTP write racing boot; it finishes quickly. */
+  }
+  blower_control_params_publish(&params);
+  atomic_flag_clear_explicit(&g_writer_busy, memory_order_release);
+}
+
+void blower_control_params_service_get(blower_control_params_t *out_params) {
+  unsigned int generation = 0u;
+
+  if (out_params == NULL) {
+    return;
+  }
+
+  while (!blower_control_params_read_published(&generation, out_params)) {
+  }
+}
+
+blower_control_params_result_t blower_control_params_service_set(
+    const blower_control_params_t *params, uint32_t expected_revision,
+    const char **out_invalid_field) {
+  blower_control_params_t current;
+  blower_control_params_t candidate;
+  blower_control_params_result_t result = BLOWER_CONTROL_PARAMS_OK;
+
+  if (params == NULL) {
+    return BLOWER_CONTROL_PARAMS_INVALID;
+  }
+  if (!blower_control_params_validate(params, out_invalid_field)) {
+    return BLOWER_CONTROL_PARAMS_INVALID;
+  }
+  if (atomic_flag_test_and_set_explicit(&g_writer_busy, memory_order_acquire)) {
+    return BLOWER_CONTROL_PARAMS_BUSY;
+  }
+
+  /* Writers are serialized, so the published copy cannot move under us. */
+  blower_control_params_service_get(&current);
+  if (expected_revision != 0u && expected_revision != current.revision) {
+    result = BLOWER_CONTROL_PARAMS_STALE_REVISION;
+  } else {
+    candidate = *params;
+    candidate.revision = current.revision + 1u;
+    blower_control_params_publish(&candidate);
+    atomic_store_explicit(&g_persist_pending, true, memory_order_relaxed);
+  }
+
+  atomic_flag_clear_explicit(&g_writer_busy, memory_order_release);
+  return result;
+}
+
+bool blower_control_params_service_acquire(uint32_t *inout_generation,
+                                           blower_control_params_t *out_params) {
+  blower_control_params_t candidate;
+  unsigned int generation = 0u;
+
+  if (inout_generation == NULL || out_params == NULL) {
+    return false;
+  }
+
+  if (atomic_load_explicit(&g_published_generation, memory_order_relaxed) ==
+      *inout_generation) {
+    return false;
+  }
+  if (!blower_control_params_read_published(&generation, &candidate)) {
+    return false;
+  }
+
+  *out_params = candidate;
+  *inout_generation = generation;
+  return true;
+}
+
+void blower_control_params_service_persist_pending(void) {
+  blower_control_params_t params;
+
+  if (!atomic_exchange_explicit(&g_persist_pending, false,
+                                memory_order_acq_rel)) {
+    return;
+  }
+
+  blower_control_params_service_get(&params);
+  (void)blower_control_params_store(&params);
+}
@@ -0,0 +1,285 @@
+#include "services/blower_fan_calibration.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#define BLOWER_FAN_CALIBRATION_MIN_PRESSURE_PA 0.5f
+#define BLOWER_FAN_CALIBRATION_MAX_PRESSURE_PA 2000.0f
+#define BLOWER_FAN_CALIBRATION_MAX_EXPONENT 2.0f
+
+static bool blower_fan_calibration_positive(float value) {
+  return isfinite(value) && value > 0.0f;
+}
+
+static void blower_fan_calibration_sort_table(
+    blower_fan_calibration_range_t *range) {
+  uint8_t i = 0u;
+
+  for (i = 1u; i < range->table_count; ++i) {
+    const float pressure = range->table_pressure_pa[i];
+    const float flow = range->table_flow_m3h[i];
+    uint8_t j = i;
+
+    while (j > 0u && range->table_pressure_pa[j - 1u] > pressure) {
+      range->table_pressure_pa[j] = range->table_pressure_pa[j - 1u];
+      range->table_flow_m3h[j] = range->table_flow_m3h[j - 1u];
+      j -= 1u;
+    }
+    range->table_pressure_pa[j] = pressure;
+    range->table_flow_m3h[j] = flow;
+  }
+}
+
+bool blower_fan_calibration_range_normalize(
+    blower_fan_calibration_range_t *range) {
+  uint8_t index = 0u;
+
+  if (range == NULL) {
+    return false;
+  }
+  if (!blower_fan_calibration_positive(range->min_pressure_pa) ||
+      !blower_fan_calibration_positive(range->max_pressure_pa) ||
+      range->min_pressure_pa < BLOWER_FAN_CALIBRATION_MIN_PRESSURE_PA ||
+      range->max_pressure_pa > BLOWER_FAN_CALIBRATION_MAX_PRESSURE_PA ||
+      range->max_pressure_pa <= range->min_pressure_pa) {
+    return false;
+  }
+
+  if (range->kind == (uint8_t)BLOWER_FAN_CALIBRATION_POWER_LAW) {
+    return blower_fan_calibration_positive(range->c) &&
+           blower_fan_calibration_positive(range->n) &&
+           range->n <= BLOWER_FAN_CALIBRATION_MAX_EXPONENT;
+  }
+  if (range->kind != (uint8_t)BLOWER_FAN_CALIBRATION_TABLE ||
+      range->table_count < 2u ||
+      range->table_count > BLOWER_FAN_CALIBRATION_MAX_TABLE_POINTS) {
+    return false;
+  }
+
+  for (index = 0u; index < range->table_count; ++index) {
+    if (!blower_fan_calibration_positive(range->table_pressure_pa[index]) ||
+        !blower_fan_calibration_positive(range->table_flow_m3h[index])) {
+      return false;
+    }
+  }
+  blower_fan_calibration_sort_table(range);
+  /* Flow has to rise with pressure for the curve to be invertible. */
+  for (index = 1u; index < range->table_count; ++index) {
+    if (range->table_pressure_pa[index] <=
+            range->table_pressure_pa[index - 1u] ||
+        range->table_flow_m3h[index] <= range->table_flow_m3h[index - 1u]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool blower_fan_calibration_range_equal(
+    const blower_fan_calibration_range_t *a,
+    const blower_fan_calibration_range_t *b) {
+  uint8_t index = 0u;
+
+  if (a->kind != b->kind || a->table_count != b->table_count ||
+      a->min_pressure_pa != b->min_pressure_pa ||
+      a->max_pressure_pa != b->max_pressure_pa || a->c != b->c ||
+      a->n != b->n) {
+    return false;
+  }
+  for (index = 0u; index < a->table_count &&
+                   index < BLOWER_FAN_CALIBRATION_MAX_TABLE_POINTS;
+       ++index) {
+    if (a->table_pressure_pa[index] != b->table_pressure_pa[index] ||
+        a->table_flow_m3h[index] != b->table_flow_m3h[index]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+float blower_fan_calibration_model_m3h(
+    const blower_fan_calibration_range_t *range, float pressure_pa) {
+  const float dp_abs = fabsf(pressure_pa);
+  uint8_t segment = 0u;
+  float p0 = 0.0f;
+  float p1 = 0.0f;
+  float q0 = 0.0f;
+  float q1 = 0.0f;
+
+  if (range == NULL || !(dp_abs > 0.0f)) {
+    return 0.0f;
+  }
+  if (range->kind == (uint8_t)BLOWER_FAN_CALIBRATION_POWER_LAW) {
+    return range->c * powf(dp_abs, range->n);
+  }
+  if (range->table_count < 2u) {
+    return 0.0f;
+  }
+
+  /* Log-log segment holding dP; the end segments extrapolate. */
+  while (segment + 2u < range->table_count &&
+         dp_abs > range->table_pressure_pa[segment + 1u]) {
+    segment += 1u;
+  }
+  p0 = range->table_pressure_pa[segment];
+  p1 = range->table_pressure_pa[segment + 1u];
+  q0 = range->table_flow_m3h[segment];
+  q1 = range->table_flow_m3h[segment + 1u];
+  return q0 * powf(dp_abs / p0, logf(q1 / q0) / logf(p1 / p0));
+}
+
+/*
+ * Largest |m (m - 1)| over the curve, m = 2 n being the exponent of Q in
+ * sqrt(dP). Linear interpolation of s^m with step h is off by about
+ * h^2 / 8 * |m (m - 1)| / s^2, relative.
+ */
+static float blower_fan_calibration_curvature(
+    const blower_fan_calibration_range_t *range) {
+  float worst = 0.0f;
+  uint8_t segment = 0u;
+
+  if (range->kind == (uint8_t)BLOWER_FAN_CALIBRATION_POWER_LAW) {
+    const float m = 2.0f * range->n;
+    return fabsf(m * (m - 1.0f));
+  }
+  for (segment = 0u; segment + 1u < range->table_count; ++segment) {
+    const float m =
+        2.0f * logf(range->table_flow_m3h[segment + 1u] /
+                    range->table_flow_m3h[segment]) /
+        logf(range->table_pressure_pa[segment + 1u] /
+             range->table_pressure_pa[segment]);
+    worst = fmaxf(worst, fabsf(m * (m - 1.0f)));
+  }
+  return worst;
+}
+
+void blower_fan_calibration_compile(const blower_fan_calibration_range_t *range,
+                                    blower_fan_calibration_curve_t *out_curve) {
+  const float intervals = (float)(BLOWER_FAN_CALIBRATION_LUT_SIZE - 1u);
+  float sqrt_max_pa = 0.0f;
+  float start_to_step = 0.0f;
+  float step = 0.0f;
+  uint32_t index = 0u;
+
+  if (out_curve == NULL) {
+    return;
+  }
+  memset(out_curve, 0, sizeof(*out_curve));
+  if (range == NULL) {
+    return;
+  }
+
+  out_curve->range = *range;
+  sqrt_max_pa = sqrtf(range->max_pressure_pa);
+  /*
+   * The error peaks in the first interval. Start the table where
+   * sqrt(dP) / step reaches sqrt(|m (m - 1)| / (8 * max error)); the
+   * 0.8 keeps the bound for m > 2, where the curvature peaks one step in.
+   */
+  start_to_step = sqrtf(blower_fan_calibration_curvature(range) /
+                        (8.0f * 0.8f * BLOWER_FAN_CALIBRATION_LUT_MAX_ERROR));
+  out_curve->sqrt_min_pa =
+      fmaxf(sqrtf(range->min_pressure_pa),
+            start_to_step * sqrt_max_pa / (intervals + start_to_step));
+  out_curve->lut_min_pa = out_curve->sqrt_min_pa * out_curve->sqrt_min_pa;
+  step = (sqrt_max_pa - out_curve->sqrt_min_pa) / intervals;
+  if (!(step > 0.0f)) {
+    return;
+  }
+  out_curve->inverse_step = 1.0f / step;
+
+  for (index = 0u; index < BLOWER_FAN_CALIBRATION_LUT_SIZE; ++index) {
+    const float root = out_curve->sqrt_min_pa + step * (float)index;
+    out_curve->lut_m3h[index] =
+        blower_fan_calibration_model_m3h(range, root * root);
+  }
+  out_curve->valid = true;
+}
+
+float blower_fan_calibration_evaluate(
+    const blower_fan_calibration_curve_t *curve, float pressure_pa,
+    bool *out_in_range) {
+  const float dp_abs = fabsf(pressure_pa);
+  bool in_range = false;
+  float position = 0.0f;
+  uint32_t index = 0u;
+
+  if (out_in_range != NULL) {
+    *out_in_range = false;
+  }
+  if (curve == NULL || !curve->valid || !(dp_abs > 0.0f)) {
+    return 0.0f;
+  }
+
+  in_range = dp_abs >= curve->range.min_pressure_pa &&
+             dp_abs <= curve->range.max_pressure_pa;
+  if (out_in_range != NULL) {
+    *out_in_range = in_range;
+  }
+  if (!in_range || dp_abs < curve->lut_min_pa) {
+    return blower_fan_calibration_model_m3h(&curve->range, dp_abs);
+  }
+
+  position = (sqrtf(dp_abs) - curve->sqrt_min_pa) * curve->inverse_step;
+  index = position > 0.0f ? (uint32_t)position : 0u;
+  if (index >= BLOWER_FAN_CALIBRATION_LUT_SIZE - 1u) {
+    index = BLOWER_FAN_CALIBRATION_LUT_SIZE - 2u;
+  }
+  return curve->lut_m3h[index] +
+         (position - (float)index) *
+             (curve->lut_m3h[index + 1u] - curve->lut_m3h[index]);
+}
+
+uint8_t blower_fan_calibration_suggest_range(
+    const blower_fan_calibration_range_t *ranges, uint8_t range_count,
+    uint8_t current_index, float flow_m3h) {
+  uint8_t best_covering = range_count;
+  float best_covering_max = 0.0f;
+  uint8_t best_nearest = current_index;
+  float best_nearest_ratio = INFINITY;
+  uint8_t index = 0u;
+
+  if (ranges == NULL || !(flow_m3h > 0.0f)) {
+    return current_index;
+  }
+
+  for (index = 0u; index < range_count; ++index) {
+    const float q_min =
+        blower_fan_calibration_model_m3h(&ranges[index],
+                                         ranges[index].min_pressure_pa);
+    const float q_max =
+        blower_fan_calibration_model_m3h(&ranges[index],
+                                         ranges[index].max_pressure_pa);
+
+    if (flow_m3h >= q_min && flow_m3h <= q_max) {
+      if (index == current_index) {
+        return current_index;
+      }
+      if (best_covering == range_count || q_max < best_covering_max) {
+        best_covering = index;
+        best_covering_max = q_max;
+      }
+    } else if (best_covering == range_count) {
+      const float ratio = flow_m3h < q_min ? q_min / flow_m3h
+                                           : flow_m3h / q_max;
+      if (ratio < best_nearest_ratio) {
+        best_nearest = index;
+        best_nearest_ratio = ratio;
+      }
+    }
+  }
+
+  return best_covering < range_count ? best_covering : best_nearest;
+}
+
+const char *blower_fan_calibration_kind_name(
+    blower_fan_calibration_kind_t kind) {
+  switch (kind) {
+  case BLOWER_FAN_CALIBRATION_POWER_LAW:
+    return "power_law";
+  case BLOWER_FAN_CALIBRATION_TABLE:
+    return "table";
+  default:
+    return "unknown";
+  }
+}
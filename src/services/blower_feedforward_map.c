@@ -0,0 +1,284 @@
+#include "services/blower_feedforward_map.h"
+
+#include "app/app_config.h"
+#include "hardware/flash.h"
+#include "hardware/regs/addressmap.h"
+#include "services/flash_storage.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BLOWER_FEEDFORWARD_STORAGE_MAGIC 0x4246464du /* BFFM */
+#define BLOWER_FEEDFORWARD_STORAGE_VERSION 1u
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t payload_size;
+  blower_feedforward_map_t map;
+  uint32_t crc32;
+} blower_feedforward_persistent_blob_t;
+
+#define BLOWER_FEEDFORWARD_STORAGE_IMAGE_SIZE                                  \
+  (((sizeof(blower_feedforward_persistent_blob_t) + FLASH_PAGE_SIZE - 1u) /    \
+    FLASH_PAGE_SIZE) *                                                         \
+   FLASH_PAGE_SIZE)
+
+static uint8_t g_storage_image_buffer[BLOWER_FEEDFORWARD_STORAGE_IMAGE_SIZE];
+
+_Static_assert(BLOWER_FEEDFORWARD_STORAGE_IMAGE_SIZE <=
+                   APP_CONTROL_FEEDFORWARD_STORAGE_SIZE_BYTES,
+               "Feedforward blob is larger than its storage region");
+
+static float blower_feedforward_clampf(float value, float min_value,
+                                       float max_value) {
+  if (value < min_value) {
+    return min_value;
+  }
+  if (value > max_value) {
+    return max_value;
+  }
+  return value;
+}
+
+static bool blower_feedforward_direction_is_valid(
+    blower_feedforward_direction_t direction) {
+  return direction == BLOWER_FEEDFORWARD_DIRECTION_PRESSURIZATION ||
+         direction == BLOWER_FEEDFORWARD_DIRECTION_DEPRESSURIZATION;
+}
+
+static float blower_feedforward_interpolate(
+    const blower_feedforward_map_entry_t *from,
+    const blower_feedforward_map_entry_t *to, float target_pressure_pa) {
+  const float span_pa = to->target_pressure_pa - from->target_pressure_pa;
+
+  if (fabsf(span_pa) < 0.001f) {
+    return (from->pwm_percent + to->pwm_percent) * 0.5f;
+  }
+
+  return from->pwm_percent +
+         (to->pwm_percent - from->pwm_percent) *
+             ((target_pressure_pa - from->target_pressure_pa) / span_pa);
+}
+
+void blower_feedforward_map_reset(blower_feedforward_map_t *map) {
+  if (map == NULL) {
+    return;
+  }
+
+  memset(map, 0, sizeof(*map));
+}
+
+bool blower_feedforward_map_lookup(const blower_feedforward_map_t *map,
+                                   blower_feedforward_direction_t direction,
+                                   float target_pressure_pa,
+                                   float *out_pwm_percent) {
+  const blower_feedforward_map_entry_t *entries = NULL;
+  uint8_t count = 0u;
+  uint8_t index = 0u;
+  float estimate = 0.0f;
+
+  if (map == NULL || out_pwm_percent == NULL ||
+      !blower_feedforward_direction_is_valid(direction) ||
+      !isfinite(target_pressure_pa)) {
+    return false;
+  }
+
+  entries = map->entries[direction];
+  count = map->entry_count[direction];
+  if (count == 0u || count > BLOWER_FEEDFORWARD_MAP_CAPACITY) {
+    return false;
+  }
+
+  if (count == 1u) {
+    /* A lone point says nothing about slope; only trust it close by. */
+    if (fabsf(target_pressure_pa - entries[0].target_pressure_pa) >
+        APP_CONTROL_FEEDFORWARD_MAP_EXTRAPOLATE_PA) {
+      return false;
+    }
+    *out_pwm_percent = entries[0].pwm_percent;
+    return true;
+  }
+
+  if (target_pressure_pa <= entries[0].target_pressure_pa) {
+    estimate = blower_feedforward_interpolate(&entries[0], &entries[1],
+                                              target_pressure_pa);
+  } else if (target_pressure_pa >= entries[count - 1u].target_pressure_pa) {
+    estimate = blower_feedforward_interpolate(
+        &entries[count - 2u], &entries[count - 1u], target_pressure_pa);
+  } else {
+    for (index = 0u; index + 1u < count; ++index) {
+      if (target_pressure_pa <= entries[index + 1u].target_pressure_pa) {
+        estimate = blower_feedforward_interpolate(
+            &entries[index], &entries[index + 1u], target_pressure_pa);
+        break;
+      }
+    }
+  }
+
+  if (!isfinite(estimate)) {
+    return false;
+  }
+
+  *out_pwm_percent = blower_feedforward_clampf(estimate, 0.0f, 100.0f);
+  return true;
+}
+
+bool blower_feedforward_map_record(blower_feedforward_map_t *map,
+                                   blower_feedforward_direction_t direction,
+                                   float target_pressure_pa,
+                                   float pwm_percent) {
+  const float alpha =
+      blower_feedforward_clampf(APP_CONTROL_FEEDFORWARD_MAP_ALPHA, 0.05f, 1.0f);
+  blower_feedforward_map_entry_t *entries = NULL;
+  uint8_t count = 0u;
+  uint8_t index = 0u;
+  uint8_t nearest_index = 0u;
+  float nearest_distance_pa = 0.0f;
+
+  if (map == NULL || !blower_feedforward_direction_is_valid(direction) ||
+      !isfinite(target_pressure_pa) || !isfinite(pwm_percent) ||
+      target_pressure_pa <= 0.0f) {
+    return false;
+  }
+
+  entries = map->entries[direction];
+  count = map->entry_count[direction];
+  if (count > BLOWER_FEEDFORWARD_MAP_CAPACITY) {
+    count = 0u;
+  }
+  pwm_percent = blower_feedforward_clampf(pwm_percent, 0.0f, 100.0f);
+
+  for (index = 0u; index < count; ++index) {
+    const float distance_pa =
+        fabsf(entries[index].target_pressure_pa - target_pressure_pa);
+    if (index == 0u || distance_pa < nearest_distance_pa) {
+      nearest_distance_pa = distance_pa;
+      nearest_index = index;
+    }
+  }
+
+  if (count > 0u && (nearest_distance_pa <= APP_CONTROL_FEEDFORWARD_MAP_MERGE_PA ||
+                     count >= BLOWER_FEEDFORWARD_MAP_CAPACITY)) {
+    blower_feedforward_map_entry_t *entry = &entries[nearest_index];
+    const float previous_pwm = entry->pwm_percent;
+
+    /*
+     * When the table is full the observation is folded into its nearest
+     * neighbour; the averaged target stays between the same neighbours, so
+     * the entries remain sorted.
+     */
+    if (nearest_distance_pa > APP_CONTROL_FEEDFORWARD_MAP_MERGE_PA) {
+      entry->target_pressure_pa =
+          (entry->target_pressure_pa + target_pressure_pa) * 0.5f;
+    }
+    entry->pwm_percent += alpha * (pwm_percent - entry->pwm_percent);
+
+    return fabsf(entry->pwm_percent - previous_pwm) >=
+               APP_CONTROL_FEEDFORWARD_MAP_MIN_CHANGE_PERCENT ||
+           nearest_distance_pa > APP_CONTROL_FEEDFORWARD_MAP_MERGE_PA;
+  }
+
+  index = count;
+  while (index > 0u &&
+         entries[index - 1u].target_pressure_pa > target_pressure_pa) {
+    entries[index] = entries[index - 1u];
+    index -= 1u;
+  }
+
+  entries[index] = (blower_feedforward_map_entry_t){
+      .target_pressure_pa = target_pressure_pa,
+      .pwm_percent = pwm_percent,
+  };
+  map->entry_count[direction] = (uint8_t)(count + 1u);
+  return true;
+}
+
+static uint32_t blower_feedforward_crc32_for_blob(
+    const blower_feedforward_persistent_blob_t *blob) {
+  return flash_storage_crc32(
+      blob, offsetof(blower_feedforward_persistent_blob_t, crc32));
+}
+
+static bool blower_feedforward_storage_layout_is_valid(void) {
+  return flash_storage_region_is_valid(
+      APP_CONTROL_FEEDFORWARD_STORAGE_OFFSET_BYTES,
+      APP_CONTROL_FEEDFORWARD_STORAGE_SIZE_BYTES,
+      APP_OTA_STAGING_OFFSET_BYTES + APP_OTA_STAGING_SIZE_BYTES);
+}
+
+static bool blower_feedforward_map_is_sane(const blower_feedforward_map_t *map) {
+  uint8_t direction = 0u;
+
+  for (direction = 0u; direction < BLOWER_FEEDFORWARD_DIRECTION_COUNT;
+       ++direction) {
+    uint8_t index = 0u;
+    const uint8_t count = map->entry_count[direction];
+
+    if (count > BLOWER_FEEDFORWARD_MAP_CAPACITY) {
+      return false;
+    }
+
+    for (index = 0u; index < count; ++index) {
+      const blower_feedforward_map_entry_t *entry =
+          &map->entries[direction][index];
+      if (!isfinite(entry->target_pressure_pa) ||
+          !isfinite(entry->pwm_percent) || entry->pwm_percent < 0.0f ||
+          entry->pwm_percent > 100.0f) {
+        return false;
+      }
+      if (index > 0u && entry->target_pressure_pa <
+                            map->entries[direction][index - 1u]
+                                .target_pressure_pa) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool blower_feedforward_map_load(blower_feedforward_map_t *out_map) {
+  blower_feedforward_persistent_blob_t loaded_blob = {0};
+
+  if (out_map == NULL || !blower_feedforward_storage_layout_is_valid()) {
+    return false;
+  }
+
+  memcpy(&loaded_blob,
+         (const void *)(XIP_BASE + APP_CONTROL_FEEDFORWARD_STORAGE_OFFSET_BYTES),
+         sizeof(loaded_blob));
+
+  if (loaded_blob.magic != BLOWER_FEEDFORWARD_STORAGE_MAGIC ||
+      loaded_blob.version != BLOWER_FEEDFORWARD_STORAGE_VERSION ||
+      loaded_blob.payload_size != sizeof(loaded_blob)) {
+    return false;
+  }
+
+  if (blower_feedforward_crc32_for_blob(&loaded_blob) != loaded_blob.crc32 ||
+      !blower_feedforward_map_is_sane(&loaded_blob.map)) {
+    return false;
+  }
+
+  *out_map = loaded_blob.map;
+  return true;
+}
+
+bool blower_feedforward_map_store(const blower_feedforward_map_t *map) {
+  blower_feedforward_persistent_blob_t blob = {0};
+
+  if (map == NULL || !blower_feedforward_storage_layout_is_valid()) {
+    return false;
+  }
+
+  blob.magic = BLOWER_FEEDFORWARD_STORAGE_MAGIC;
+  blob.version = BLOWER_FEEDFORWARD_STORAGE_VERSION;
+  blob.payload_size = sizeof(blob);
+  blob.map = *map;
+  blob.crc32 = blower_feedforward_crc32_for_blob(&blob);
+
+  return flash_storage_write_image(
+      APP_CONTROL_FEEDFORWARD_STORAGE_OFFSET_BYTES, g_storage_image_buffer,
+      sizeof(g_storage_image_buffer), &blob, sizeof(blob));
+}
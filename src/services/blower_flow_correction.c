@@ -0,0 +1,196 @@
+#include "services/blower_flow_correction.h"
+
+#include "app/app_config.h"
+#include "hardware/sync.h"
+#include <math.h>
+#include <stddef.h>
+
+#define BLOWER_FLOW_CORRECTION_FALLBACK_TEMPERATURE_C 20.0f
+#define BLOWER_FLOW_CORRECTION_MIN_TEMPERATURE_C -40.0f
+#define BLOWER_FLOW_CORRECTION_MAX_TEMPERATURE_C 80.0f
+#define BLOWER_FLOW_CORRECTION_MAX_ALTITUDE_M 6000.0f
+#define BLOWER_FLOW_CORRECTION_KELVIN_OFFSET 273.15f
+
+/*
+ * Everything that only depends on the site settings. Configured from one
+ * task at a time and read by every task, so it is built in a staging copy
+ * and swapped in under a short interrupt-off section; readers copy the
+ * curve only when the generation moved.
+ */
+typedef struct {
+  uint32_t generation;
+  blower_flow_correction_settings_t settings;
+  float pressure_over_gas_constant;
+  blower_fan_calibration_curve_t curve;
+} blower_flow_correction_site_t;
+
+static blower_flow_correction_site_t g_site;
+static blower_flow_correction_site_t g_staging_site;
+
+static float blower_flow_correction_clampf(float value, float min_value,
+                                           float max_value) {
+  if (!isfinite(value)) {
+    return min_value;
+  }
+  if (value < min_value) {
+    return min_value;
+  }
+  if (value > max_value) {
+    return max_value;
+  }
+  return value;
+}
+
+static bool blower_flow_correction_settings_equal(
+    const blower_flow_correction_settings_t *a,
+    const blower_flow_correction_settings_t *b) {
+  return a->altitude_m == b->altitude_m &&
+         blower_fan_calibration_range_equal(&a->fan_range, &b->fan_range);
+}
+
+static void blower_flow_correction_build_site(
+    const blower_flow_correction_settings_t *settings,
+    blower_flow_correction_site_t *out_site) {
+  const float altitude_m = blower_flow_correction_clampf(
+      settings->altitude_m, 0.0f, BLOWER_FLOW_CORRECTION_MAX_ALTITUDE_M);
+  /* Barometric formula (ISA troposphere), evaluated once per change. */
+  const float pressure_pa =
+      APP_REFERENCE_PRESSURE_PA *
+      powf(1.0f - 2.25577e-5f * altitude_m, 5.25588f);
+
+  out_site->generation = 0u;
+  out_site->settings = *settings;
+  out_site->pressure_over_gas_constant = pressure_pa / APP_AIR_GAS_CONSTANT;
+  blower_fan_calibration_compile(&settings->fan_range, &out_site->curve);
+}
+
+void blower_flow_correction_configure(
+    const blower_flow_correction_settings_t *settings) {
+  uint32_t irq_state = 0u;
+
+  if (settings == NULL ||
+      (g_site.generation != 0u &&
+       blower_flow_correction_settings_equal(&g_site.settings, settings))) {
+    return;
+  }
+
+  blower_flow_correction_build_site(settings, &g_staging_site);
+  irq_state = save_and_disable_interrupts();
+  g_staging_site.generation = g_site.generation + 1u;
+  if (g_staging_site.generation == 0u) {
+    g_staging_site.generation = 1u;
+  }
+  g_site = g_staging_site;
+  restore_interrupts(irq_state);
+}
+
+void blower_flow_correction_reset(blower_flow_correction_t *state) {
+  if (state == NULL) {
+    return;
+  }
+
+  *state = (blower_flow_correction_t){
+      .generation = 0u,
+      .temperature_c = BLOWER_FLOW_CORRECTION_FALLBACK_TEMPERATURE_C,
+      .density_kg_m3 = APP_SEA_LEVEL_AIR_DENSITY,
+      .density_factor = 1.0f,
+      .valid = false,
+  };
+  state->curve.valid = false;
+}
+
+void blower_flow_correction_refresh(blower_flow_correction_t *state,
+                                    float temperature_c) {
+  float pressure_over_gas_constant = 0.0f;
+  float temperature_k = 0.0f;
+  uint32_t irq_state = 0u;
+
+  if (state == NULL) {
+    return;
+  }
+
+  if (!isfinite(temperature_c)) {
+    temperature_c = state->valid
+                        ? state->temperature_c
+                        : BLOWER_FLOW_CORRECTION_FALLBACK_TEMPERATURE_C;
+  }
+
+  if (state->valid && state->generation == g_site.generation &&
+      fabsf(temperature_c - state->temperature_c) <
+          APP_FLOW_CORRECTION_TEMPERATURE_STEP_C) {
+    return;
+  }
+
+  irq_state = save_and_disable_interrupts();
+  if (state->generation != g_site.generation || !state->valid) {
+    state->curve = g_site.curve;
+    state->generation = g_site.generation;
+  }
+  pressure_over_gas_constant = g_site.pressure_over_gas_constant;
+  restore_interrupts(irq_state);
+
+  /* Nothing configured yet. */
+  if (state->generation == 0u) {
+    state->valid = false;
+    return;
+  }
+
+  temperature_k =
+      blower_flow_correction_clampf(temperature_c,
+                                    BLOWER_FLOW_CORRECTION_MIN_TEMPERATURE_C,
+                                    BLOWER_FLOW_CORRECTION_MAX_TEMPERATURE_C) +
+      BLOWER_FLOW_CORRECTION_KELVIN_OFFSET;
+
+  state->temperature_c = temperature_c;
+  state->density_kg_m3 = pressure_over_gas_constant / temperature_k;
+  state->density_factor =
+      state->density_kg_m3 > 0.0f
+          ? sqrtf(APP_SEA_LEVEL_AIR_DENSITY / state->density_kg_m3)
+          : 1.0f;
+  state->valid = true;
+}
+
+float blower_flow_correction_flow_m3h(const blower_flow_correction_t *state,
+                                      float fan_pressure_pa,
+                                      bool *out_in_range) {
+  if (out_in_range != NULL) {
+    *out_in_range = false;
+  }
+  if (state == NULL || !state->valid) {
+    return 0.0f;
+  }
+  return state->density_factor *
+         blower_fan_calibration_evaluate(&state->curve, fan_pressure_pa,
+                                         out_in_range);
+}
+
+float blower_flow_correction_pitot_speed_ms(
+    const blower_flow_correction_t *state, float fan_pressure_pa) {
+  const float dp_abs = fabsf(fan_pressure_pa);
+
+  if (state == NULL || !state->valid || state->density_kg_m3 <= 0.0f ||
+      !(dp_abs > 0.0f)) {
+    return 0.0f;
+  }
+  return sqrtf(2.0f * dp_abs / state->density_kg_m3);
+}
+
+float blower_flow_correction_density_kg_m3(float temperature_c) {
+  float pressure_over_gas_constant = 0.0f;
+  const uint32_t irq_state = save_and_disable_interrupts();
+
+  pressure_over_gas_constant = g_site.pressure_over_gas_constant;
+  restore_interrupts(irq_state);
+
+  if (!isfinite(temperature_c)) {
+    temperature_c = BLOWER_FLOW_CORRECTION_FALLBACK_TEMPERATURE_C;
+  }
+  if (!(pressure_over_gas_constant > 0.0f)) {
+    return APP_SEA_LEVEL_AIR_DENSITY;
+  }
+  return pressure_over_gas_constant /
+         (blower_flow_correction_clampf(
+              temperature_c, BLOWER_FLOW_CORRECTION_MIN_TEMPERATURE_C,
+              BLOWER_FLOW_CORRECTION_MAX_TEMPERATURE_C) +
+          BLOWER_FLOW_CORRECTION_KELVIN_OFFSET);
+}
@@ -0,0 +1,426 @@
+#include "services/blower_fopdt_predictor.h"
+
+#include "app/app_config.h"
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#define BLOWER_FOPDT_Q16_ONE 65536
+#define BLOWER_FOPDT_OUTPUT_MAX_Q16 (100 * BLOWER_FOPDT_Q16_ONE)
+#define BLOWER_FOPDT_STEADY_SAMPLES 4u
+
+static float blower_fopdt_clampf(float value, float min_value,
+                                 float max_value) {
+  if (value < min_value) {
+    return min_value;
+  }
+  if (value > max_value) {
+    return max_value;
+  }
+  return value;
+}
+
+static int32_t blower_fopdt_to_q16(float value) {
+  const float scaled = blower_fopdt_clampf(value * (float)BLOWER_FOPDT_Q16_ONE,
+                                           -2147483520.0f, 2147483520.0f);
+  return (int32_t)(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+}
+
+static float blower_fopdt_from_q16(int32_t value) {
+  return (float)value / (float)BLOWER_FOPDT_Q16_ONE;
+}
+
+static int32_t blower_fopdt_mul_q16(int32_t lhs, int32_t rhs) {
+  return (int32_t)(((int64_t)lhs * (int64_t)rhs) >> 16);
+}
+
+static int32_t blower_fopdt_clamp_q16(int32_t value, int32_t min_value,
+                                      int32_t max_value) {
+  if (value < min_value) {
+    return min_value;
+  }
+  if (value > max_value) {
+    return max_value;
+  }
+  return value;
+}
+
+static float blower_fopdt_loop_period_s(void) {
+  return (float)APP_CONTROL_LOOP_PERIOD_MS / 1000.0f;
+}
+
+static int16_t blower_fopdt_pressure_to_cpa(float pressure_pa) {
+  return (int16_t)(blower_fopdt_clampf(pressure_pa, -327.0f, 327.0f) *
+                   100.0f);
+}
+
+static float blower_fopdt_sample_pa(const blower_fopdt_predictor_t *predictor,
+                                    uint16_t index) {
+  return (float)predictor->ident_samples_cpa[index] / 100.0f;
+}
+
+/*
+ * Keeps the identification window bounded: once the buffer is full every
+ * other sample is dropped and the sampling interval doubles.
+ */
+static void blower_fopdt_compact_samples(blower_fopdt_predictor_t *predictor) {
+  uint16_t index = 0u;
+
+  for (index = 0u; index < BLOWER_FOPDT_IDENT_CAPACITY / 2u; ++index) {
+    predictor->ident_samples_cpa[index] =
+        predictor->ident_samples_cpa[index * 2u];
+  }
+
+  predictor->ident_count = BLOWER_FOPDT_IDENT_CAPACITY / 2u;
+  predictor->ident_decimation *= 2u;
+}
+
+static bool blower_fopdt_find_crossing_s(
+    const blower_fopdt_predictor_t *predictor, float base_pa, float delta_pa,
+    float fraction, float *out_time_s) {
+  const float sample_period_s =
+      blower_fopdt_loop_period_s() * (float)predictor->ident_decimation;
+  float previous_ratio = 0.0f;
+  uint16_t index = 0u;
+
+  for (index = 0u; index < predictor->ident_count; ++index) {
+    const float ratio =
+        (blower_fopdt_sample_pa(predictor, index) - base_pa) / delta_pa;
+
+    if (ratio >= fraction) {
+      float interpolation = 0.0f;
+
+      if (index > 0u && ratio > previous_ratio) {
+        interpolation = (fraction - previous_ratio) / (ratio - previous_ratio);
+        interpolation = blower_fopdt_clampf(interpolation, 0.0f, 1.0f);
+        *out_time_s = ((float)(index - 1u) + interpolation) * sample_period_s;
+      } else {
+        *out_time_s = (float)index * sample_period_s;
+      }
+      return true;
+    }
+
+    previous_ratio = ratio;
+  }
+
+  return false;
+}
+
+static float blower_fopdt_plant_exponent(void) {
+  return blower_fopdt_clampf(APP_CONTROL_PREDICTIVE_PLANT_EXPONENT, 1.0f, 3.0f);
+}
+
+static void blower_fopdt_apply_model(blower_fopdt_predictor_t *predictor,
+                                     float gain_pa_per_percent) {
+  const float loop_period_s = blower_fopdt_loop_period_s();
+  const float lambda_ratio =
+      blower_fopdt_clampf(APP_CONTROL_PREDICTIVE_LAMBDA_RATIO, 0.1f, 4.0f);
+  const blower_fopdt_model_t *model = &predictor->model;
+  const float lambda_s =
+      fmaxf(model->time_constant_s * lambda_ratio, loop_period_s);
+  const float delay_steps = model->dead_time_s / loop_period_s + 0.5f;
+  /* SIMC tuning on the delay-free plant: Ti = tau, closed loop ~ lambda. */
+  const float kc = model->time_constant_s / (gain_pa_per_percent * lambda_s);
+  const float ki = loop_period_s / (gain_pa_per_percent * lambda_s);
+
+  predictor->gain_q16 = blower_fopdt_to_q16(gain_pa_per_percent);
+  predictor->model_alpha_q16 = blower_fopdt_to_q16(
+      1.0f - expf(-loop_period_s / model->time_constant_s));
+  predictor->kc_q16 = blower_fopdt_to_q16(kc);
+  predictor->ki_q16 = blower_fopdt_to_q16(ki);
+  predictor->delay_steps = (uint8_t)blower_fopdt_clampf(
+      delay_steps, 0.0f, (float)(BLOWER_FOPDT_DELAY_CAPACITY - 1u));
+}
+
+/*
+ * Two-point (28.3% / 63.2%) fit of gain, time constant and dead time from the
+ * recorded open-loop step response.
+ */
+static void blower_fopdt_finish_identification(
+    blower_fopdt_predictor_t *predictor) {
+  const float loop_period_s = blower_fopdt_loop_period_s();
+  const float min_response_pa =
+      fmaxf(APP_CONTROL_PREDICTIVE_IDENT_MIN_RESPONSE_PA, 0.5f);
+  const float step_percent = predictor->ident_step_output_percent -
+                             predictor->ident_base_output_percent;
+  const uint16_t steady_count = predictor->ident_count < BLOWER_FOPDT_STEADY_SAMPLES
+                                    ? predictor->ident_count
+                                    : BLOWER_FOPDT_STEADY_SAMPLES;
+  float steady_pa = 0.0f;
+  float delta_pa = 0.0f;
+  float t28_s = 0.0f;
+  float t63_s = 0.0f;
+  float time_constant_s = 0.0f;
+  float dead_time_s = 0.0f;
+  uint16_t index = 0u;
+
+  predictor->state = BLOWER_FOPDT_STATE_FAILED;
+  predictor->model.valid = false;
+
+  if (steady_count == 0u || fabsf(step_percent) < 1.0f) {
+    return;
+  }
+
+  for (index = predictor->ident_count - steady_count;
+       index < predictor->ident_count; ++index) {
+    steady_pa += blower_fopdt_sample_pa(predictor, index);
+  }
+  steady_pa /= (float)steady_count;
+  delta_pa = steady_pa - predictor->ident_base_pressure_pa;
+
+  if (delta_pa < min_response_pa ||
+      !blower_fopdt_find_crossing_s(predictor,
+                                    predictor->ident_base_pressure_pa,
+                                    delta_pa, 0.283f, &t28_s) ||
+      !blower_fopdt_find_crossing_s(predictor,
+                                    predictor->ident_base_pressure_pa,
+                                    delta_pa, 0.632f, &t63_s)) {
+    return;
+  }
+
+  time_constant_s = fmaxf(1.5f * (t63_s - t28_s), loop_period_s);
+  dead_time_s = fmaxf(t63_s - time_constant_s, 0.0f);
+
+  predictor->model = (blower_fopdt_model_t){
+      .gain_pa_per_percent = delta_pa / step_percent,
+      .time_constant_s = time_constant_s,
+      .dead_time_s = dead_time_s,
+      .static_output_percent = predictor->ident_step_output_percent,
+      .static_pressure_pa = steady_pa,
+      .valid = true,
+  };
+  blower_fopdt_apply_model(predictor, predictor->model.gain_pa_per_percent);
+  predictor->state = BLOWER_FOPDT_STATE_TRACKING;
+  predictor->tracking_primed = false;
+}
+
+void blower_fopdt_predictor_reset(blower_fopdt_predictor_t *predictor) {
+  if (predictor == NULL) {
+    return;
+  }
+
+  memset(predictor, 0, sizeof(*predictor));
+  predictor->state = BLOWER_FOPDT_STATE_IDLE;
+  predictor->ident_decimation = 1u;
+}
+
+void blower_fopdt_predictor_restart(blower_fopdt_predictor_t *predictor) {
+  if (predictor == NULL) {
+    return;
+  }
+
+  if (predictor->state == BLOWER_FOPDT_STATE_IDENTIFYING) {
+    predictor->state = BLOWER_FOPDT_STATE_IDLE;
+  } else if (predictor->state == BLOWER_FOPDT_STATE_TRACKING) {
+    predictor->tracking_primed = false;
+  }
+}
+
+void blower_fopdt_predictor_begin_identification(
+    blower_fopdt_predictor_t *predictor, float base_output_percent,
+    float base_pressure_pa, float step_output_percent,
+    float abort_pressure_pa, uint32_t now_tick_ms) {
+  if (predictor == NULL) {
+    return;
+  }
+
+  blower_fopdt_predictor_reset(predictor);
+  predictor->state = BLOWER_FOPDT_STATE_IDENTIFYING;
+  predictor->ident_start_tick_ms = now_tick_ms;
+  predictor->ident_base_output_percent =
+      blower_fopdt_clampf(base_output_percent, 0.0f, 100.0f);
+  predictor->ident_step_output_percent =
+      blower_fopdt_clampf(step_output_percent, 0.0f, 100.0f);
+  predictor->ident_base_pressure_pa = base_pressure_pa;
+  predictor->ident_abort_pressure_pa = abort_pressure_pa;
+}
+
+float blower_fopdt_predictor_identify(blower_fopdt_predictor_t *predictor,
+                                      float measured_pressure_pa,
+                                      uint32_t now_tick_ms) {
+  const uint32_t settle_window_cycles =
+      APP_CONTROL_PREDICTIVE_IDENT_SETTLE_WINDOW_MS / APP_CONTROL_LOOP_PERIOD_MS;
+  uint32_t elapsed_ms = 0u;
+
+  if (predictor == NULL) {
+    return 0.0f;
+  }
+  if (predictor->state != BLOWER_FOPDT_STATE_IDENTIFYING) {
+    return predictor->ident_base_output_percent;
+  }
+
+  /*
+   * The step is open loop, so nothing else stops it from driving the
+   * envelope far past the target. Give up and let the caller fall back.
+   */
+  if (measured_pressure_pa >= predictor->ident_abort_pressure_pa) {
+    predictor->state = BLOWER_FOPDT_STATE_FAILED;
+    predictor->model.valid = false;
+    return predictor->ident_base_output_percent;
+  }
+
+  if ((predictor->ident_cycles % predictor->ident_decimation) == 0u) {
+    if (predictor->ident_count >= BLOWER_FOPDT_IDENT_CAPACITY) {
+      blower_fopdt_compact_samples(predictor);
+    }
+    predictor->ident_samples_cpa[predictor->ident_count++] =
+        blower_fopdt_pressure_to_cpa(measured_pressure_pa);
+  }
+
+  /* Dead time looks flat too; only count quiet cycles once it responded. */
+  if (predictor->ident_cycles >= settle_window_cycles &&
+      fabsf(measured_pressure_pa - predictor->ident_base_pressure_pa) >=
+          APP_CONTROL_PREDICTIVE_IDENT_MIN_RESPONSE_PA) {
+    const uint32_t reference_index =
+        (predictor->ident_cycles - settle_window_cycles) /
+        predictor->ident_decimation;
+    const float drift_pa =
+        measured_pressure_pa -
+        blower_fopdt_sample_pa(predictor, (uint16_t)reference_index);
+
+    if (fabsf(drift_pa) <= APP_CONTROL_PREDICTIVE_IDENT_SETTLE_PA) {
+      if (predictor->ident_quiet_cycles < 65535u) {
+        predictor->ident_quiet_cycles += 1u;
+      }
+    } else {
+      predictor->ident_quiet_cycles = 0u;
+    }
+  }
+
+  if (predictor->ident_cycles < 65535u) {
+    predictor->ident_cycles += 1u;
+  }
+
+  elapsed_ms = now_tick_ms - predictor->ident_start_tick_ms;
+  if ((elapsed_ms >= APP_CONTROL_PREDICTIVE_IDENT_MIN_MS &&
+       predictor->ident_quiet_cycles >=
+           APP_CONTROL_PREDICTIVE_IDENT_SETTLE_CYCLES) ||
+      elapsed_ms >= APP_CONTROL_PREDICTIVE_IDENT_TIMEOUT_MS) {
+    blower_fopdt_finish_identification(predictor);
+  }
+
+  return predictor->ident_step_output_percent;
+}
+
+bool blower_fopdt_predictor_steady_output(
+    const blower_fopdt_predictor_t *predictor, float target_pressure_pa,
+    float *out_output_percent) {
+  const blower_fopdt_model_t *model = NULL;
+
+  if (predictor == NULL || out_output_percent == NULL ||
+      !predictor->model.valid || target_pressure_pa <= 0.0f) {
+    return false;
+  }
+
+  model = &predictor->model;
+  if (model->static_pressure_pa <= 0.0f ||
+      model->static_output_percent <= 0.0f) {
+    return false;
+  }
+
+  *out_output_percent = blower_fopdt_clampf(
+      model->static_output_percent *
+          powf(target_pressure_pa / model->static_pressure_pa,
+               1.0f / blower_fopdt_plant_exponent()),
+      0.0f, 100.0f);
+  return true;
+}
+
+/*
+ * The step is identified at one operating point; the fan law makes the
+ * incremental gain grow with pressure, so rescale it for the new target.
+ */
+static void blower_fopdt_schedule_gain(blower_fopdt_predictor_t *predictor,
+                                       float target_pressure_pa) {
+  float steady_output = 0.0f;
+  float gain = predictor->model.gain_pa_per_percent;
+
+  if (target_pressure_pa >= APP_CONTROL_PREDICTIVE_IDENT_MIN_RESPONSE_PA &&
+      blower_fopdt_predictor_steady_output(predictor, target_pressure_pa,
+                                           &steady_output) &&
+      steady_output >= 1.0f) {
+    gain = blower_fopdt_plant_exponent() * target_pressure_pa / steady_output;
+  }
+
+  blower_fopdt_apply_model(predictor, fmaxf(gain, 0.01f));
+}
+
+float blower_fopdt_predictor_control(blower_fopdt_predictor_t *predictor,
+                                     float target_pressure_pa,
+                                     float measured_pressure_pa,
+                                     float current_output_percent,
+                                     float feedforward_output_percent,
+                                     float max_step_up_percent,
+                                     float max_step_down_percent) {
+  int32_t model_delayed_q16 = 0;
+  int32_t error_q16 = 0;
+  int32_t delta_q16 = 0;
+  uint8_t delayed_index = 0u;
+
+  if (predictor == NULL || predictor->state != BLOWER_FOPDT_STATE_TRACKING) {
+    return current_output_percent;
+  }
+
+  if (!predictor->tracking_primed) {
+    blower_fopdt_schedule_gain(predictor, target_pressure_pa);
+    predictor->base_output_q16 = blower_fopdt_to_q16(
+        blower_fopdt_clampf(current_output_percent, 0.0f, 100.0f));
+    /*
+     * Jump straight to the feedforward estimate; the model sees the jump
+     * as a step, so the predictor expects the delayed pressure rise.
+     */
+    predictor->output_q16 =
+        feedforward_output_percent >= 0.0f
+            ? blower_fopdt_to_q16(
+                  blower_fopdt_clampf(feedforward_output_percent, 0.0f, 100.0f))
+            : predictor->base_output_q16;
+    predictor->model_output_q16 = 0;
+    predictor->delay_head = 0u;
+    memset(predictor->delay_line_q16, 0, sizeof(predictor->delay_line_q16));
+    predictor->has_last_error = false;
+    predictor->tracking_primed = true;
+  }
+
+  /* Advance the delay-free model with the output applied last period. */
+  {
+    const int32_t model_target_q16 = blower_fopdt_mul_q16(
+        predictor->gain_q16,
+        predictor->output_q16 - predictor->base_output_q16);
+    predictor->model_output_q16 += blower_fopdt_mul_q16(
+        predictor->model_alpha_q16,
+        model_target_q16 - predictor->model_output_q16);
+  }
+
+  predictor->delay_line_q16[predictor->delay_head] = predictor->model_output_q16;
+  delayed_index = (uint8_t)((predictor->delay_head + BLOWER_FOPDT_DELAY_CAPACITY -
+                             predictor->delay_steps) %
+                            BLOWER_FOPDT_DELAY_CAPACITY);
+  model_delayed_q16 = predictor->delay_line_q16[delayed_index];
+  predictor->delay_head =
+      (uint8_t)((predictor->delay_head + 1u) % BLOWER_FOPDT_DELAY_CAPACITY);
+
+  /*
+   * Smith predictor: the PI sees the measurement shifted forward by the
+   * model's prediction of what the dead time is still hiding.
+   */
+  error_q16 = blower_fopdt_to_q16(target_pressure_pa) -
+              (blower_fopdt_to_q16(measured_pressure_pa) +
+               predictor->model_output_q16 - model_delayed_q16);
+
+  /* Velocity-form PI: output clamping doubles as anti-windup. */
+  delta_q16 = blower_fopdt_mul_q16(predictor->ki_q16, error_q16);
+  if (predictor->has_last_error) {
+    delta_q16 += blower_fopdt_mul_q16(predictor->kc_q16,
+                                      error_q16 - predictor->last_error_q16);
+  }
+  delta_q16 = blower_fopdt_clamp_q16(
+      delta_q16, -blower_fopdt_to_q16(fmaxf(max_step_down_percent, 0.0f)),
+      blower_fopdt_to_q16(fmaxf(max_step_up_percent, 0.0f)));
+
+  predictor->output_q16 = blower_fopdt_clamp_q16(
+      predictor->output_q16 + delta_q16, 0, BLOWER_FOPDT_OUTPUT_MAX_Q16);
+  predictor->last_error_q16 = error_q16;
+  predictor->has_last_error = true;
+
+  return blower_fopdt_from_q16(predictor->output_q16);
+}
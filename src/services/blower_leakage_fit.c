@@ -0,0 +1,431 @@
+#include "services/blower_leakage_fit.h"
+
+#include "services/blower_running_stats.h"
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#define BLOWER_LEAKAGE_FIT_MIN_REL_VARIANCE 1.0e-6f
+#define BLOWER_LEAKAGE_FIT_PRIOR_EXPONENT 0.65f
+#define BLOWER_LEAKAGE_FIT_HUBER_K 1.345f
+#define BLOWER_LEAKAGE_FIT_MAD_SCALE 1.4826f
+#define BLOWER_LEAKAGE_FIT_HUBER_MAX_ITERATIONS 20u
+#define BLOWER_LEAKAGE_FIT_HUBER_TOLERANCE 1.0e-6f
+
+typedef struct {
+  float sum;
+  float compensation;
+} blower_leakage_fit_kahan_t;
+
+typedef struct {
+  float intercept;
+  float slope;
+  float x_mean;
+  float sxx;
+  float sxy;
+  float syy;
+  float weight_sum;
+  float sse;
+} blower_leakage_fit_line_t;
+
+static void blower_leakage_fit_kahan_add(blower_leakage_fit_kahan_t *acc,
+                                         float value) {
+  const float corrected = value - acc->compensation;
+  const float next_sum = acc->sum + corrected;
+  acc->compensation = (next_sum - acc->sum) - corrected;
+  acc->sum = next_sum;
+}
+
+static void blower_leakage_fit_sort(float *values, size_t count) {
+  size_t outer = 0u;
+
+  for (outer = 1u; outer < count; ++outer) {
+    const float value = values[outer];
+    size_t inner = outer;
+    while (inner > 0u && values[inner - 1u] > value) {
+      values[inner] = values[inner - 1u];
+      --inner;
+    }
+    values[inner] = value;
+  }
+}
+
+static float blower_leakage_fit_median(float *values, size_t count) {
+  if (count == 0u) {
+    return 0.0f;
+  }
+
+  blower_leakage_fit_sort(values, count);
+  if ((count % 2u) == 1u) {
+    return values[count / 2u];
+  }
+  return 0.5f * (values[count / 2u - 1u] + values[count / 2u]);
+}
+
+/*
+ * Weighted straight-line fit y = a + b x. Two passes: weighted means first,
+ * then centred cross products, all with compensated sums, so the result
+ * does not depend on how far ln(dP) sits from zero.
+ */
+static bool blower_leakage_fit_line(const blower_leakage_fit_workspace_t *data,
+                                    blower_leakage_fit_line_t *out_line) {
+  blower_leakage_fit_kahan_t sw = {0};
+  blower_leakage_fit_kahan_t swx = {0};
+  blower_leakage_fit_kahan_t swy = {0};
+  blower_leakage_fit_kahan_t sxx = {0};
+  blower_leakage_fit_kahan_t sxy = {0};
+  blower_leakage_fit_kahan_t syy = {0};
+  blower_leakage_fit_kahan_t sse = {0};
+  blower_leakage_fit_line_t line = {0};
+  float y_mean = 0.0f;
+  uint8_t index = 0u;
+
+  for (index = 0u; index < data->count; ++index) {
+    const float w = data->weight[index];
+    blower_leakage_fit_kahan_add(&sw, w);
+    blower_leakage_fit_kahan_add(&swx, w * data->x[index]);
+    blower_leakage_fit_kahan_add(&swy, w * data->y[index]);
+  }
+  if (sw.sum <= 0.0f) {
+    return false;
+  }
+
+  line.weight_sum = sw.sum;
+  line.x_mean = swx.sum / sw.sum;
+  y_mean = swy.sum / sw.sum;
+
+  for (index = 0u; index < data->count; ++index) {
+    const float w = data->weight[index];
+    const float dx = data->x[index] - line.x_mean;
+    const float dy = data->y[index] - y_mean;
+    blower_leakage_fit_kahan_add(&sxx, w * dx * dx);
+    blower_leakage_fit_kahan_add(&sxy, w * dx * dy);
+    blower_leakage_fit_kahan_add(&syy, w * dy * dy);
+  }
+  if (sxx.sum <= 1.0e-12f) {
+    return false;
+  }
+
+  line.sxx = sxx.sum;
+  line.sxy = sxy.sum;
+  line.syy = syy.sum;
+  line.slope = sxy.sum / sxx.sum;
+  line.intercept = y_mean - line.slope * line.x_mean;
+
+  for (index = 0u; index < data->count; ++index) {
+    const float residual =
+        data->y[index] - (line.intercept + line.slope * data->x[index]);
+    blower_leakage_fit_kahan_add(&sse,
+                                 data->weight[index] * residual * residual);
+  }
+  line.sse = sse.sum;
+
+  *out_line = line;
+  return true;
+}
+
+/* Scales the weights to a mean of one so OLS and WLS share the formulas. */
+static void blower_leakage_fit_normalize(float *weights, uint8_t count) {
+  float sum = 0.0f;
+  uint8_t index = 0u;
+
+  for (index = 0u; index < count; ++index) {
+    sum += weights[index];
+  }
+  if (sum <= 0.0f) {
+    for (index = 0u; index < count; ++index) {
+      weights[index] = 1.0f;
+    }
+    return;
+  }
+  for (index = 0u; index < count; ++index) {
+    weights[index] *= (float)count / sum;
+  }
+}
+
+/*
+ * Inverse variance of ln Q per point. The pressure error enters through
+ * the exponent (d ln Q = n d ln dP), so it needs an estimate of n.
+ */
+static void blower_leakage_fit_variance_weights(
+    const blower_leakage_fit_point_t *points,
+    blower_leakage_fit_workspace_t *data,
+    float exponent_estimate) {
+  bool has_errors = false;
+  uint8_t index = 0u;
+
+  for (index = 0u; index < data->count; ++index) {
+    const float rel_flow =
+        points[index].flow_std_error_m3h / points[index].flow_m3h;
+    const float rel_pressure = exponent_estimate *
+                               points[index].pressure_std_error_pa /
+                               points[index].pressure_pa;
+    float variance = rel_flow * rel_flow + rel_pressure * rel_pressure;
+
+    if (variance > 0.0f) {
+      has_errors = true;
+    }
+    if (!(variance >= BLOWER_LEAKAGE_FIT_MIN_REL_VARIANCE)) {
+      variance = BLOWER_LEAKAGE_FIT_MIN_REL_VARIANCE;
+    }
+    data->base_weight[index] = 1.0f / variance;
+  }
+
+  if (!has_errors) {
+    for (index = 0u; index < data->count; ++index) {
+      data->base_weight[index] = 1.0f;
+    }
+  }
+  blower_leakage_fit_normalize(data->base_weight, data->count);
+}
+
+static uint8_t blower_leakage_fit_huber(blower_leakage_fit_workspace_t *data,
+                                        blower_leakage_fit_line_t *inout_line) {
+  float *abs_u = data->scratch;
+  float u[BLOWER_LEAKAGE_FIT_MAX_POINTS];
+  uint8_t downweighted = 0u;
+  uint32_t iteration = 0u;
+  uint8_t index = 0u;
+
+  for (iteration = 0u; iteration < BLOWER_LEAKAGE_FIT_HUBER_MAX_ITERATIONS;
+       ++iteration) {
+    blower_leakage_fit_line_t next = {0};
+    float scale = 0.0f;
+
+    for (index = 0u; index < data->count; ++index) {
+      const float residual =
+          data->y[index] -
+          (inout_line->intercept + inout_line->slope * data->x[index]);
+      u[index] = residual * sqrtf(data->base_weight[index]);
+      abs_u[index] = fabsf(u[index]);
+    }
+    scale = BLOWER_LEAKAGE_FIT_MAD_SCALE *
+            blower_leakage_fit_median(abs_u, data->count);
+    if (scale <= 1.0e-9f) {
+      break;
+    }
+
+    downweighted = 0u;
+    for (index = 0u; index < data->count; ++index) {
+      const float standardized = fabsf(u[index]) / scale;
+      float robust_weight = 1.0f;
+      if (standardized > BLOWER_LEAKAGE_FIT_HUBER_K) {
+        robust_weight = BLOWER_LEAKAGE_FIT_HUBER_K / standardized;
+        downweighted += 1u;
+      }
+      data->weight[index] = data->base_weight[index] * robust_weight;
+    }
+
+    if (!blower_leakage_fit_line(data, &next)) {
+      break;
+    }
+    if (fabsf(next.slope - inout_line->slope) <
+        BLOWER_LEAKAGE_FIT_HUBER_TOLERANCE) {
+      *inout_line = next;
+      break;
+    }
+    *inout_line = next;
+  }
+
+  return downweighted;
+}
+
+/*
+ * Theil-Sen: slope is the median of pairwise slopes, intercept the median
+ * of y - b x. The n interval comes from the rank bounds of Kendall's S
+ * (Sen 1968). sse is taken over the Theil-Sen residuals; x_mean, sxx and
+ * syy are the unweighted sums, which depend on the data only.
+ */
+static bool blower_leakage_fit_theil_sen(blower_leakage_fit_workspace_t *data,
+                                         blower_leakage_fit_line_t *out_line,
+                                         float *out_n_ci95) {
+  float *slopes = data->slopes;
+  float *intercepts = data->scratch;
+  blower_leakage_fit_line_t line = {0};
+  blower_leakage_fit_kahan_t sse = {0};
+  size_t pair_count = 0u;
+  uint8_t i = 0u;
+  uint8_t j = 0u;
+
+  for (i = 0u; i < data->count; ++i) {
+    data->weight[i] = 1.0f;
+    for (j = (uint8_t)(i + 1u); j < data->count; ++j) {
+      const float dx = data->x[j] - data->x[i];
+      if (fabsf(dx) > 1.0e-6f) {
+        slopes[pair_count++] = (data->y[j] - data->y[i]) / dx;
+      }
+    }
+  }
+  if (pair_count == 0u || !blower_leakage_fit_line(data, &line)) {
+    return false;
+  }
+
+  line.slope = blower_leakage_fit_median(slopes, pair_count);
+  for (i = 0u; i < data->count; ++i) {
+    intercepts[i] = data->y[i] - line.slope * data->x[i];
+  }
+  line.intercept = blower_leakage_fit_median(intercepts, data->count);
+
+  for (i = 0u; i < data->count; ++i) {
+    const float residual =
+        data->y[i] - (line.intercept + line.slope * data->x[i]);
+    blower_leakage_fit_kahan_add(&sse, residual * residual);
+  }
+  line.sse = sse.sum;
+
+  {
+    const float count_f = (float)data->count;
+    const float c_alpha =
+        1.96f * sqrtf(count_f * (count_f - 1.0f) * (2.0f * count_f + 5.0f) /
+                      18.0f);
+    const float lower_rank = 0.5f * ((float)pair_count - c_alpha);
+    const float upper_rank = 0.5f * ((float)pair_count + c_alpha) + 1.0f;
+    size_t lower_index = 0u;
+    size_t upper_index = pair_count - 1u;
+
+    /* slopes[] is sorted by the median call; ranks are 1-based. */
+    if (lower_rank >= 1.0f) {
+      lower_index = (size_t)lower_rank - 1u;
+    }
+    if (upper_rank <= (float)pair_count) {
+      upper_index = (size_t)upper_rank - 1u;
+    }
+    *out_n_ci95 = 0.5f * (slopes[upper_index] - slopes[lower_index]);
+  }
+
+  *out_line = line;
+  return true;
+}
+
+bool blower_leakage_fit(const blower_leakage_fit_point_t *points,
+                        uint8_t point_count,
+                        blower_leakage_fit_method_t method,
+                        blower_leakage_fit_workspace_t *workspace,
+                        blower_leakage_fit_result_t *out_result) {
+  blower_leakage_fit_line_t line = {0};
+  blower_leakage_fit_result_t result = {0};
+  float n_ci95 = 0.0f;
+  uint8_t index = 0u;
+
+  if (points == NULL || workspace == NULL || out_result == NULL ||
+      point_count < 2u || point_count > BLOWER_LEAKAGE_FIT_MAX_POINTS) {
+    return false;
+  }
+
+  memset(workspace, 0, sizeof(*workspace));
+  for (index = 0u; index < point_count; ++index) {
+    if (!(points[index].pressure_pa > 0.0f) ||
+        !(points[index].flow_m3h > 0.0f)) {
+      return false;
+    }
+    workspace->x[index] = logf(points[index].pressure_pa);
+    workspace->y[index] = logf(points[index].flow_m3h);
+    workspace->base_weight[index] = 1.0f;
+    workspace->weight[index] = 1.0f;
+  }
+  workspace->count = point_count;
+
+  if (!blower_leakage_fit_line(workspace, &line)) {
+    return false;
+  }
+
+  if (method == BLOWER_LEAKAGE_FIT_WLS || method == BLOWER_LEAKAGE_FIT_HUBER) {
+    const float prior = line.slope > 0.0f && line.slope < 2.0f
+                            ? line.slope
+                            : BLOWER_LEAKAGE_FIT_PRIOR_EXPONENT;
+    blower_leakage_fit_variance_weights(points, workspace, prior);
+    memcpy(workspace->weight, workspace->base_weight,
+           sizeof(workspace->weight));
+    if (!blower_leakage_fit_line(workspace, &line)) {
+      return false;
+    }
+    if (method == BLOWER_LEAKAGE_FIT_HUBER) {
+      result.downweighted_count = blower_leakage_fit_huber(workspace, &line);
+    }
+  } else if (method == BLOWER_LEAKAGE_FIT_THEIL_SEN) {
+    if (!blower_leakage_fit_theil_sen(workspace, &line, &n_ci95)) {
+      return false;
+    }
+  }
+
+  result.method = method;
+  result.point_count = point_count;
+  result.n = line.slope;
+  result.c = expf(line.intercept);
+  result.x_mean = line.x_mean;
+  result.sxx = line.sxx;
+  result.weight_sum = line.weight_sum;
+  if (method == BLOWER_LEAKAGE_FIT_THEIL_SEN) {
+    if (line.syy > 0.0f) {
+      const float r2 = fmaxf(0.0f, 1.0f - line.sse / line.syy);
+      result.correlation_r = copysignf(sqrtf(r2), line.slope);
+    }
+  } else if (line.sxx > 0.0f && line.syy > 0.0f) {
+    result.correlation_r = line.sxy / sqrtf(line.sxx * line.syy);
+  }
+
+  if (point_count > 2u) {
+    float se_ln_c = 0.0f;
+
+    result.residual_variance = line.sse / (float)(point_count - 2u);
+    result.t95 = blower_running_stats_t95(point_count - 2u);
+    se_ln_c = sqrtf(result.residual_variance *
+                    (1.0f / line.weight_sum +
+                     line.x_mean * line.x_mean / line.sxx));
+    if (method != BLOWER_LEAKAGE_FIT_THEIL_SEN) {
+      n_ci95 = result.t95 * sqrtf(result.residual_variance / line.sxx);
+    }
+    result.n_ci95 = n_ci95;
+    result.c_ci95_low = expf(line.intercept - result.t95 * se_ln_c);
+    result.c_ci95_high = expf(line.intercept + result.t95 * se_ln_c);
+  } else {
+    result.c_ci95_low = result.c;
+    result.c_ci95_high = result.c;
+  }
+
+  result.valid = isfinite(result.c) && isfinite(result.n);
+  *out_result = result;
+  return result.valid;
+}
+
+bool blower_leakage_fit_flow_ci95(const blower_leakage_fit_result_t *fit,
+                                  float pressure_pa, float *out_flow_m3h,
+                                  float *out_low_m3h, float *out_high_m3h) {
+  float x = 0.0f;
+  float y = 0.0f;
+  float half_width = 0.0f;
+
+  if (fit == NULL || !fit->valid || !(pressure_pa > 0.0f) ||
+      out_flow_m3h == NULL || out_low_m3h == NULL || out_high_m3h == NULL) {
+    return false;
+  }
+
+  x = logf(pressure_pa);
+  y = logf(fit->c) + fit->n * x;
+  if (fit->point_count > 2u && fit->sxx > 0.0f && fit->weight_sum > 0.0f) {
+    const float dx = x - fit->x_mean;
+    const float leverage = 1.0f / fit->weight_sum + dx * dx / fit->sxx;
+    half_width = fit->t95 * sqrtf(fit->residual_variance * leverage);
+  }
+
+  *out_flow_m3h = expf(y);
+  *out_low_m3h = expf(y - half_width);
+  *out_high_m3h = expf(y + half_width);
+  return true;
+}
+
+const char *
+blower_leakage_fit_method_name(blower_leakage_fit_method_t method) {
+  switch (method) {
+  case BLOWER_LEAKAGE_FIT_OLS:
+    return "ols";
+  case BLOWER_LEAKAGE_FIT_WLS:
+    return "wls";
+  case BLOWER_LEAKAGE_FIT_HUBER:
+    return "huber";
+  case BLOWER_LEAKAGE_FIT_THEIL_SEN:
+    return "theil_sen";
+  default:
+    return "unknown";
+  }
+}
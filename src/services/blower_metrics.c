@@ -124,6 +124,7 @@ void blower_metrics_service_update(const adp910_sample_t *fan_sample,
     snapshot->fan_pressure_pa = g_service_context.last_fan_pressure_raw_pa -
                                 g_service_context.fan_pressure_offset_pa;
     snapshot->fan_temperature_c = fan_sample->temperature_c;
+    snapshot->fan_sample_time_us = fan_sample->capture_time_us;
     snapshot->fan_sample_valid = true;
   } else {
     snapshot->fan_sample_valid = false;
@@ -137,6 +138,7 @@ void blower_metrics_service_update(const adp910_sample_t *fan_sample,
         g_service_context.last_envelope_pressure_raw_pa -
         g_service_context.envelope_pressure_offset_pa;
     snapshot->envelope_temperature_c = envelope_sample->temperature_c;
+    snapshot->envelope_sample_time_us = envelope_sample->capture_time_us;
     snapshot->envelope_sample_valid = true;
   } else {
     snapshot->envelope_sample_valid = false;
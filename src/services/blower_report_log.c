@@ -0,0 +1,450 @@
+#include "services/blower_report_log.h"
+
+#include "FreeRTOS.h"
+#include "app/app_config.h"
+#include "hardware/flash.h"
+#include "hardware/regs/addressmap.h"
+#include "hardware/sync.h"
+#include "semphr.h"
+#include "services/flash_storage.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BLOWER_REPORT_LOG_MAGIC 0x4254524cu /* BTRL */
+#define BLOWER_REPORT_LOG_VERSION 1u
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t payload_size;
+  uint32_t report_id;
+  /* Covers the fields above and the payload that follows the header. */
+  uint32_t crc32;
+} blower_report_log_header_t;
+
+#define BLOWER_REPORT_LOG_RECORD_BYTES \
+  (sizeof(blower_report_log_header_t) + sizeof(blower_test_report_t))
+#define BLOWER_REPORT_LOG_SLOT_SIZE                                     \
+  (((BLOWER_REPORT_LOG_RECORD_BYTES + FLASH_PAGE_SIZE - 1u) /            \
+    FLASH_PAGE_SIZE) *                                                  \
+   FLASH_PAGE_SIZE)
+#define BLOWER_REPORT_LOG_PAGES_PER_SLOT \
+  (BLOWER_REPORT_LOG_SLOT_SIZE / FLASH_PAGE_SIZE)
+#define BLOWER_REPORT_LOG_SLOTS_PER_SECTOR \
+  (FLASH_SECTOR_SIZE / BLOWER_REPORT_LOG_SLOT_SIZE)
+#define BLOWER_REPORT_LOG_SECTOR_COUNT \
+  (APP_TEST_REPORT_LOG_SIZE_BYTES / FLASH_SECTOR_SIZE)
+#define BLOWER_REPORT_LOG_SLOT_COUNT \
+  (BLOWER_REPORT_LOG_SECTOR_COUNT * BLOWER_REPORT_LOG_SLOTS_PER_SECTOR)
+
+_Static_assert(BLOWER_REPORT_LOG_SLOTS_PER_SECTOR >= 1u,
+               "A report record does not fit in one flash sector");
+_Static_assert(BLOWER_REPORT_LOG_SECTOR_COUNT >= 2u,
+               "The report log needs at least two sectors");
+_Static_assert(sizeof(blower_test_report_t) <= 0xffffu,
+               "Report payload size does not fit the record header");
+
+typedef struct {
+  SemaphoreHandle_t mutex;
+  bool available;
+
+  /* Report id stored in each slot; 0 for erased or invalid slots. */
+  uint32_t slot_report_id[BLOWER_REPORT_LOG_SLOT_COUNT];
+  uint32_t head_slot;
+  bool head_sector_needs_erase;
+
+  blower_test_report_t queue[BLOWER_REPORT_LOG_QUEUE_CAPACITY];
+  uint8_t queue_head;
+  uint8_t queue_count;
+
+  bool staging_ready;
+  uint32_t staging_page;
+  uint32_t staging_report_id;
+} blower_report_log_context_t;
+
+static blower_report_log_context_t g_log;
+static uint8_t g_record_image[BLOWER_REPORT_LOG_SLOT_SIZE];
+
+static uint32_t blower_report_log_crc32_for_record(const uint8_t *record) {
+  uint32_t crc = flash_storage_crc32_update(
+      FLASH_STORAGE_CRC32_INIT, record,
+      offsetof(blower_report_log_header_t, crc32));
+  crc = flash_storage_crc32_update(
+      crc, record + sizeof(blower_report_log_header_t),
+      sizeof(blower_test_report_t));
+  return crc ^ 0xffffffffu;
+}
+
+static bool blower_report_log_layout_is_valid(void) {
+  return flash_storage_region_is_valid(APP_TEST_REPORT_LOG_OFFSET_BYTES,
+                                       APP_TEST_REPORT_LOG_SIZE_BYTES, 0u);
+}
+
+static uint32_t blower_report_log_slot_offset(uint32_t slot) {
+  const uint32_t sector = slot / BLOWER_REPORT_LOG_SLOTS_PER_SECTOR;
+  const uint32_t index_in_sector = slot % BLOWER_REPORT_LOG_SLOTS_PER_SECTOR;
+  return APP_TEST_REPORT_LOG_OFFSET_BYTES + sector * FLASH_SECTOR_SIZE +
+         index_in_sector * BLOWER_REPORT_LOG_SLOT_SIZE;
+}
+
+static const uint8_t *blower_report_log_slot_ptr(uint32_t slot) {
+  return (const uint8_t *)(XIP_BASE + blower_report_log_slot_offset(slot));
+}
+
+static bool blower_report_log_sector_is_erased(uint32_t sector) {
+  return flash_storage_range_is_erased(
+      APP_TEST_REPORT_LOG_OFFSET_BYTES + sector * FLASH_SECTOR_SIZE,
+      FLASH_SECTOR_SIZE);
+}
+
+/* Returns the stored report id, or 0 when the slot holds no valid record. */
+static uint32_t blower_report_log_validate_slot(uint32_t slot) {
+  const uint8_t *record = blower_report_log_slot_ptr(slot);
+  blower_report_log_header_t header = {0};
+
+  memcpy(&header, record, sizeof(header));
+  if (header.magic != BLOWER_REPORT_LOG_MAGIC ||
+      header.version != BLOWER_REPORT_LOG_VERSION ||
+      header.payload_size != sizeof(blower_test_report_t) ||
+      header.report_id == 0u) {
+    return 0u;
+  }
+  if (blower_report_log_crc32_for_record(record) != header.crc32) {
+    return 0u;
+  }
+
+  return header.report_id;
+}
+
+/*
+ * Moves the head on by one slot. Entering a sector that still holds data
+ * schedules its erase right away, so the next append only has to program.
+ */
+static void blower_report_log_advance_head(void) {
+  g_log.head_slot = (g_log.head_slot + 1u) % BLOWER_REPORT_LOG_SLOT_COUNT;
+  if ((g_log.head_slot % BLOWER_REPORT_LOG_SLOTS_PER_SECTOR) == 0u) {
+    const uint32_t sector =
+        g_log.head_slot / BLOWER_REPORT_LOG_SLOTS_PER_SECTOR;
+    g_log.head_sector_needs_erase =
+        !blower_report_log_sector_is_erased(sector);
+  }
+}
+
+static void blower_report_log_rebuild_index(void) {
+  uint32_t newest_id = 0u;
+  uint32_t newest_slot = 0u;
+  uint32_t slot = 0u;
+
+  for (slot = 0u; slot < BLOWER_REPORT_LOG_SLOT_COUNT; ++slot) {
+    const uint32_t report_id = blower_report_log_validate_slot(slot);
+    g_log.slot_report_id[slot] = report_id;
+    if (report_id != 0u && report_id >= newest_id) {
+      newest_id = report_id;
+      newest_slot = slot;
+    }
+  }
+
+  if (newest_id == 0u) {
+    g_log.head_slot = 0u;
+    g_log.head_sector_needs_erase = !blower_report_log_sector_is_erased(0u);
+  } else {
+    g_log.head_slot = newest_slot;
+    g_log.head_sector_needs_erase = false;
+    blower_report_log_advance_head();
+  }
+
+  /*
+   * A head slot that is neither erased nor valid is a record torn by a
+   * reset mid-write; skip the rest of its sector rather than program over
+   * it.
+   */
+  if (!g_log.head_sector_needs_erase &&
+      !flash_storage_range_is_erased(
+          blower_report_log_slot_offset(g_log.head_slot),
+          BLOWER_REPORT_LOG_SLOT_SIZE)) {
+    g_log.head_slot =
+        (g_log.head_slot / BLOWER_REPORT_LOG_SLOTS_PER_SECTOR) *
+            BLOWER_REPORT_LOG_SLOTS_PER_SECTOR +
+        BLOWER_REPORT_LOG_SLOTS_PER_SECTOR - 1u;
+    blower_report_log_advance_head();
+  }
+}
+
+void blower_report_log_init(void) {
+  if (g_log.mutex != NULL) {
+    return;
+  }
+
+  memset(&g_log, 0, sizeof(g_log));
+  g_log.mutex = xSemaphoreCreateMutex();
+  if (g_log.mutex == NULL) {
+    return;
+  }
+
+  g_log.available = blower_report_log_layout_is_valid();
+  if (g_log.available) {
+    blower_report_log_rebuild_index();
+  }
+}
+
+bool blower_report_log_is_available(void) {
+  return g_log.mutex != NULL && g_log.available;
+}
+
+bool blower_report_log_append(const blower_test_report_t *report) {
+  uint8_t tail = 0u;
+
+  if (report == NULL || report->report_id == 0u || g_log.mutex == NULL ||
+      !g_log.available) {
+    return false;
+  }
+
+  if (xSemaphoreTake(g_log.mutex, 0) != pdTRUE) {
+    return false;
+  }
+
+  if (g_log.queue_count >= BLOWER_REPORT_LOG_QUEUE_CAPACITY) {
+    xSemaphoreGive(g_log.mutex);
+    return false;
+  }
+
+  tail = (uint8_t)((g_log.queue_head + g_log.queue_count) %
+                   BLOWER_REPORT_LOG_QUEUE_CAPACITY);
+  g_log.queue[tail] = *report;
+  g_log.queue_count += 1u;
+
+  xSemaphoreGive(g_log.mutex);
+  return true;
+}
+
+static void blower_report_log_stage_locked(void) {
+  const blower_test_report_t *report = &g_log.queue[g_log.queue_head];
+  blower_report_log_header_t header = {
+      .magic = BLOWER_REPORT_LOG_MAGIC,
+      .version = BLOWER_REPORT_LOG_VERSION,
+      .payload_size = (uint16_t)sizeof(blower_test_report_t),
+      .report_id = report->report_id,
+      .crc32 = 0u,
+  };
+
+  memset(g_record_image, FLASH_STORAGE_ERASED_BYTE, sizeof(g_record_image));
+  memcpy(g_record_image, &header, sizeof(header));
+  memcpy(g_record_image + sizeof(header), report, sizeof(*report));
+  header.crc32 = blower_report_log_crc32_for_record(g_record_image);
+  memcpy(g_record_image, &header, sizeof(header));
+
+  g_log.staging_ready = true;
+  g_log.staging_page = 0u;
+  g_log.staging_report_id = report->report_id;
+}
+
+static void blower_report_log_finish_record_locked(void) {
+  const uint8_t *written = blower_report_log_slot_ptr(g_log.head_slot);
+
+  /* A record that failed to verify is left for the index scan to skip. */
+  if (memcmp(written, g_record_image, BLOWER_REPORT_LOG_RECORD_BYTES) == 0) {
+    g_log.slot_report_id[g_log.head_slot] = g_log.staging_report_id;
+  }
+
+  g_log.queue_head =
+      (uint8_t)((g_log.queue_head + 1u) % BLOWER_REPORT_LOG_QUEUE_CAPACITY);
+  g_log.queue_count -= 1u;
+  g_log.staging_ready = false;
+  blower_report_log_advance_head();
+}
+
+bool blower_report_log_persist_step(void) {
+  uint32_t irq_state = 0u;
+  bool touched_flash = false;
+
+  if (g_log.mutex == NULL || !g_log.available) {
+    return false;
+  }
+
+  if (xSemaphoreTake(g_log.mutex, 0) != pdTRUE) {
+    return false;
+  }
+
+  if (g_log.head_sector_needs_erase) {
+    const uint32_t sector =
+        g_log.head_slot / BLOWER_REPORT_LOG_SLOTS_PER_SECTOR;
+    const uint32_t first_slot = sector * BLOWER_REPORT_LOG_SLOTS_PER_SECTOR;
+    uint32_t slot = 0u;
+
+    /* Garbage collection: the sector ahead of the head holds the oldest. */
+    for (slot = 0u; slot < BLOWER_REPORT_LOG_SLOTS_PER_SECTOR; ++slot) {
+      g_log.slot_report_id[first_slot + slot] = 0u;
+    }
+
+    irq_state = save_and_disable_interrupts();
+    flash_range_erase(APP_TEST_REPORT_LOG_OFFSET_BYTES +
+                          sector * FLASH_SECTOR_SIZE,
+                      FLASH_SECTOR_SIZE);
+    restore_interrupts(irq_state);
+
+    g_log.head_sector_needs_erase = false;
+    touched_flash = true;
+  } else {
+    if (!g_log.staging_ready && g_log.queue_count > 0u) {
+      blower_report_log_stage_locked();
+    }
+
+    if (g_log.staging_ready) {
+      const uint32_t page_offset = g_log.staging_page * FLASH_PAGE_SIZE;
+
+      irq_state = save_and_disable_interrupts();
+      flash_range_program(
+          blower_report_log_slot_offset(g_log.head_slot) + page_offset,
+          g_record_image + page_offset, FLASH_PAGE_SIZE);
+      restore_interrupts(irq_state);
+
+      g_log.staging_page += 1u;
+      if (g_log.staging_page >= BLOWER_REPORT_LOG_PAGES_PER_SLOT) {
+        blower_report_log_finish_record_locked();
+      }
+      touched_flash = true;
+    }
+  }
+
+  xSemaphoreGive(g_log.mutex);
+  return touched_flash;
+}
+
+uint32_t blower_report_log_count(void) {
+  uint32_t count = 0u;
+  uint32_t slot = 0u;
+
+  if (g_log.mutex == NULL) {
+    return 0u;
+  }
+
+  if (xSemaphoreTake(g_log.mutex, portMAX_DELAY) != pdTRUE) {
+    return 0u;
+  }
+
+  for (slot = 0u; slot < BLOWER_REPORT_LOG_SLOT_COUNT; ++slot) {
+    if (g_log.slot_report_id[slot] != 0u) {
+      count += 1u;
+    }
+  }
+  count += g_log.queue_count;
+
+  xSemaphoreGive(g_log.mutex);
+  return count;
+}
+
+uint32_t blower_report_log_newest_id(void) {
+  uint32_t newest_id = 0u;
+  uint32_t slot = 0u;
+  uint8_t queued = 0u;
+
+  if (g_log.mutex == NULL) {
+    return 0u;
+  }
+
+  if (xSemaphoreTake(g_log.mutex, portMAX_DELAY) != pdTRUE) {
+    return 0u;
+  }
+
+  for (slot = 0u; slot < BLOWER_REPORT_LOG_SLOT_COUNT; ++slot) {
+    if (g_log.slot_report_id[slot] > newest_id) {
+      newest_id = g_log.slot_report_id[slot];
+    }
+  }
+  for (queued = 0u; queued < g_log.queue_count; ++queued) {
+    const uint8_t index = (uint8_t)((g_log.queue_head + queued) %
+                                    BLOWER_REPORT_LOG_QUEUE_CAPACITY);
+    if (g_log.queue[index].report_id > newest_id) {
+      newest_id = g_log.queue[index].report_id;
+    }
+  }
+
+  xSemaphoreGive(g_log.mutex);
+  return newest_id;
+}
+
+uint32_t blower_report_log_capacity(void) {
+  /* One sector is always kept erased ahead of the head. */
+  return BLOWER_REPORT_LOG_SLOT_COUNT - BLOWER_REPORT_LOG_SLOTS_PER_SECTOR;
+}
+
+size_t blower_report_log_list(uint32_t before_report_id, uint32_t *out_ids,
+                              size_t max_ids) {
+  size_t written = 0u;
+  uint32_t step = 0u;
+  uint8_t queued = 0u;
+
+  if (out_ids == NULL || max_ids == 0u || g_log.mutex == NULL) {
+    return 0u;
+  }
+
+  if (xSemaphoreTake(g_log.mutex, portMAX_DELAY) != pdTRUE) {
+    return 0u;
+  }
+
+  /* Queued reports are newer than anything already in flash. */
+  for (queued = g_log.queue_count; queued > 0u && written < max_ids;
+       --queued) {
+    const uint8_t index =
+        (uint8_t)((g_log.queue_head + queued - 1u) %
+                  BLOWER_REPORT_LOG_QUEUE_CAPACITY);
+    const uint32_t report_id = g_log.queue[index].report_id;
+    if (before_report_id == 0u || report_id < before_report_id) {
+      out_ids[written++] = report_id;
+    }
+  }
+
+  /* Walking backwards from the head visits slots newest first. */
+  for (step = 1u; step <= BLOWER_REPORT_LOG_SLOT_COUNT && written < max_ids;
+       ++step) {
+    const uint32_t slot =
+        (g_log.head_slot + BLOWER_REPORT_LOG_SLOT_COUNT - step) %
+        BLOWER_REPORT_LOG_SLOT_COUNT;
+    const uint32_t report_id = g_log.slot_report_id[slot];
+    if (report_id != 0u &&
+        (before_report_id == 0u || report_id < before_report_id)) {
+      out_ids[written++] = report_id;
+    }
+  }
+
+  xSemaphoreGive(g_log.mutex);
+  return written;
+}
+
+bool blower_report_log_read(uint32_t report_id,
+                            blower_test_report_t *out_report) {
+  bool found = false;
+  uint32_t slot = 0u;
+  uint8_t queued = 0u;
+
+  if (out_report == NULL || report_id == 0u || g_log.mutex == NULL) {
+    return false;
+  }
+
+  if (xSemaphoreTake(g_log.mutex, portMAX_DELAY) != pdTRUE) {
+    return false;
+  }
+
+  for (queued = 0u; queued < g_log.queue_count && !found; ++queued) {
+    const uint8_t index = (uint8_t)((g_log.queue_head + queued) %
+                                    BLOWER_REPORT_LOG_QUEUE_CAPACITY);
+    if (g_log.queue[index].report_id == report_id) {
+      *out_report = g_log.queue[index];
+      found = true;
+    }
+  }
+
+  for (slot = 0u; slot < BLOWER_REPORT_LOG_SLOT_COUNT && !found; ++slot) {
+    if (g_log.slot_report_id[slot] == report_id) {
+      memcpy(out_report,
+             blower_report_log_slot_ptr(slot) +
+                 sizeof(blower_report_log_header_t),
+             sizeof(*out_report));
+      found = true;
+    }
+  }
+
+  xSemaphoreGive(g_log.mutex);
+  return found;
+}
@@ -0,0 +1,118 @@
+#include "services/blower_running_stats.h"
+
+#include <math.h>
+#include <stddef.h>
+
+static void blower_running_stats_kahan_add(float *sum, float *compensation,
+                                           float value) {
+  const float corrected = value - *compensation;
+  const float next_sum = *sum + corrected;
+  *compensation = (next_sum - *sum) - corrected;
+  *sum = next_sum;
+}
+
+void blower_running_stats_reset(blower_running_stats_t *stats) {
+  if (stats == NULL) {
+    return;
+  }
+
+  *stats = (blower_running_stats_t){
+      .count = 0u,
+      .mean = 0.0f,
+      .mean_compensation = 0.0f,
+      .m2 = 0.0f,
+      .m2_compensation = 0.0f,
+      .min_value = 0.0f,
+      .max_value = 0.0f,
+  };
+}
+
+void blower_running_stats_push(blower_running_stats_t *stats, float value) {
+  float delta = 0.0f;
+
+  if (stats == NULL || !isfinite(value)) {
+    return;
+  }
+
+  if (stats->count == 0u) {
+    stats->min_value = value;
+    stats->max_value = value;
+  } else {
+    if (value < stats->min_value) {
+      stats->min_value = value;
+    }
+    if (value > stats->max_value) {
+      stats->max_value = value;
+    }
+  }
+
+  stats->count += 1u;
+  delta = value - stats->mean;
+  blower_running_stats_kahan_add(&stats->mean, &stats->mean_compensation,
+                                 delta / (float)stats->count);
+  blower_running_stats_kahan_add(&stats->m2, &stats->m2_compensation,
+                                 delta * (value - stats->mean));
+}
+
+float blower_running_stats_variance(const blower_running_stats_t *stats) {
+  if (stats == NULL || stats->count < 2u || stats->m2 <= 0.0f) {
+    return 0.0f;
+  }
+
+  return stats->m2 / (float)(stats->count - 1u);
+}
+
+float blower_running_stats_stddev(const blower_running_stats_t *stats) {
+  return sqrtf(blower_running_stats_variance(stats));
+}
+
+float blower_running_stats_std_error(const blower_running_stats_t *stats) {
+  if (stats == NULL || stats->count < 2u) {
+    return 0.0f;
+  }
+
+  return sqrtf(blower_running_stats_variance(stats) / (float)stats->count);
+}
+
+/*
+ * Two-sided 95% Student t quantile. Exact to df 30; beyond that it is
+ * interpolated linearly in 1/df between tabulated points and the normal
+ * limit. The quantile is convex in 1/df, so the result never falls below
+ * the exact value and the intervals stay conservative.
+ */
+float blower_running_stats_t95(uint32_t degrees_of_freedom) {
+  static const float k_t95[] = {
+      12.706f, 4.303f, 3.182f, 2.776f, 2.571f, 2.447f, 2.365f, 2.306f,
+      2.262f,  2.228f, 2.201f, 2.179f, 2.160f, 2.145f, 2.131f, 2.120f,
+      2.110f,  2.101f, 2.093f, 2.086f, 2.080f, 2.074f, 2.069f, 2.064f,
+      2.060f,  2.056f, 2.052f, 2.048f, 2.045f, 2.042f};
+  /* Tail anchors {df, t}; 0 df stands for df = infinity (z = 1.960). */
+  static const float k_t95_tail[][2] = {
+      {30.0f, 2.042f}, {40.0f, 2.021f}, {60.0f, 2.000f},
+      {120.0f, 1.980f}, {0.0f, 1.960f}};
+  const uint32_t table_size = sizeof(k_t95) / sizeof(k_t95[0]);
+  const float inverse_df = 1.0f / (float)degrees_of_freedom;
+  uint32_t index = 0u;
+
+  if (degrees_of_freedom == 0u) {
+    return k_t95[0];
+  }
+  if (degrees_of_freedom <= table_size) {
+    return k_t95[degrees_of_freedom - 1u];
+  }
+  for (index = 1u; index < sizeof(k_t95_tail) / sizeof(k_t95_tail[0]);
+       ++index) {
+    const float upper_inverse = 1.0f / k_t95_tail[index - 1u][0];
+    const float lower_inverse =
+        k_t95_tail[index][0] > 0.0f ? 1.0f / k_t95_tail[index][0] : 0.0f;
+
+    if (inverse_df >= lower_inverse) {
+      const float fraction =
+          (inverse_df - lower_inverse) / (upper_inverse - lower_inverse);
+
+      return k_t95_tail[index][1] +
+             fraction * (k_t95_tail[index - 1u][1] - k_t95_tail[index][1]);
+    }
+  }
+  return k_t95_tail[index - 1u][1];
+}
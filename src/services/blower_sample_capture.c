@@ -0,0 +1,619 @@
+#include "services/blower_sample_capture.h"
+
+#include "FreeRTOS.h"
+#include "app/app_config.h"
+#include "hardware/flash.h"
+#include "hardware/regs/addressmap.h"
+#include "hardware/sync.h"
+#include "semphr.h"
+#include "services/flash_storage.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BLOWER_SAMPLE_CAPTURE_MAGIC 0x42545343u /* BTSC */
+#define BLOWER_SAMPLE_CAPTURE_VERSION 1u
+
+/* Values are clamped so that the delta of any two fits an int32. */
+#define BLOWER_SAMPLE_CAPTURE_VALUE_LIMIT 0x3fffffff
+#define BLOWER_SAMPLE_CAPTURE_FIELD_COUNT 5u
+/* A varint dt plus one zigzag varint per field, 5 bytes each at most. */
+#define BLOWER_SAMPLE_CAPTURE_MAX_ENCODED_BYTES \
+  (5u * (1u + BLOWER_SAMPLE_CAPTURE_FIELD_COUNT))
+
+typedef struct {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t direction;
+  uint8_t point_index;
+  uint8_t sample_count;
+  uint32_t report_id;
+  uint32_t sequence;
+  uint32_t first_tick_ms;
+  uint16_t payload_length;
+  uint16_t reserved;
+  /* Covers the fields above and payload_length bytes of payload. */
+  uint32_t crc32;
+} blower_sample_capture_header_t;
+
+#define BLOWER_SAMPLE_CAPTURE_PAYLOAD_CAPACITY \
+  (FLASH_PAGE_SIZE - sizeof(blower_sample_capture_header_t))
+#define BLOWER_SAMPLE_CAPTURE_PAGE_COUNT \
+  (APP_TEST_SAMPLE_LOG_SIZE_BYTES / FLASH_PAGE_SIZE)
+#define BLOWER_SAMPLE_CAPTURE_PAGES_PER_SECTOR \
+  (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE)
+#define BLOWER_SAMPLE_CAPTURE_SECTOR_COUNT \
+  (APP_TEST_SAMPLE_LOG_SIZE_BYTES / FLASH_SECTOR_SIZE)
+
+_Static_assert(BLOWER_SAMPLE_CAPTURE_SECTOR_COUNT >= 2u,
+               "The sample log needs at least two sectors");
+_Static_assert(APP_TEST_SAMPLE_CAPTURE_STAGING_PAGES >= 1u &&
+                   APP_TEST_SAMPLE_CAPTURE_STAGING_PAGES <= 0xffffu,
+               "Invalid APP_TEST_SAMPLE_CAPTURE_STAGING_PAGES");
+_Static_assert(APP_TEST_SAMPLE_CAPTURE_DECIMATION >= 1u,
+               "APP_TEST_SAMPLE_CAPTURE_DECIMATION must be at least 1");
+
+typedef struct {
+  /* Flash ring state; written by the control task only. */
+  SemaphoreHandle_t mutex;
+  bool available;
+  uint32_t head_page;
+  bool head_sector_needs_erase;
+
+  /*
+   * Staging ring of sealed pages. The test service produces and the
+   * control task consumes; the indices change in short interrupt-off
+   * sections so neither side ever waits on the other.
+   */
+  uint16_t staging_head;
+  uint16_t staging_count;
+
+  /* Producer state, serialized by the test service lock. */
+  uint32_t next_sequence;
+  bool window_open;
+  uint32_t window_report_id;
+  uint8_t window_direction;
+  uint8_t window_point_index;
+  uint32_t decimation_count;
+  uint16_t open_length;
+  uint8_t open_sample_count;
+  uint32_t open_first_tick_ms;
+  uint32_t last_tick_ms;
+  int32_t last_values[BLOWER_SAMPLE_CAPTURE_FIELD_COUNT];
+
+  uint32_t captured_samples;
+  uint32_t dropped_samples;
+} blower_sample_capture_context_t;
+
+static blower_sample_capture_context_t g_capture;
+static uint8_t g_open_page[FLASH_PAGE_SIZE];
+static uint8_t g_staging_pages[APP_TEST_SAMPLE_CAPTURE_STAGING_PAGES]
+                              [FLASH_PAGE_SIZE];
+
+static uint32_t blower_sample_capture_crc32_for_page(
+    const uint8_t *page, const blower_sample_capture_header_t *header) {
+  uint32_t crc = flash_storage_crc32_update(
+      FLASH_STORAGE_CRC32_INIT, page,
+      offsetof(blower_sample_capture_header_t, crc32));
+  crc = flash_storage_crc32_update(
+      crc, page + sizeof(blower_sample_capture_header_t),
+      header->payload_length);
+  return crc ^ 0xffffffffu;
+}
+
+static bool blower_sample_capture_layout_is_valid(void) {
+  return flash_storage_region_is_valid(APP_TEST_SAMPLE_LOG_OFFSET_BYTES,
+                                       APP_TEST_SAMPLE_LOG_SIZE_BYTES, 0u);
+}
+
+static uint32_t blower_sample_capture_page_offset(uint32_t page) {
+  return APP_TEST_SAMPLE_LOG_OFFSET_BYTES + page * FLASH_PAGE_SIZE;
+}
+
+static const uint8_t *blower_sample_capture_page_ptr(uint32_t page) {
+  return (const uint8_t *)(XIP_BASE + blower_sample_capture_page_offset(page));
+}
+
+static bool blower_sample_capture_sector_is_erased(uint32_t sector) {
+  return flash_storage_range_is_erased(
+      APP_TEST_SAMPLE_LOG_OFFSET_BYTES + sector * FLASH_SECTOR_SIZE,
+      FLASH_SECTOR_SIZE);
+}
+
+static bool blower_sample_capture_page_is_valid(
+    const uint8_t *page, blower_sample_capture_header_t *out_header) {
+  memcpy(out_header, page, sizeof(*out_header));
+  if (out_header->magic != BLOWER_SAMPLE_CAPTURE_MAGIC ||
+      out_header->version != BLOWER_SAMPLE_CAPTURE_VERSION ||
+      out_header->report_id == 0u || out_header->sample_count == 0u ||
+      out_header->payload_length > BLOWER_SAMPLE_CAPTURE_PAYLOAD_CAPACITY) {
+    return false;
+  }
+
+  return blower_sample_capture_crc32_for_page(page, out_header) ==
+         out_header->crc32;
+}
+
+static void blower_sample_capture_advance_head(void) {
+  g_capture.head_page =
+      (g_capture.head_page + 1u) % BLOWER_SAMPLE_CAPTURE_PAGE_COUNT;
+  if ((g_capture.head_page % BLOWER_SAMPLE_CAPTURE_PAGES_PER_SECTOR) == 0u) {
+    const uint32_t sector =
+        g_capture.head_page / BLOWER_SAMPLE_CAPTURE_PAGES_PER_SECTOR;
+    g_capture.head_sector_needs_erase =
+        !blower_sample_capture_sector_is_erased(sector);
+  }
+}
+
+static void blower_sample_capture_find_head(void) {
+  blower_sample_capture_header_t header = {0};
+  uint32_t newest_sequence = 0u;
+  uint32_t newest_page = 0u;
+  bool found = false;
+  uint32_t page = 0u;
+
+  for (page = 0u; page < BLOWER_SAMPLE_CAPTURE_PAGE_COUNT; ++page) {
+    if (blower_sample_capture_page_is_valid(
+            blower_sample_capture_page_ptr(page), &header) &&
+        (!found || header.sequence >= newest_sequence)) {
+      newest_sequence = header.sequence;
+      newest_page = page;
+      found = true;
+    }
+  }
+
+  g_capture.next_sequence = found ? newest_sequence + 1u : 1u;
+  if (!found) {
+    g_capture.head_page = 0u;
+    g_capture.head_sector_needs_erase =
+        !blower_sample_capture_sector_is_erased(0u);
+  } else {
+    g_capture.head_page = newest_page;
+    g_capture.head_sector_needs_erase = false;
+    blower_sample_capture_advance_head();
+  }
+
+  /* A page torn by a reset mid-write: skip the rest of its sector. */
+  if (!g_capture.head_sector_needs_erase &&
+      !flash_storage_range_is_erased(
+          blower_sample_capture_page_offset(g_capture.head_page),
+          FLASH_PAGE_SIZE)) {
+    g_capture.head_page =
+        (g_capture.head_page / BLOWER_SAMPLE_CAPTURE_PAGES_PER_SECTOR) *
+            BLOWER_SAMPLE_CAPTURE_PAGES_PER_SECTOR +
+        BLOWER_SAMPLE_CAPTURE_PAGES_PER_SECTOR - 1u;
+    blower_sample_capture_advance_head();
+  }
+}
+
+void blower_sample_capture_init(void) {
+  if (g_capture.mutex != NULL) {
+    return;
+  }
+
+  memset(&g_capture, 0, sizeof(g_capture));
+  g_capture.next_sequence = 1u;
+  g_capture.mutex = xSemaphoreCreateMutex();
+  if (g_capture.mutex == NULL) {
+    return;
+  }
+
+  g_capture.available = blower_sample_capture_layout_is_valid();
+  if (g_capture.available) {
+    blower_sample_capture_find_head();
+  }
+}
+
+static int32_t blower_sample_capture_to_fixed(float value, float scale) {
+  const float scaled = value * scale;
+
+  if (!isfinite(scaled)) {
+    return 0;
+  }
+  if (scaled >= (float)BLOWER_SAMPLE_CAPTURE_VALUE_LIMIT) {
+    return BLOWER_SAMPLE_CAPTURE_VALUE_LIMIT;
+  }
+  if (scaled <= -(float)BLOWER_SAMPLE_CAPTURE_VALUE_LIMIT) {
+    return -BLOWER_SAMPLE_CAPTURE_VALUE_LIMIT;
+  }
+  return (int32_t)(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+}
+
+static size_t blower_sample_capture_put_varint(uint8_t *out, uint32_t value) {
+  size_t length = 0u;
+
+  while (value >= 0x80u) {
+    out[length++] = (uint8_t)(value | 0x80u);
+    value >>= 7u;
+  }
+  out[length++] = (uint8_t)value;
+  return length;
+}
+
+static bool blower_sample_capture_get_varint(const uint8_t *data,
+                                             size_t length, size_t *cursor,
+                                             uint32_t *out_value) {
+  uint32_t value = 0u;
+  uint32_t shift = 0u;
+
+  while (*cursor < length && shift < 35u) {
+    const uint8_t byte = data[(*cursor)++];
+    value |= (uint32_t)(byte & 0x7fu) << shift;
+    if ((byte & 0x80u) == 0u) {
+      *out_value = value;
+      return true;
+    }
+    shift += 7u;
+  }
+
+  return false;
+}
+
+static uint32_t blower_sample_capture_zigzag(int32_t value) {
+  return ((uint32_t)value << 1u) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t blower_sample_capture_unzigzag(uint32_t value) {
+  return (int32_t)((value >> 1u) ^ (uint32_t)-(int32_t)(value & 1u));
+}
+
+static void blower_sample_capture_seal_page(void) {
+  blower_sample_capture_header_t header = {
+      .magic = BLOWER_SAMPLE_CAPTURE_MAGIC,
+      .version = BLOWER_SAMPLE_CAPTURE_VERSION,
+      .direction = g_capture.window_direction,
+      .point_index = g_capture.window_point_index,
+      .sample_count = g_capture.open_sample_count,
+      .report_id = g_capture.window_report_id,
+      .sequence = g_capture.next_sequence,
+      .first_tick_ms = g_capture.open_first_tick_ms,
+      .payload_length = g_capture.open_length,
+      .reserved = 0u,
+      .crc32 = 0u,
+  };
+  uint32_t irq_state = 0u;
+  bool staged = false;
+
+  if (g_capture.open_sample_count == 0u) {
+    return;
+  }
+
+  memset(g_open_page + sizeof(header) + g_capture.open_length,
+         FLASH_STORAGE_ERASED_BYTE,
+         BLOWER_SAMPLE_CAPTURE_PAYLOAD_CAPACITY - g_capture.open_length);
+  memcpy(g_open_page, &header, sizeof(header));
+  header.crc32 = blower_sample_capture_crc32_for_page(g_open_page, &header);
+  memcpy(g_open_page, &header, sizeof(header));
+
+  irq_state = save_and_disable_interrupts();
+  if (g_capture.staging_count < APP_TEST_SAMPLE_CAPTURE_STAGING_PAGES) {
+    const uint16_t tail =
+        (uint16_t)((g_capture.staging_head + g_capture.staging_count) %
+                   APP_TEST_SAMPLE_CAPTURE_STAGING_PAGES);
+    memcpy(g_staging_pages[tail], g_open_page, FLASH_PAGE_SIZE);
+    g_capture.staging_count += 1u;
+    staged = true;
+  }
+  restore_interrupts(irq_state);
+
+  if (staged) {
+    g_capture.next_sequence += 1u;
+  } else {
+    g_capture.captured_samples -= g_capture.open_sample_count;
+    g_capture.dropped_samples += g_capture.open_sample_count;
+  }
+  g_capture.open_length = 0u;
+  g_capture.open_sample_count = 0u;
+}
+
+void blower_sample_capture_begin_window(uint32_t report_id, uint8_t direction,
+                                        uint8_t point_index) {
+  blower_sample_capture_end_window();
+  if (report_id == 0u || !g_capture.available) {
+    return;
+  }
+
+  g_capture.window_open = true;
+  g_capture.window_report_id = report_id;
+  g_capture.window_direction = direction;
+  g_capture.window_point_index = point_index;
+  g_capture.decimation_count = 0u;
+  g_capture.open_length = 0u;
+  g_capture.open_sample_count = 0u;
+}
+
+/*
+ * Each page decodes on its own: its first sample is stored relative to
+ * zero and first_tick_ms, later ones as deltas from their predecessor.
+ */
+static size_t blower_sample_capture_encode(uint8_t *out, uint32_t tick_ms,
+                                           const int32_t *values,
+                                           bool first_in_page) {
+  size_t length = 0u;
+  uint32_t field = 0u;
+
+  length += blower_sample_capture_put_varint(
+      out + length, first_in_page ? 0u : tick_ms - g_capture.last_tick_ms);
+  for (field = 0u; field < BLOWER_SAMPLE_CAPTURE_FIELD_COUNT; ++field) {
+    const int32_t delta =
+        first_in_page ? values[field]
+                      : values[field] - g_capture.last_values[field];
+    length += blower_sample_capture_put_varint(
+        out + length, blower_sample_capture_zigzag(delta));
+  }
+
+  return length;
+}
+
+void blower_sample_capture_push(uint32_t tick_ms, float envelope_pressure_pa,
+                                float fan_pressure_pa,
+                                float fan_temperature_c,
+                                float envelope_temperature_c,
+                                float power_percent) {
+  const int32_t values[BLOWER_SAMPLE_CAPTURE_FIELD_COUNT] = {
+      blower_sample_capture_to_fixed(envelope_pressure_pa, 100.0f),
+      blower_sample_capture_to_fixed(fan_pressure_pa, 100.0f),
+      blower_sample_capture_to_fixed(fan_temperature_c, 100.0f),
+      blower_sample_capture_to_fixed(envelope_temperature_c, 100.0f),
+      blower_sample_capture_to_fixed(power_percent, 10.0f),
+  };
+  uint8_t encoded[BLOWER_SAMPLE_CAPTURE_MAX_ENCODED_BYTES];
+  size_t encoded_length = 0u;
+
+  if (!g_capture.window_open) {
+    return;
+  }
+
+  g_capture.decimation_count += 1u;
+  if (((g_capture.decimation_count - 1u) %
+       APP_TEST_SAMPLE_CAPTURE_DECIMATION) != 0u) {
+    return;
+  }
+
+  encoded_length = blower_sample_capture_encode(
+      encoded, tick_ms, values, g_capture.open_sample_count == 0u);
+  if (g_capture.open_sample_count == 0xffu ||
+      g_capture.open_length + encoded_length >
+          BLOWER_SAMPLE_CAPTURE_PAYLOAD_CAPACITY) {
+    blower_sample_capture_seal_page();
+    encoded_length =
+        blower_sample_capture_encode(encoded, tick_ms, values, true);
+  }
+
+  if (g_capture.open_sample_count == 0u) {
+    g_capture.open_first_tick_ms = tick_ms;
+  }
+  memcpy(g_open_page + sizeof(blower_sample_capture_header_t) +
+             g_capture.open_length,
+         encoded, encoded_length);
+  g_capture.open_length += (uint16_t)encoded_length;
+  g_capture.open_sample_count += 1u;
+  g_capture.last_tick_ms = tick_ms;
+  memcpy(g_capture.last_values, values, sizeof(g_capture.last_values));
+  g_capture.captured_samples += 1u;
+}
+
+void blower_sample_capture_end_window(void) {
+  if (!g_capture.window_open) {
+    return;
+  }
+
+  blower_sample_capture_seal_page();
+  g_capture.window_open = false;
+}
+
+bool blower_sample_capture_persist_step(void) {
+  uint32_t irq_state = 0u;
+  bool touched_flash = false;
+
+  if (g_capture.mutex == NULL || !g_capture.available) {
+    return false;
+  }
+
+  if (xSemaphoreTake(g_capture.mutex, 0) != pdTRUE) {
+    return false;
+  }
+
+  if (g_capture.head_sector_needs_erase) {
+    const uint32_t sector =
+        g_capture.head_page / BLOWER_SAMPLE_CAPTURE_PAGES_PER_SECTOR;
+
+    irq_state = save_and_disable_interrupts();
+    flash_range_erase(APP_TEST_SAMPLE_LOG_OFFSET_BYTES +
+                          sector * FLASH_SECTOR_SIZE,
+                      FLASH_SECTOR_SIZE);
+    restore_interrupts(irq_state);
+
+    g_capture.head_sector_needs_erase = false;
+    touched_flash = true;
+  } else if (g_capture.staging_count > 0u) {
+    /* The producer never touches the head slot while it is counted. */
+    irq_state = save_and_disable_interrupts();
+    flash_range_program(
+        blower_sample_capture_page_offset(g_capture.head_page),
+        g_staging_pages[g_capture.staging_head], FLASH_PAGE_SIZE);
+    g_capture.staging_head =
+        (uint16_t)((g_capture.staging_head + 1u) %
+                   APP_TEST_SAMPLE_CAPTURE_STAGING_PAGES);
+    g_capture.staging_count -= 1u;
+    restore_interrupts(irq_state);
+
+    blower_sample_capture_advance_head();
+    touched_flash = true;
+  }
+
+  xSemaphoreGive(g_capture.mutex);
+  return touched_flash;
+}
+
+static uint32_t blower_sample_capture_visit_page(
+    const uint8_t *page, const blower_sample_capture_header_t *header,
+    blower_sample_capture_visitor_fn visitor, void *context, bool *out_stop) {
+  const uint8_t *payload = page + sizeof(blower_sample_capture_header_t);
+  blower_sample_capture_sample_t sample = {
+      .report_id = header->report_id,
+      .tick_ms = header->first_tick_ms,
+      .direction = header->direction,
+      .point_index = header->point_index,
+  };
+  int32_t values[BLOWER_SAMPLE_CAPTURE_FIELD_COUNT] = {0};
+  size_t cursor = 0u;
+  uint32_t visited = 0u;
+  uint32_t index = 0u;
+
+  for (index = 0u; index < header->sample_count && !*out_stop; ++index) {
+    uint32_t raw = 0u;
+    uint32_t field = 0u;
+
+    if (!blower_sample_capture_get_varint(payload, header->payload_length,
+                                          &cursor, &raw)) {
+      break;
+    }
+    sample.tick_ms += raw;
+    for (field = 0u; field < BLOWER_SAMPLE_CAPTURE_FIELD_COUNT; ++field) {
+      if (!blower_sample_capture_get_varint(payload, header->payload_length,
+                                            &cursor, &raw)) {
+        return visited;
+      }
+      values[field] += blower_sample_capture_unzigzag(raw);
+    }
+
+    sample.envelope_pressure_cpa = values[0];
+    sample.fan_pressure_cpa = values[1];
+    sample.fan_temperature_cc = values[2];
+    sample.envelope_temperature_cc = values[3];
+    sample.power_permille = values[4];
+    visited += 1u;
+    *out_stop = !visitor(&sample, context);
+  }
+
+  return visited;
+}
+
+uint32_t blower_sample_capture_for_each(
+    uint32_t report_id, blower_sample_capture_visitor_fn visitor,
+    void *context) {
+  uint8_t page[FLASH_PAGE_SIZE];
+  blower_sample_capture_header_t header = {0};
+  uint32_t last_sequence = 0u;
+  uint32_t head_page = 0u;
+  uint32_t visited = 0u;
+  uint32_t step = 0u;
+  bool stop = false;
+
+  if (report_id == 0u || visitor == NULL || g_capture.mutex == NULL ||
+      !g_capture.available) {
+    return 0u;
+  }
+
+  if (xSemaphoreTake(g_capture.mutex, portMAX_DELAY) != pdTRUE) {
+    return 0u;
+  }
+  head_page = g_capture.head_page;
+  xSemaphoreGive(g_capture.mutex);
+
+  /* Starting at the head walks the ring oldest first. */
+  for (step = 0u; step < BLOWER_SAMPLE_CAPTURE_PAGE_COUNT && !stop; ++step) {
+    const uint32_t flash_page =
+        (head_page + step) % BLOWER_SAMPLE_CAPTURE_PAGE_COUNT;
+    const uint8_t *stored = blower_sample_capture_page_ptr(flash_page);
+
+    memcpy(&header, stored, sizeof(header));
+    if (header.magic != BLOWER_SAMPLE_CAPTURE_MAGIC ||
+        header.report_id != report_id) {
+      continue;
+    }
+
+    /* Copied under the lock so no erase lands between check and decode. */
+    if (xSemaphoreTake(g_capture.mutex, portMAX_DELAY) != pdTRUE) {
+      break;
+    }
+    memcpy(page, stored, sizeof(page));
+    xSemaphoreGive(g_capture.mutex);
+
+    if (blower_sample_capture_page_is_valid(page, &header) &&
+        header.report_id == report_id && header.sequence > last_sequence) {
+      last_sequence = header.sequence;
+      visited += blower_sample_capture_visit_page(page, &header, visitor,
+                                                  context, &stop);
+    }
+  }
+
+  /* Staged pages are newer than anything in flash. */
+  while (!stop) {
+    uint32_t irq_state = save_and_disable_interrupts();
+    uint16_t index = 0u;
+    bool found = false;
+
+    for (index = 0u; index < g_capture.staging_count && !found; ++index) {
+      const uint8_t *staged =
+          g_staging_pages[(g_capture.staging_head + index) %
+                          APP_TEST_SAMPLE_CAPTURE_STAGING_PAGES];
+      memcpy(&header, staged, sizeof(header));
+      if (header.report_id == report_id && header.sequence > last_sequence) {
+        memcpy(page, staged, sizeof(page));
+        found = true;
+      }
+    }
+    restore_interrupts(irq_state);
+
+    if (!found) {
+      break;
+    }
+    last_sequence = header.sequence;
+    if (blower_sample_capture_page_is_valid(page, &header)) {
+      visited += blower_sample_capture_visit_page(page, &header, visitor,
+                                                  context, &stop);
+    }
+  }
+
+  return visited;
+}
+
+bool blower_sample_capture_has_report(uint32_t report_id) {
+  blower_sample_capture_header_t header = {0};
+  uint32_t irq_state = 0u;
+  uint32_t index = 0u;
+  bool found = false;
+
+  if (report_id == 0u || !g_capture.available) {
+    return false;
+  }
+
+  for (index = 0u; index < BLOWER_SAMPLE_CAPTURE_PAGE_COUNT && !found;
+       ++index) {
+    memcpy(&header, blower_sample_capture_page_ptr(index), sizeof(header));
+    found = header.magic == BLOWER_SAMPLE_CAPTURE_MAGIC &&
+            header.report_id == report_id;
+  }
+
+  irq_state = save_and_disable_interrupts();
+  for (index = 0u; index < g_capture.staging_count && !found; ++index) {
+    memcpy(&header,
+           g_staging_pages[(g_capture.staging_head + index) %
+                           APP_TEST_SAMPLE_CAPTURE_STAGING_PAGES],
+           sizeof(header));
+    found = header.report_id == report_id;
+  }
+  restore_interrupts(irq_state);
+
+  return found;
+}
+
+void blower_sample_capture_get_stats(blower_sample_capture_stats_t *out_stats) {
+  uint32_t irq_state = 0u;
+
+  if (out_stats == NULL) {
+    return;
+  }
+
+  irq_state = save_and_disable_interrupts();
+  *out_stats = (blower_sample_capture_stats_t){
+      .captured_samples = g_capture.captured_samples,
+      .dropped_samples = g_capture.dropped_samples,
+      .staged_pages = g_capture.staging_count,
+      .staging_capacity_pages = APP_TEST_SAMPLE_CAPTURE_STAGING_PAGES,
+  };
+  restore_interrupts(irq_state);
+}
@@ -2,24 +2,26 @@
 
 #include "FreeRTOS.h"
 #include "app/app_config.h"
+#include "services/blower_flow_correction.h"
+#include "services/blower_leakage_fit.h"
+#include "services/blower_report_log.h"
+#include "services/blower_running_stats.h"
+#include "services/blower_sample_capture.h"
+#include "services/flash_storage.h"
 #include "hardware/flash.h"
 #include "hardware/regs/addressmap.h"
-#include "hardware/sync.h"
 #include "semphr.h"
 #include "task.h"
 #include <math.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
 #define BLOWER_TEST_STORAGE_MAGIC 0x42544452u /* BTDR */
-#define BLOWER_TEST_STORAGE_VERSION 1u
-#define BLOWER_TEST_STORAGE_FILL_BYTE 0xffu
+#define BLOWER_TEST_STORAGE_VERSION 8u
 
-#define BLOWER_TEST_FULL_APERTURE_DIAMETER_CM 31.0f
-#define BLOWER_TEST_SEA_LEVEL_AIR_DENSITY 1.225f
-#define BLOWER_TEST_AIR_GAS_CONSTANT 287.05f
-#define BLOWER_TEST_REFERENCE_PRESSURE_PA 101325.0f
+#define BLOWER_TEST_SUMMARY_FALLBACK_TEMPERATURE_C 20.0f
 
 #define BLOWER_TEST_MIN_PRESSURE_PA 10.0f
 #define BLOWER_TEST_MAX_PRESSURE_PA 100.0f
@@ -30,6 +32,46 @@
 #define BLOWER_TEST_MIN_MEASURE_TIME_S 2u
 #define BLOWER_TEST_MAX_MEASURE_TIME_S 300u
 #define BLOWER_TEST_DEFAULT_MIN_POINTS 5u
+#define BLOWER_TEST_MIN_CI_PA 0.05f
+#define BLOWER_TEST_MAX_CI_PA 5.0f
+#define BLOWER_TEST_MIN_DRIFT_PA_S 0.05f
+#define BLOWER_TEST_MAX_DRIFT_PA_S 10.0f
+#define BLOWER_TEST_MIN_BASELINE_TIME_S 10u
+#define BLOWER_TEST_MAX_BASELINE_TIME_S 300u
+#define BLOWER_TEST_MIN_BASELINE_PA 0.5f
+#define BLOWER_TEST_MAX_BASELINE_PA 20.0f
+
+/*
+ * Zero-flow phases wait this long after the relay opens so the fan has
+ * spun down and the envelope pressure decayed before sampling starts.
+ * ISO 9972 asks for at least ten readings per phase.
+ */
+#define BLOWER_TEST_BASELINE_SETTLE_MS 5000u
+#define BLOWER_TEST_MIN_BASELINE_SAMPLES 10u
+
+/*
+ * Convergence is judged on 1 s block means rather than raw 50 Hz samples:
+ * consecutive samples are strongly correlated, so the naive sd/sqrt(n)
+ * would overstate the confidence. Block means are close to independent.
+ */
+#define BLOWER_TEST_BLOCK_MS 1000u
+#define BLOWER_TEST_MIN_CI_BLOCKS 3u
+
+/*
+ * A fan pressure has to stay outside the mounted range this long before
+ * the test asks for another ring; below the range it only counts once the
+ * envelope is on target, so the spin-up of each point is not mistaken for
+ * a ring that is too open.
+ */
+#define BLOWER_TEST_RING_CHANGE_DELAY_MS 5000u
+#define BLOWER_TEST_MAX_FAN_OUT_OF_RANGE_FRACTION 0.1f
+
+/*
+ * The control loop applies an engage request on its next 20 ms step. If
+ * the loop has still not taken it this long after the request (queue full,
+ * control task stalled), the test stops with an error.
+ */
+#define BLOWER_TEST_ENGAGE_TIMEOUT_MS 2000u
 
 typedef struct {
   uint32_t magic;
@@ -37,13 +79,31 @@ typedef struct {
   uint16_t payload_size;
   uint32_t sequence;
   blower_test_config_t config;
-  uint8_t history_count;
-  uint8_t history_head;
-  uint16_t reserved0;
-  blower_test_report_t history[BLOWER_TEST_HISTORY_CAPACITY];
   uint32_t crc32;
 } blower_test_persistent_blob_t;
 
+#define BLOWER_TEST_STORAGE_IMAGE_SIZE                                      \
+  (((sizeof(blower_test_persistent_blob_t) + FLASH_PAGE_SIZE - 1u) /        \
+    FLASH_PAGE_SIZE) *                                                      \
+   FLASH_PAGE_SIZE)
+
+/*
+ * Control requests are recorded under the test mutex and issued to
+ * blower_control only after it is released, so the two services never
+ * nest their locks.
+ */
+typedef enum {
+  BLOWER_TEST_CONTROL_ACTION_NONE = 0,
+  BLOWER_TEST_CONTROL_ACTION_ENGAGE,
+  BLOWER_TEST_CONTROL_ACTION_SET_TARGET,
+  BLOWER_TEST_CONTROL_ACTION_RELEASE,
+} blower_test_control_action_kind_t;
+
+typedef struct {
+  blower_test_control_action_kind_t kind;
+  float target_pressure_pa;
+} blower_test_control_action_t;
+
 typedef struct {
   SemaphoreHandle_t mutex;
   bool initialized;
@@ -56,38 +116,66 @@ typedef struct {
   blower_test_report_t latest_report;
   bool has_latest_report;
   uint32_t next_report_id;
-
-  blower_test_report_t history[BLOWER_TEST_HISTORY_CAPACITY];
-  uint8_t history_count;
-  uint8_t history_head;
+  /* Set under the mutex, cleared by the control task after the append. */
+  atomic_bool report_append_pending;
 
   uint32_t state_enter_tick_ms;
   uint32_t stable_since_tick_ms;
   uint32_t measure_start_tick_ms;
-
-  float acc_pressure_pa;
-  float acc_fan_flow_m3h;
-  float acc_fan_temp_c;
-  float acc_envelope_temp_c;
-  float acc_pwm_percent;
-  uint16_t acc_samples;
+  uint32_t point_start_tick_ms;
+  uint32_t baseline_since_tick_ms;
+  uint32_t fan_out_of_range_since_tick_ms;
+  uint32_t fan_out_of_range_samples;
+  bool ring_change_resume;
+
+  blower_running_stats_t block_pressure_pa;
+  blower_running_stats_t block_fan_flow_m3h;
+  uint32_t block_start_tick_ms;
+  blower_running_stats_t block_means_pressure_pa;
+  blower_running_stats_t block_means_fan_flow_m3h;
+  float last_block_mean_pa;
+  bool has_last_block_mean;
+  bool settle_block_ok;
+
+  blower_running_stats_t stats_pressure_pa;
+  blower_running_stats_t stats_fan_flow_m3h;
+  blower_running_stats_t stats_fan_temp_c;
+  blower_running_stats_t stats_envelope_temp_c;
+  blower_running_stats_t stats_pwm_percent;
+  blower_flow_correction_t flow_correction;
+  blower_leakage_fit_workspace_t fit_workspace;
 
   blower_test_direction_t direction_sequence[2];
   uint8_t direction_count;
   uint8_t direction_slot;
+
+  blower_test_control_action_t pending_action;
+  bool control_engaged;
+  uint32_t engage_wait_since_tick_ms;
+  bool persist_pending;
+
+  /* Control task only: the sample refused on a busy mutex, if any. */
+  uint32_t busy_sequence;
+  bool has_busy_sequence;
+  uint32_t lost_busy_samples;
 } blower_test_context_t;
 
 static blower_test_context_t g_context;
-static uint8_t g_storage_image_buffer[APP_PERSISTENT_STORAGE_SIZE_BYTES];
+static blower_test_persistent_blob_t g_persist_blob;
+static uint8_t g_storage_image_buffer[BLOWER_TEST_STORAGE_IMAGE_SIZE];
 
 _Static_assert(
-    sizeof(blower_test_persistent_blob_t) <= APP_PERSISTENT_STORAGE_SIZE_BYTES,
+    BLOWER_TEST_STORAGE_IMAGE_SIZE <= APP_PERSISTENT_STORAGE_SIZE_BYTES,
     "Persistent blob is larger than APP_PERSISTENT_STORAGE_SIZE_BYTES");
 
 static float blower_test_absf(float value) {
   return value >= 0.0f ? value : -value;
 }
 
+static uint16_t blower_test_sample_count_u16(uint32_t count) {
+  return count > 0xffffu ? 0xffffu : (uint16_t)count;
+}
+
 static float blower_test_clampf(float value, float min_value, float max_value) {
   if (value < min_value) {
     return min_value;
@@ -98,104 +186,27 @@ static float blower_test_clampf(float value, float min_value, float max_value) {
   return value;
 }
 
-static uint32_t blower_test_crc32_update(uint32_t crc, const uint8_t *data,
-                                         size_t data_len) {
-  uint32_t value = crc;
-  size_t index = 0u;
-
-  if (data == NULL) {
-    return value;
-  }
-
-  for (index = 0u; index < data_len; ++index) {
-    uint32_t bit = 0u;
-    value ^= data[index];
-    for (bit = 0u; bit < 8u; ++bit) {
-      const uint32_t mask = (uint32_t)-(int32_t)(value & 1u);
-      value = (value >> 1u) ^ (0xedb88320u & mask);
-    }
-  }
-
-  return value;
-}
-
 static uint32_t blower_test_crc32_for_blob(
     const blower_test_persistent_blob_t *blob) {
-  const size_t payload_size =
-      offsetof(blower_test_persistent_blob_t, crc32);
-  return blower_test_crc32_update(0xffffffffu, (const uint8_t *)blob,
-                                  payload_size) ^
-         0xffffffffu;
+  return flash_storage_crc32(blob,
+                             offsetof(blower_test_persistent_blob_t, crc32));
 }
 
 static bool blower_test_storage_layout_is_valid(void) {
-  const uint32_t storage_end =
-      APP_PERSISTENT_STORAGE_OFFSET_BYTES + APP_PERSISTENT_STORAGE_SIZE_BYTES;
-
-  if (APP_PERSISTENT_STORAGE_SIZE_BYTES == 0u) {
-    return false;
-  }
-  if ((APP_PERSISTENT_STORAGE_OFFSET_BYTES % FLASH_SECTOR_SIZE) != 0u) {
-    return false;
-  }
-  if ((APP_PERSISTENT_STORAGE_SIZE_BYTES % FLASH_SECTOR_SIZE) != 0u) {
-    return false;
-  }
-  if ((APP_PERSISTENT_STORAGE_SIZE_BYTES % FLASH_PAGE_SIZE) != 0u) {
-    return false;
-  }
-  if (APP_PERSISTENT_STORAGE_OFFSET_BYTES >= PICO_FLASH_SIZE_BYTES ||
-      storage_end > PICO_FLASH_SIZE_BYTES) {
-    return false;
-  }
-
-  return true;
+  return flash_storage_region_is_valid(APP_PERSISTENT_STORAGE_OFFSET_BYTES,
+                                       APP_PERSISTENT_STORAGE_SIZE_BYTES, 0u);
 }
 
-static bool blower_test_storage_verify(const uint8_t *expected_data,
-                                       size_t verify_len) {
-  const volatile uint8_t *flash_bytes =
-      (const volatile uint8_t *)(XIP_BASE + APP_PERSISTENT_STORAGE_OFFSET_BYTES);
-  size_t index = 0u;
-
-  if (expected_data == NULL) {
-    return false;
-  }
-
-  for (index = 0u; index < verify_len; ++index) {
-    if (flash_bytes[index] != expected_data[index]) {
-      return false;
-    }
-  }
-
-  return true;
-}
-
-static bool blower_test_storage_program(const blower_test_persistent_blob_t *blob) {
-  uint32_t offset = 0u;
-  uint32_t irq_state = 0u;
-
+static bool blower_test_storage_program(
+    const blower_test_persistent_blob_t *blob) {
   if (blob == NULL || !blower_test_storage_layout_is_valid()) {
     return false;
   }
 
-  memset(g_storage_image_buffer, BLOWER_TEST_STORAGE_FILL_BYTE,
-         sizeof(g_storage_image_buffer));
-  memcpy(g_storage_image_buffer, blob, sizeof(*blob));
-
-  irq_state = save_and_disable_interrupts();
-  flash_range_erase(APP_PERSISTENT_STORAGE_OFFSET_BYTES,
-                    APP_PERSISTENT_STORAGE_SIZE_BYTES);
-
-  for (offset = 0u; offset < APP_PERSISTENT_STORAGE_SIZE_BYTES;
-       offset += FLASH_PAGE_SIZE) {
-    flash_range_program(APP_PERSISTENT_STORAGE_OFFSET_BYTES + offset,
-                        g_storage_image_buffer + offset, FLASH_PAGE_SIZE);
-  }
-  restore_interrupts(irq_state);
-
-  return blower_test_storage_verify(g_storage_image_buffer,
-                                    APP_PERSISTENT_STORAGE_SIZE_BYTES);
+  return flash_storage_write_image(APP_PERSISTENT_STORAGE_OFFSET_BYTES,
+                                   g_storage_image_buffer,
+                                   sizeof(g_storage_image_buffer), blob,
+                                   sizeof(*blob));
 }
 
 static bool blower_test_storage_load(blower_test_persistent_blob_t *out_blob) {
@@ -225,50 +236,33 @@ static bool blower_test_storage_load(blower_test_persistent_blob_t *out_blob) {
   return true;
 }
 
-static float blower_test_air_density_kg_m3(float altitude_m, float temperature_c) {
-  const float clamped_altitude = blower_test_clampf(altitude_m, 0.0f, 6000.0f);
-  const float pressure_pa =
-      BLOWER_TEST_REFERENCE_PRESSURE_PA *
-      powf(1.0f - 2.25577e-5f * clamped_altitude, 5.25588f);
-  const float temp_kelvin =
-      blower_test_clampf(temperature_c, -40.0f, 80.0f) + 273.15f;
-
-  if (temp_kelvin <= 1.0f) {
-    return BLOWER_TEST_SEA_LEVEL_AIR_DENSITY;
-  }
-
-  return pressure_pa / (BLOWER_TEST_AIR_GAS_CONSTANT * temp_kelvin);
-}
-
-static float blower_test_aperture_scale(float aperture_diameter_cm) {
-  const float aperture_cm = blower_test_clampf(aperture_diameter_cm, 5.0f, 60.0f);
-  const float aperture_m = aperture_cm / 100.0f;
-  const float full_aperture_m = BLOWER_TEST_FULL_APERTURE_DIAMETER_CM / 100.0f;
-  const float aperture_area = (float)M_PI * powf(aperture_m * 0.5f, 2.0f);
-  const float full_area = (float)M_PI * powf(full_aperture_m * 0.5f, 2.0f);
+static void blower_test_publish_flow_settings_locked(void) {
+  const blower_test_config_t *config = &g_context.config;
+  blower_flow_correction_settings_t settings = {
+      .altitude_m = config->altitude_m,
+  };
 
-  if (full_area <= 0.0f) {
-    return 1.0f;
-  }
-  return aperture_area / full_area;
+  if (config->fan_range_count > 0u) {
+    settings.fan_range = config->fan_ranges[config->fan_range_index];
+  } else {
+    /* Open fan: the single curve, scaled by the aperture area. */
+    const float aperture_ratio =
+        config->fan_aperture_cm / (APP_FAN_DIAMETER_M * 100.0f);
+    settings.fan_range = (blower_fan_calibration_range_t){
+        .kind = (uint8_t)BLOWER_FAN_CALIBRATION_POWER_LAW,
+        .min_pressure_pa = APP_FAN_OPEN_MIN_PRESSURE_PA,
+        .max_pressure_pa = APP_FAN_OPEN_MAX_PRESSURE_PA,
+        .c = config->fan_curve_c * aperture_ratio * aperture_ratio,
+        .n = config->fan_curve_n,
+    };
+  }
+  blower_flow_correction_configure(&settings);
 }
 
-static float blower_test_compute_fan_flow_m3h(
-    const blower_test_config_t *config, float fan_pressure_pa,
-    float envelope_temperature_c) {
-  const float dp_abs = blower_test_absf(fan_pressure_pa);
-  const float density =
-      blower_test_air_density_kg_m3(config->altitude_m, envelope_temperature_c);
-  const float density_factor =
-      density > 0.0f ? sqrtf(BLOWER_TEST_SEA_LEVEL_AIR_DENSITY / density) : 1.0f;
-  const float aperture_scale = blower_test_aperture_scale(config->fan_aperture_cm);
-
-  if (dp_abs <= 0.0f || config->fan_curve_c <= 0.0f || config->fan_curve_n <= 0.0f) {
-    return 0.0f;
-  }
-
-  return config->fan_curve_c * powf(dp_abs, config->fan_curve_n) * aperture_scale *
-         density_factor;
+static void blower_test_apply_config_locked(
+    const blower_test_config_t *config) {
+  g_context.config = *config;
+  blower_test_publish_flow_settings_locked();
 }
 
 static void blower_test_fill_default_config(blower_test_config_t *config) {
@@ -286,16 +280,25 @@ static void blower_test_fill_default_config(blower_test_config_t *config) {
   config->envelope_area_m2 = 168.0f;
   config->building_height_m = 2.9f;
   config->dimensions_uncertainty_pct = 5.0f;
-  config->altitude_m = 650.0f;
-  config->fan_aperture_cm = 31.0f;
+  config->altitude_m = APP_ALTITUDE_M;
+  config->fan_aperture_cm = APP_FAN_DIAMETER_M * 100.0f;
   config->fan_curve_c = APP_FAN_FLOW_COEFFICIENT_C;
   config->fan_curve_n = APP_FAN_FLOW_EXPONENT_N;
   config->target_tolerance_pa = 2.0f;
   config->settle_time_s = 8u;
   config->measure_time_s = 10u;
+  config->adaptive_windows = true;
+  config->min_settle_time_s = 3u;
+  config->min_measure_time_s = 4u;
+  config->target_ci_pa = 0.3f;
+  config->max_drift_pa_s = 0.5f;
+  config->baseline_time_s = 30u;
+  config->max_baseline_pa = 5.0f;
   config->reference_pressure_pa = 50u;
   config->min_points_required = BLOWER_TEST_DEFAULT_MIN_POINTS;
   config->enforce_iso_9972_rules = true;
+  config->fit_method = (uint8_t)BLOWER_LEAKAGE_FIT_WLS;
+  config->capture_raw_samples = false;
   config->pressure_points_count = (uint8_t)(sizeof(k_default_pressures) /
                                             sizeof(k_default_pressures[0]));
 
@@ -360,6 +363,29 @@ static bool blower_test_validate_and_normalize_config(blower_test_config_t *conf
   config->measure_time_s = (uint16_t)blower_test_clampf(
       (float)config->measure_time_s, (float)BLOWER_TEST_MIN_MEASURE_TIME_S,
       (float)BLOWER_TEST_MAX_MEASURE_TIME_S);
+  config->min_settle_time_s = (uint16_t)blower_test_clampf(
+      (float)config->min_settle_time_s, 1.0f, (float)config->settle_time_s);
+  config->min_measure_time_s = (uint16_t)blower_test_clampf(
+      (float)config->min_measure_time_s, 1.0f, (float)config->measure_time_s);
+  if (!isfinite(config->target_ci_pa) || !isfinite(config->max_drift_pa_s)) {
+    return false;
+  }
+  config->target_ci_pa = blower_test_clampf(
+      config->target_ci_pa, BLOWER_TEST_MIN_CI_PA, BLOWER_TEST_MAX_CI_PA);
+  config->max_drift_pa_s =
+      blower_test_clampf(config->max_drift_pa_s, BLOWER_TEST_MIN_DRIFT_PA_S,
+                         BLOWER_TEST_MAX_DRIFT_PA_S);
+  if (!isfinite(config->max_baseline_pa)) {
+    return false;
+  }
+  config->max_baseline_pa =
+      blower_test_clampf(config->max_baseline_pa, BLOWER_TEST_MIN_BASELINE_PA,
+                         BLOWER_TEST_MAX_BASELINE_PA);
+  if (config->baseline_time_s != 0u) {
+    config->baseline_time_s = (uint16_t)blower_test_clampf(
+        (float)config->baseline_time_s, (float)BLOWER_TEST_MIN_BASELINE_TIME_S,
+        (float)BLOWER_TEST_MAX_BASELINE_TIME_S);
+  }
   config->fan_aperture_cm =
       blower_test_clampf(config->fan_aperture_cm, 5.0f, 60.0f);
   config->altitude_m = blower_test_clampf(config->altitude_m, 0.0f, 6000.0f);
@@ -369,6 +395,9 @@ static bool blower_test_validate_and_normalize_config(blower_test_config_t *conf
   if (config->reference_pressure_pa < 10u || config->reference_pressure_pa > 100u) {
     return false;
   }
+  if (config->fit_method > (uint8_t)BLOWER_LEAKAGE_FIT_THEIL_SEN) {
+    return false;
+  }
   if (config->pressure_points_count == 0u ||
       config->pressure_points_count > BLOWER_TEST_MAX_PRESSURE_POINTS) {
     return false;
@@ -389,6 +418,18 @@ static bool blower_test_validate_and_normalize_config(blower_test_config_t *conf
   blower_test_sort_pressures_desc(config->pressure_points_pa,
                                   config->pressure_points_count);
 
+  if (config->fan_range_count > BLOWER_FAN_CALIBRATION_MAX_RANGES) {
+    return false;
+  }
+  for (index = 0u; index < config->fan_range_count; ++index) {
+    if (!blower_fan_calibration_range_normalize(&config->fan_ranges[index])) {
+      return false;
+    }
+  }
+  if (config->fan_range_index >= config->fan_range_count) {
+    config->fan_range_index = 0u;
+  }
+
   if (config->enforce_iso_9972_rules &&
       config->pressure_points_count < config->min_points_required) {
     return false;
@@ -399,6 +440,10 @@ static bool blower_test_validate_and_normalize_config(blower_test_config_t *conf
 
 static void blower_test_set_state_locked(blower_test_state_t state,
                                          uint32_t now_tick_ms) {
+  if (g_context.runtime.state == BLOWER_TEST_STATE_MEASURING &&
+      state != BLOWER_TEST_STATE_MEASURING) {
+    blower_sample_capture_end_window();
+  }
   g_context.runtime.state = state;
   g_context.state_enter_tick_ms = now_tick_ms;
   g_context.runtime.state_elapsed_ms = 0u;
@@ -418,70 +463,149 @@ static blower_test_direction_report_t *blower_test_active_direction_report_locke
   return NULL;
 }
 
+static void blower_test_reset_blocks_locked(void) {
+  blower_running_stats_reset(&g_context.block_pressure_pa);
+  blower_running_stats_reset(&g_context.block_fan_flow_m3h);
+  blower_running_stats_reset(&g_context.block_means_pressure_pa);
+  blower_running_stats_reset(&g_context.block_means_fan_flow_m3h);
+  g_context.block_start_tick_ms = 0u;
+  g_context.last_block_mean_pa = 0.0f;
+  g_context.has_last_block_mean = false;
+  g_context.settle_block_ok = false;
+  g_context.runtime.current_ci95_pa = 0.0f;
+}
+
+static void blower_test_reset_point_stats_locked(void) {
+  blower_running_stats_reset(&g_context.stats_pressure_pa);
+  blower_running_stats_reset(&g_context.stats_fan_flow_m3h);
+  blower_running_stats_reset(&g_context.stats_fan_temp_c);
+  blower_running_stats_reset(&g_context.stats_envelope_temp_c);
+  blower_running_stats_reset(&g_context.stats_pwm_percent);
+  blower_test_reset_blocks_locked();
+  g_context.fan_out_of_range_since_tick_ms = 0u;
+  g_context.fan_out_of_range_samples = 0u;
+}
+
+static float blower_test_ci95_half_width(const blower_running_stats_t *means) {
+  if (means->count < 2u) {
+    return 0.0f;
+  }
+  return blower_running_stats_t95(means->count - 1u) *
+         blower_running_stats_std_error(means);
+}
+
+/*
+ * Adds a pressure (and optionally flow) sample to the current 1 s block.
+ * Returns true when the block is complete; the caller consumes and resets.
+ */
+static bool blower_test_block_push_locked(float pressure_pa,
+                                          const float *fan_flow_m3h,
+                                          uint32_t now_tick_ms) {
+  if (g_context.block_pressure_pa.count == 0u) {
+    g_context.block_start_tick_ms = now_tick_ms;
+  }
+  blower_running_stats_push(&g_context.block_pressure_pa, pressure_pa);
+  if (fan_flow_m3h != NULL) {
+    blower_running_stats_push(&g_context.block_fan_flow_m3h, *fan_flow_m3h);
+  }
+
+  return (now_tick_ms - g_context.block_start_tick_ms) >= BLOWER_TEST_BLOCK_MS;
+}
+
 static void blower_test_prepare_measurement_locked(uint32_t now_tick_ms) {
-  g_context.acc_pressure_pa = 0.0f;
-  g_context.acc_fan_flow_m3h = 0.0f;
-  g_context.acc_fan_temp_c = 0.0f;
-  g_context.acc_envelope_temp_c = 0.0f;
-  g_context.acc_pwm_percent = 0.0f;
-  g_context.acc_samples = 0u;
+  blower_test_reset_point_stats_locked();
   g_context.measure_start_tick_ms = now_tick_ms;
   g_context.runtime.active_sample_count = 0u;
+  if (g_context.config.capture_raw_samples) {
+    blower_sample_capture_begin_window(
+        g_context.active_report.report_id,
+        (uint8_t)g_context.runtime.current_direction,
+        g_context.runtime.current_point_index);
+  }
   blower_test_set_state_locked(BLOWER_TEST_STATE_MEASURING, now_tick_ms);
 }
 
 static void blower_test_abort_control_locked(void) {
-  blower_control_set_mode(BLOWER_CONTROL_MODE_MANUAL_PERCENT);
-  blower_control_set_relay_enabled(false);
-  blower_control_set_manual_pwm_percent(0u);
+  g_context.pending_action = (blower_test_control_action_t){
+      .kind = BLOWER_TEST_CONTROL_ACTION_RELEASE,
+      .target_pressure_pa = 0.0f,
+  };
+  g_context.control_engaged = false;
+}
+
+static blower_test_control_action_t blower_test_take_action_locked(void) {
+  const blower_test_control_action_t action = g_context.pending_action;
+  g_context.pending_action = (blower_test_control_action_t){
+      .kind = BLOWER_TEST_CONTROL_ACTION_NONE,
+      .target_pressure_pa = 0.0f,
+  };
+  return action;
+}
+
+/* Must be called without the test mutex held. */
+static void blower_test_apply_control_action(
+    const blower_test_control_action_t *action) {
+  switch (action->kind) {
+  case BLOWER_TEST_CONTROL_ACTION_ENGAGE:
+    blower_control_set_target_pressure_pa(action->target_pressure_pa);
+    blower_control_set_mode(BLOWER_CONTROL_MODE_AUTO_TEST);
+    blower_control_set_relay_enabled(true);
+    break;
+  case BLOWER_TEST_CONTROL_ACTION_SET_TARGET:
+    blower_control_set_target_pressure_pa(action->target_pressure_pa);
+    break;
+  case BLOWER_TEST_CONTROL_ACTION_RELEASE:
+    /* Latched, so a full command queue cannot leave the fan running. */
+    blower_control_release();
+    break;
+  default:
+    break;
+  }
 }
 
 static bool blower_test_compute_summary_from_direction(
     const blower_test_config_t *config,
     const blower_test_direction_report_t *direction_report,
+    blower_leakage_fit_workspace_t *fit_workspace,
     blower_test_curve_summary_t *out_summary) {
-  float sum_x = 0.0f;
-  float sum_y = 0.0f;
-  float sum_x2 = 0.0f;
-  float sum_y2 = 0.0f;
-  float sum_xy = 0.0f;
+  blower_leakage_fit_point_t fit_points[BLOWER_TEST_MAX_PRESSURE_POINTS];
+  blower_leakage_fit_result_t fit = {0};
   float sum_rel_err2 = 0.0f;
+  float sum_rel_noise2 = 0.0f;
   uint8_t valid_count = 0u;
   uint8_t index = 0u;
-  float slope_n = 0.0f;
-  float intercept = 0.0f;
-  float denominator = 0.0f;
-  float correlation_denominator = 0.0f;
-  float correlation_r = 0.0f;
   float cl = 0.0f;
+  float slope_n = 0.0f;
   float q_ref = 0.0f;
+  float q_ref_low = 0.0f;
+  float q_ref_high = 0.0f;
   float q10_m3h = 0.0f;
   float q4_m3h = 0.0f;
-  const float rho =
-      blower_test_air_density_kg_m3(config->altitude_m, 20.0f);
+  float rho = 0.0f;
+  blower_running_stats_t fan_temperature_c;
   blower_test_curve_summary_t summary = {0};
 
   if (config == NULL || direction_report == NULL || out_summary == NULL) {
     return false;
   }
 
+  blower_running_stats_reset(&fan_temperature_c);
   for (index = 0u; index < direction_report->point_count; ++index) {
     const blower_test_point_result_t *point = &direction_report->points[index];
     if (!point->valid || point->avg_pressure_pa <= 0.0f ||
         point->avg_fan_flow_m3h <= 0.0f) {
       continue;
     }
+    blower_running_stats_push(&fan_temperature_c,
+                              point->avg_fan_temperature_c);
 
-    {
-      const float x = logf(point->avg_pressure_pa);
-      const float y = logf(point->avg_fan_flow_m3h);
-      sum_x += x;
-      sum_y += y;
-      sum_x2 += x * x;
-      sum_y2 += y * y;
-      sum_xy += x * y;
-      valid_count += 1u;
-    }
+    fit_points[valid_count] = (blower_leakage_fit_point_t){
+        .pressure_pa = point->avg_pressure_pa,
+        .flow_m3h = point->avg_fan_flow_m3h,
+        .pressure_std_error_pa = point->pressure_std_error_pa,
+        .flow_std_error_m3h = point->flow_std_error_m3h,
+    };
+    valid_count += 1u;
   }
 
   if (valid_count < 2u ||
@@ -490,48 +614,55 @@ static bool blower_test_compute_summary_from_direction(
     return false;
   }
 
-  denominator = (float)valid_count * sum_x2 - (sum_x * sum_x);
-  if (fabsf(denominator) < 1e-6f) {
-    return false;
-  }
-
-  slope_n = ((float)valid_count * sum_xy - (sum_x * sum_y)) / denominator;
-  intercept = (sum_y - slope_n * sum_x) / (float)valid_count;
-  cl = expf(intercept);
+  /* Same air the point flows were density-corrected with. */
+  rho = blower_flow_correction_density_kg_m3(
+      fan_temperature_c.count > 0u
+          ? fan_temperature_c.mean
+          : BLOWER_TEST_SUMMARY_FALLBACK_TEMPERATURE_C);
 
-  correlation_denominator =
-      ((float)valid_count * sum_x2 - (sum_x * sum_x)) *
-      ((float)valid_count * sum_y2 - (sum_y * sum_y));
-  if (correlation_denominator > 1e-9f) {
-    correlation_r =
-        ((float)valid_count * sum_xy - (sum_x * sum_y)) /
-        sqrtf(correlation_denominator);
+  if (!blower_leakage_fit(fit_points, valid_count,
+                          (blower_leakage_fit_method_t)config->fit_method,
+                          fit_workspace, &fit)) {
+    return false;
   }
-
-  for (index = 0u; index < direction_report->point_count; ++index) {
-    const blower_test_point_result_t *point = &direction_report->points[index];
-    if (!point->valid || point->avg_pressure_pa <= 0.0f ||
-        point->avg_fan_flow_m3h <= 0.0f) {
-      continue;
-    }
-
-    {
-      const float q_pred = cl * powf(point->avg_pressure_pa, slope_n);
-      if (q_pred > 0.0f) {
-        const float rel_err = (point->avg_fan_flow_m3h - q_pred) / q_pred;
-        sum_rel_err2 += rel_err * rel_err;
-      }
+  cl = fit.c;
+  slope_n = fit.n;
+
+  for (index = 0u; index < valid_count; ++index) {
+    const blower_leakage_fit_point_t *point = &fit_points[index];
+    const float q_pred = cl * powf(point->pressure_pa, slope_n);
+    /*
+     * Measurement noise of the point means, propagated through
+     * Q = C * dP^n: relative SE of the flow plus n times that of dP.
+     */
+    const float rel_se_flow = point->flow_std_error_m3h / point->flow_m3h;
+    const float rel_se_pressure =
+        slope_n * point->pressure_std_error_pa / point->pressure_pa;
+    if (q_pred > 0.0f) {
+      const float rel_err = (point->flow_m3h - q_pred) / q_pred;
+      sum_rel_err2 += rel_err * rel_err;
     }
+    sum_rel_noise2 +=
+        rel_se_flow * rel_se_flow + rel_se_pressure * rel_se_pressure;
   }
 
-  q_ref = cl * powf((float)config->reference_pressure_pa, slope_n);
+  (void)blower_leakage_fit_flow_ci95(&fit,
+                                     (float)config->reference_pressure_pa,
+                                     &q_ref, &q_ref_low, &q_ref_high);
   q10_m3h = cl * powf(10.0f, slope_n);
   q4_m3h = cl * powf(4.0f, slope_n);
 
+  summary.fit_method = (uint8_t)fit.method;
+  summary.downweighted_points = fit.downweighted_count;
   summary.cl_m3h_pan = cl;
+  summary.cl_ci95_low_m3h_pan = fit.c_ci95_low;
+  summary.cl_ci95_high_m3h_pan = fit.c_ci95_high;
   summary.exponent_n = slope_n;
-  summary.correlation_r = correlation_r;
+  summary.exponent_n_ci95 = fit.n_ci95;
+  summary.correlation_r = fit.correlation_r;
   summary.q_ref_m3h = q_ref;
+  summary.q_ref_ci95_low_m3h = q_ref_low;
+  summary.q_ref_ci95_high_m3h = q_ref_high;
   summary.ach_ref_h1 =
       config->building_volume_m3 > 0.0f ? q_ref / config->building_volume_m3 : 0.0f;
   summary.w_ref_m3h_m2 =
@@ -557,11 +688,26 @@ static bool blower_test_compute_summary_from_direction(
           ? summary.lbl_ela4_cm2 / config->envelope_area_m2
           : 0.0f;
 
-  summary.uncertainty_pct =
-      sqrtf(sum_rel_err2 / (float)valid_count) * 100.0f;
-  summary.uncertainty_pct = sqrtf(summary.uncertainty_pct * summary.uncertainty_pct +
-                                  config->dimensions_uncertainty_pct *
-                                      config->dimensions_uncertainty_pct);
+  summary.noise_uncertainty_pct =
+      sqrtf(sum_rel_noise2 / (float)valid_count) * 100.0f;
+  if (valid_count > 2u && q_ref > 0.0f) {
+    /*
+     * ISO 9972 Annex C: the 95% interval of the fitted flow at the
+     * reference pressure, combined with the dimension uncertainty.
+     */
+    const float ci_pct = (q_ref_high - q_ref_low) * 0.5f / q_ref * 100.0f;
+    summary.uncertainty_pct =
+        sqrtf(ci_pct * ci_pct + config->dimensions_uncertainty_pct *
+                                    config->dimensions_uncertainty_pct);
+  } else {
+    /* Two points leave no residual degrees of freedom for an interval. */
+    const float rms_pct = sqrtf(sum_rel_err2 / (float)valid_count) * 100.0f;
+    summary.uncertainty_pct =
+        sqrtf(rms_pct * rms_pct +
+              summary.noise_uncertainty_pct * summary.noise_uncertainty_pct +
+              config->dimensions_uncertainty_pct *
+                  config->dimensions_uncertainty_pct);
+  }
   summary.valid = true;
 
   *out_summary = summary;
@@ -585,10 +731,23 @@ static void blower_test_compute_mean_summary_locked(void) {
         &g_context.active_report.pressurization.summary;
     const blower_test_curve_summary_t *depress =
         &g_context.active_report.depressurization.summary;
+    mean.fit_method = press->fit_method;
+    mean.downweighted_points =
+        (uint8_t)(press->downweighted_points + depress->downweighted_points);
     mean.cl_m3h_pan = (press->cl_m3h_pan + depress->cl_m3h_pan) * 0.5f;
+    mean.cl_ci95_low_m3h_pan =
+        (press->cl_ci95_low_m3h_pan + depress->cl_ci95_low_m3h_pan) * 0.5f;
+    mean.cl_ci95_high_m3h_pan =
+        (press->cl_ci95_high_m3h_pan + depress->cl_ci95_high_m3h_pan) * 0.5f;
     mean.exponent_n = (press->exponent_n + depress->exponent_n) * 0.5f;
+    mean.exponent_n_ci95 =
+        (press->exponent_n_ci95 + depress->exponent_n_ci95) * 0.5f;
     mean.correlation_r = (press->correlation_r + depress->correlation_r) * 0.5f;
     mean.q_ref_m3h = (press->q_ref_m3h + depress->q_ref_m3h) * 0.5f;
+    mean.q_ref_ci95_low_m3h =
+        (press->q_ref_ci95_low_m3h + depress->q_ref_ci95_low_m3h) * 0.5f;
+    mean.q_ref_ci95_high_m3h =
+        (press->q_ref_ci95_high_m3h + depress->q_ref_ci95_high_m3h) * 0.5f;
     mean.ach_ref_h1 = (press->ach_ref_h1 + depress->ach_ref_h1) * 0.5f;
     mean.w_ref_m3h_m2 = (press->w_ref_m3h_m2 + depress->w_ref_m3h_m2) * 0.5f;
     mean.q_ref_envelope_m3h_m2 =
@@ -603,6 +762,8 @@ static void blower_test_compute_mean_summary_locked(void) {
         (press->lbl_ela4_cm2_per_m2_envelope +
          depress->lbl_ela4_cm2_per_m2_envelope) *
         0.5f;
+    mean.noise_uncertainty_pct =
+        (press->noise_uncertainty_pct + depress->noise_uncertainty_pct) * 0.5f;
     mean.uncertainty_pct =
         (press->uncertainty_pct + depress->uncertainty_pct) * 0.5f;
     if (mean.q_ref_m3h > 0.0f) {
@@ -620,36 +781,14 @@ static void blower_test_compute_mean_summary_locked(void) {
   g_context.active_report.mean_summary = mean;
 }
 
-static void blower_test_history_push_locked(const blower_test_report_t *report) {
-  if (report == NULL) {
-    return;
-  }
-
-  g_context.history[g_context.history_head] = *report;
-  g_context.history_head = (uint8_t)((g_context.history_head + 1u) %
-                                     BLOWER_TEST_HISTORY_CAPACITY);
-  if (g_context.history_count < BLOWER_TEST_HISTORY_CAPACITY) {
-    g_context.history_count += 1u;
-  }
-}
-
-static bool blower_test_persist_locked(void) {
-  blower_test_persistent_blob_t blob = {0};
-
-  if (!g_context.persistence_available) {
-    return false;
-  }
-
-  blob.magic = BLOWER_TEST_STORAGE_MAGIC;
-  blob.version = BLOWER_TEST_STORAGE_VERSION;
-  blob.payload_size = sizeof(blob);
-  blob.sequence = g_context.next_report_id;
-  blob.config = g_context.config;
-  blob.history_count = g_context.history_count;
-  blob.history_head = g_context.history_head;
-  memcpy(blob.history, g_context.history, sizeof(blob.history));
-  blob.crc32 = blower_test_crc32_for_blob(&blob);
-  return blower_test_storage_program(&blob);
+static void blower_test_build_blob_locked(blower_test_persistent_blob_t *blob) {
+  memset(blob, 0, sizeof(*blob));
+  blob->magic = BLOWER_TEST_STORAGE_MAGIC;
+  blob->version = BLOWER_TEST_STORAGE_VERSION;
+  blob->payload_size = sizeof(*blob);
+  blob->sequence = g_context.next_report_id;
+  blob->config = g_context.config;
+  blob->crc32 = blower_test_crc32_for_blob(blob);
 }
 
 static void blower_test_load_from_storage_or_defaults_locked(void) {
@@ -657,44 +796,40 @@ static void blower_test_load_from_storage_or_defaults_locked(void) {
   blower_test_config_t default_config = {0};
   bool loaded = false;
 
+  uint32_t latest_id = 0u;
+
   blower_test_fill_default_config(&default_config);
-  g_context.config = default_config;
-  g_context.history_count = 0u;
-  g_context.history_head = 0u;
+  blower_test_apply_config_locked(&default_config);
   g_context.has_latest_report = false;
   g_context.next_report_id = 1u;
 
+  /*
+   * Ids continue after the newest record in flash, whether or not it can
+   * be read back; the config blob's sequence is only a floor.
+   */
+  latest_id = blower_report_log_newest_id();
+  if (latest_id != 0u) {
+    g_context.next_report_id = latest_id + 1u;
+    g_context.has_latest_report =
+        blower_report_log_read(latest_id, &g_context.latest_report);
+  }
+
   if (!g_context.persistence_available) {
     return;
   }
 
   loaded = blower_test_storage_load(&blob);
   if (!loaded) {
-    (void)blower_test_persist_locked();
+    g_context.persist_pending = true;
     return;
   }
 
   if (blower_test_validate_and_normalize_config(&blob.config)) {
-    g_context.config = blob.config;
+    blower_test_apply_config_locked(&blob.config);
   }
 
-  g_context.history_count = blob.history_count <= BLOWER_TEST_HISTORY_CAPACITY
-                                ? blob.history_count
-                                : BLOWER_TEST_HISTORY_CAPACITY;
-  g_context.history_head = blob.history_head % BLOWER_TEST_HISTORY_CAPACITY;
-  memcpy(g_context.history, blob.history, sizeof(g_context.history));
-
-  if (g_context.history_count > 0u) {
-    const uint8_t last_index =
-        (uint8_t)((g_context.history_head + BLOWER_TEST_HISTORY_CAPACITY - 1u) %
-                  BLOWER_TEST_HISTORY_CAPACITY);
-    g_context.latest_report = g_context.history[last_index];
-    g_context.has_latest_report = true;
-    g_context.next_report_id = g_context.latest_report.report_id + 1u;
-  }
-
-  if (blob.sequence >= g_context.next_report_id) {
-    g_context.next_report_id = blob.sequence + 1u;
+  if (blob.sequence > g_context.next_report_id) {
+    g_context.next_report_id = blob.sequence;
   }
 }
 
@@ -711,6 +846,9 @@ static void blower_test_reset_runtime_locked(void) {
       .current_measured_flow_m3h = 0.0f,
       .state_elapsed_ms = 0u,
       .active_sample_count = 0u,
+      .fan_range_index = g_context.config.fan_range_index,
+      .fan_in_range = false,
+      .suggested_fan_range = g_context.config.fan_range_index,
       .report_ready = g_context.has_latest_report,
       .latest_report_id = g_context.has_latest_report
                               ? g_context.latest_report.report_id
@@ -720,12 +858,7 @@ static void blower_test_reset_runtime_locked(void) {
               ? g_context.latest_report.mean_summary.ach_ref_h1
               : 0.0f,
   };
-  g_context.acc_pressure_pa = 0.0f;
-  g_context.acc_fan_flow_m3h = 0.0f;
-  g_context.acc_fan_temp_c = 0.0f;
-  g_context.acc_envelope_temp_c = 0.0f;
-  g_context.acc_pwm_percent = 0.0f;
-  g_context.acc_samples = 0u;
+  blower_test_reset_point_stats_locked();
   g_context.state_enter_tick_ms = 0u;
   g_context.stable_since_tick_ms = 0u;
   g_context.measure_start_tick_ms = 0u;
@@ -750,6 +883,9 @@ void blower_test_service_init(void) {
     return;
   }
 
+  blower_report_log_init();
+  blower_sample_capture_init();
+  blower_flow_correction_reset(&g_context.flow_correction);
   g_context.persistence_available = blower_test_storage_layout_is_valid();
   blower_test_load_from_storage_or_defaults_locked();
   blower_test_reset_runtime_locked();
@@ -773,7 +909,6 @@ void blower_test_service_get_config(blower_test_config_t *out_config) {
 
 bool blower_test_service_set_config(const blower_test_config_t *config) {
   blower_test_config_t normalized = {0};
-  bool persisted_ok = true;
 
   if (config == NULL || g_context.mutex == NULL) {
     return false;
@@ -793,13 +928,11 @@ bool blower_test_service_set_config(const blower_test_config_t *config) {
     return false;
   }
 
-  g_context.config = normalized;
-  if (g_context.persistence_available) {
-    persisted_ok = blower_test_persist_locked();
-  }
+  blower_test_apply_config_locked(&normalized);
+  g_context.persist_pending = g_context.persistence_available;
 
   xSemaphoreGive(g_context.mutex);
-  return persisted_ok;
+  return true;
 }
 
 void blower_test_service_reset_config_to_defaults(void) {
@@ -816,10 +949,8 @@ void blower_test_service_reset_config_to_defaults(void) {
   }
 
   if (!g_context.runtime.active) {
-    g_context.config = defaults;
-    if (g_context.persistence_available) {
-      (void)blower_test_persist_locked();
-    }
+    blower_test_apply_config_locked(&defaults);
+    g_context.persist_pending = g_context.persistence_available;
   }
 
   xSemaphoreGive(g_context.mutex);
@@ -845,6 +976,7 @@ static void blower_test_setup_mode_sequence_locked(blower_test_mode_t mode) {
 }
 
 bool blower_test_service_start(blower_test_mode_t mode) {
+  blower_test_control_action_t action = {0};
   bool can_start = false;
 
   if (g_context.mutex == NULL) {
@@ -861,7 +993,11 @@ bool blower_test_service_start(blower_test_mode_t mode) {
     return false;
   }
 
-  if (g_context.runtime.active || g_context.config.pressure_points_count == 0u ||
+  /* latest_report is the only copy until the log has queued it. */
+  if (g_context.runtime.active ||
+      atomic_load_explicit(&g_context.report_append_pending,
+                           memory_order_acquire) ||
+      g_context.config.pressure_points_count == 0u ||
       (g_context.config.enforce_iso_9972_rules &&
        g_context.config.pressure_points_count <
            g_context.config.min_points_required)) {
@@ -886,6 +1022,9 @@ bool blower_test_service_start(blower_test_mode_t mode) {
   g_context.runtime.current_measured_pressure_pa = 0.0f;
   g_context.runtime.current_measured_flow_m3h = 0.0f;
   g_context.runtime.active_sample_count = 0u;
+  g_context.runtime.dropped_samples = 0u;
+  g_context.runtime.fan_range_index = g_context.config.fan_range_index;
+  g_context.runtime.suggested_fan_range = g_context.config.fan_range_index;
   g_context.runtime.report_ready = g_context.has_latest_report;
   g_context.runtime.latest_report_id =
       g_context.has_latest_report ? g_context.latest_report.report_id : 0u;
@@ -896,20 +1035,35 @@ bool blower_test_service_start(blower_test_mode_t mode) {
 
   g_context.stable_since_tick_ms = 0u;
   g_context.measure_start_tick_ms = 0u;
-  g_context.acc_samples = 0u;
-  blower_test_set_state_locked(BLOWER_TEST_STATE_PREPARING, 0u);
-
-  blower_control_set_mode(BLOWER_CONTROL_MODE_AUTO_TEST);
-  blower_control_set_relay_enabled(true);
+  g_context.baseline_since_tick_ms = 0u;
+  g_context.ring_change_resume = false;
+  blower_test_reset_point_stats_locked();
+
+  g_context.control_engaged = false;
+  g_context.engage_wait_since_tick_ms = 0u;
+  if (g_context.config.baseline_time_s > 0u) {
+    /* The pre-test baseline is taken with the fan off. */
+    blower_test_set_state_locked(BLOWER_TEST_STATE_BASELINE_PRE, 0u);
+    blower_test_abort_control_locked();
+  } else {
+    blower_test_set_state_locked(BLOWER_TEST_STATE_PREPARING, 0u);
+    g_context.pending_action = (blower_test_control_action_t){
+        .kind = BLOWER_TEST_CONTROL_ACTION_ENGAGE,
+        .target_pressure_pa = g_context.runtime.current_target_pressure_pa,
+    };
+  }
+  action = blower_test_take_action_locked();
 
   can_start = true;
   xSemaphoreGive(g_context.mutex);
+  blower_test_apply_control_action(&action);
   return can_start;
 }
 
 void blower_test_service_stop(void) {
   const uint32_t now_tick_ms =
       (uint32_t)xTaskGetTickCount() * (uint32_t)portTICK_PERIOD_MS;
+  blower_test_control_action_t action = {0};
 
   if (g_context.mutex == NULL) {
     return;
@@ -924,8 +1078,37 @@ void blower_test_service_stop(void) {
     blower_test_set_state_locked(BLOWER_TEST_STATE_ABORTED, now_tick_ms);
     blower_test_abort_control_locked();
   }
+  action = blower_test_take_action_locked();
 
   xSemaphoreGive(g_context.mutex);
+  blower_test_apply_control_action(&action);
+}
+
+bool blower_test_service_select_fan_range(uint8_t range_index) {
+  bool accepted = false;
+
+  if (g_context.mutex == NULL) {
+    return false;
+  }
+
+  if (xSemaphoreTake(g_context.mutex, portMAX_DELAY) != pdTRUE) {
+    return false;
+  }
+
+  if (range_index < g_context.config.fan_range_count &&
+      (!g_context.runtime.active ||
+       g_context.runtime.state == BLOWER_TEST_STATE_RING_CHANGE)) {
+    g_context.config.fan_range_index = range_index;
+    blower_test_publish_flow_settings_locked();
+    g_context.runtime.fan_range_index = range_index;
+    g_context.runtime.suggested_fan_range = range_index;
+    g_context.persist_pending = g_context.persistence_available;
+    g_context.ring_change_resume = g_context.runtime.active;
+    accepted = true;
+  }
+
+  xSemaphoreGive(g_context.mutex);
+  return accepted;
 }
 
 static void blower_test_finalize_direction_locked(
@@ -934,9 +1117,9 @@ static void blower_test_finalize_direction_locked(
     return;
   }
 
-  (void)blower_test_compute_summary_from_direction(&g_context.config,
-                                                   direction_report,
-                                                   &direction_report->summary);
+  (void)blower_test_compute_summary_from_direction(
+      &g_context.config, direction_report, &g_context.fit_workspace,
+      &direction_report->summary);
 
   if (direction_report->direction == BLOWER_TEST_DIRECTION_PRESSURIZATION) {
     g_context.active_report.has_pressurization = direction_report->summary.valid;
@@ -946,6 +1129,88 @@ static void blower_test_finalize_direction_locked(
   }
 }
 
+/*
+ * ISO 9972: the zero-flow pressure is the mean of the pre- and post-test
+ * baselines and is subtracted from each signed point pressure; its standard
+ * error adds to the point's in quadrature. A baseline beyond
+ * max_baseline_pa marks the test as not compliant.
+ */
+static void blower_test_apply_baseline_locked(void) {
+  blower_test_baseline_t *baseline = &g_context.active_report.baseline;
+  blower_test_direction_report_t *const directions[] = {
+      &g_context.active_report.pressurization,
+      &g_context.active_report.depressurization,
+  };
+  size_t direction_index = 0u;
+
+  baseline->bias_pa = 0.5f * (baseline->pre_pa + baseline->post_pa);
+  baseline->bias_std_error_pa =
+      0.5f * sqrtf(baseline->pre_std_error_pa * baseline->pre_std_error_pa +
+                   baseline->post_std_error_pa * baseline->post_std_error_pa);
+  baseline->stable =
+      fabsf(baseline->pre_pa) <= g_context.config.max_baseline_pa &&
+      fabsf(baseline->post_pa) <= g_context.config.max_baseline_pa;
+  baseline->valid = true;
+
+  for (direction_index = 0u;
+       direction_index < sizeof(directions) / sizeof(directions[0]);
+       ++direction_index) {
+    blower_test_direction_report_t *direction_report =
+        directions[direction_index];
+    uint8_t index = 0u;
+
+    if (direction_report->point_count == 0u) {
+      continue;
+    }
+
+    for (index = 0u; index < direction_report->point_count; ++index) {
+      blower_test_point_result_t *point = &direction_report->points[index];
+      float shift = 0.0f;
+
+      if (!point->valid) {
+        continue;
+      }
+      shift = (float)point->pressure_sign * baseline->bias_pa;
+      point->avg_pressure_pa = point->raw_avg_pressure_pa - shift;
+      point->pressure_min_pa -= shift;
+      point->pressure_max_pa -= shift;
+      point->pressure_std_error_pa =
+          sqrtf(point->pressure_std_error_pa * point->pressure_std_error_pa +
+                baseline->bias_std_error_pa * baseline->bias_std_error_pa);
+    }
+
+    blower_test_finalize_direction_locked(direction_report);
+  }
+}
+
+static void blower_test_complete_locked(uint32_t now_tick_ms) {
+  if (g_context.config.baseline_time_s > 0u) {
+    blower_test_apply_baseline_locked();
+  }
+  blower_test_compute_mean_summary_locked();
+  if (g_context.active_report.baseline.valid &&
+      !g_context.active_report.baseline.stable &&
+      g_context.config.enforce_iso_9972_rules) {
+    g_context.active_report.mean_summary.valid = false;
+  }
+  g_context.active_report.completed_tick_ms = now_tick_ms;
+  g_context.latest_report = g_context.active_report;
+  g_context.has_latest_report = true;
+  atomic_store_explicit(&g_context.report_append_pending,
+                        blower_report_log_is_available(),
+                        memory_order_release);
+
+  g_context.runtime.active = false;
+  g_context.runtime.report_ready = true;
+  g_context.runtime.latest_report_id = g_context.latest_report.report_id;
+  g_context.runtime.latest_ach_ref_h1 =
+      g_context.latest_report.mean_summary.valid
+          ? g_context.latest_report.mean_summary.ach_ref_h1
+          : 0.0f;
+  blower_test_set_state_locked(BLOWER_TEST_STATE_COMPLETED, now_tick_ms);
+  blower_test_abort_control_locked();
+}
+
 static void blower_test_advance_to_next_target_locked(uint32_t now_tick_ms) {
   blower_test_direction_report_t *direction_report =
       blower_test_active_direction_report_locked();
@@ -979,122 +1244,373 @@ static void blower_test_advance_to_next_target_locked(uint32_t now_tick_ms) {
         g_context.config.pressure_points_pa[0];
     g_context.stable_since_tick_ms = 0u;
     g_context.measure_start_tick_ms = 0u;
-    g_context.acc_samples = 0u;
+    blower_test_reset_point_stats_locked();
     blower_test_set_state_locked(BLOWER_TEST_STATE_PREPARING, now_tick_ms);
     return;
   }
 
-  blower_test_compute_mean_summary_locked();
-  g_context.active_report.completed_tick_ms = now_tick_ms;
-  g_context.latest_report = g_context.active_report;
-  g_context.has_latest_report = true;
-  blower_test_history_push_locked(&g_context.latest_report);
-  if (g_context.persistence_available) {
-    (void)blower_test_persist_locked();
+  if (g_context.config.baseline_time_s > 0u) {
+    /* The post-test baseline is taken with the fan off again. */
+    g_context.baseline_since_tick_ms = 0u;
+    blower_test_set_state_locked(BLOWER_TEST_STATE_BASELINE_POST, now_tick_ms);
+    blower_test_abort_control_locked();
+    return;
   }
 
-  g_context.runtime.active = false;
-  g_context.runtime.report_ready = true;
-  g_context.runtime.latest_report_id = g_context.latest_report.report_id;
-  g_context.runtime.latest_ach_ref_h1 =
-      g_context.latest_report.mean_summary.valid
-          ? g_context.latest_report.mean_summary.ach_ref_h1
-          : 0.0f;
-  blower_test_set_state_locked(BLOWER_TEST_STATE_COMPLETED, now_tick_ms);
+  blower_test_complete_locked(now_tick_ms);
+}
+
+/*
+ * Zero-flow phase: waits for the relay to be off and the fan to spin down,
+ * then accumulates the signed envelope pressure for baseline_time_s with the
+ * same running and 1 s block statistics a point uses. Returns true with the
+ * result once the phase is complete.
+ */
+static bool blower_test_baseline_step_locked(
+    const blower_metrics_snapshot_t *metrics_snapshot,
+    const blower_control_snapshot_t *control_snapshot, uint32_t now_tick_ms,
+    float *out_mean_pa, float *out_std_error_pa, uint16_t *out_sample_count) {
+  const float pressure_pa = metrics_snapshot->envelope_pressure_pa;
+  uint32_t sampled_ms = 0u;
+
+  if (control_snapshot->relay_enabled) {
+    g_context.baseline_since_tick_ms = 0u;
+    return false;
+  }
+  if (g_context.baseline_since_tick_ms == 0u) {
+    g_context.baseline_since_tick_ms = now_tick_ms;
+    blower_test_reset_point_stats_locked();
+    g_context.runtime.active_sample_count = 0u;
+  }
+
+  sampled_ms = now_tick_ms - g_context.baseline_since_tick_ms;
+  if (sampled_ms < BLOWER_TEST_BASELINE_SETTLE_MS ||
+      !metrics_snapshot->envelope_sample_valid) {
+    return false;
+  }
+  sampled_ms -= BLOWER_TEST_BASELINE_SETTLE_MS;
+
+  blower_running_stats_push(&g_context.stats_pressure_pa, pressure_pa);
+  if (blower_test_block_push_locked(pressure_pa, NULL, now_tick_ms)) {
+    blower_running_stats_push(&g_context.block_means_pressure_pa,
+                              g_context.block_pressure_pa.mean);
+    blower_running_stats_reset(&g_context.block_pressure_pa);
+    g_context.runtime.current_ci95_pa =
+        blower_test_ci95_half_width(&g_context.block_means_pressure_pa);
+  }
+  g_context.runtime.active_sample_count =
+      blower_test_sample_count_u16(g_context.stats_pressure_pa.count);
+
+  if (sampled_ms < (uint32_t)g_context.config.baseline_time_s * 1000u ||
+      g_context.stats_pressure_pa.count < BLOWER_TEST_MIN_BASELINE_SAMPLES) {
+    return false;
+  }
+
+  *out_mean_pa = g_context.stats_pressure_pa.mean;
+  *out_std_error_pa =
+      g_context.block_means_pressure_pa.count >= BLOWER_TEST_MIN_CI_BLOCKS
+          ? blower_running_stats_std_error(&g_context.block_means_pressure_pa)
+          : blower_running_stats_std_error(&g_context.stats_pressure_pa);
+  *out_sample_count =
+      blower_test_sample_count_u16(g_context.stats_pressure_pa.count);
+  g_context.baseline_since_tick_ms = 0u;
+  return true;
+}
+
+/*
+ * Watches the fan pressure against the mounted range while a point is
+ * settling or measuring. Once it has been outside long enough and another
+ * range covers the current flow, the fan is released and the test waits in
+ * RING_CHANGE. Returns true when it did so.
+ */
+static bool blower_test_ring_change_step_locked(bool fan_valid,
+                                                bool fan_in_range,
+                                                float fan_pressure_pa,
+                                                bool envelope_on_target,
+                                                float fan_flow_m3h,
+                                                uint32_t now_tick_ms) {
+  const blower_test_config_t *config = &g_context.config;
+  const bool above_range =
+      fabsf(fan_pressure_pa) >
+      config->fan_ranges[config->fan_range_index].max_pressure_pa;
+  uint8_t suggested = 0u;
+
+  if (config->fan_range_count < 2u || !fan_valid || fan_in_range ||
+      (!above_range && !envelope_on_target)) {
+    g_context.fan_out_of_range_since_tick_ms = 0u;
+    return false;
+  }
+
+  if (g_context.fan_out_of_range_since_tick_ms == 0u) {
+    g_context.fan_out_of_range_since_tick_ms = now_tick_ms;
+    return false;
+  }
+  if (now_tick_ms - g_context.fan_out_of_range_since_tick_ms <
+      BLOWER_TEST_RING_CHANGE_DELAY_MS) {
+    return false;
+  }
+
+  /* Registry flows are at standard density. */
+  suggested = blower_fan_calibration_suggest_range(
+      config->fan_ranges, config->fan_range_count, config->fan_range_index,
+      fan_flow_m3h / g_context.flow_correction.density_factor);
+  if (suggested == config->fan_range_index) {
+    /* No better ring; carry on and check again after another delay. */
+    g_context.fan_out_of_range_since_tick_ms = now_tick_ms;
+    return false;
+  }
+
+  g_context.runtime.suggested_fan_range = suggested;
+  blower_test_set_state_locked(BLOWER_TEST_STATE_RING_CHANGE, now_tick_ms);
   blower_test_abort_control_locked();
+  return true;
 }
 
-void blower_test_service_update(const blower_metrics_snapshot_t *metrics_snapshot,
-                                const blower_control_snapshot_t *control_snapshot,
-                                uint32_t now_tick_ms) {
+static void blower_test_update_locked(
+    const blower_metrics_snapshot_t *metrics_snapshot,
+    const blower_control_snapshot_t *control_snapshot, uint32_t now_tick_ms) {
   float envelope_pressure_pa = 0.0f;
   float fan_flow_m3h = 0.0f;
   bool envelope_valid = false;
   bool fan_valid = false;
+  bool fan_in_range = false;
   float pwm_percent = 0.0f;
 
-  if (g_context.mutex == NULL || metrics_snapshot == NULL ||
-      control_snapshot == NULL) {
-    return;
-  }
-
-  if (xSemaphoreTake(g_context.mutex, portMAX_DELAY) != pdTRUE) {
+  if (!g_context.runtime.active) {
     return;
   }
 
-  if (!g_context.runtime.active) {
-    xSemaphoreGive(g_context.mutex);
-    return;
+  /*
+   * The engage request lands on the next control step. Once it has, any
+   * change of mode or relay from elsewhere (web UI, manual override) ends
+   * the test instead of measuring against a loop the test no longer owns.
+   */
+  {
+    const bool engaged =
+        control_snapshot->mode == BLOWER_CONTROL_MODE_AUTO_TEST &&
+        control_snapshot->relay_enabled;
+    if (engaged) {
+      g_context.control_engaged = true;
+    } else if (g_context.control_engaged) {
+      g_context.runtime.active = false;
+      blower_test_set_state_locked(BLOWER_TEST_STATE_ABORTED, now_tick_ms);
+      blower_test_abort_control_locked();
+      return;
+    }
   }
 
   envelope_valid = metrics_snapshot->envelope_sample_valid;
   fan_valid = metrics_snapshot->fan_sample_valid;
   envelope_pressure_pa = blower_test_absf(metrics_snapshot->envelope_pressure_pa);
-  fan_flow_m3h = blower_test_compute_fan_flow_m3h(
-      &g_context.config, metrics_snapshot->fan_pressure_pa,
-      metrics_snapshot->envelope_temperature_c);
+  blower_flow_correction_refresh(&g_context.flow_correction,
+                                 metrics_snapshot->fan_temperature_c);
+  fan_flow_m3h = blower_flow_correction_flow_m3h(
+      &g_context.flow_correction, metrics_snapshot->fan_pressure_pa,
+      &fan_in_range);
+  fan_in_range = fan_in_range && fan_valid;
   pwm_percent = (float)control_snapshot->output_pwm_percent;
 
   g_context.runtime.current_measured_pressure_pa = envelope_pressure_pa;
   g_context.runtime.current_measured_flow_m3h = fan_flow_m3h;
+  g_context.runtime.fan_range_index = g_context.config.fan_range_index;
+  g_context.runtime.fan_in_range = fan_in_range;
   g_context.runtime.state_elapsed_ms = now_tick_ms - g_context.state_enter_tick_ms;
 
+  if (g_context.runtime.state == BLOWER_TEST_STATE_BASELINE_PRE) {
+    blower_test_baseline_t *baseline = &g_context.active_report.baseline;
+
+    if (blower_test_baseline_step_locked(
+            metrics_snapshot, control_snapshot, now_tick_ms,
+            &baseline->pre_pa, &baseline->pre_std_error_pa,
+            &baseline->pre_sample_count)) {
+      blower_test_reset_point_stats_locked();
+      g_context.pending_action = (blower_test_control_action_t){
+          .kind = BLOWER_TEST_CONTROL_ACTION_ENGAGE,
+          .target_pressure_pa = g_context.runtime.current_target_pressure_pa,
+      };
+      blower_test_set_state_locked(BLOWER_TEST_STATE_PREPARING, now_tick_ms);
+    }
+    return;
+  }
+
+  if (g_context.runtime.state == BLOWER_TEST_STATE_BASELINE_POST) {
+    blower_test_baseline_t *baseline = &g_context.active_report.baseline;
+
+    if (blower_test_baseline_step_locked(
+            metrics_snapshot, control_snapshot, now_tick_ms,
+            &baseline->post_pa, &baseline->post_std_error_pa,
+            &baseline->post_sample_count)) {
+      blower_test_complete_locked(now_tick_ms);
+    }
+    return;
+  }
+
+  if (g_context.runtime.state == BLOWER_TEST_STATE_RING_CHANGE) {
+    /* The point starts over on the new ring once one is selected. */
+    if (g_context.ring_change_resume) {
+      g_context.ring_change_resume = false;
+      blower_test_reset_point_stats_locked();
+      g_context.pending_action = (blower_test_control_action_t){
+          .kind = BLOWER_TEST_CONTROL_ACTION_ENGAGE,
+          .target_pressure_pa = g_context.runtime.current_target_pressure_pa,
+      };
+      blower_test_set_state_locked(BLOWER_TEST_STATE_PREPARING, now_tick_ms);
+    }
+    return;
+  }
+
+  if (g_context.runtime.state == BLOWER_TEST_STATE_PREPARING &&
+      !g_context.control_engaged) {
+    if (g_context.engage_wait_since_tick_ms == 0u) {
+      g_context.engage_wait_since_tick_ms = now_tick_ms;
+    }
+    if ((now_tick_ms - g_context.engage_wait_since_tick_ms) >=
+        BLOWER_TEST_ENGAGE_TIMEOUT_MS) {
+      g_context.runtime.active = false;
+      blower_test_set_state_locked(BLOWER_TEST_STATE_ERROR, now_tick_ms);
+      blower_test_abort_control_locked();
+    }
+    return;
+  }
+
   if (g_context.runtime.state == BLOWER_TEST_STATE_PREPARING) {
     const float target =
         g_context.config
             .pressure_points_pa[g_context.runtime.current_point_index];
-    blower_control_set_target_pressure_pa(target);
+    g_context.engage_wait_since_tick_ms = 0u;
+    g_context.pending_action = (blower_test_control_action_t){
+        .kind = BLOWER_TEST_CONTROL_ACTION_SET_TARGET,
+        .target_pressure_pa = target,
+    };
     g_context.runtime.current_target_pressure_pa = target;
     g_context.stable_since_tick_ms = 0u;
+    g_context.point_start_tick_ms = now_tick_ms;
+    blower_test_reset_blocks_locked();
     blower_test_set_state_locked(BLOWER_TEST_STATE_STABILIZING, now_tick_ms);
-    xSemaphoreGive(g_context.mutex);
     return;
   }
 
   if (g_context.runtime.state == BLOWER_TEST_STATE_STABILIZING) {
+    const float target = g_context.runtime.current_target_pressure_pa;
+    const float tolerance = g_context.config.target_tolerance_pa;
+
+    if (blower_test_ring_change_step_locked(
+            fan_valid, fan_in_range, metrics_snapshot->fan_pressure_pa,
+            envelope_valid &&
+                fabsf(envelope_pressure_pa - target) <= tolerance,
+            fan_flow_m3h, now_tick_ms)) {
+      return;
+    }
+
     if (!envelope_valid) {
       g_context.stable_since_tick_ms = 0u;
-      xSemaphoreGive(g_context.mutex);
+      blower_test_reset_blocks_locked();
       return;
     }
 
-    if (fabsf(envelope_pressure_pa - g_context.runtime.current_target_pressure_pa) <=
-        g_context.config.target_tolerance_pa) {
+    /*
+     * Adaptive settle: a closed block whose mean is on target, whose noise
+     * fits the tolerance band and that moved less than max_drift_pa_s from
+     * the previous block.
+     */
+    if (blower_test_block_push_locked(envelope_pressure_pa, NULL,
+                                      now_tick_ms)) {
+      const float block_mean = g_context.block_pressure_pa.mean;
+      const float block_stddev =
+          blower_running_stats_stddev(&g_context.block_pressure_pa);
+      const bool drift_ok =
+          g_context.has_last_block_mean &&
+          fabsf(block_mean - g_context.last_block_mean_pa) *
+                  (1000.0f / (float)BLOWER_TEST_BLOCK_MS) <=
+              g_context.config.max_drift_pa_s;
+      g_context.settle_block_ok = drift_ok &&
+                                  fabsf(block_mean - target) <= tolerance &&
+                                  block_stddev <= tolerance;
+      g_context.last_block_mean_pa = block_mean;
+      g_context.has_last_block_mean = true;
+      blower_running_stats_reset(&g_context.block_pressure_pa);
+    }
+
+    if (fabsf(envelope_pressure_pa - target) <= tolerance) {
+      uint32_t stable_ms = 0u;
+
       if (g_context.stable_since_tick_ms == 0u) {
         g_context.stable_since_tick_ms = now_tick_ms;
       }
+      stable_ms = now_tick_ms - g_context.stable_since_tick_ms;
 
-      if ((now_tick_ms - g_context.stable_since_tick_ms) >=
-          ((uint32_t)g_context.config.settle_time_s * 1000u)) {
+      if (stable_ms >= ((uint32_t)g_context.config.settle_time_s * 1000u) ||
+          (g_context.config.adaptive_windows && g_context.settle_block_ok &&
+           stable_ms >=
+               ((uint32_t)g_context.config.min_settle_time_s * 1000u))) {
         blower_test_prepare_measurement_locked(now_tick_ms);
       }
     } else {
       g_context.stable_since_tick_ms = 0u;
+      g_context.settle_block_ok = false;
     }
 
-    xSemaphoreGive(g_context.mutex);
     return;
   }
 
   if (g_context.runtime.state != BLOWER_TEST_STATE_MEASURING) {
-    xSemaphoreGive(g_context.mutex);
+    return;
+  }
+
+  if (blower_test_ring_change_step_locked(
+          fan_valid, fan_in_range, metrics_snapshot->fan_pressure_pa, true,
+          fan_flow_m3h, now_tick_ms)) {
     return;
   }
 
   if (envelope_valid && fan_valid) {
-    g_context.acc_pressure_pa += envelope_pressure_pa;
-    g_context.acc_fan_flow_m3h += fan_flow_m3h;
-    g_context.acc_fan_temp_c += metrics_snapshot->fan_temperature_c;
-    g_context.acc_envelope_temp_c += metrics_snapshot->envelope_temperature_c;
-    g_context.acc_pwm_percent += pwm_percent;
-    g_context.acc_samples += 1u;
-    g_context.runtime.active_sample_count = g_context.acc_samples;
+    if (!fan_in_range) {
+      g_context.fan_out_of_range_samples += 1u;
+    }
+    blower_running_stats_push(&g_context.stats_pressure_pa,
+                              envelope_pressure_pa);
+    blower_running_stats_push(&g_context.stats_fan_flow_m3h, fan_flow_m3h);
+    blower_running_stats_push(&g_context.stats_fan_temp_c,
+                              metrics_snapshot->fan_temperature_c);
+    blower_running_stats_push(&g_context.stats_envelope_temp_c,
+                              metrics_snapshot->envelope_temperature_c);
+    blower_running_stats_push(&g_context.stats_pwm_percent, pwm_percent);
+    /* Signed, uncorrected readings so the capture can be refitted later. */
+    blower_sample_capture_push(now_tick_ms,
+                               metrics_snapshot->envelope_pressure_pa,
+                               metrics_snapshot->fan_pressure_pa,
+                               metrics_snapshot->fan_temperature_c,
+                               metrics_snapshot->envelope_temperature_c,
+                               pwm_percent);
+    g_context.runtime.active_sample_count =
+        blower_test_sample_count_u16(g_context.stats_pressure_pa.count);
+
+    if (blower_test_block_push_locked(envelope_pressure_pa, &fan_flow_m3h,
+                                      now_tick_ms)) {
+      blower_running_stats_push(&g_context.block_means_pressure_pa,
+                                g_context.block_pressure_pa.mean);
+      blower_running_stats_push(&g_context.block_means_fan_flow_m3h,
+                                g_context.block_fan_flow_m3h.mean);
+      blower_running_stats_reset(&g_context.block_pressure_pa);
+      blower_running_stats_reset(&g_context.block_fan_flow_m3h);
+      g_context.runtime.current_ci95_pa =
+          blower_test_ci95_half_width(&g_context.block_means_pressure_pa);
+    }
   }
 
-  if ((now_tick_ms - g_context.measure_start_tick_ms) <
-      ((uint32_t)g_context.config.measure_time_s * 1000u)) {
-    xSemaphoreGive(g_context.mutex);
-    return;
+  {
+    const uint32_t measured_ms = now_tick_ms - g_context.measure_start_tick_ms;
+    const bool converged =
+        g_context.config.adaptive_windows &&
+        measured_ms >=
+            ((uint32_t)g_context.config.min_measure_time_s * 1000u) &&
+        g_context.block_means_pressure_pa.count >= BLOWER_TEST_MIN_CI_BLOCKS &&
+        g_context.runtime.current_ci95_pa <= g_context.config.target_ci_pa;
+
+    if (!converged &&
+        measured_ms < ((uint32_t)g_context.config.measure_time_s * 1000u)) {
+      return;
+    }
   }
 
   {
@@ -1107,7 +1623,6 @@ void blower_test_service_update(const blower_metrics_snapshot_t *metrics_snapsho
       g_context.runtime.active = false;
       blower_test_set_state_locked(BLOWER_TEST_STATE_ERROR, now_tick_ms);
       blower_test_abort_control_locked();
-      xSemaphoreGive(g_context.mutex);
       return;
     }
 
@@ -1121,20 +1636,58 @@ void blower_test_service_update(const blower_metrics_snapshot_t *metrics_snapsho
 
     point = &direction_report->points[g_context.runtime.current_point_index];
     point->target_pressure_pa = g_context.runtime.current_target_pressure_pa;
-    point->sample_count = g_context.acc_samples;
-    point->valid = g_context.acc_samples > 0u;
+    point->settle_duration_ms =
+        g_context.measure_start_tick_ms - g_context.point_start_tick_ms;
+    point->measure_duration_ms = now_tick_ms - g_context.measure_start_tick_ms;
+    point->sample_count =
+        blower_test_sample_count_u16(g_context.stats_pressure_pa.count);
+    point->valid = g_context.stats_pressure_pa.count > 0u;
+    point->fan_range_index = g_context.config.fan_range_index;
+    point->fan_in_range =
+        (float)g_context.fan_out_of_range_samples <=
+        BLOWER_TEST_MAX_FAN_OUT_OF_RANGE_FRACTION *
+            (float)g_context.stats_pressure_pa.count;
+    point->pressure_sign =
+        metrics_snapshot->envelope_pressure_pa < 0.0f ? -1 : 1;
 
     if (point->valid) {
-      const float sample_count_f = (float)g_context.acc_samples;
-      point->avg_pressure_pa = g_context.acc_pressure_pa / sample_count_f;
-      point->avg_fan_flow_m3h = g_context.acc_fan_flow_m3h / sample_count_f;
-      point->avg_fan_temperature_c = g_context.acc_fan_temp_c / sample_count_f;
-      point->avg_envelope_temperature_c =
-          g_context.acc_envelope_temp_c / sample_count_f;
-      point->avg_pwm_percent = g_context.acc_pwm_percent / sample_count_f;
+      const blower_running_stats_t *pressure = &g_context.stats_pressure_pa;
+      const blower_running_stats_t *flow = &g_context.stats_fan_flow_m3h;
+
+      const blower_running_stats_t *pressure_means =
+          &g_context.block_means_pressure_pa;
+      const blower_running_stats_t *flow_means =
+          &g_context.block_means_fan_flow_m3h;
+
+      point->avg_pressure_pa = pressure->mean;
+      point->raw_avg_pressure_pa = pressure->mean;
+      point->pressure_stddev_pa = blower_running_stats_stddev(pressure);
+      point->pressure_min_pa = pressure->min_value;
+      point->pressure_max_pa = pressure->max_value;
+      point->avg_fan_flow_m3h = flow->mean;
+      point->flow_stddev_m3h = blower_running_stats_stddev(flow);
+      /* Batch-means standard error once there are enough blocks. */
+      point->pressure_std_error_pa =
+          pressure_means->count >= BLOWER_TEST_MIN_CI_BLOCKS
+              ? blower_running_stats_std_error(pressure_means)
+              : blower_running_stats_std_error(pressure);
+      point->flow_std_error_m3h =
+          flow_means->count >= BLOWER_TEST_MIN_CI_BLOCKS
+              ? blower_running_stats_std_error(flow_means)
+              : blower_running_stats_std_error(flow);
+      point->avg_fan_temperature_c = g_context.stats_fan_temp_c.mean;
+      point->avg_envelope_temperature_c = g_context.stats_envelope_temp_c.mean;
+      point->avg_pwm_percent = g_context.stats_pwm_percent.mean;
     } else {
       point->avg_pressure_pa = 0.0f;
+      point->raw_avg_pressure_pa = 0.0f;
+      point->pressure_stddev_pa = 0.0f;
+      point->pressure_std_error_pa = 0.0f;
+      point->pressure_min_pa = 0.0f;
+      point->pressure_max_pa = 0.0f;
       point->avg_fan_flow_m3h = 0.0f;
+      point->flow_stddev_m3h = 0.0f;
+      point->flow_std_error_m3h = 0.0f;
       point->avg_fan_temperature_c = 0.0f;
       point->avg_envelope_temperature_c = 0.0f;
       point->avg_pwm_percent = 0.0f;
@@ -1142,7 +1695,82 @@ void blower_test_service_update(const blower_metrics_snapshot_t *metrics_snapsho
   }
 
   blower_test_advance_to_next_target_locked(now_tick_ms);
+}
+
+bool blower_test_service_update(
+    const blower_metrics_snapshot_t *metrics_snapshot,
+    const blower_control_snapshot_t *control_snapshot, uint32_t now_tick_ms) {
+  blower_test_control_action_t action = {0};
+
+  if (g_context.mutex == NULL || metrics_snapshot == NULL ||
+      control_snapshot == NULL) {
+    return false;
+  }
+
+  /*
+   * Never wait on a reader from the control loop. The caller offers the
+   * sample again; it only counts as lost once a newer one replaces it.
+   */
+  if (g_context.has_busy_sequence &&
+      g_context.busy_sequence != metrics_snapshot->update_sequence) {
+    g_context.lost_busy_samples += 1u;
+  }
+  g_context.busy_sequence = metrics_snapshot->update_sequence;
+  g_context.has_busy_sequence = true;
+  if (xSemaphoreTake(g_context.mutex, 0) != pdTRUE) {
+    return false;
+  }
+  g_context.has_busy_sequence = false;
+  if (g_context.runtime.active) {
+    g_context.runtime.dropped_samples += g_context.lost_busy_samples;
+  }
+  g_context.lost_busy_samples = 0u;
+
+  blower_test_update_locked(metrics_snapshot, control_snapshot, now_tick_ms);
+  action = blower_test_take_action_locked();
+
   xSemaphoreGive(g_context.mutex);
+  blower_test_apply_control_action(&action);
+
+  /*
+   * latest_report only changes in this task, so it can be handed to the
+   * log without the test mutex. A busy or full log is retried next sample;
+   * until then a new test is refused, so the report cannot be replaced.
+   */
+  if (atomic_load_explicit(&g_context.report_append_pending,
+                           memory_order_acquire) &&
+      blower_report_log_append(&g_context.latest_report)) {
+    atomic_store_explicit(&g_context.report_append_pending, false,
+                          memory_order_release);
+  }
+  return true;
+}
+
+void blower_test_service_persist_pending(bool fan_running) {
+  bool should_persist = false;
+
+  if (g_context.mutex == NULL || fan_running) {
+    return;
+  }
+
+  if (xSemaphoreTake(g_context.mutex, 0) != pdTRUE) {
+    return;
+  }
+
+  should_persist = g_context.persist_pending && !g_context.runtime.active;
+  if (should_persist) {
+    blower_test_build_blob_locked(&g_persist_blob);
+    g_context.persist_pending = false;
+  }
+
+  xSemaphoreGive(g_context.mutex);
+
+  /* One flash operation per call keeps each interrupt-off window short. */
+  if (should_persist) {
+    (void)blower_test_storage_program(&g_persist_blob);
+  } else if (!blower_report_log_persist_step()) {
+    (void)blower_sample_capture_persist_step();
+  }
 }
 
 void blower_test_service_get_runtime(blower_test_runtime_status_t *out_runtime) {
@@ -1225,12 +1853,18 @@ const char *blower_test_state_name(blower_test_state_t state) {
   switch (state) {
   case BLOWER_TEST_STATE_IDLE:
     return "idle";
+  case BLOWER_TEST_STATE_BASELINE_PRE:
+    return "baseline_pre";
   case BLOWER_TEST_STATE_PREPARING:
     return "preparing";
   case BLOWER_TEST_STATE_STABILIZING:
     return "stabilizing";
   case BLOWER_TEST_STATE_MEASURING:
     return "measuring";
+  case BLOWER_TEST_STATE_RING_CHANGE:
+    return "ring_change";
+  case BLOWER_TEST_STATE_BASELINE_POST:
+    return "baseline_post";
   case BLOWER_TEST_STATE_COMPLETED:
     return "completed";
   case BLOWER_TEST_STATE_ABORTED:
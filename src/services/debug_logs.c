@@ -1,34 +1,107 @@
 #include "services/debug_logs.h"
 
 #include "app/app_config.h"
-#include "hardware/sync.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdatomic.h>
 #include <string.h>
 
 #if APP_ENABLE_DEBUG_HTTP_ROUTES
-static volatile bool g_debug_logs_enabled = false;
-static volatile uint32_t g_debug_logs_generation = 0u;
+_Static_assert((DEBUG_LOG_BUFFER_SIZE & (DEBUG_LOG_BUFFER_SIZE - 1u)) == 0u,
+               "DEBUG_LOG_BUFFER_SIZE must be a power of two");
+
+/*
+ * Circular byte ring. head counts every byte ever appended, so byte p
+ * sits at p % size and the ring holds [head - size, head); cleared_at
+ * hides older bytes after a clear. Appending suspends the scheduler
+ * instead of masking interrupts, which makes the caller the only writer
+ * on the core; readers copy without locking and drop whatever the
+ * writer overwrote meanwhile.
+ */
+static atomic_bool g_debug_logs_enabled = false;
+static atomic_uint g_debug_logs_generation = 0u;
+static atomic_uint g_debug_log_head = 0u;
+static atomic_uint g_debug_log_cleared_at = 0u;
 static char g_debug_log_buffer[DEBUG_LOG_BUFFER_SIZE];
-static size_t g_debug_log_length = 0u;
+
+static void debug_logs_ring_write(uint32_t position, const char *data,
+                                  size_t length) {
+  const size_t index = position & (DEBUG_LOG_BUFFER_SIZE - 1u);
+  const size_t first = DEBUG_LOG_BUFFER_SIZE - index < length
+                           ? DEBUG_LOG_BUFFER_SIZE - index
+                           : length;
+
+  memcpy(&g_debug_log_buffer[index], data, first);
+  memcpy(g_debug_log_buffer, data + first, length - first);
+}
+
+static void debug_logs_ring_read(uint32_t position, char *out,
+                                 size_t length) {
+  const size_t index = position & (DEBUG_LOG_BUFFER_SIZE - 1u);
+  const size_t first = DEBUG_LOG_BUFFER_SIZE - index < length
+                           ? DEBUG_LOG_BUFFER_SIZE - index
+                           : length;
+
+  memcpy(out, &g_debug_log_buffer[index], first);
+  memcpy(out + first, g_debug_log_buffer, length - first);
+}
+
+/* Copies the oldest (tail = false) or newest retained bytes, NUL-ended. */
+static void debug_logs_copy_range(char *out_buffer, size_t out_buffer_size,
+                                  bool tail) {
+  const size_t max_copy = out_buffer_size - 1u;
+  uint32_t head = atomic_load_explicit(&g_debug_log_head, memory_order_acquire);
+  uint32_t start = atomic_load_explicit(&g_debug_log_cleared_at,
+                                        memory_order_relaxed);
+  uint32_t valid_from = 0u;
+  size_t copy_length = 0u;
+
+  if (head - start > DEBUG_LOG_BUFFER_SIZE) {
+    start = head - DEBUG_LOG_BUFFER_SIZE;
+  }
+  copy_length = head - start;
+  if (copy_length > max_copy) {
+    if (tail) {
+      start = head - (uint32_t)max_copy;
+    }
+    copy_length = max_copy;
+  }
+  debug_logs_ring_read(start, out_buffer, copy_length);
+
+  /* Anything a writer wrapped over during the copy is stale: drop it. */
+  head = atomic_load_explicit(&g_debug_log_head, memory_order_acquire);
+  valid_from = head - DEBUG_LOG_BUFFER_SIZE;
+  if ((int32_t)(valid_from - start) > 0) {
+    const size_t stale = valid_from - start < copy_length
+                             ? valid_from - start
+                             : copy_length;
+    memmove(out_buffer, out_buffer + stale, copy_length - stale);
+    copy_length -= stale;
+  }
+  out_buffer[copy_length] = '\0';
+}
 #endif
 
 void debug_logs_clear(void) {
 #if APP_ENABLE_DEBUG_HTTP_ROUTES
-  const uint32_t irq_state = save_and_disable_interrupts();
-  g_debug_log_length = 0u;
-  g_debug_log_buffer[0] = '\0';
-  g_debug_logs_generation += 1u;
-  restore_interrupts(irq_state);
+  vTaskSuspendAll();
+  atomic_store_explicit(&g_debug_log_cleared_at,
+                        atomic_load_explicit(&g_debug_log_head,
+                                             memory_order_relaxed),
+                        memory_order_release);
+  atomic_fetch_add_explicit(&g_debug_logs_generation, 1u,
+                            memory_order_release);
+  (void)xTaskResumeAll();
 #endif
 }
 
 void debug_logs_append(const char *line) {
 #if APP_ENABLE_DEBUG_HTTP_ROUTES
   size_t line_length = 0u;
-  size_t overflow = 0u;
-  const uint32_t irq_state = save_and_disable_interrupts();
+  uint32_t head = 0u;
 
-  if (line == NULL || !g_debug_logs_enabled) {
-    restore_interrupts(irq_state);
+  if (line == NULL ||
+      !atomic_load_explicit(&g_debug_logs_enabled, memory_order_relaxed)) {
     return;
   }
 
@@ -38,61 +111,35 @@ void debug_logs_append(const char *line) {
     line_length = DEBUG_LOG_BUFFER_SIZE - 2u;
   }
 
-  if (g_debug_log_length + line_length + 1u >= DEBUG_LOG_BUFFER_SIZE) {
-    overflow = g_debug_log_length + line_length + 1u - DEBUG_LOG_BUFFER_SIZE;
-    if (overflow > g_debug_log_length) {
-      overflow = g_debug_log_length;
-    }
-    if (overflow > 0u) {
-      memmove(g_debug_log_buffer, g_debug_log_buffer + overflow,
-              g_debug_log_length - overflow);
-      g_debug_log_length -= overflow;
-    }
-  }
-
-  memcpy(g_debug_log_buffer + g_debug_log_length, line, line_length);
-  g_debug_log_length += line_length;
-  g_debug_log_buffer[g_debug_log_length++] = '\n';
-  g_debug_log_buffer[g_debug_log_length] = '\0';
-  g_debug_logs_generation += 1u;
-
-  restore_interrupts(irq_state);
+  vTaskSuspendAll();
+  head = atomic_load_explicit(&g_debug_log_head, memory_order_relaxed);
+  debug_logs_ring_write(head, line, line_length);
+  debug_logs_ring_write(head + (uint32_t)line_length, "\n", 1u);
+  atomic_store_explicit(&g_debug_log_head,
+                        head + (uint32_t)line_length + 1u,
+                        memory_order_release);
+  atomic_fetch_add_explicit(&g_debug_logs_generation, 1u,
+                            memory_order_release);
+  (void)xTaskResumeAll();
 #else
   (void)line;
 #endif
 }
 
 void debug_logs_copy(char *out_buffer, size_t out_buffer_size) {
-#if APP_ENABLE_DEBUG_HTTP_ROUTES
-  const uint32_t irq_state = save_and_disable_interrupts();
-  size_t copy_length = 0u;
-
   if (out_buffer == NULL || out_buffer_size == 0u) {
-    restore_interrupts(irq_state);
     return;
   }
-
-  copy_length = g_debug_log_length;
-  if (copy_length >= out_buffer_size) {
-    copy_length = out_buffer_size - 1u;
-  }
-
-  memcpy(out_buffer, g_debug_log_buffer, copy_length);
-  out_buffer[copy_length] = '\0';
-  restore_interrupts(irq_state);
+#if APP_ENABLE_DEBUG_HTTP_ROUTES
+  debug_logs_copy_range(out_buffer, out_buffer_size, false);
 #else
-  if (out_buffer != NULL && out_buffer_size > 0u) {
-    out_buffer[0] = '\0';
-  }
+  out_buffer[0] = '\0';
 #endif
 }
 
 bool debug_logs_enabled_get(void) {
 #if APP_ENABLE_DEBUG_HTTP_ROUTES
-  const uint32_t irq_state = save_and_disable_interrupts();
-  const bool enabled = g_debug_logs_enabled;
-  restore_interrupts(irq_state);
-  return enabled;
+  return atomic_load_explicit(&g_debug_logs_enabled, memory_order_relaxed);
 #else
   return false;
 #endif
@@ -100,10 +147,7 @@ bool debug_logs_enabled_get(void) {
 
 uint32_t debug_logs_generation_get(void) {
 #if APP_ENABLE_DEBUG_HTTP_ROUTES
-  const uint32_t irq_state = save_and_disable_interrupts();
-  const uint32_t generation = g_debug_logs_generation;
-  restore_interrupts(irq_state);
-  return generation;
+  return atomic_load_explicit(&g_debug_logs_generation, memory_order_acquire);
 #else
   return 0u;
 #endif
@@ -111,41 +155,19 @@ uint32_t debug_logs_generation_get(void) {
 
 void debug_logs_enabled_set(bool enabled) {
 #if APP_ENABLE_DEBUG_HTTP_ROUTES
-  const uint32_t irq_state = save_and_disable_interrupts();
-  g_debug_logs_enabled = enabled;
-  restore_interrupts(irq_state);
+  atomic_store_explicit(&g_debug_logs_enabled, enabled, memory_order_relaxed);
 #else
   (void)enabled;
 #endif
 }
 
 void debug_logs_copy_tail(char *out_buffer, size_t out_buffer_size) {
-#if APP_ENABLE_DEBUG_HTTP_ROUTES
-  const uint32_t irq_state = save_and_disable_interrupts();
-  size_t copy_length = 0u;
-  size_t start_index = 0u;
-
   if (out_buffer == NULL || out_buffer_size == 0u) {
-    restore_interrupts(irq_state);
     return;
   }
-
-  if (g_debug_log_length > 0u) {
-    const size_t max_copy = out_buffer_size - 1u;
-    if (g_debug_log_length > max_copy) {
-      start_index = g_debug_log_length - max_copy;
-      copy_length = max_copy;
-    } else {
-      copy_length = g_debug_log_length;
-    }
-    memcpy(out_buffer, g_debug_log_buffer + start_index, copy_length);
-  }
-
-  out_buffer[copy_length] = '\0';
-  restore_interrupts(irq_state);
+#if APP_ENABLE_DEBUG_HTTP_ROUTES
+  debug_logs_copy_range(out_buffer, out_buffer_size, true);
 #else
-  if (out_buffer != NULL && out_buffer_size > 0u) {
-    out_buffer[0] = '\0';
-  }
+  out_buffer[0] = '\0';
 #endif
 }
@@ -1,13 +1,19 @@
 #include "services/dimmer_control.h"
 
+#include "app/app_config.h"
+#include "hardware/gpio.h"
 #include "hardware/sync.h"
+#include <stdbool.h>
 
 static volatile uint8_t g_dimmer_power_percent;
+static volatile bool g_dimmer_forced_off;
 
 void dimmer_control_set_power_percent(uint8_t power_percent) {
   uint32_t irq_state = save_and_disable_interrupts();
 
-  g_dimmer_power_percent = power_percent <= 100u ? power_percent : 100u;
+  if (!g_dimmer_forced_off) {
+    g_dimmer_power_percent = power_percent <= 100u ? power_percent : 100u;
+  }
 
   restore_interrupts(irq_state);
 }
@@ -18,3 +24,14 @@ uint8_t dimmer_control_get_power_percent(void) {
   restore_interrupts(irq_state);
   return power_percent;
 }
+
+void dimmer_control_force_off(void) {
+  uint32_t irq_state = save_and_disable_interrupts();
+
+  g_dimmer_forced_off = true;
+  g_dimmer_power_percent = 0u;
+  /* The zero-cross ISR keeps it low from here; pending pulses check 0. */
+  gpio_put(APP_DIMMER_GATE_PIN, 0);
+
+  restore_interrupts(irq_state);
+}
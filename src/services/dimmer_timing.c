@@ -0,0 +1,221 @@
+#include "services/dimmer_timing.h"
+
+#include "app/app_config.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Plausible zero-cross periods: 60 Hz both edges .. 50 Hz one edge (x1.25). */
+#define DIMMER_TIMING_MIN_PERIOD_US 5000u
+#define DIMMER_TIMING_MAX_PERIOD_US 25000u
+/* Mean period IIR weight 1/32 in Q8; phase follows 1/8 of each error. */
+#define DIMMER_TIMING_PERIOD_Q 8u
+#define DIMMER_TIMING_PERIOD_FILTER_DIVISOR 32
+#define DIMMER_TIMING_PHASE_FILTER_DIVISOR 8
+/* Periods after a resync spent settling the filters, not recorded. */
+#define DIMMER_TIMING_WARMUP_PERIODS 64u
+
+typedef struct {
+  uint32_t period_mean_us;
+  uint32_t period_min_us;
+  uint32_t period_max_us;
+  uint32_t resyncs;
+  dimmer_timing_jitter_t period_deviation;
+  dimmer_timing_jitter_t edge_phase;
+} dimmer_timing_zero_cross_stats_t;
+
+/* Written only by the zero-cross ISR. */
+static struct {
+  atomic_uint sequence;
+  atomic_bool reset_requested;
+  dimmer_timing_zero_cross_stats_t stats;
+  bool has_edge;
+  uint32_t last_edge_us;
+  uint32_t phase_us;
+  /* Sub-microsecond part of the predicted edge, Q8. */
+  uint32_t phase_fraction_q8;
+  uint32_t mean_period_q8;
+  uint32_t warmup_periods;
+} g_zero_cross;
+
+/* Written only by the gate alarm ISR. */
+static struct {
+  atomic_uint sequence;
+  atomic_bool reset_requested;
+  sys_histogram_t lateness;
+} g_gate;
+
+static void dimmer_timing_jitter_add(dimmer_timing_jitter_t *jitter,
+                                     int32_t value_us) {
+  const int32_t width = (int32_t)APP_DIMMER_TIMING_BIN_US;
+  const int32_t bin =
+      (value_us >= 0 ? value_us / width : -((width - 1 - value_us) / width)) +
+      (int32_t)(DIMMER_TIMING_BIN_COUNT / 2u);
+
+  if (jitter->count == 0u || value_us < jitter->min_us) {
+    jitter->min_us = value_us;
+  }
+  if (jitter->count == 0u || value_us > jitter->max_us) {
+    jitter->max_us = value_us;
+  }
+  jitter->count += 1u;
+  if (bin < 0) {
+    jitter->underflow += 1u;
+  } else if (bin >= (int32_t)DIMMER_TIMING_BIN_COUNT) {
+    jitter->overflow += 1u;
+  } else {
+    jitter->bins[bin] += 1u;
+  }
+}
+
+static void dimmer_timing_begin_write(atomic_uint *sequence) {
+  atomic_store_explicit(sequence,
+                        atomic_load_explicit(sequence, memory_order_relaxed) +
+                            1u,
+                        memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+}
+
+static void dimmer_timing_end_write(atomic_uint *sequence) {
+  atomic_store_explicit(sequence,
+                        atomic_load_explicit(sequence, memory_order_relaxed) +
+                            1u,
+                        memory_order_release);
+}
+
+/* Restarts period and phase tracking from this edge. */
+static void dimmer_timing_resync(uint32_t entry_us) {
+  g_zero_cross.mean_period_q8 = 0u;
+  g_zero_cross.phase_us = entry_us;
+  g_zero_cross.phase_fraction_q8 = 0u;
+  g_zero_cross.warmup_periods = DIMMER_TIMING_WARMUP_PERIODS;
+}
+
+void dimmer_timing_record_zero_cross(uint32_t entry_us) {
+  dimmer_timing_zero_cross_stats_t *stats = &g_zero_cross.stats;
+  uint32_t period_us = 0u;
+  uint32_t mean_us = 0u;
+  uint32_t predicted_us = 0u;
+  uint32_t fraction_q8 = 0u;
+  int32_t phase_error_us = 0;
+
+  dimmer_timing_begin_write(&g_zero_cross.sequence);
+  if (atomic_exchange_explicit(&g_zero_cross.reset_requested, false,
+                               memory_order_relaxed)) {
+    memset(stats, 0, sizeof(*stats));
+    g_zero_cross.has_edge = false;
+  }
+  if (!g_zero_cross.has_edge) {
+    g_zero_cross.has_edge = true;
+    g_zero_cross.last_edge_us = entry_us;
+    dimmer_timing_resync(entry_us);
+    dimmer_timing_end_write(&g_zero_cross.sequence);
+    return;
+  }
+
+  period_us = entry_us - g_zero_cross.last_edge_us;
+  g_zero_cross.last_edge_us = entry_us;
+  mean_us = g_zero_cross.mean_period_q8 >> DIMMER_TIMING_PERIOD_Q;
+
+  if (period_us < DIMMER_TIMING_MIN_PERIOD_US ||
+      period_us > DIMMER_TIMING_MAX_PERIOD_US ||
+      (mean_us > 0u &&
+       (period_us < mean_us / 2u || period_us > mean_us + mean_us / 2u))) {
+    stats->resyncs += 1u;
+    dimmer_timing_resync(entry_us);
+    dimmer_timing_end_write(&g_zero_cross.sequence);
+    return;
+  }
+  if (mean_us == 0u) {
+    g_zero_cross.mean_period_q8 = period_us << DIMMER_TIMING_PERIOD_Q;
+    g_zero_cross.phase_us = entry_us;
+    dimmer_timing_end_write(&g_zero_cross.sequence);
+    return;
+  }
+
+  fraction_q8 = g_zero_cross.phase_fraction_q8 +
+                (g_zero_cross.mean_period_q8 &
+                 ((1u << DIMMER_TIMING_PERIOD_Q) - 1u));
+  predicted_us = g_zero_cross.phase_us + mean_us +
+                 (fraction_q8 >> DIMMER_TIMING_PERIOD_Q);
+  g_zero_cross.phase_fraction_q8 =
+      fraction_q8 & ((1u << DIMMER_TIMING_PERIOD_Q) - 1u);
+  phase_error_us = (int32_t)(entry_us - predicted_us);
+  if (g_zero_cross.warmup_periods > 0u) {
+    g_zero_cross.warmup_periods -= 1u;
+  } else {
+    dimmer_timing_jitter_add(&stats->period_deviation,
+                             (int32_t)(period_us - mean_us));
+    dimmer_timing_jitter_add(&stats->edge_phase, phase_error_us);
+  }
+  g_zero_cross.phase_us =
+      predicted_us +
+      (uint32_t)(phase_error_us / DIMMER_TIMING_PHASE_FILTER_DIVISOR);
+  g_zero_cross.mean_period_q8 = (uint32_t)(
+      (int32_t)g_zero_cross.mean_period_q8 +
+      ((int32_t)(period_us << DIMMER_TIMING_PERIOD_Q) -
+       (int32_t)g_zero_cross.mean_period_q8) /
+          DIMMER_TIMING_PERIOD_FILTER_DIVISOR);
+
+  if (stats->period_min_us == 0u || period_us < stats->period_min_us) {
+    stats->period_min_us = period_us;
+  }
+  if (period_us > stats->period_max_us) {
+    stats->period_max_us = period_us;
+  }
+  stats->period_mean_us = g_zero_cross.mean_period_q8 >> DIMMER_TIMING_PERIOD_Q;
+  dimmer_timing_end_write(&g_zero_cross.sequence);
+}
+
+void dimmer_timing_record_gate(uint32_t scheduled_us, uint32_t entry_us) {
+  const int32_t lateness_us = (int32_t)(entry_us - scheduled_us);
+
+  dimmer_timing_begin_write(&g_gate.sequence);
+  if (atomic_exchange_explicit(&g_gate.reset_requested, false,
+                               memory_order_relaxed)) {
+    sys_histogram_clear(&g_gate.lateness);
+  }
+  sys_histogram_add(&g_gate.lateness,
+                    lateness_us > 0 ? (uint32_t)lateness_us : 0u);
+  dimmer_timing_end_write(&g_gate.sequence);
+}
+
+void dimmer_timing_get_snapshot(dimmer_timing_snapshot_t *out_snapshot) {
+  dimmer_timing_zero_cross_stats_t zero_cross;
+  unsigned int sequence = 0u;
+
+  if (out_snapshot == NULL) {
+    return;
+  }
+
+  do {
+    sequence =
+        atomic_load_explicit(&g_zero_cross.sequence, memory_order_acquire);
+    zero_cross = g_zero_cross.stats;
+    atomic_thread_fence(memory_order_acquire);
+  } while ((sequence & 1u) != 0u ||
+           atomic_load_explicit(&g_zero_cross.sequence,
+                                memory_order_relaxed) != sequence);
+
+  do {
+    sequence = atomic_load_explicit(&g_gate.sequence, memory_order_acquire);
+    out_snapshot->gate_lateness = g_gate.lateness;
+    atomic_thread_fence(memory_order_acquire);
+  } while ((sequence & 1u) != 0u ||
+           atomic_load_explicit(&g_gate.sequence, memory_order_relaxed) !=
+               sequence);
+
+  out_snapshot->period_mean_us = zero_cross.period_mean_us;
+  out_snapshot->period_min_us = zero_cross.period_min_us;
+  out_snapshot->period_max_us = zero_cross.period_max_us;
+  out_snapshot->resyncs = zero_cross.resyncs;
+  out_snapshot->period_deviation = zero_cross.period_deviation;
+  out_snapshot->edge_phase = zero_cross.edge_phase;
+}
+
+void dimmer_timing_reset(void) {
+  atomic_store_explicit(&g_zero_cross.reset_requested, true,
+                        memory_order_relaxed);
+  atomic_store_explicit(&g_gate.reset_requested, true, memory_order_relaxed);
+}
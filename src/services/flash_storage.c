@@ -0,0 +1,102 @@
+#include "services/flash_storage.h"
+
+#include "hardware/flash.h"
+#include "hardware/regs/addressmap.h"
+#include "hardware/sync.h"
+#include <string.h>
+
+uint32_t flash_storage_crc32_update(uint32_t crc, const uint8_t *data,
+                                    size_t data_len) {
+  uint32_t value = crc;
+  size_t index = 0u;
+
+  if (data == NULL) {
+    return value;
+  }
+
+  for (index = 0u; index < data_len; ++index) {
+    uint32_t bit = 0u;
+    value ^= data[index];
+    for (bit = 0u; bit < 8u; ++bit) {
+      const uint32_t mask = (uint32_t)-(int32_t)(value & 1u);
+      value = (value >> 1u) ^ (0xedb88320u & mask);
+    }
+  }
+
+  return value;
+}
+
+uint32_t flash_storage_crc32(const void *data, size_t data_len) {
+  return flash_storage_crc32_update(FLASH_STORAGE_CRC32_INIT,
+                                    (const uint8_t *)data, data_len) ^
+         0xffffffffu;
+}
+
+bool flash_storage_region_is_valid(uint32_t offset, uint32_t size,
+                                   uint32_t min_offset) {
+  if (size == 0u) {
+    return false;
+  }
+  if ((offset % FLASH_SECTOR_SIZE) != 0u || (size % FLASH_SECTOR_SIZE) != 0u) {
+    return false;
+  }
+  if (offset < min_offset) {
+    return false;
+  }
+  if (offset >= PICO_FLASH_SIZE_BYTES ||
+      size > PICO_FLASH_SIZE_BYTES - offset) {
+    return false;
+  }
+
+  return true;
+}
+
+bool flash_storage_range_is_erased(uint32_t offset, uint32_t length) {
+  const volatile uint8_t *flash_bytes =
+      (const volatile uint8_t *)(XIP_BASE + offset);
+  uint32_t index = 0u;
+
+  for (index = 0u; index < length; ++index) {
+    if (flash_bytes[index] != FLASH_STORAGE_ERASED_BYTE) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool flash_storage_write_image(uint32_t offset, uint8_t *image,
+                               size_t image_size, const void *data,
+                               size_t data_size) {
+  const size_t erase_size =
+      ((image_size + FLASH_SECTOR_SIZE - 1u) / FLASH_SECTOR_SIZE) *
+      FLASH_SECTOR_SIZE;
+  const volatile uint8_t *flash_bytes =
+      (const volatile uint8_t *)(XIP_BASE + offset);
+  uint32_t irq_state = 0u;
+  size_t position = 0u;
+
+  if (image == NULL || data == NULL || data_size > image_size ||
+      (image_size % FLASH_PAGE_SIZE) != 0u) {
+    return false;
+  }
+
+  memset(image, FLASH_STORAGE_ERASED_BYTE, image_size);
+  memcpy(image, data, data_size);
+
+  irq_state = save_and_disable_interrupts();
+  flash_range_erase(offset, erase_size);
+  for (position = 0u; position < image_size; position += FLASH_PAGE_SIZE) {
+    flash_range_program(offset + (uint32_t)position, image + position,
+                        FLASH_PAGE_SIZE);
+  }
+  restore_interrupts(irq_state);
+
+  for (position = 0u; position < image_size; ++position) {
+    if (flash_bytes[position] != image[position]) {
+      return false;
+    }
+  }
+
+  return true;
+}
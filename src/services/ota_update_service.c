@@ -8,6 +8,7 @@
 #include "hardware/watchdog.h"
 #include "pico/stdlib.h"
 #include "semphr.h"
+#include "services/sys_watchdog.h"
 #include "task.h"
 #include <ctype.h>
 #include <stdbool.h>
@@ -31,6 +32,11 @@ typedef struct {
   size_t page_fill_bytes;
   uint8_t page_buffer[FLASH_PAGE_SIZE];
   TaskHandle_t apply_task_handle;
+  uint32_t begin_ms;
+  uint32_t last_chunk_ms;
+  /* Lifetime totals; not cleared by ota_context_reset_locked(). */
+  uint32_t total_received_bytes;
+  uint32_t total_chunks;
   char staged_version[OTA_UPDATE_VERSION_LABEL_MAX_LEN];
   char last_error[OTA_UPDATE_ERROR_TEXT_MAX_LEN];
 } ota_update_context_t;
@@ -237,6 +243,10 @@ static bool ota_stage_validate_image_locked(void) {
   return true;
 }
 
+static uint32_t ota_now_ms(void) {
+  return (uint32_t)xTaskGetTickCount() * (uint32_t)portTICK_PERIOD_MS;
+}
+
 static uint32_t ota_round_up_to_page(uint32_t value) {
   return (value + (FLASH_PAGE_SIZE - 1u)) & ~(FLASH_PAGE_SIZE - 1u);
 }
@@ -252,6 +262,8 @@ static void ota_context_reset_locked(void) {
   g_context.staged_programmed_size_bytes = 0u;
   g_context.page_fill_bytes = 0u;
   g_context.apply_task_handle = NULL;
+  g_context.begin_ms = 0u;
+  g_context.last_chunk_ms = 0u;
   g_context.staged_version[0] = '\0';
   g_context.last_error[0] = '\0';
 }
@@ -268,6 +280,11 @@ static void ota_copy_status_locked(ota_update_status_t *out_status) {
       .expected_crc32 = g_context.expected_crc32,
       .computed_crc32 = g_context.computed_crc32,
       .apply_task_active = g_context.apply_task_handle != NULL,
+      .receive_elapsed_ms = g_context.received_size_bytes > 0u
+                                ? g_context.last_chunk_ms - g_context.begin_ms
+                                : 0u,
+      .total_received_bytes = g_context.total_received_bytes,
+      .total_chunks = g_context.total_chunks,
       .staged_version = {0},
       .last_error = {0},
   };
@@ -329,6 +346,8 @@ static void ota_apply_task_entry(void *params) {
   (void)params;
 
   vTaskDelay(pdMS_TO_TICKS(APP_OTA_APPLY_DELAY_MS));
+  /* The copy runs with interrupts off for longer than the watchdog. */
+  sys_watchdog_release();
   ota_apply_staged_image_and_reboot(bytes_to_apply);
 
   if (g_context.mutex != NULL) {
@@ -422,6 +441,7 @@ ota_update_result_t ota_update_service_begin(uint32_t image_size_bytes,
   g_context.expected_size_bytes = image_size_bytes;
   g_context.expected_crc32 = expected_crc32;
   g_context.running_crc32 = 0xffffffffu;
+  g_context.begin_ms = ota_now_ms();
   g_context.last_error[0] = '\0';
 
 finish:
@@ -490,6 +510,9 @@ ota_update_result_t ota_update_service_write_chunk(uint32_t offset,
 
   g_context.received_size_bytes += (uint32_t)chunk_length;
   g_context.next_expected_offset += (uint32_t)chunk_length;
+  g_context.last_chunk_ms = ota_now_ms();
+  g_context.total_received_bytes += (uint32_t)chunk_length;
+  g_context.total_chunks += 1u;
 
 finish:
   xSemaphoreGive(g_context.mutex);
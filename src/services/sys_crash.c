@@ -0,0 +1,139 @@
+#include "services/sys_crash.h"
+
+#include "app/app_config.h"
+#include "FreeRTOS.h"
+#include "hardware/regs/addressmap.h"
+#include "hardware/structs/scb.h"
+#include "hardware/timer.h"
+#include "pico/stdlib.h"
+#include "services/debug_logs.h"
+#include "task.h"
+#include <stddef.h>
+#include <string.h>
+
+#define SYS_CRASH_MAGIC 0x43525348u
+#define SYS_CRASH_FRAME_WORDS 8u
+
+/* Survives the watchdog reboot: the C runtime neither loads nor zeroes it. */
+static sys_crash_record_t __uninitialized_ram(g_crash_dump);
+static bool g_has_last_crash = false;
+
+static uint32_t sys_crash_checksum(const sys_crash_record_t *record) {
+  const uint8_t *bytes = (const uint8_t *)record;
+  uint32_t hash = 2166136261u;
+  size_t index = 0u;
+
+  /* FNV-1a over everything before the checksum field. */
+  for (index = 0u; index < offsetof(sys_crash_record_t, checksum); ++index) {
+    hash = (hash ^ bytes[index]) * 16777619u;
+  }
+  return hash;
+}
+
+static void sys_crash_copy_text(char *out, size_t out_size, const char *text) {
+  size_t index = 0u;
+
+  for (index = 0u; text != NULL && text[index] != '\0' && index + 1u < out_size;
+       ++index) {
+    out[index] = text[index];
+  }
+  out[index] = '\0';
+}
+
+void sys_crash_init(void) {
+  g_has_last_crash = g_crash_dump.magic == SYS_CRASH_MAGIC &&
+                     g_crash_dump.checksum == sys_crash_checksum(&g_crash_dump);
+  /* Report a dump on one boot only; the contents stay until overwritten. */
+  g_crash_dump.magic = 0u;
+}
+
+void sys_crash_capture(sys_crash_reason_t reason, const uint32_t *frame,
+                       uint32_t exc_return, const char *message) {
+  sys_crash_record_t *record = &g_crash_dump;
+  const uintptr_t frame_address = (uintptr_t)frame;
+
+  memset(record, 0, sizeof(*record));
+  record->reason = (uint32_t)reason;
+  record->uptime_us = time_us_32();
+  sys_crash_copy_text(record->firmware_version,
+                      sizeof(record->firmware_version), APP_FIRMWARE_VERSION);
+  sys_crash_copy_text(record->message, sizeof(record->message), message);
+  if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) {
+    const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+    if (task != NULL) {
+      sys_crash_copy_text(record->task_name, sizeof(record->task_name),
+                          pcTaskGetName(task));
+    }
+  }
+  record->cfsr = scb_hw->cfsr;
+  record->hfsr = scb_hw->hfsr;
+  record->mmfar = scb_hw->mmfar;
+  record->bfar = scb_hw->bfar;
+
+  /* A corrupt stack pointer must not fault again while dumping. */
+  if (frame != NULL && (frame_address & 3u) == 0u &&
+      frame_address >= SRAM_BASE &&
+      frame_address + SYS_CRASH_FRAME_WORDS * 4u <= SRAM_END) {
+    const uint32_t available = (uint32_t)(SRAM_END - frame_address) / 4u;
+
+    record->has_frame = true;
+    record->r0 = frame[0];
+    record->r1 = frame[1];
+    record->r2 = frame[2];
+    record->r3 = frame[3];
+    record->r12 = frame[4];
+    record->lr = frame[5];
+    record->pc = frame[6];
+    record->xpsr = frame[7];
+    record->exc_return = exc_return;
+    record->stack_address = (uint32_t)frame_address;
+    record->stack_word_count =
+        available < SYS_CRASH_STACK_WORDS ? available : SYS_CRASH_STACK_WORDS;
+    memcpy(record->stack, frame, record->stack_word_count * 4u);
+  }
+
+  record->trace_count =
+      sys_trace_copy_recent(record->trace, SYS_CRASH_TRACE_EVENTS);
+  debug_logs_copy_tail(record->log_tail, sizeof(record->log_tail));
+
+  record->magic = SYS_CRASH_MAGIC;
+  record->checksum = sys_crash_checksum(record);
+}
+
+bool sys_crash_get_last(sys_crash_record_t *out_record) {
+  if (out_record == NULL || !g_has_last_crash) {
+    return false;
+  }
+  *out_record = g_crash_dump;
+  return true;
+}
+
+void sys_crash_clear(void) { g_has_last_crash = false; }
+
+const char *sys_crash_reason_name(sys_crash_reason_t reason) {
+  switch (reason) {
+  case SYS_CRASH_NONE:
+    return "none";
+  case SYS_CRASH_HARD_FAULT:
+    return "hard_fault";
+  case SYS_CRASH_MEM_MANAGE:
+    return "mem_manage";
+  case SYS_CRASH_BUS_FAULT:
+    return "bus_fault";
+  case SYS_CRASH_USAGE_FAULT:
+    return "usage_fault";
+  case SYS_CRASH_SECURE_FAULT:
+    return "secure_fault";
+  case SYS_CRASH_STACK_OVERFLOW:
+    return "stack_overflow";
+  case SYS_CRASH_MALLOC_FAILED:
+    return "malloc_failed";
+  case SYS_CRASH_PANIC:
+    return "panic";
+  case SYS_CRASH_WATCHDOG:
+    return "watchdog";
+  default:
+    return "unknown";
+  }
+}
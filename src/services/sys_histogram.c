@@ -0,0 +1,61 @@
+#include "services/sys_histogram.h"
+
+#include <stddef.h>
+#include <string.h>
+
+void sys_histogram_clear(sys_histogram_t *histogram) {
+  if (histogram == NULL) {
+    return;
+  }
+  memset(histogram, 0, sizeof(*histogram));
+}
+
+void sys_histogram_add(sys_histogram_t *histogram, uint32_t value) {
+  const uint32_t bucket =
+      value == 0u ? 0u : 32u - (uint32_t)__builtin_clz(value);
+
+  if (histogram->count == 0u || value < histogram->min) {
+    histogram->min = value;
+  }
+  if (value > histogram->max) {
+    histogram->max = value;
+  }
+  histogram->count += 1u;
+  histogram->total += value;
+  histogram->buckets[bucket] += 1u;
+}
+
+uint32_t sys_histogram_mean(const sys_histogram_t *histogram) {
+  if (histogram == NULL || histogram->count == 0u) {
+    return 0u;
+  }
+  return (uint32_t)(histogram->total / (uint64_t)histogram->count);
+}
+
+uint32_t sys_histogram_percentile(const sys_histogram_t *histogram,
+                                  float fraction) {
+  uint64_t wanted = 0u;
+  uint64_t seen = 0u;
+  uint32_t bucket = 0u;
+
+  if (histogram == NULL || histogram->count == 0u) {
+    return 0u;
+  }
+  /* ceil(count * fraction), at least one sample. */
+  wanted = ((uint64_t)histogram->count * (uint64_t)(fraction * 1000.0f) +
+            999u) /
+           1000u;
+  if (wanted == 0u) {
+    wanted = 1u;
+  }
+
+  for (bucket = 0u; bucket < SYS_HISTOGRAM_BUCKET_COUNT; ++bucket) {
+    seen += histogram->buckets[bucket];
+    if (seen >= wanted) {
+      const uint32_t upper =
+          bucket >= 32u ? UINT32_MAX : (uint32_t)((1ull << bucket) - 1u);
+      return upper < histogram->max ? upper : histogram->max;
+    }
+  }
+  return histogram->max;
+}
@@ -0,0 +1,81 @@
+#include "services/sys_latency.h"
+
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef struct {
+  sys_histogram_t stages[SYS_LATENCY_STAGE_COUNT];
+  uint32_t superseded;
+  bool pending;
+  uint32_t pending_sample_us;
+  uint32_t pending_command_us;
+} sys_latency_state_t;
+
+/* Shared with the gate ISRs; every access masks interrupts. */
+static sys_latency_state_t g_latency;
+
+void sys_latency_trace_command(uint32_t sample_time_us,
+                               uint8_t power_percent) {
+  const uint32_t now_us = time_us_32();
+  const uint32_t irq_state = save_and_disable_interrupts();
+
+  sys_histogram_add(&g_latency.stages[SYS_LATENCY_SAMPLE_TO_COMMAND],
+                    now_us - sample_time_us);
+  if (g_latency.pending) {
+    g_latency.superseded += 1u;
+  }
+  g_latency.pending = power_percent > 0u;
+  g_latency.pending_sample_us = sample_time_us;
+  g_latency.pending_command_us = now_us;
+  restore_interrupts(irq_state);
+}
+
+void sys_latency_trace_gate(void) {
+  const uint32_t now_us = time_us_32();
+  const uint32_t irq_state = save_and_disable_interrupts();
+
+  if (g_latency.pending) {
+    g_latency.pending = false;
+    sys_histogram_add(&g_latency.stages[SYS_LATENCY_COMMAND_TO_GATE],
+                      now_us - g_latency.pending_command_us);
+    sys_histogram_add(&g_latency.stages[SYS_LATENCY_SAMPLE_TO_GATE],
+                      now_us - g_latency.pending_sample_us);
+  }
+  restore_interrupts(irq_state);
+}
+
+void sys_latency_get_snapshot(sys_latency_snapshot_t *out_snapshot) {
+  uint32_t irq_state = 0u;
+
+  if (out_snapshot == NULL) {
+    return;
+  }
+  irq_state = save_and_disable_interrupts();
+  memcpy(out_snapshot->stages, g_latency.stages,
+         sizeof(out_snapshot->stages));
+  out_snapshot->superseded = g_latency.superseded;
+  restore_interrupts(irq_state);
+}
+
+void sys_latency_reset(void) {
+  const uint32_t irq_state = save_and_disable_interrupts();
+
+  memset(&g_latency, 0, sizeof(g_latency));
+  restore_interrupts(irq_state);
+}
+
+const char *sys_latency_stage_name(sys_latency_stage_t stage) {
+  switch (stage) {
+  case SYS_LATENCY_SAMPLE_TO_COMMAND:
+    return "sample_to_command";
+  case SYS_LATENCY_COMMAND_TO_GATE:
+    return "command_to_gate";
+  case SYS_LATENCY_SAMPLE_TO_GATE:
+    return "sample_to_gate";
+  default:
+    return "unknown";
+  }
+}
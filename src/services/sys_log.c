@@ -0,0 +1,235 @@
+#include "services/sys_log.h"
+
+#include "hardware/timer.h"
+#include <stdatomic.h>
+#include <stdio.h>
+
+_Static_assert((APP_LOG_RING_ENTRIES & (APP_LOG_RING_ENTRIES - 1u)) == 0u,
+               "APP_LOG_RING_ENTRIES must be a power of two");
+
+/* Format strings are expanded by sys_log_format, one argument word each. */
+static const char *const k_sys_log_formats[SYS_LOG_ID_COUNT] = {
+    [SYS_LOG_ADP910_INIT_FAIL] =
+        "[ADP910][%s] init_fail status=%s bus=%lu sda=%u sda_lv=%u scl=%u "
+        "scl_lv=%u addr=0x%02x hz=%lu io=%d",
+    [SYS_LOG_ADP910_INIT_OK] =
+        "[ADP910][%s] init_ok bus=%lu sda=%u scl=%u addr=0x%02x hz=%lu",
+    [SYS_LOG_ADP910_READ_FAIL] =
+        "[ADP910][%s] read_fail status=%s streak=%u sda=%u sda_lv=%u scl=%u "
+        "scl_lv=%u io=%d",
+    [SYS_LOG_ADP910_DIAG] =
+        "[ADP910][diag] seq=%lu s0_ready=%u s0_last=%s s0_ok=%lu s0_bus=%lu "
+        "s0_crc=%lu s0_nr=%lu s1_ready=%u s1_last=%s s1_ok=%lu s1_bus=%lu "
+        "s1_crc=%lu s1_nr=%lu s0_dp=%.3f s1_dp=%.3f",
+    [SYS_LOG_PROFILER_PROBE] =
+        "[PROF] %s n=%lu min=%.1fus mean=%.1fus p50=%.1fus p99=%.1fus "
+        "max=%.1fus",
+};
+
+#if APP_ENABLE_LOG_TASK
+/*
+ * Bounded multi-producer ring. Position p lands in slot p % size during
+ * lap p / size; the slot's turn is 2 * lap while it waits for that lap's
+ * writer and 2 * lap + 1 once written, so zeroed storage starts empty.
+ */
+typedef struct {
+  atomic_uint turn;
+  sys_log_record_t record;
+} sys_log_slot_t;
+
+static struct {
+  atomic_uint head;
+  /* Only the log task advances tail. */
+  uint32_t tail;
+  atomic_uint dropped;
+  sys_log_slot_t slots[APP_LOG_RING_ENTRIES];
+} g_sys_log;
+#endif
+
+static void sys_log_fill_record(sys_log_record_t *record, sys_log_id_t id,
+                                const sys_log_arg_t *args, size_t arg_count) {
+  size_t index = 0u;
+
+  if (arg_count > SYS_LOG_MAX_ARGS) {
+    arg_count = SYS_LOG_MAX_ARGS;
+  }
+  record->timestamp_us = time_us_32();
+  record->id = (uint16_t)id;
+  record->arg_count = (uint8_t)arg_count;
+  for (index = 0u; index < arg_count; ++index) {
+    record->args[index] = args[index];
+  }
+}
+
+bool sys_log_write(sys_log_id_t id, const sys_log_arg_t *args,
+                   size_t arg_count) {
+#if APP_ENABLE_LOG_TASK
+  unsigned int position =
+      atomic_load_explicit(&g_sys_log.head, memory_order_relaxed);
+  sys_log_slot_t *slot = NULL;
+
+  for (;;) {
+    const unsigned int lap = position / APP_LOG_RING_ENTRIES;
+    unsigned int turn = 0u;
+
+    slot = &g_sys_log.slots[position & (APP_LOG_RING_ENTRIES - 1u)];
+    turn = atomic_load_explicit(&slot->turn, memory_order_acquire);
+    if (turn == 2u * lap) {
+      if (atomic_compare_exchange_weak_explicit(
+              &g_sys_log.head, &position, position + 1u,
+              memory_order_relaxed, memory_order_relaxed)) {
+        break;
+      }
+    } else if ((int)(turn - 2u * lap) < 0) {
+      /* Still holds last lap's record: the log task is behind. */
+      atomic_fetch_add_explicit(&g_sys_log.dropped, 1u,
+                                memory_order_relaxed);
+      return false;
+    } else {
+      position = atomic_load_explicit(&g_sys_log.head, memory_order_relaxed);
+    }
+  }
+
+  sys_log_fill_record(&slot->record, id, args, arg_count);
+  atomic_store_explicit(&slot->turn,
+                        2u * (position / APP_LOG_RING_ENTRIES) + 1u,
+                        memory_order_release);
+  return true;
+#else
+  sys_log_record_t record;
+  char line[SYS_LOG_LINE_MAX];
+
+  sys_log_fill_record(&record, id, args, arg_count);
+  (void)sys_log_format(&record, line, sizeof(line));
+  printf("%s\n", line);
+  return true;
+#endif
+}
+
+bool sys_log_read(sys_log_record_t *out_record) {
+#if APP_ENABLE_LOG_TASK
+  const uint32_t lap = g_sys_log.tail / APP_LOG_RING_ENTRIES;
+  sys_log_slot_t *slot =
+      &g_sys_log.slots[g_sys_log.tail & (APP_LOG_RING_ENTRIES - 1u)];
+
+  if (out_record == NULL ||
+      atomic_load_explicit(&slot->turn, memory_order_acquire) !=
+          2u * lap + 1u) {
+    return false;
+  }
+  *out_record = slot->record;
+  atomic_store_explicit(&slot->turn, 2u * lap + 2u, memory_order_release);
+  g_sys_log.tail += 1u;
+  return true;
+#else
+  (void)out_record;
+  return false;
+#endif
+}
+
+size_t sys_log_format(const sys_log_record_t *record, char *out,
+                      size_t out_size) {
+  const char *format = NULL;
+  size_t offset = 0u;
+  size_t arg_index = 0u;
+
+  if (record == NULL || out == NULL || out_size == 0u) {
+    return 0u;
+  }
+  out[0] = '\0';
+  if (record->id >= SYS_LOG_ID_COUNT) {
+    const int written = snprintf(out, out_size, "[LOG] unknown id=%u",
+                                 (unsigned int)record->id);
+    return written > 0 ? (size_t)written : 0u;
+  }
+  format = k_sys_log_formats[record->id];
+
+  while (*format != '\0' && offset + 1u < out_size) {
+    char spec[16];
+    size_t spec_length = 0u;
+    bool is_long = false;
+    char conversion = '\0';
+    sys_log_arg_t value = 0u;
+    int written = 0;
+
+    if (*format != '%' || format[1] == '%') {
+      out[offset++] = *format;
+      format += *format == '%' ? 2 : 1;
+      continue;
+    }
+
+    /* Flags, width, precision and length up to the conversion. */
+    spec[spec_length++] = *format++;
+    while (*format != '\0' && strchr("diuxXcsfp", *format) == NULL &&
+           spec_length + 2u < sizeof(spec)) {
+      is_long = is_long || *format == 'l';
+      spec[spec_length++] = *format++;
+    }
+    if (*format == '\0') {
+      break;
+    }
+    conversion = *format++;
+    spec[spec_length++] = conversion;
+    spec[spec_length] = '\0';
+    value = arg_index < record->arg_count ? record->args[arg_index] : 0u;
+    arg_index += 1u;
+
+    switch (conversion) {
+    case 'd':
+    case 'i':
+      written = is_long ? snprintf(&out[offset], out_size - offset, spec,
+                                   (long)(int32_t)value)
+                        : snprintf(&out[offset], out_size - offset, spec,
+                                   (int)(int32_t)value);
+      break;
+    case 'u':
+    case 'x':
+    case 'X':
+      written = is_long ? snprintf(&out[offset], out_size - offset, spec,
+                                   (unsigned long)(uint32_t)value)
+                        : snprintf(&out[offset], out_size - offset, spec,
+                                   (unsigned int)(uint32_t)value);
+      break;
+    case 'c':
+      written = snprintf(&out[offset], out_size - offset, spec, (int)value);
+      break;
+    case 's':
+      written = snprintf(&out[offset], out_size - offset, spec,
+                         value != 0u ? (const char *)value : "(null)");
+      break;
+    case 'f': {
+      const uint32_t bits = (uint32_t)value;
+      float number = 0.0f;
+
+      memcpy(&number, &bits, sizeof(number));
+      written = snprintf(&out[offset], out_size - offset, spec,
+                         (double)number);
+      break;
+    }
+    default:
+      written = snprintf(&out[offset], out_size - offset, spec,
+                         (void *)value);
+      break;
+    }
+
+    if (written < 0) {
+      break;
+    }
+    offset += (size_t)written;
+    if (offset >= out_size) {
+      offset = out_size - 1u;
+      break;
+    }
+  }
+
+  out[offset] = '\0';
+  return offset;
+}
+
+uint32_t sys_log_dropped(void) {
+#if APP_ENABLE_LOG_TASK
+  return atomic_load_explicit(&g_sys_log.dropped, memory_order_relaxed);
+#else
+  return 0u;
+#endif
+}
@@ -0,0 +1,118 @@
+#include "services/sys_profiler.h"
+
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "services/sys_log.h"
+#include <stddef.h>
+#include <string.h>
+
+#if APP_ENABLE_PROFILER
+static sys_histogram_t g_probes[SYS_PROFILE_PROBE_COUNT];
+static bool g_cycle_counter;
+
+void sys_profiler_record(sys_profile_probe_t probe, uint32_t cycles) {
+  uint32_t irq_state = 0u;
+
+  if ((uint32_t)probe >= SYS_PROFILE_PROBE_COUNT) {
+    return;
+  }
+  irq_state = save_and_disable_interrupts();
+  sys_histogram_add(&g_probes[probe], cycles);
+  restore_interrupts(irq_state);
+}
+#endif
+
+void sys_profiler_init(void) {
+#if APP_ENABLE_PROFILER
+  size_t index = 0u;
+
+  m33_hw->demcr |= M33_DEMCR_TRCENA_BITS;
+  g_cycle_counter = (m33_hw->dwt_ctrl & M33_DWT_CTRL_NOCYCCNT_BITS) == 0u;
+  if (g_cycle_counter) {
+    m33_hw->dwt_cyccnt = 0u;
+    m33_hw->dwt_ctrl |= M33_DWT_CTRL_CYCCNTENA_BITS;
+  }
+  for (index = 0u; index < SYS_PROFILE_PROBE_COUNT; ++index) {
+    sys_histogram_clear(&g_probes[index]);
+  }
+#endif
+}
+
+void sys_profiler_get_snapshot(sys_profiler_snapshot_t *out_snapshot) {
+  if (out_snapshot == NULL) {
+    return;
+  }
+  memset(out_snapshot, 0, sizeof(*out_snapshot));
+  out_snapshot->cpu_hz = clock_get_hz(clk_sys);
+
+#if APP_ENABLE_PROFILER
+  {
+    const uint32_t irq_state = save_and_disable_interrupts();
+
+    memcpy(out_snapshot->probes, g_probes, sizeof(g_probes));
+    restore_interrupts(irq_state);
+    out_snapshot->enabled = true;
+    out_snapshot->cycle_counter = g_cycle_counter;
+  }
+#endif
+}
+
+void sys_profiler_reset(void) {
+#if APP_ENABLE_PROFILER
+  size_t index = 0u;
+
+  for (index = 0u; index < SYS_PROFILE_PROBE_COUNT; ++index) {
+    const uint32_t irq_state = save_and_disable_interrupts();
+
+    sys_histogram_clear(&g_probes[index]);
+    restore_interrupts(irq_state);
+  }
+#endif
+}
+
+const char *sys_profiler_probe_name(sys_profile_probe_t probe) {
+  switch (probe) {
+  case SYS_PROFILE_CONTROL_STEP:
+    return "control_step";
+  case SYS_PROFILE_METRICS_UPDATE:
+    return "metrics_update";
+  case SYS_PROFILE_ADP910_READ:
+    return "adp910_read";
+  case SYS_PROFILE_STATUS_JSON:
+    return "status_json";
+  case SYS_PROFILE_ZERO_CROSS_ISR:
+    return "zero_cross_isr";
+  default:
+    return "unknown";
+  }
+}
+
+void sys_profiler_print(void) {
+  static sys_profiler_snapshot_t snapshot;
+  float cycles_per_us = 0.0f;
+  size_t index = 0u;
+
+  sys_profiler_get_snapshot(&snapshot);
+  if (!snapshot.enabled || snapshot.cpu_hz == 0u) {
+    return;
+  }
+  cycles_per_us = (float)snapshot.cpu_hz / 1000000.0f;
+
+  for (index = 0u; index < SYS_PROFILE_PROBE_COUNT; ++index) {
+    const sys_histogram_t *stats = &snapshot.probes[index];
+
+    if (stats->count == 0u) {
+      continue;
+    }
+    SYS_LOG(SYS_LOG_PROFILER_PROBE,
+            SYS_LOG_STR(sys_profiler_probe_name((sys_profile_probe_t)index)),
+            SYS_LOG_U32(stats->count),
+            SYS_LOG_F32((float)stats->min / cycles_per_us),
+            SYS_LOG_F32((float)sys_histogram_mean(stats) / cycles_per_us),
+            SYS_LOG_F32((float)sys_histogram_percentile(stats, 0.5f) /
+                        cycles_per_us),
+            SYS_LOG_F32((float)sys_histogram_percentile(stats, 0.99f) /
+                        cycles_per_us),
+            SYS_LOG_F32((float)stats->max / cycles_per_us));
+  }
+}
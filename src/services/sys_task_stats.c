@@ -0,0 +1,237 @@
+#include "services/sys_task_stats.h"
+
+#include "app/app_config.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stddef.h>
+#include <string.h>
+
+typedef struct {
+  const char *name;
+  uint32_t stack_words;
+} sys_task_stats_stack_size_t;
+
+/* Stacks this firmware asks for; SDK and lwIP tasks are reported as 0. */
+static const sys_task_stats_stack_size_t k_stack_sizes[] = {
+    {"WiFiTask", APP_WIFI_TASK_STACK_WORDS},
+    {"DimmerTask", APP_DIMMER_TASK_STACK_WORDS},
+    {"ADP910Task", APP_ADP910_TASK_STACK_WORDS},
+    {"LogTask", APP_LOG_TASK_STACK_WORDS},
+    {"WatchdogTask", APP_WATCHDOG_TASK_STACK_WORDS},
+    {"SSETask", APP_SSE_TASK_STACK_WORDS},
+    {"OTAApplyTask", APP_OTA_APPLY_TASK_STACK_WORDS},
+    {"Tmr Svc", configTIMER_TASK_STACK_DEPTH},
+};
+
+static TaskStatus_t g_task_status[SYS_TASK_STATS_MAX_TASKS];
+static uint32_t g_previous_numbers[SYS_TASK_STATS_MAX_TASKS];
+static uint32_t g_previous_run_time_us[SYS_TASK_STATS_MAX_TASKS];
+static uint32_t g_previous_count;
+static uint32_t g_previous_total_us;
+
+/* 64-bit run time per live task; rebuilt from the task list each fold. */
+typedef struct {
+  uint32_t count;
+  uint32_t numbers[SYS_TASK_STATS_MAX_TASKS];
+  uint32_t last_run_time_us[SYS_TASK_STATS_MAX_TASKS];
+  uint64_t total_run_time_us[SYS_TASK_STATS_MAX_TASKS];
+} sys_task_stats_totals_t;
+
+static sys_task_stats_totals_t g_totals[2];
+static uint8_t g_totals_current;
+
+static uint32_t sys_task_stats_stack_size(const char *name, bool idle) {
+  size_t index = 0u;
+
+  if (idle) {
+    return configMINIMAL_STACK_SIZE;
+  }
+  for (index = 0u; index < sizeof(k_stack_sizes) / sizeof(k_stack_sizes[0]);
+       ++index) {
+    if (strcmp(name, k_stack_sizes[index].name) == 0) {
+      return k_stack_sizes[index].stack_words;
+    }
+  }
+  return 0u;
+}
+
+/* Run time the task had at the previous snapshot; 0 for a new task. */
+static uint32_t sys_task_stats_previous_run_time(uint32_t number) {
+  uint32_t index = 0u;
+
+  for (index = 0u; index < g_previous_count; ++index) {
+    if (g_previous_numbers[index] == number) {
+      return g_previous_run_time_us[index];
+    }
+  }
+  return 0u;
+}
+
+/*
+ * Adds each task's counter delta since the last fold to its total. A task
+ * not seen before starts from its raw counter, which has not wrapped yet
+ * as long as folds run more often than the wrap; ended tasks drop out.
+ */
+static void sys_task_stats_fold_totals(uint32_t count) {
+  const sys_task_stats_totals_t *previous = &g_totals[g_totals_current];
+  sys_task_stats_totals_t *next = &g_totals[g_totals_current ^ 1u];
+  uint32_t index = 0u;
+
+  /* A failed system-state read lists no tasks; keep the totals. */
+  if (count == 0u) {
+    return;
+  }
+
+  for (index = 0u; index < count; ++index) {
+    const uint32_t number = (uint32_t)g_task_status[index].xTaskNumber;
+    const uint32_t run_time_us =
+        (uint32_t)g_task_status[index].ulRunTimeCounter;
+    uint64_t total_us = run_time_us;
+    uint32_t slot = 0u;
+
+    for (slot = 0u; slot < previous->count; ++slot) {
+      if (previous->numbers[slot] == number) {
+        total_us = previous->total_run_time_us[slot] +
+                   (uint32_t)(run_time_us - previous->last_run_time_us[slot]);
+        break;
+      }
+    }
+    next->numbers[index] = number;
+    next->last_run_time_us[index] = run_time_us;
+    next->total_run_time_us[index] = total_us;
+  }
+  next->count = count;
+  g_totals_current ^= 1u;
+}
+
+static uint16_t sys_task_stats_permille(uint32_t part, uint32_t whole) {
+  uint64_t permille = 0u;
+
+  if (whole == 0u) {
+    return 0u;
+  }
+  permille = ((uint64_t)part * 1000u) / whole;
+  return permille > 1000u ? 1000u : (uint16_t)permille;
+}
+
+static void sys_task_stats_collect_heap(sys_task_stats_heap_t *out_heap) {
+  HeapStats_t heap_stats;
+
+  memset(&heap_stats, 0, sizeof(heap_stats));
+  vPortGetHeapStats(&heap_stats);
+
+  *out_heap = (sys_task_stats_heap_t){
+      .total_bytes = (uint32_t)configTOTAL_HEAP_SIZE,
+      .free_bytes = (uint32_t)heap_stats.xAvailableHeapSpaceInBytes,
+      .min_ever_free_bytes =
+          (uint32_t)heap_stats.xMinimumEverFreeBytesRemaining,
+      .largest_free_block_bytes =
+          (uint32_t)heap_stats.xSizeOfLargestFreeBlockInBytes,
+      .smallest_free_block_bytes =
+          (uint32_t)heap_stats.xSizeOfSmallestFreeBlockInBytes,
+      .free_blocks = (uint32_t)heap_stats.xNumberOfFreeBlocks,
+      .allocations = (uint32_t)heap_stats.xNumberOfSuccessfulAllocations,
+      .frees = (uint32_t)heap_stats.xNumberOfSuccessfulFrees,
+  };
+  if (out_heap->free_bytes > 0u) {
+    out_heap->fragmentation_permille =
+        1000u - sys_task_stats_permille(out_heap->largest_free_block_bytes,
+                                        out_heap->free_bytes);
+  }
+}
+
+static void sys_task_stats_fill(sys_task_stats_snapshot_t *out_snapshot,
+                                bool start_window) {
+  const TaskHandle_t idle_handle = xTaskGetIdleTaskHandle();
+  uint32_t total_us = 0u;
+  uint32_t idle_us = 0u;
+  uint32_t count = 0u;
+  uint32_t index = 0u;
+
+  if (out_snapshot == NULL) {
+    return;
+  }
+  memset(out_snapshot, 0, sizeof(*out_snapshot));
+
+  /* Fails as a whole (returns 0) when the array is too small. */
+  count = (uint32_t)uxTaskGetSystemState(
+      g_task_status, SYS_TASK_STATS_MAX_TASKS, &total_us);
+  out_snapshot->truncated =
+      uxTaskGetNumberOfTasks() > SYS_TASK_STATS_MAX_TASKS;
+  out_snapshot->window_us = total_us - g_previous_total_us;
+  sys_task_stats_fold_totals(count);
+
+  for (index = 0u; index < count; ++index) {
+    const TaskStatus_t *status = &g_task_status[index];
+    sys_task_stats_task_t *task = &out_snapshot->tasks[index];
+    const uint32_t run_time_us = (uint32_t)status->ulRunTimeCounter;
+    const uint32_t window_run_us =
+        run_time_us -
+        sys_task_stats_previous_run_time((uint32_t)status->xTaskNumber);
+
+    task->idle = status->xHandle == idle_handle;
+    strncpy(task->name, status->pcTaskName, sizeof(task->name) - 1u);
+    task->number = (uint32_t)status->xTaskNumber;
+    task->state = (uint8_t)status->eCurrentState;
+    task->priority = (uint8_t)status->uxCurrentPriority;
+    task->base_priority = (uint8_t)status->uxBasePriority;
+    task->stack_size_words =
+        sys_task_stats_stack_size(task->name, task->idle);
+    task->stack_high_water_words = (uint32_t)status->usStackHighWaterMark;
+    task->run_time_us = run_time_us;
+    task->total_run_time_us =
+        g_totals[g_totals_current].total_run_time_us[index];
+    task->cpu_permille =
+        sys_task_stats_permille(window_run_us, out_snapshot->window_us);
+    if (task->idle) {
+      idle_us = window_run_us;
+    }
+  }
+
+  out_snapshot->task_count = count;
+  out_snapshot->cpu_load_permille =
+      1000u - sys_task_stats_permille(idle_us, out_snapshot->window_us);
+  sys_task_stats_collect_heap(&out_snapshot->heap);
+
+  if (!start_window) {
+    return;
+  }
+  for (index = 0u; index < count; ++index) {
+    g_previous_numbers[index] = out_snapshot->tasks[index].number;
+    g_previous_run_time_us[index] = out_snapshot->tasks[index].run_time_us;
+  }
+  g_previous_count = count;
+  g_previous_total_us = total_us;
+}
+
+void sys_task_stats_collect(sys_task_stats_snapshot_t *out_snapshot) {
+  sys_task_stats_fill(out_snapshot, true);
+}
+
+void sys_task_stats_read(sys_task_stats_snapshot_t *out_snapshot) {
+  sys_task_stats_fill(out_snapshot, false);
+}
+
+void sys_task_stats_refresh(void) {
+  uint32_t total_us = 0u;
+
+  sys_task_stats_fold_totals((uint32_t)uxTaskGetSystemState(
+      g_task_status, SYS_TASK_STATS_MAX_TASKS, &total_us));
+}
+
+const char *sys_task_stats_state_name(uint8_t state) {
+  switch ((eTaskState)state) {
+  case eRunning:
+    return "running";
+  case eReady:
+    return "ready";
+  case eBlocked:
+    return "blocked";
+  case eSuspended:
+    return "suspended";
+  case eDeleted:
+    return "deleted";
+  default:
+    return "invalid";
+  }
+}
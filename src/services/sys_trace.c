@@ -0,0 +1,180 @@
+#include "services/sys_trace.h"
+
+#include "FreeRTOS.h"
+#include "hardware/timer.h"
+#include "task.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Longest wait for writers still inside sys_trace_record on a freeze. */
+#define SYS_TRACE_FREEZE_WAIT_TICKS 10u
+
+_Static_assert(sizeof(sys_trace_event_t) == 8u,
+               "trace records are 8 bytes on the wire");
+_Static_assert((APP_TRACE_BUFFER_EVENTS &
+                (APP_TRACE_BUFFER_EVENTS - 1u)) == 0u,
+               "APP_TRACE_BUFFER_EVENTS must be a power of two");
+
+#if APP_ENABLE_TRACE
+static struct {
+  /* Slots claimed since the last reset; the ring index is head % size. */
+  atomic_uint head;
+  /* Writers between the frozen check and the end of their slot write. */
+  atomic_uint in_flight;
+  atomic_bool frozen;
+  atomic_uint missed;
+  sys_trace_event_t events[APP_TRACE_BUFFER_EVENTS];
+} g_trace;
+
+/* Guarded by task critical sections; traceTASK_CREATE runs inside one. */
+static struct {
+  uint32_t count;
+  uint32_t next;
+  /* Last task number handed out; 0 is never assigned. */
+  uint32_t last_number;
+  sys_trace_task_t tasks[SYS_TRACE_MAX_TASKS];
+} g_trace_tasks;
+
+void sys_trace_record(sys_trace_type_t type, uint8_t id, uint16_t payload) {
+  unsigned int slot = 0u;
+
+  atomic_fetch_add_explicit(&g_trace.in_flight, 1u, memory_order_acq_rel);
+  if (atomic_load_explicit(&g_trace.frozen, memory_order_acquire)) {
+    atomic_fetch_add_explicit(&g_trace.missed, 1u, memory_order_relaxed);
+  } else {
+    slot = atomic_fetch_add_explicit(&g_trace.head, 1u,
+                                     memory_order_relaxed) &
+           (APP_TRACE_BUFFER_EVENTS - 1u);
+    g_trace.events[slot] = (sys_trace_event_t){
+        .timestamp_us = time_us_32(),
+        .type = (uint8_t)type,
+        .id = id,
+        .payload = payload,
+    };
+  }
+  atomic_fetch_sub_explicit(&g_trace.in_flight, 1u, memory_order_release);
+}
+
+static void sys_trace_stop_writers(void) {
+  uint32_t wait_ticks = 0u;
+
+  atomic_store_explicit(&g_trace.frozen, true, memory_order_seq_cst);
+  /* A lower-priority writer may have been preempted mid-slot. */
+  while (atomic_load_explicit(&g_trace.in_flight, memory_order_acquire) !=
+             0u &&
+         wait_ticks < SYS_TRACE_FREEZE_WAIT_TICKS) {
+    vTaskDelay(1);
+    wait_ticks += 1u;
+  }
+}
+#endif
+
+void sys_trace_task_switched_in(void) {
+#if APP_ENABLE_TRACE
+  sys_trace_record(SYS_TRACE_TYPE_TASK_SWITCH, 0u,
+                   (uint16_t)uxTaskGetTaskNumber(xTaskGetCurrentTaskHandle()));
+#endif
+}
+
+void sys_trace_task_created(void *task) {
+#if APP_ENABLE_TRACE
+  const TaskHandle_t handle = (TaskHandle_t)task;
+  sys_trace_task_t *entry = &g_trace_tasks.tasks[g_trace_tasks.next];
+
+  /*
+   * FreeRTOS leaves every task number at 0, so hand out our own; the
+   * switch hook reads it back through uxTaskGetTaskNumber.
+   */
+  g_trace_tasks.last_number += 1u;
+  vTaskSetTaskNumber(handle, (UBaseType_t)g_trace_tasks.last_number);
+
+  /* Oldest name goes first when full; its events are likely gone too. */
+  entry->number = g_trace_tasks.last_number;
+  (void)strncpy(entry->name, pcTaskGetName(handle), sizeof(entry->name) - 1u);
+  entry->name[sizeof(entry->name) - 1u] = '\0';
+  g_trace_tasks.next = (g_trace_tasks.next + 1u) % SYS_TRACE_MAX_TASKS;
+  if (g_trace_tasks.count < SYS_TRACE_MAX_TASKS) {
+    g_trace_tasks.count += 1u;
+  }
+#else
+  (void)task;
+#endif
+}
+
+void sys_trace_freeze(sys_trace_dump_t *out_dump) {
+  if (out_dump == NULL) {
+    return;
+  }
+  memset(out_dump, 0, sizeof(*out_dump));
+
+#if APP_ENABLE_TRACE
+  uint32_t head = 0u;
+  uint32_t count = 0u;
+  uint32_t first = 0u;
+
+  sys_trace_stop_writers();
+  head = atomic_load_explicit(&g_trace.head, memory_order_acquire);
+  count = head < APP_TRACE_BUFFER_EVENTS ? head : APP_TRACE_BUFFER_EVENTS;
+  first = (head - count) & (APP_TRACE_BUFFER_EVENTS - 1u);
+
+  out_dump->enabled = true;
+  out_dump->now_us = time_us_32();
+  out_dump->overwritten = head - count;
+  out_dump->missed =
+      atomic_load_explicit(&g_trace.missed, memory_order_relaxed);
+  out_dump->segments[0] = &g_trace.events[first];
+  out_dump->segment_counts[0] = APP_TRACE_BUFFER_EVENTS - first < count
+                                    ? APP_TRACE_BUFFER_EVENTS - first
+                                    : count;
+  out_dump->segments[1] = g_trace.events;
+  out_dump->segment_counts[1] = count - out_dump->segment_counts[0];
+
+  taskENTER_CRITICAL();
+  out_dump->task_count = g_trace_tasks.count;
+  memcpy(out_dump->tasks, g_trace_tasks.tasks, sizeof(out_dump->tasks));
+  taskEXIT_CRITICAL();
+#endif
+}
+
+void sys_trace_thaw(void) {
+#if APP_ENABLE_TRACE
+  atomic_store_explicit(&g_trace.frozen, false, memory_order_seq_cst);
+#endif
+}
+
+uint32_t sys_trace_copy_recent(sys_trace_event_t *out_events,
+                               uint32_t max_events) {
+#if APP_ENABLE_TRACE
+  const uint32_t head =
+      atomic_load_explicit(&g_trace.head, memory_order_acquire);
+  uint32_t count = head < APP_TRACE_BUFFER_EVENTS ? head
+                                                  : APP_TRACE_BUFFER_EVENTS;
+  uint32_t index = 0u;
+
+  if (out_events == NULL) {
+    return 0u;
+  }
+  if (count > max_events) {
+    count = max_events;
+  }
+  for (index = 0u; index < count; ++index) {
+    out_events[index] =
+        g_trace.events[(head - count + index) & (APP_TRACE_BUFFER_EVENTS - 1u)];
+  }
+  return count;
+#else
+  (void)out_events;
+  (void)max_events;
+  return 0u;
+#endif
+}
+
+void sys_trace_reset(void) {
+#if APP_ENABLE_TRACE
+  sys_trace_stop_writers();
+  atomic_store_explicit(&g_trace.head, 0u, memory_order_relaxed);
+  atomic_store_explicit(&g_trace.missed, 0u, memory_order_relaxed);
+  sys_trace_thaw();
+#endif
+}
@@ -0,0 +1,206 @@
+#include "services/sys_watchdog.h"
+
+#include "app/app_config.h"
+#include "FreeRTOS.h"
+#include "hardware/watchdog.h"
+#include "pico/stdlib.h"
+#include "services/dimmer_control.h"
+#include "services/sys_crash.h"
+#include "task.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SYS_WATCHDOG_HISTORY_MAGIC 0x57444f47u
+
+/* Written by the owning task (beats) and read by the supervisor. */
+typedef struct {
+  const char *name;
+  uint32_t deadline_ms;
+  atomic_bool registered;
+  atomic_uint last_beat_ms;
+  atomic_uint max_gap_ms;
+} sys_watchdog_slot_state_t;
+
+/* Miss counts since power-on, kept across the resets they cause. */
+typedef struct {
+  uint32_t magic;
+  uint32_t trips;
+  uint32_t deadline_misses[SYS_WATCHDOG_SLOT_COUNT];
+} sys_watchdog_history_t;
+
+static sys_watchdog_history_t __uninitialized_ram(g_watchdog_history);
+static sys_watchdog_slot_state_t g_watchdog_slots[SYS_WATCHDOG_SLOT_COUNT];
+static bool g_watchdog_reset_by_watchdog = false;
+static atomic_bool g_watchdog_running = false;
+static atomic_bool g_watchdog_tripped = false;
+static atomic_bool g_watchdog_released = false;
+static atomic_uint g_watchdog_feeds = 0u;
+
+static uint32_t sys_watchdog_now_ms(void) {
+  return (uint32_t)xTaskGetTickCount() * (uint32_t)portTICK_PERIOD_MS;
+}
+
+static void sys_watchdog_trip(sys_watchdog_slot_t slot, uint32_t age_ms) {
+  const sys_watchdog_slot_state_t *state = &g_watchdog_slots[slot];
+  char message[SYS_CRASH_TEXT_LEN];
+
+  /* Gate first: nothing below may leave the fan running. */
+  dimmer_control_force_off();
+  atomic_store_explicit(&g_watchdog_tripped, true, memory_order_relaxed);
+  g_watchdog_history.deadline_misses[slot] += 1u;
+  g_watchdog_history.trips += 1u;
+
+  snprintf(message, sizeof(message), "%s silent %lums",
+           state->name != NULL ? state->name : "?", (unsigned long)age_ms);
+  sys_crash_capture(SYS_CRASH_WATCHDOG, NULL, 0u, message);
+  printf("[WDT] %s missed its %lums heartbeat deadline; gate off, reset in "
+         "%lums\n",
+         state->name != NULL ? state->name : "?",
+         (unsigned long)state->deadline_ms,
+         (unsigned long)APP_WATCHDOG_TIMEOUT_MS);
+}
+
+void sys_watchdog_init(void) {
+  g_watchdog_reset_by_watchdog = watchdog_caused_reboot();
+  if (!g_watchdog_reset_by_watchdog ||
+      g_watchdog_history.magic != SYS_WATCHDOG_HISTORY_MAGIC) {
+    memset(&g_watchdog_history, 0, sizeof(g_watchdog_history));
+    g_watchdog_history.magic = SYS_WATCHDOG_HISTORY_MAGIC;
+  }
+}
+
+void sys_watchdog_register(sys_watchdog_slot_t slot, const char *name,
+                           uint32_t deadline_ms) {
+  sys_watchdog_slot_state_t *state = NULL;
+
+  if (slot >= SYS_WATCHDOG_SLOT_COUNT) {
+    return;
+  }
+
+  state = &g_watchdog_slots[slot];
+  state->name = name;
+  state->deadline_ms = deadline_ms;
+  atomic_store_explicit(&state->last_beat_ms, sys_watchdog_now_ms(),
+                        memory_order_relaxed);
+  atomic_store_explicit(&state->max_gap_ms, 0u, memory_order_relaxed);
+  atomic_store_explicit(&state->registered, deadline_ms > 0u,
+                        memory_order_release);
+}
+
+void sys_watchdog_unregister(sys_watchdog_slot_t slot) {
+  if (slot >= SYS_WATCHDOG_SLOT_COUNT) {
+    return;
+  }
+  atomic_store_explicit(&g_watchdog_slots[slot].registered, false,
+                        memory_order_release);
+}
+
+void sys_watchdog_heartbeat(sys_watchdog_slot_t slot) {
+  sys_watchdog_slot_state_t *state = NULL;
+  uint32_t now_ms = 0u;
+  uint32_t gap_ms = 0u;
+
+  if (slot >= SYS_WATCHDOG_SLOT_COUNT) {
+    return;
+  }
+
+  state = &g_watchdog_slots[slot];
+  now_ms = sys_watchdog_now_ms();
+  gap_ms = now_ms - atomic_load_explicit(&state->last_beat_ms,
+                                         memory_order_relaxed);
+  if (gap_ms > atomic_load_explicit(&state->max_gap_ms,
+                                    memory_order_relaxed)) {
+    atomic_store_explicit(&state->max_gap_ms, gap_ms, memory_order_relaxed);
+  }
+  atomic_store_explicit(&state->last_beat_ms, now_ms, memory_order_release);
+}
+
+void sys_watchdog_start(void) {
+  if (atomic_load_explicit(&g_watchdog_released, memory_order_acquire)) {
+    return;
+  }
+  /* Paused while a debugger halts the cores. */
+  watchdog_enable(APP_WATCHDOG_TIMEOUT_MS, true);
+  atomic_store_explicit(&g_watchdog_running, true, memory_order_release);
+}
+
+bool sys_watchdog_poll(void) {
+  size_t index = 0u;
+
+  if (!atomic_load_explicit(&g_watchdog_running, memory_order_acquire) ||
+      atomic_load_explicit(&g_watchdog_released, memory_order_acquire) ||
+      atomic_load_explicit(&g_watchdog_tripped, memory_order_relaxed)) {
+    return false;
+  }
+
+  for (index = 0u; index < SYS_WATCHDOG_SLOT_COUNT; ++index) {
+    sys_watchdog_slot_state_t *state = &g_watchdog_slots[index];
+    uint32_t last_beat_ms = 0u;
+    uint32_t age_ms = 0u;
+
+    if (!atomic_load_explicit(&state->registered, memory_order_acquire)) {
+      continue;
+    }
+    /* Beat read before the clock, so a fresh beat never looks negative. */
+    last_beat_ms =
+        atomic_load_explicit(&state->last_beat_ms, memory_order_acquire);
+    age_ms = sys_watchdog_now_ms() - last_beat_ms;
+    if (age_ms > state->deadline_ms) {
+      sys_watchdog_trip((sys_watchdog_slot_t)index, age_ms);
+      return false;
+    }
+  }
+
+  watchdog_update();
+  atomic_fetch_add_explicit(&g_watchdog_feeds, 1u, memory_order_relaxed);
+  return true;
+}
+
+void sys_watchdog_release(void) {
+  atomic_store_explicit(&g_watchdog_released, true, memory_order_release);
+  watchdog_disable();
+}
+
+void sys_watchdog_get_snapshot(sys_watchdog_snapshot_t *out_snapshot) {
+  const uint32_t now_ms = sys_watchdog_now_ms();
+  size_t index = 0u;
+
+  if (out_snapshot == NULL) {
+    return;
+  }
+
+  *out_snapshot = (sys_watchdog_snapshot_t){
+      .running =
+          atomic_load_explicit(&g_watchdog_running, memory_order_acquire),
+      .tripped =
+          atomic_load_explicit(&g_watchdog_tripped, memory_order_relaxed),
+      .released =
+          atomic_load_explicit(&g_watchdog_released, memory_order_acquire),
+      .reset_by_watchdog = g_watchdog_reset_by_watchdog,
+      .timeout_ms = APP_WATCHDOG_TIMEOUT_MS,
+      .check_period_ms = APP_WATCHDOG_CHECK_PERIOD_MS,
+      .feeds = atomic_load_explicit(&g_watchdog_feeds, memory_order_relaxed),
+      .trips = g_watchdog_history.trips,
+  };
+
+  for (index = 0u; index < SYS_WATCHDOG_SLOT_COUNT; ++index) {
+    sys_watchdog_slot_state_t *state = &g_watchdog_slots[index];
+    const uint32_t last_beat_ms =
+        atomic_load_explicit(&state->last_beat_ms, memory_order_acquire);
+
+    out_snapshot->tasks[index] = (sys_watchdog_task_snapshot_t){
+        .name = state->name,
+        .registered =
+            atomic_load_explicit(&state->registered, memory_order_acquire),
+        .deadline_ms = state->deadline_ms,
+        .last_beat_age_ms =
+            (int32_t)(now_ms - last_beat_ms) > 0 ? now_ms - last_beat_ms
+                                                 : 0u,
+        .max_gap_ms =
+            atomic_load_explicit(&state->max_gap_ms, memory_order_relaxed),
+        .deadline_misses = g_watchdog_history.deadline_misses[index],
+    };
+  }
+}
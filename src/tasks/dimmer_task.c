@@ -8,7 +8,13 @@
 #include "pico/stdlib.h"
 #include "services/blower_control.h"
 #include "services/blower_metrics.h"
+#include "services/blower_test_service.h"
 #include "services/dimmer_control.h"
+#include "services/dimmer_timing.h"
+#include "services/sys_latency.h"
+#include "services/sys_profiler.h"
+#include "services/sys_trace.h"
+#include "services/sys_watchdog.h"
 #include "task.h"
 #include <math.h>
 #include <stdint.h>
@@ -20,14 +26,17 @@ static volatile uint32_t g_last_zero_cross_us = 0u;
 static volatile uint32_t g_zero_cross_period_us = 0u;
 
 static bool dimmer_pick_control_pressure(
-    const blower_metrics_snapshot_t *snapshot, float *out_pressure_pa) {
-  if (snapshot == NULL || out_pressure_pa == NULL) {
+    const blower_metrics_snapshot_t *snapshot, float *out_pressure_pa,
+    uint32_t *out_sample_time_us) {
+  if (snapshot == NULL || out_pressure_pa == NULL ||
+      out_sample_time_us == NULL) {
     return false;
   }
 
 #if APP_CONTROL_PRESSURE_SOURCE_MODE == APP_CONTROL_PRESSURE_SOURCE_FAN
   if (snapshot->fan_sample_valid) {
     *out_pressure_pa = snapshot->fan_pressure_pa;
+    *out_sample_time_us = snapshot->fan_sample_time_us;
     return true;
   }
   return false;
@@ -36,23 +45,28 @@ static bool dimmer_pick_control_pressure(
     if (fabsf(snapshot->fan_pressure_pa) <=
         fabsf(snapshot->envelope_pressure_pa)) {
       *out_pressure_pa = snapshot->fan_pressure_pa;
+      *out_sample_time_us = snapshot->fan_sample_time_us;
     } else {
       *out_pressure_pa = snapshot->envelope_pressure_pa;
+      *out_sample_time_us = snapshot->envelope_sample_time_us;
     }
     return true;
   }
   if (snapshot->envelope_sample_valid) {
     *out_pressure_pa = snapshot->envelope_pressure_pa;
+    *out_sample_time_us = snapshot->envelope_sample_time_us;
     return true;
   }
   if (snapshot->fan_sample_valid) {
     *out_pressure_pa = snapshot->fan_pressure_pa;
+    *out_sample_time_us = snapshot->fan_sample_time_us;
     return true;
   }
   return false;
 #else
   if (snapshot->envelope_sample_valid) {
     *out_pressure_pa = snapshot->envelope_pressure_pa;
+    *out_sample_time_us = snapshot->envelope_sample_time_us;
     return true;
   }
   return false;
@@ -61,15 +75,25 @@ static bool dimmer_pick_control_pressure(
 
 static int64_t dimmer_gate_pulse_alarm_callback(alarm_id_t alarm_id,
                                                 void *user_data) {
-  gpio_put(APP_DIMMER_GATE_PIN, 1);
-  busy_wait_us(DIMMER_GATE_PULSE_US);
-  gpio_put(APP_DIMMER_GATE_PIN, 0);
+  const uint32_t entry_us = time_us_32();
+
+  SYS_TRACE_ISR_ENTER(SYS_TRACE_ISR_GATE_ALARM);
+  /* Power dropped to 0 since scheduling (e.g. forced off): no pulse. */
+  if (dimmer_control_get_power_percent() > 0u) {
+    gpio_put(APP_DIMMER_GATE_PIN, 1);
+    sys_latency_trace_gate();
+    busy_wait_us(DIMMER_GATE_PULSE_US);
+    gpio_put(APP_DIMMER_GATE_PIN, 0);
+    /* user_data carries the time_us_32() the pulse was scheduled for. */
+    dimmer_timing_record_gate((uint32_t)(uintptr_t)user_data, entry_us);
+  }
+  SYS_TRACE_ISR_EXIT(SYS_TRACE_ISR_GATE_ALARM);
   (void)alarm_id;
-  (void)user_data;
   return 0;
 }
 
 static void dimmer_zero_crossing_callback(uint gpio, uint32_t events) {
+  SYS_PROFILE_BEGIN(SYS_PROFILE_ZERO_CROSS_ISR);
   const uint32_t now_us = time_us_32();
   const uint8_t power_percent = dimmer_control_get_power_percent();
   (void)events;
@@ -77,20 +101,28 @@ static void dimmer_zero_crossing_callback(uint gpio, uint32_t events) {
   if (gpio != APP_DIMMER_ZERO_CROSS_PIN) {
     return;
   }
+  SYS_TRACE_ISR_ENTER(SYS_TRACE_ISR_ZERO_CROSS);
 
   if (g_last_zero_cross_us != 0u) {
     g_zero_cross_period_us = now_us - g_last_zero_cross_us;
   }
   g_last_zero_cross_us = now_us;
+  dimmer_timing_record_zero_cross(now_us);
 
   if (power_percent > 0u && power_percent < 100u) {
     const uint32_t delay_us = (uint32_t)(100u - power_percent) * 100u;
-    add_alarm_in_us(delay_us, dimmer_gate_pulse_alarm_callback, NULL, false);
+    const uint32_t scheduled_us = time_us_32() + delay_us;
+
+    add_alarm_in_us(delay_us, dimmer_gate_pulse_alarm_callback,
+                    (void *)(uintptr_t)scheduled_us, false);
   } else if (power_percent >= 100u) {
     gpio_put(APP_DIMMER_GATE_PIN, 1);
+    sys_latency_trace_gate();
   } else {
     gpio_put(APP_DIMMER_GATE_PIN, 0);
   }
+  SYS_TRACE_ISR_EXIT(SYS_TRACE_ISR_ZERO_CROSS);
+  SYS_PROFILE_END(SYS_PROFILE_ZERO_CROSS_ISR);
 }
 
 static void dimmer_update_line_feedback(void) {
@@ -117,9 +149,12 @@ static void dimmer_update_line_feedback(void) {
 
 void dimmer_task_entry(void *params) {
   TickType_t next_wake_tick = xTaskGetTickCount();
+  uint32_t last_test_sequence = 0u;
+  uint32_t last_traced_sequence = 0u;
   (void)params;
 
   blower_control_initialize();
+  blower_test_service_init();
   dimmer_control_set_power_percent(0u);
 
   gpio_init(APP_DIMMER_ZERO_CROSS_PIN);
@@ -136,20 +171,55 @@ void dimmer_task_entry(void *params) {
   while (1) {
     blower_metrics_snapshot_t metrics_snapshot = {0};
     float control_pressure_pa = 0.0f;
+    uint32_t control_sample_time_us = 0u;
     const uint32_t now_ms =
         (uint32_t)xTaskGetTickCount() * (uint32_t)portTICK_PERIOD_MS;
     const bool has_snapshot =
         blower_metrics_service_get_snapshot(&metrics_snapshot);
     const bool control_pressure_valid =
         has_snapshot &&
-        dimmer_pick_control_pressure(&metrics_snapshot, &control_pressure_pa);
+        dimmer_pick_control_pressure(&metrics_snapshot, &control_pressure_pa,
+                                     &control_sample_time_us);
+    SYS_TRACE_SPAN_BEGIN(SYS_TRACE_SPAN_CONTROL_STEP);
+    SYS_PROFILE_BEGIN(SYS_PROFILE_CONTROL_STEP);
     const uint8_t control_output_percent = blower_control_step(
         control_pressure_valid ? control_pressure_pa : 0.0f,
         control_pressure_valid, now_ms);
+    SYS_PROFILE_END(SYS_PROFILE_CONTROL_STEP);
+    SYS_TRACE_SPAN_END(SYS_TRACE_SPAN_CONTROL_STEP);
+
+    blower_control_snapshot_t control_snapshot = {0};
 
     dimmer_control_set_power_percent(control_output_percent);
+    SYS_TRACE_INSTANT(SYS_TRACE_INSTANT_POWER_COMMAND, control_output_percent);
+    /* Trace each sample once, to the first command computed from it. */
+    if (control_pressure_valid &&
+        metrics_snapshot.update_sequence != last_traced_sequence) {
+      last_traced_sequence = metrics_snapshot.update_sequence;
+      sys_latency_trace_command(control_sample_time_us,
+                                control_output_percent);
+    }
     dimmer_update_line_feedback();
 
+    blower_control_get_snapshot(&control_snapshot);
+    /* A sample refused on a busy test mutex is offered again next cycle. */
+    if (has_snapshot &&
+        metrics_snapshot.update_sequence != last_test_sequence &&
+        blower_test_service_update(&metrics_snapshot, &control_snapshot,
+                                   now_ms)) {
+      last_test_sequence = metrics_snapshot.update_sequence;
+    }
+
+    {
+      /* The ISR may still fire gate pulses until the power reads 0. */
+      const bool fan_running = control_snapshot.relay_enabled ||
+                               dimmer_control_get_power_percent() > 0u;
+
+      blower_control_persist_pending(fan_running);
+      blower_test_service_persist_pending(fan_running);
+    }
+
+    sys_watchdog_heartbeat(SYS_WATCHDOG_SLOT_DIMMER);
     vTaskDelayUntil(&next_wake_tick,
                     pdMS_TO_TICKS(APP_CONTROL_LOOP_PERIOD_MS));
   }
@@ -0,0 +1,38 @@
+#include "tasks/task_entries.h"
+
+#include "app/app_config.h"
+#include "FreeRTOS.h"
+#include "services/sys_log.h"
+#include "services/sys_watchdog.h"
+#include "task.h"
+#include <stdint.h>
+#include <stdio.h>
+
+void log_task_entry(void *params) {
+  static sys_log_record_t record;
+  static char line[SYS_LOG_LINE_MAX];
+  uint32_t reported_dropped = 0u;
+  (void)params;
+
+  while (1) {
+    const uint32_t dropped = sys_log_dropped();
+    uint32_t drained = 0u;
+
+    /*
+     * printf blocks on stdout, so beat per record and leave a backlog for
+     * the next pass rather than starving the deadline behind a full ring.
+     */
+    while (drained < APP_LOG_DRAIN_MAX_RECORDS && sys_log_read(&record)) {
+      (void)sys_log_format(&record, line, sizeof(line));
+      printf("%s\n", line);
+      sys_watchdog_heartbeat(SYS_WATCHDOG_SLOT_LOG);
+      drained += 1u;
+    }
+    if (dropped != reported_dropped) {
+      printf("[LOG] dropped=%lu\n", (unsigned long)dropped);
+      reported_dropped = dropped;
+    }
+    sys_watchdog_heartbeat(SYS_WATCHDOG_SLOT_LOG);
+    vTaskDelay(pdMS_TO_TICKS(APP_LOG_DRAIN_PERIOD_MS));
+  }
+}
@@ -0,0 +1,19 @@
+#include "tasks/task_entries.h"
+
+#include "app/app_config.h"
+#include "FreeRTOS.h"
+#include "services/sys_watchdog.h"
+#include "task.h"
+
+void watchdog_task_entry(void *params) {
+  TickType_t next_wake_tick = xTaskGetTickCount();
+  (void)params;
+
+  sys_watchdog_start();
+
+  while (1) {
+    (void)sys_watchdog_poll();
+    vTaskDelayUntil(&next_wake_tick,
+                    pdMS_TO_TICKS(APP_WATCHDOG_CHECK_PERIOD_MS));
+  }
+}
@@ -7,13 +7,31 @@
 #include "lwip/ip4_addr.h"
 #include "lwip/netif.h"
 #include "pico/cyw43_arch.h"
+#include "services/adp910_diag.h"
 #include "services/blower_control.h"
+#include "services/blower_control_params.h"
+#include "services/blower_flow_correction.h"
+#include "services/blower_leakage_fit.h"
 #include "services/blower_metrics.h"
+#include "services/blower_report_log.h"
+#include "services/blower_sample_capture.h"
+#include "services/blower_test_service.h"
+#include "services/debug_logs.h"
+#include "services/dimmer_timing.h"
 #include "services/ota_update_service.h"
+#include "services/sys_crash.h"
+#include "services/sys_histogram.h"
+#include "services/sys_latency.h"
+#include "services/sys_log.h"
+#include "services/sys_profiler.h"
+#include "services/sys_task_stats.h"
+#include "services/sys_trace.h"
+#include "services/sys_watchdog.h"
 #include "task.h"
 #include "web/web_assets.h"
 #include <ctype.h>
 #include <math.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -33,19 +51,24 @@
 #define WIFI_CONNECT_TIMEOUT_MS 30000u
 #define WIFI_RETRY_DELAY_MS 1000u
 #define HTTP_SERVER_PORT 80u
+#define HTTP_ACCEPT_TIMEOUT_MS 1000
+#define HTTP_CLIENT_IO_TIMEOUT_MS 5000
 
 #define HTTP_REQUEST_LINE_BUFFER_SIZE 256u
 #define HTTP_REQUEST_BUFFER_SIZE 6144u
 #define HTTP_MAX_BODY_SIZE 4096u
 #define HTTP_RESPONSE_PAYLOAD_BUFFER_SIZE 1024u
 #define HTTP_RESPONSE_CHUNK_SIZE 1024u
+#define HTTP_CONTROL_PARAMS_PAYLOAD_BUFFER_SIZE 2048u
+#define HTTP_TEST_REPORT_PAYLOAD_BUFFER_SIZE 12288u
+#define HTTP_TEST_REPORTS_DEFAULT_LIMIT 10u
+#define HTTP_TEST_REPORTS_MAX_LIMIT 50u
+#define HTTP_TEST_SAMPLES_FLUSH_BYTES 2048u
 
 #define SSE_LOOP_INTERVAL_MS 250u
 #define SSE_FORCE_PUBLISH_INTERVAL_MS 1000u
 #define STATUS_FLOAT_TOLERANCE 0.01f
 
-#define DEBUG_LOG_BUFFER_SIZE 1024u
-#define DEBUG_LOG_TAIL_CHARS 192u
 #define OTA_MAX_DECODED_CHUNK_BYTES 3072u
 
 typedef enum {
@@ -58,6 +81,7 @@ typedef enum {
 typedef struct {
   http_method_t method;
   char path[96];
+  char query[64];
   char body[HTTP_MAX_BODY_SIZE + 1u];
   size_t body_length;
 } http_request_t;
@@ -65,6 +89,7 @@ typedef struct {
 typedef struct {
   uint8_t pwm;
   uint8_t led;
+  uint8_t mode;
   uint8_t relay;
   uint8_t line_sync;
   float frequency_hz;
@@ -91,165 +116,63 @@ typedef struct {
   web_status_snapshot_t last_status;
   bool has_last_status;
   uint32_t last_emit_ms;
+  blower_flow_correction_t flow_correction;
 } sse_stream_context_t;
 
+/* Request classes for /metrics, matched by path prefix. */
+typedef enum {
+  WEB_HTTP_ROUTE_STATUS = 0,
+  WEB_HTTP_ROUTE_CONTROL,
+  WEB_HTTP_ROUTE_TEST,
+  WEB_HTTP_ROUTE_SYS,
+  WEB_HTTP_ROUTE_OTA,
+  WEB_HTTP_ROUTE_EVENTS,
+  WEB_HTTP_ROUTE_DEBUG,
+  WEB_HTTP_ROUTE_METRICS,
+  WEB_HTTP_ROUTE_STATIC,
+  WEB_HTTP_ROUTE_BAD_REQUEST,
+  WEB_HTTP_ROUTE_COUNT,
+} web_http_route_t;
+
+typedef struct {
+  uint32_t requests;
+  /* Accept to close, in microseconds. */
+  sys_histogram_t duration_us;
+} web_http_route_stats_t;
+
+/*
+ * /metrics is streamed: lines are formatted into buffer and sent as one
+ * HTTP chunk whenever the next line would not fit. ok latches false on
+ * the first failed write or oversized line.
+ */
+typedef struct {
+  struct netconn *connection;
+  size_t length;
+  bool ok;
+  char buffer[HTTP_RESPONSE_CHUNK_SIZE];
+} web_metrics_writer_t;
+
 static volatile bool g_sse_active = false;
 static volatile bool g_sse_stop_requested = false;
-#if APP_ENABLE_DEBUG_HTTP_ROUTES
-static volatile bool g_debug_logs_enabled = false;
-static volatile uint32_t g_debug_logs_generation = 0u;
-static char g_debug_log_buffer[DEBUG_LOG_BUFFER_SIZE];
-static size_t g_debug_log_length = 0u;
-#endif
+/* Written by the WiFi task (accepts) and the SSE task (events). */
+static volatile uint32_t g_sse_connections_total = 0u;
+static volatile uint32_t g_sse_rejected_total = 0u;
+static volatile uint32_t g_sse_events_total = 0u;
+/* Only touched by the HTTP server loop. */
+static web_http_route_stats_t g_http_route_stats[WEB_HTTP_ROUTE_COUNT];
+static web_http_route_t g_http_current_route = WEB_HTTP_ROUTE_BAD_REQUEST;
+static web_metrics_writer_t g_metrics_writer;
 static uint8_t g_ota_decoded_chunk_buffer[OTA_MAX_DECODED_CHUNK_BYTES];
+/* Only touched by the HTTP server loop; too large for the task stack. */
+static blower_test_report_t g_test_report_snapshot;
+static char g_test_report_payload[HTTP_TEST_REPORT_PAYLOAD_BUFFER_SIZE];
+/* Density cache of /api/status; the SSE task keeps its own. */
+static blower_flow_correction_t g_status_flow_correction;
 
 static float web_absf(float value) { return value >= 0.0f ? value : -value; }
 
 #define WEB_PITOT_NOISE_FLOOR_PA 0.5f
 
-static float web_task_air_density(float altitude_m, float temperature_c) {
-  const float alt = altitude_m < 0.0f ? 0.0f : (altitude_m > 6000.0f ? 6000.0f : altitude_m);
-  const float p_pa = APP_REFERENCE_PRESSURE_PA * powf(1.0f - 2.25577e-5f * alt, 5.25588f);
-  float t_k = temperature_c + 273.15f;
-  if (t_k < 233.15f) t_k = 233.15f;
-  if (t_k > 353.15f) t_k = 353.15f;
-  return p_pa / (APP_AIR_GAS_CONSTANT * t_k);
-}
-
-static float web_task_pitot_speed_ms(float dp_pa, float air_density) {
-  const float dp_abs = web_absf(dp_pa);
-  if (dp_abs <= 0.0f || air_density <= 0.0f) return 0.0f;
-  return sqrtf(2.0f * dp_abs / air_density);
-}
-
-#if APP_ENABLE_DEBUG_HTTP_ROUTES
-static void debug_logs_clear(void) {
-  const uint32_t irq_state = save_and_disable_interrupts();
-  g_debug_log_length = 0u;
-  g_debug_log_buffer[0] = '\0';
-  g_debug_logs_generation += 1u;
-  restore_interrupts(irq_state);
-}
-
-static void debug_logs_append(const char *line) {
-  size_t line_length = 0u;
-  size_t overflow = 0u;
-  const uint32_t irq_state = save_and_disable_interrupts();
-
-  if (line == NULL || !g_debug_logs_enabled) {
-    restore_interrupts(irq_state);
-    return;
-  }
-
-  line_length = strlen(line);
-  if (line_length + 1u >= DEBUG_LOG_BUFFER_SIZE) {
-    line += line_length - (DEBUG_LOG_BUFFER_SIZE - 2u);
-    line_length = DEBUG_LOG_BUFFER_SIZE - 2u;
-  }
-
-  if (g_debug_log_length + line_length + 1u >= DEBUG_LOG_BUFFER_SIZE) {
-    overflow = g_debug_log_length + line_length + 1u - DEBUG_LOG_BUFFER_SIZE;
-    if (overflow > g_debug_log_length) {
-      overflow = g_debug_log_length;
-    }
-    if (overflow > 0u) {
-      memmove(g_debug_log_buffer, g_debug_log_buffer + overflow,
-              g_debug_log_length - overflow);
-      g_debug_log_length -= overflow;
-    }
-  }
-
-  memcpy(g_debug_log_buffer + g_debug_log_length, line, line_length);
-  g_debug_log_length += line_length;
-  g_debug_log_buffer[g_debug_log_length++] = '\n';
-  g_debug_log_buffer[g_debug_log_length] = '\0';
-  g_debug_logs_generation += 1u;
-
-  restore_interrupts(irq_state);
-}
-
-static void debug_logs_copy(char *out_buffer, size_t out_buffer_size) {
-  const uint32_t irq_state = save_and_disable_interrupts();
-  size_t copy_length = 0u;
-
-  if (out_buffer == NULL || out_buffer_size == 0u) {
-    restore_interrupts(irq_state);
-    return;
-  }
-
-  copy_length = g_debug_log_length;
-  if (copy_length >= out_buffer_size) {
-    copy_length = out_buffer_size - 1u;
-  }
-
-  memcpy(out_buffer, g_debug_log_buffer, copy_length);
-  out_buffer[copy_length] = '\0';
-
-  restore_interrupts(irq_state);
-}
-
-static bool debug_logs_enabled_get(void) {
-  const uint32_t irq_state = save_and_disable_interrupts();
-  const bool enabled = g_debug_logs_enabled;
-  restore_interrupts(irq_state);
-  return enabled;
-}
-
-static uint32_t debug_logs_generation_get(void) {
-  const uint32_t irq_state = save_and_disable_interrupts();
-  const uint32_t generation = g_debug_logs_generation;
-  restore_interrupts(irq_state);
-  return generation;
-}
-
-static void debug_logs_enabled_set(bool enabled) {
-  const uint32_t irq_state = save_and_disable_interrupts();
-  g_debug_logs_enabled = enabled;
-  restore_interrupts(irq_state);
-}
-
-static void debug_logs_copy_tail(char *out_buffer, size_t out_buffer_size) {
-  const uint32_t irq_state = save_and_disable_interrupts();
-  size_t copy_length = 0u;
-  size_t start_index = 0u;
-
-  if (out_buffer == NULL || out_buffer_size == 0u) {
-    restore_interrupts(irq_state);
-    return;
-  }
-
-  if (g_debug_log_length > 0u) {
-    const size_t max_copy = out_buffer_size - 1u;
-    if (g_debug_log_length > max_copy) {
-      start_index = g_debug_log_length - max_copy;
-      copy_length = max_copy;
-    } else {
-      copy_length = g_debug_log_length;
-    }
-    memcpy(out_buffer, g_debug_log_buffer + start_index, copy_length);
-  }
-
-  out_buffer[copy_length] = '\0';
-  restore_interrupts(irq_state);
-}
-#else
-static void debug_logs_clear(void) {}
-static void debug_logs_append(const char *line) { (void)line; }
-static void debug_logs_copy(char *out_buffer, size_t out_buffer_size) {
-  if (out_buffer != NULL && out_buffer_size > 0u) {
-    out_buffer[0] = '\0';
-  }
-}
-static bool debug_logs_enabled_get(void) { return false; }
-static uint32_t debug_logs_generation_get(void) { return 0u; }
-static void debug_logs_enabled_set(bool enabled) { (void)enabled; }
-static void debug_logs_copy_tail(char *out_buffer, size_t out_buffer_size) {
-  if (out_buffer != NULL && out_buffer_size > 0u) {
-    out_buffer[0] = '\0';
-  }
-}
-#endif
-
 static bool json_escape_string(const char *input, char *output,
                                size_t output_size) {
   size_t write_index = 0u;
@@ -377,11 +300,75 @@ static void http_send_headers_only(struct netconn *connection,
   netconn_write(connection, header, (size_t)header_length, NETCONN_COPY);
 }
 
+/*
+ * Chunked transfer encoding lets large responses be generated piece by
+ * piece without knowing their length up front. extra_headers is either
+ * NULL or complete "Name: value\r\n" lines.
+ */
+static bool http_send_chunked_headers(struct netconn *connection,
+                                      const char *status_line,
+                                      const char *content_type,
+                                      const char *extra_headers) {
+  char header[256];
+  const int header_length = snprintf(
+      header, sizeof(header),
+      "HTTP/1.1 %s\r\n"
+      "Content-Type: %s\r\n"
+      "Transfer-Encoding: chunked\r\n"
+      "%s"
+      "Connection: close\r\n"
+      "\r\n",
+      status_line, content_type, extra_headers != NULL ? extra_headers : "");
+
+  if (header_length <= 0 || (size_t)header_length >= sizeof(header)) {
+    return false;
+  }
+
+  return netconn_write(connection, header, (size_t)header_length,
+                       NETCONN_COPY) == ERR_OK;
+}
+
+static bool http_send_chunk(struct netconn *connection, const char *data,
+                            size_t length) {
+  char size_line[12];
+  int size_line_length = 0;
+  size_t offset = 0u;
+
+  while (offset < length) {
+    const size_t remaining = length - offset;
+    const size_t chunk_size =
+        remaining > HTTP_RESPONSE_CHUNK_SIZE ? HTTP_RESPONSE_CHUNK_SIZE
+                                             : remaining;
+
+    size_line_length = snprintf(size_line, sizeof(size_line), "%lx\r\n",
+                                (unsigned long)chunk_size);
+    if (size_line_length <= 0 ||
+        netconn_write(connection, size_line, (size_t)size_line_length,
+                      NETCONN_COPY) != ERR_OK ||
+        netconn_write(connection, data + offset, chunk_size, NETCONN_COPY) !=
+            ERR_OK ||
+        netconn_write(connection, "\r\n", 2u, NETCONN_COPY) != ERR_OK) {
+      return false;
+    }
+    offset += chunk_size;
+  }
+
+  return true;
+}
+
+static bool http_send_last_chunk(struct netconn *connection) {
+  static const char k_last_chunk[] = "0\r\n\r\n";
+  return netconn_write(connection, k_last_chunk, sizeof(k_last_chunk) - 1u,
+                       NETCONN_COPY) == ERR_OK;
+}
+
 static bool http_parse_request_path_and_method(const char *request_data,
                                                size_t request_length,
                                                http_method_t *out_method,
                                                char *out_path,
-                                               size_t out_path_size) {
+                                               size_t out_path_size,
+                                               char *out_query,
+                                               size_t out_query_size) {
   char request_line[HTTP_REQUEST_LINE_BUFFER_SIZE];
   const char *method_prefix = NULL;
   char *path_begin = NULL;
@@ -392,10 +379,13 @@ static bool http_parse_request_path_and_method(const char *request_data,
   size_t path_length = 0u;
 
   if (request_data == NULL || out_method == NULL || out_path == NULL ||
-      out_path_size == 0u || request_length < 5u) {
+      out_path_size == 0u || out_query == NULL || out_query_size == 0u ||
+      request_length < 5u) {
     return false;
   }
 
+  out_query[0] = '\0';
+
   if (copy_length >= sizeof(request_line)) {
     copy_length = sizeof(request_line) - 1u;
   }
@@ -448,6 +438,8 @@ static bool http_parse_request_path_and_method(const char *request_data,
   query_separator = strchr(out_path, '?');
   if (query_separator != NULL) {
     *query_separator = '\0';
+    strncpy(out_query, query_separator + 1, out_query_size - 1u);
+    out_query[out_query_size - 1u] = '\0';
   }
 
   if (out_path[0] == '\0') {
@@ -457,6 +449,61 @@ static bool http_parse_request_path_and_method(const char *request_data,
   return true;
 }
 
+/* Copies the value of name=value from a query string; no %-decoding. */
+static bool http_query_get_param(const char *query, const char *name,
+                                 char *out_value, size_t out_value_size) {
+  const size_t name_length = strlen(name);
+  const char *cursor = query;
+
+  if (query == NULL || out_value == NULL || out_value_size == 0u) {
+    return false;
+  }
+
+  while (*cursor != '\0') {
+    const char *end = strchr(cursor, '&');
+    const size_t pair_length =
+        end != NULL ? (size_t)(end - cursor) : strlen(cursor);
+
+    if (pair_length > name_length && strncmp(cursor, name, name_length) == 0 &&
+        cursor[name_length] == '=') {
+      size_t value_length = pair_length - name_length - 1u;
+      if (value_length >= out_value_size) {
+        value_length = out_value_size - 1u;
+      }
+      memcpy(out_value, cursor + name_length + 1u, value_length);
+      out_value[value_length] = '\0';
+      return true;
+    }
+
+    if (end == NULL) {
+      break;
+    }
+    cursor = end + 1;
+  }
+
+  return false;
+}
+
+static bool http_query_get_uint32(const char *query, const char *name,
+                                  uint32_t *out_value) {
+  char value[16];
+  char *end = NULL;
+  unsigned long parsed = 0ul;
+
+  if (!http_query_get_param(query, name, value, sizeof(value)) ||
+      value[0] == '\0') {
+    return false;
+  }
+
+  parsed = strtoul(value, &end, 10);
+  if (end == value || *end != '\0' || parsed > 0xfffffffful) {
+    return false;
+  }
+
+  *out_value = (uint32_t)parsed;
+  return true;
+}
+
 static size_t http_extract_content_length(const char *buffer, size_t header_size) {
   const char *cursor = buffer;
   const char *end = buffer + header_size;
@@ -613,6 +660,119 @@ static bool json_extract_int_field(const char *json_body, const char *field_name
   return true;
 }
 
+static bool json_extract_float_field(const char *json_body,
+                                     const char *field_name, float *out_value) {
+  char token[32];
+  const char *field = NULL;
+  const char *colon = NULL;
+  char *end_ptr = NULL;
+  float parsed_value = 0.0f;
+
+  if (json_body == NULL || field_name == NULL || out_value == NULL) {
+    return false;
+  }
+
+  if (snprintf(token, sizeof(token), "\"%s\"", field_name) <= 0) {
+    return false;
+  }
+
+  field = strstr(json_body, token);
+  if (field == NULL) {
+    return false;
+  }
+
+  colon = strchr(field, ':');
+  if (colon == NULL) {
+    return false;
+  }
+
+  colon++;
+  while (*colon != '\0' && isspace((unsigned char)*colon)) {
+    colon++;
+  }
+
+  parsed_value = strtof(colon, &end_ptr);
+  if (end_ptr == colon) {
+    return false;
+  }
+
+  *out_value = parsed_value;
+  return true;
+}
+
+static bool json_extract_float_array_field(const char *json_body,
+                                           const char *field_name,
+                                           float *out_values,
+                                           size_t max_values,
+                                           size_t *out_count) {
+  char token[32];
+  const char *field = NULL;
+  const char *cursor = NULL;
+  size_t count = 0u;
+
+  if (json_body == NULL || field_name == NULL || out_values == NULL ||
+      out_count == NULL) {
+    return false;
+  }
+
+  if (snprintf(token, sizeof(token), "\"%s\"", field_name) <= 0) {
+    return false;
+  }
+
+  field = strstr(json_body, token);
+  if (field == NULL) {
+    return false;
+  }
+
+  cursor = strchr(field, ':');
+  if (cursor == NULL) {
+    return false;
+  }
+
+  cursor++;
+  while (*cursor != '\0' && isspace((unsigned char)*cursor)) {
+    cursor++;
+  }
+  if (*cursor != '[') {
+    return false;
+  }
+  cursor++;
+
+  while (1) {
+    char *end_ptr = NULL;
+    float parsed_value = 0.0f;
+
+    while (*cursor != '\0' && isspace((unsigned char)*cursor)) {
+      cursor++;
+    }
+    if (*cursor == ']') {
+      break;
+    }
+    if (count >= max_values) {
+      return false;
+    }
+
+    parsed_value = strtof(cursor, &end_ptr);
+    if (end_ptr == cursor) {
+      return false;
+    }
+    out_values[count++] = parsed_value;
+    cursor = end_ptr;
+
+    while (*cursor != '\0' && isspace((unsigned char)*cursor)) {
+      cursor++;
+    }
+    if (*cursor == ',') {
+      cursor++;
+    } else if (*cursor != ']') {
+      return false;
+    }
+  }
+
+  *out_count = count;
+  return true;
+}
+
 static bool json_extract_bool_field(const char *json_body, const char *field_name,
                                     bool *out_value) {
   char token[32];
@@ -872,12 +1032,14 @@ static bool base64_decode_payload(const char *input, uint8_t *output,
   return true;
 }
 
-static bool web_collect_status_snapshot(web_status_snapshot_t *out_snapshot) {
+static bool web_collect_status_snapshot(
+    web_status_snapshot_t *out_snapshot,
+    blower_flow_correction_t *flow_correction) {
   blower_control_snapshot_t control_snapshot = {0};
   blower_metrics_snapshot_t metrics_snapshot = {0};
   const bool has_metrics = blower_metrics_service_get_snapshot(&metrics_snapshot);
 
-  if (out_snapshot == NULL) {
+  if (out_snapshot == NULL || flow_correction == NULL) {
     return false;
   }
 
@@ -886,6 +1048,7 @@ static bool web_collect_status_snapshot(web_status_snapshot_t *out_snapshot) {
   *out_snapshot = (web_status_snapshot_t){
       .pwm = control_snapshot.output_pwm_percent,
       .led = control_snapshot.auto_hold_enabled ? 1u : 0u,
+      .mode = (uint8_t)control_snapshot.mode,
       .relay = control_snapshot.relay_enabled ? 1u : 0u,
       .line_sync = control_snapshot.line_sync ? 1u : 0u,
       .frequency_hz = control_snapshot.line_frequency_hz,
@@ -914,13 +1077,11 @@ static bool web_collect_status_snapshot(web_status_snapshot_t *out_snapshot) {
     if (dp_abs >= WEB_PITOT_NOISE_FLOOR_PA) {
       const float temp_c = metrics_snapshot.fan_temperature_c;
       if (isfinite(dp_abs) && isfinite(temp_c)) {
-        const float rho = web_task_air_density(APP_ALTITUDE_M, temp_c);
-        const float v_ms = web_task_pitot_speed_ms(
-            metrics_snapshot.fan_pressure_pa, rho);
-        const float density_factor = rho > 0.0f
-            ? sqrtf(APP_SEA_LEVEL_AIR_DENSITY / rho) : 1.0f;
-        const float flow = APP_FAN_FLOW_COEFFICIENT_C *
-              powf(dp_abs, APP_FAN_FLOW_EXPONENT_N) * density_factor;
+        blower_flow_correction_refresh(flow_correction, temp_c);
+        const float v_ms = blower_flow_correction_pitot_speed_ms(
+            flow_correction, metrics_snapshot.fan_pressure_pa);
+        const float flow = blower_flow_correction_flow_m3h(
+            flow_correction, metrics_snapshot.fan_pressure_pa, NULL);
         if (isfinite(v_ms))  out_snapshot->fan_wind_speed_ms  = v_ms;
         if (isfinite(v_ms))  out_snapshot->fan_wind_speed_kmh = v_ms * 3.6f;
         if (isfinite(flow))  out_snapshot->fan_flow_m3h       = flow;
@@ -938,6 +1099,7 @@ static bool web_status_changed(const web_status_snapshot_t *current,
   }
 
   if (current->pwm != last->pwm || current->led != last->led ||
+      current->mode != last->mode ||
       current->relay != last->relay || current->line_sync != last->line_sync ||
       current->dp1_ok != last->dp1_ok || current->dp2_ok != last->dp2_ok ||
       current->cal_state != last->cal_state ||
@@ -1008,7 +1170,7 @@ static int web_status_json_write_common(const web_status_snapshot_t *status,
     return snprintf(
         payload, payload_size,
         "{\"fw\":\"" APP_FIRMWARE_VERSION "\","
-        "\"pwm\":%u,\"led\":%u,\"relay\":%u,\"line_sync\":%u,"
+        "\"pwm\":%u,\"led\":%u,\"mode\":%u,\"relay\":%u,\"line_sync\":%u,"
         "\"input\":%u,\"frequency\":%.1f,\"dp1_pressure\":%.3f,"
         "\"dp1_temperature\":%.3f,\"dp1_ok\":%s,\"dp2_pressure\":%.3f,"
         "\"dp2_temperature\":%.3f,\"dp2_ok\":%s,\"dp_pressure\":%.3f,"
@@ -1018,8 +1180,8 @@ static int web_status_json_write_common(const web_status_snapshot_t *status,
         "\"cal\":%u,\"cal_pct\":%u,"
         "\"cal_fan\":%.3f,\"cal_env\":%.3f,"
         "\"logs_enabled\":true,\"logs\":\"%s\"}",
-        status->pwm, status->led, status->relay, status->line_sync,
-        status->line_sync, frequency, dp1_p,
+        status->pwm, status->led, status->mode, status->relay,
+        status->line_sync, status->line_sync, frequency, dp1_p,
         dp1_t, status->dp1_ok ? "true" : "false",
         dp2_p, dp2_t,
         status->dp2_ok ? "true" : "false", dp1_p,
@@ -1034,7 +1196,8 @@ static int web_status_json_write_common(const web_status_snapshot_t *status,
   return snprintf(
       payload, payload_size,
       "{\"fw\":\"" APP_FIRMWARE_VERSION "\","
-      "\"pwm\":%u,\"led\":%u,\"relay\":%u,\"line_sync\":%u,\"input\":%u,"
+      "\"pwm\":%u,\"led\":%u,\"mode\":%u,\"relay\":%u,\"line_sync\":%u,"
+      "\"input\":%u,"
       "\"frequency\":%.1f,\"dp1_pressure\":%.3f,\"dp1_temperature\":%.3f,"
       "\"dp1_ok\":%s,\"dp2_pressure\":%.3f,\"dp2_temperature\":%.3f,"
       "\"dp2_ok\":%s,\"dp_pressure\":%.3f,\"dp_temperature\":%.3f,"
@@ -1044,8 +1207,8 @@ static int web_status_json_write_common(const web_status_snapshot_t *status,
       "\"cal\":%u,\"cal_pct\":%u,"
       "\"cal_fan\":%.3f,\"cal_env\":%.3f,"
       "\"logs_enabled\":false}",
-      status->pwm, status->led, status->relay, status->line_sync,
-      status->line_sync, frequency, dp1_p,
+      status->pwm, status->led, status->mode, status->relay,
+      status->line_sync, status->line_sync, frequency, dp1_p,
       dp1_t, status->dp1_ok ? "true" : "false",
       dp2_p, dp2_t,
       status->dp2_ok ? "true" : "false", dp1_p,
@@ -1056,8 +1219,8 @@ static int web_status_json_write_common(const web_status_snapshot_t *status,
       cal_fan, cal_env);
 }
 
-static bool web_format_status_json(const web_status_snapshot_t *status,
-                                   char *payload, size_t payload_size) {
+static bool web_format_status_json_payload(const web_status_snapshot_t *status,
+                                           char *payload, size_t payload_size) {
   bool logs_enabled = debug_logs_enabled_get();
   int written = 0;
 
@@ -1106,6 +1269,16 @@ static bool web_format_status_json(const web_status_snapshot_t *status,
   return written > 0 && (size_t)written < payload_size;
 }
 
+static bool web_format_status_json(const web_status_snapshot_t *status,
+                                   char *payload, size_t payload_size) {
+  bool formatted = false;
+
+  SYS_PROFILE_BEGIN(SYS_PROFILE_STATUS_JSON);
+  formatted = web_format_status_json_payload(status, payload, payload_size);
+  SYS_PROFILE_END(SYS_PROFILE_STATUS_JSON);
+  return formatted;
+}
+
 static bool sse_write_event(struct netconn *connection, const char *json_payload) {
   static const char k_prefix[] = "data:";
   static const char k_suffix[] = "\n\n";
@@ -1177,7 +1350,8 @@ static void sse_stream_task(void *params) {
 
     web_status_snapshot_t status_snapshot = {0};
     const uint32_t now_ms = to_ms_since_boot(get_absolute_time());
-    const bool has_status = web_collect_status_snapshot(&status_snapshot);
+    const bool has_status = web_collect_status_snapshot(
+        &status_snapshot, &context->flow_correction);
     const bool should_push =
         has_status &&
         (!context->has_last_status ||
@@ -1197,18 +1371,23 @@ static void sse_stream_task(void *params) {
           break;
         }
         sent_events += 1u;
+        g_sse_events_total += 1u;
         context->last_emit_ms = now_ms;
         vTaskDelay(pdMS_TO_TICKS(SSE_LOOP_INTERVAL_MS));
         continue;
       }
 
-      if (!sse_write_event(connection, json_payload)) {
+      SYS_TRACE_SPAN_BEGIN(SYS_TRACE_SPAN_SSE_PUSH);
+      const bool write_ok = sse_write_event(connection, json_payload);
+      SYS_TRACE_SPAN_END(SYS_TRACE_SPAN_SSE_PUSH);
+      if (!write_ok) {
         debug_logs_append("SSE write fail data");
         close_reason = "write_fail_data";
         break;
       }
 
       sent_events += 1u;
+      g_sse_events_total += 1u;
       if ((sent_events % 10u) == 0u) {
         printf("[SSE] sent=%lu seq=%lu fan_ok=%u env_ok=%u\n",
                (unsigned long)sent_events,
@@ -1253,6 +1432,7 @@ static bool http_start_sse_stream(struct netconn *connection) {
 
     if (g_sse_active) {
       printf("[SSE] reject reason=busy\n");
+      g_sse_rejected_total += 1u;
       http_send_text_response(connection, "503 Service Unavailable", "text/plain",
                               "SSE busy");
       return false;
@@ -1261,6 +1441,7 @@ static bool http_start_sse_stream(struct netconn *connection) {
 
   context = (sse_stream_context_t *)pvPortMalloc(sizeof(*context));
   if (context == NULL) {
+    g_sse_rejected_total += 1u;
     http_send_text_response(connection, "500 Internal Server Error", "text/plain",
                             "SSE allocation failed");
     return false;
@@ -1272,18 +1453,21 @@ static bool http_start_sse_stream(struct netconn *connection) {
       .has_last_status = false,
       .last_emit_ms = 0u,
   };
+  blower_flow_correction_reset(&context->flow_correction);
 
   g_sse_active = true;
   g_sse_stop_requested = false;
-  if (xTaskCreate(sse_stream_task, "SSETask", 2048u, context,
-                  APP_WIFI_TASK_PRIORITY, NULL) != pdPASS) {
+  if (xTaskCreate(sse_stream_task, "SSETask", APP_SSE_TASK_STACK_WORDS,
+                  context, APP_WIFI_TASK_PRIORITY, NULL) != pdPASS) {
     g_sse_active = false;
+    g_sse_rejected_total += 1u;
     vPortFree(context);
     http_send_text_response(connection, "500 Internal Server Error", "text/plain",
                             "SSE task creation failed");
     return false;
   }
 
+  g_sse_connections_total += 1u;
   printf("[SSE] task_started\n");
   return true;
 }
@@ -1296,6 +1480,7 @@ static bool http_parse_request(struct netconn *connection,
   size_t content_length = 0u;
   http_method_t method = HTTP_METHOD_UNKNOWN;
   char path[96];
+  char query[64];
 
   if (out_request == NULL) {
     return false;
@@ -1309,12 +1494,14 @@ static bool http_parse_request(struct netconn *connection,
   }
 
   if (!http_parse_request_path_and_method(request_buffer, header_size, &method,
-                                          path, sizeof(path))) {
+                                          path, sizeof(path), query,
+                                          sizeof(query))) {
     return false;
   }
 
   out_request->method = method;
   strncpy(out_request->path, path, sizeof(out_request->path) - 1u);
+  strncpy(out_request->query, query, sizeof(out_request->query) - 1u);
 
   if (content_length > 0u) {
     const size_t body_copy_length =
@@ -1335,7 +1522,8 @@ static bool http_handle_status_route(struct netconn *connection,
                                      const http_request_t *request) {
   web_status_snapshot_t status_snapshot = {0};
   char payload[HTTP_RESPONSE_PAYLOAD_BUFFER_SIZE];
-  const bool has_snapshot = web_collect_status_snapshot(&status_snapshot);
+  const bool has_snapshot = web_collect_status_snapshot(
+      &status_snapshot, &g_status_flow_correction);
   const bool payload_ok = has_snapshot &&
                           web_format_status_json(&status_snapshot, payload,
                                                  sizeof(payload));
@@ -1359,71 +1547,1125 @@ static bool http_handle_status_route(struct netconn *connection,
   return false;
 }
 
-static bool http_handle_test_report_compat_route(struct netconn *connection,
-                                                 const http_request_t *request) {
-  static const char k_report_payload[] = "{\"active\":false,\"report\":null}";
-  static const char k_latest_report_payload[] = "{\"report\":null}";
-  const bool is_latest_route =
-      strcmp(request->path, "/api/test/report/latest") == 0;
-  const char *payload =
-      is_latest_route ? k_latest_report_payload : k_report_payload;
-  const size_t payload_length = strlen(payload);
+static bool web_json_appendf(char *payload, size_t payload_size,
+                             size_t *inout_offset, const char *format, ...) {
+  va_list args;
+  int written = 0;
 
-  if (request->method == HTTP_METHOD_HEAD) {
-    http_send_headers_only(connection, "200 OK", "application/json",
-                           payload_length);
+  if (*inout_offset >= payload_size) {
     return false;
   }
 
-  http_send_response(connection, "200 OK", "application/json",
-                     (const uint8_t *)payload, payload_length);
-  return false;
+  va_start(args, format);
+  written = vsnprintf(payload + *inout_offset, payload_size - *inout_offset,
+                      format, args);
+  va_end(args);
+
+  if (written <= 0 || (size_t)written >= payload_size - *inout_offset) {
+    return false;
+  }
+  *inout_offset += (size_t)written;
+  return true;
 }
 
-static bool http_handle_api_post_route(struct netconn *connection,
-                                       const http_request_t *request) {
-  int value = 0;
-  char response_payload[192];
+static bool web_format_test_summary_json(
+    const blower_test_curve_summary_t *summary, char *payload,
+    size_t payload_size, size_t *inout_offset) {
+  if (!summary->valid) {
+    return web_json_appendf(payload, payload_size, inout_offset, "null");
+  }
+
+  return web_json_appendf(
+      payload, payload_size, inout_offset,
+      "{\"method\":\"%s\",\"cl_m3h_pan\":%.4f,\"cl_low\":%.4f,"
+      "\"cl_high\":%.4f,\"n\":%.4f,\"n_ci95\":%.4f,\"r\":%.5f,"
+      "\"q_ref_m3h\":%.2f,\"q_ref_low_m3h\":%.2f,\"q_ref_high_m3h\":%.2f,"
+      "\"downweighted\":%u,\"ach_ref_h1\":%.3f,\"w_ref_m3h_m2\":%.3f,"
+      "\"q_ref_envelope_m3h_m2\":%.3f,\"eqla10_cm2\":%.1f,"
+      "\"eqla10_cm2_m2\":%.3f,\"ela4_cm2\":%.1f,\"ela4_cm2_m2\":%.3f,"
+      "\"noise_uncertainty_pct\":%.2f,\"uncertainty_pct\":%.2f}",
+      blower_leakage_fit_method_name(
+          (blower_leakage_fit_method_t)summary->fit_method),
+      (double)safe_json_float(summary->cl_m3h_pan),
+      (double)safe_json_float(summary->cl_ci95_low_m3h_pan),
+      (double)safe_json_float(summary->cl_ci95_high_m3h_pan),
+      (double)safe_json_float(summary->exponent_n),
+      (double)safe_json_float(summary->exponent_n_ci95),
+      (double)safe_json_float(summary->correlation_r),
+      (double)safe_json_float(summary->q_ref_m3h),
+      (double)safe_json_float(summary->q_ref_ci95_low_m3h),
+      (double)safe_json_float(summary->q_ref_ci95_high_m3h),
+      (unsigned)summary->downweighted_points,
+      (double)safe_json_float(summary->ach_ref_h1),
+      (double)safe_json_float(summary->w_ref_m3h_m2),
+      (double)safe_json_float(summary->q_ref_envelope_m3h_m2),
+      (double)safe_json_float(summary->eqla10_cm2),
+      (double)safe_json_float(summary->eqla10_cm2_per_m2_envelope),
+      (double)safe_json_float(summary->lbl_ela4_cm2),
+      (double)safe_json_float(summary->lbl_ela4_cm2_per_m2_envelope),
+      (double)safe_json_float(summary->noise_uncertainty_pct),
+      (double)safe_json_float(summary->uncertainty_pct));
+}
 
-  if (request->method != HTTP_METHOD_POST) {
-    http_send_text_response(connection, "405 Method Not Allowed", "text/plain",
-                            "Method Not Allowed");
-    return false;
+static bool web_format_test_direction_json(
+    const blower_test_direction_report_t *direction, char *payload,
+    size_t payload_size, size_t *inout_offset) {
+  uint8_t index = 0u;
+
+  if (direction->point_count == 0u) {
+    return web_json_appendf(payload, payload_size, inout_offset, "null");
   }
 
-  if (strcmp(request->path, "/api/calibrate") == 0) {
-    blower_metrics_snapshot_t metrics_snapshot = {0};
-    const bool has_metrics = blower_metrics_service_get_snapshot(&metrics_snapshot);
-    int written = 0;
+  if (!web_json_appendf(payload, payload_size, inout_offset,
+                        "{\"direction\":\"%s\",\"points\":[",
+                        blower_test_direction_name(direction->direction))) {
+    return false;
+  }
 
-    if (!has_metrics || (!metrics_snapshot.fan_sample_valid &&
-                        !metrics_snapshot.envelope_sample_valid)) {
-      const char *reason = !has_metrics ? "metrics_unavailable" : "no_valid_samples";
-      written = snprintf(
-          response_payload, sizeof(response_payload),
-          "{\"status\":\"error\",\"reason\":\"%s\",\"fan_ok\":false,\"envelope_ok\":false}",
-          reason);
-      if (written <= 0 || (size_t)written >= sizeof(response_payload)) {
-        http_send_text_response(connection, "500 Internal Server Error",
-                                "application/json", "{\"status\":\"error\"}");
-        return false;
-      }
-      http_send_response(connection, "409 Conflict",
-                         "application/json", (const uint8_t *)response_payload,
-                         strlen(response_payload));
+  for (index = 0u; index < direction->point_count &&
+                   index < BLOWER_TEST_MAX_PRESSURE_POINTS;
+       ++index) {
+    const blower_test_point_result_t *point = &direction->points[index];
+    if (!web_json_appendf(
+            payload, payload_size, inout_offset,
+            "%s{\"target_pa\":%.1f,\"pressure_pa\":%.2f,"
+            "\"raw_pressure_pa\":%.2f,\"pressure_sd_pa\":%.3f,"
+            "\"pressure_se_pa\":%.3f,"
+            "\"pressure_min_pa\":%.2f,\"pressure_max_pa\":%.2f,"
+            "\"flow_m3h\":%.2f,\"flow_sd_m3h\":%.3f,\"flow_se_m3h\":%.3f,"
+            "\"fan_temp_c\":%.2f,\"env_temp_c\":%.2f,\"pwm_pct\":%.1f,"
+            "\"settle_ms\":%lu,\"measure_ms\":%lu,\"samples\":%u,"
+            "\"fan_range\":%u,\"fan_in_range\":%s,\"valid\":%s}",
+            index == 0u ? "" : ",",
+            (double)safe_json_float(point->target_pressure_pa),
+            (double)safe_json_float(point->avg_pressure_pa),
+            (double)safe_json_float(point->raw_avg_pressure_pa),
+            (double)safe_json_float(point->pressure_stddev_pa),
+            (double)safe_json_float(point->pressure_std_error_pa),
+            (double)safe_json_float(point->pressure_min_pa),
+            (double)safe_json_float(point->pressure_max_pa),
+            (double)safe_json_float(point->avg_fan_flow_m3h),
+            (double)safe_json_float(point->flow_stddev_m3h),
+            (double)safe_json_float(point->flow_std_error_m3h),
+            (double)safe_json_float(point->avg_fan_temperature_c),
+            (double)safe_json_float(point->avg_envelope_temperature_c),
+            (double)safe_json_float(point->avg_pwm_percent),
+            (unsigned long)point->settle_duration_ms,
+            (unsigned long)point->measure_duration_ms,
+            (unsigned)point->sample_count, (unsigned)point->fan_range_index,
+            point->fan_in_range ? "true" : "false",
+            point->valid ? "true" : "false")) {
       return false;
     }
+  }
 
-    blower_metrics_service_begin_calibration();
+  return web_json_appendf(payload, payload_size, inout_offset,
+                          "],\"summary\":") &&
+         web_format_test_summary_json(&direction->summary, payload,
+                                      payload_size, inout_offset) &&
+         web_json_appendf(payload, payload_size, inout_offset, "}");
+}
 
-    written = snprintf(
-        response_payload, sizeof(response_payload),
-        "{\"status\":\"ok\",\"reason\":\"calibration_started\","
-        "\"fan_ok\":%s,\"envelope_ok\":%s}",
-        metrics_snapshot.fan_sample_valid ? "true" : "false",
-        metrics_snapshot.envelope_sample_valid ? "true" : "false");
+static bool web_format_test_baseline_json(
+    const blower_test_baseline_t *baseline, char *payload,
+    size_t payload_size, size_t *inout_offset) {
+  if (!baseline->valid) {
+    return web_json_appendf(payload, payload_size, inout_offset, "null");
+  }
+
+  return web_json_appendf(
+      payload, payload_size, inout_offset,
+      "{\"pre_pa\":%.3f,\"pre_se_pa\":%.3f,\"pre_samples\":%u,"
+      "\"post_pa\":%.3f,\"post_se_pa\":%.3f,\"post_samples\":%u,"
+      "\"bias_pa\":%.3f,\"bias_se_pa\":%.3f,\"stable\":%s}",
+      (double)safe_json_float(baseline->pre_pa),
+      (double)safe_json_float(baseline->pre_std_error_pa),
+      (unsigned)baseline->pre_sample_count,
+      (double)safe_json_float(baseline->post_pa),
+      (double)safe_json_float(baseline->post_std_error_pa),
+      (unsigned)baseline->post_sample_count,
+      (double)safe_json_float(baseline->bias_pa),
+      (double)safe_json_float(baseline->bias_std_error_pa),
+      baseline->stable ? "true" : "false");
+}
 
-    if (written <= 0 || (size_t)written >= sizeof(response_payload)) {
+static bool web_format_test_report_json(const blower_test_report_t *report,
+                                        char *payload, size_t payload_size,
+                                        size_t *inout_offset) {
+  if (report == NULL) {
+    return web_json_appendf(payload, payload_size, inout_offset, "null");
+  }
+
+  return web_json_appendf(payload, payload_size, inout_offset,
+                          "{\"id\":%lu,\"completed_ms\":%lu,"
+                          "\"reference_pa\":%u,\"baseline\":",
+                          (unsigned long)report->report_id,
+                          (unsigned long)report->completed_tick_ms,
+                          (unsigned)report->reference_pressure_pa) &&
+         web_format_test_baseline_json(&report->baseline, payload,
+                                       payload_size, inout_offset) &&
+         web_json_appendf(payload, payload_size, inout_offset,
+                          ",\"pressurization\":") &&
+         web_format_test_direction_json(&report->pressurization, payload,
+                                        payload_size, inout_offset) &&
+         web_json_appendf(payload, payload_size, inout_offset,
+                          ",\"depressurization\":") &&
+         web_format_test_direction_json(&report->depressurization, payload,
+                                        payload_size, inout_offset) &&
+         web_json_appendf(payload, payload_size, inout_offset, ",\"mean\":") &&
+         web_format_test_summary_json(&report->mean_summary, payload,
+                                      payload_size, inout_offset) &&
+         web_json_appendf(payload, payload_size, inout_offset, "}");
+}
+
+static bool web_format_test_status_json(
+    const blower_test_runtime_status_t *runtime, char *payload,
+    size_t payload_size) {
+  size_t offset = 0u;
+
+  return web_json_appendf(
+      payload, payload_size, &offset,
+      "{\"active\":%s,\"state\":\"%s\",\"mode\":\"%s\",\"direction\":\"%s\","
+      "\"point\":%u,\"points\":%u,\"target_pa\":%.1f,\"pressure_pa\":%.2f,"
+      "\"flow_m3h\":%.2f,\"state_ms\":%lu,\"samples\":%u,\"ci95_pa\":%.3f,"
+      "\"fan_range\":%u,\"fan_in_range\":%s,\"suggested_fan_range\":%u,"
+      "\"report_ready\":%s,\"latest_report_id\":%lu,"
+      "\"latest_ach_ref_h1\":%.3f,\"dropped_samples\":%lu}",
+      runtime->active ? "true" : "false",
+      blower_test_state_name(runtime->state),
+      blower_test_mode_name(runtime->requested_mode),
+      blower_test_direction_name(runtime->current_direction),
+      (unsigned)runtime->current_point_index, (unsigned)runtime->total_points,
+      (double)safe_json_float(runtime->current_target_pressure_pa),
+      (double)safe_json_float(runtime->current_measured_pressure_pa),
+      (double)safe_json_float(runtime->current_measured_flow_m3h),
+      (unsigned long)runtime->state_elapsed_ms,
+      (unsigned)runtime->active_sample_count,
+      (double)safe_json_float(runtime->current_ci95_pa),
+      (unsigned)runtime->fan_range_index,
+      runtime->fan_in_range ? "true" : "false",
+      (unsigned)runtime->suggested_fan_range,
+      runtime->report_ready ? "true" : "false",
+      (unsigned long)runtime->latest_report_id,
+      (double)safe_json_float(runtime->latest_ach_ref_h1),
+      (unsigned long)runtime->dropped_samples);
+}
+
+static bool web_format_test_config_json(const blower_test_config_t *config,
+                                        char *payload, size_t payload_size) {
+  size_t offset = 0u;
+  uint8_t index = 0u;
+
+  if (!web_json_appendf(
+          payload, payload_size, &offset,
+          "{\"building_volume_m3\":%.2f,\"floor_area_m2\":%.2f,"
+          "\"envelope_area_m2\":%.2f,\"building_height_m\":%.2f,"
+          "\"dimensions_uncertainty_pct\":%.2f,\"altitude_m\":%.1f,"
+          "\"fan_aperture_cm\":%.1f,\"fan_curve_c\":%.4f,"
+          "\"fan_curve_n\":%.4f,\"target_tolerance_pa\":%.2f,"
+          "\"settle_time_s\":%u,\"measure_time_s\":%u,"
+          "\"adaptive_windows\":%s,\"min_settle_time_s\":%u,"
+          "\"min_measure_time_s\":%u,\"target_ci_pa\":%.2f,"
+          "\"max_drift_pa_s\":%.2f,\"baseline_time_s\":%u,"
+          "\"max_baseline_pa\":%.2f,"
+          "\"reference_pressure_pa\":%u,\"min_points_required\":%u,"
+          "\"enforce_iso_9972_rules\":%s,\"fit_method\":\"%s\","
+          "\"capture_raw_samples\":%s,\"fan_range_count\":%u,"
+          "\"fan_range_index\":%u,\"pressure_points_pa\":[",
+          (double)config->building_volume_m3, (double)config->floor_area_m2,
+          (double)config->envelope_area_m2, (double)config->building_height_m,
+          (double)config->dimensions_uncertainty_pct,
+          (double)config->altitude_m, (double)config->fan_aperture_cm,
+          (double)config->fan_curve_c, (double)config->fan_curve_n,
+          (double)config->target_tolerance_pa,
+          (unsigned)config->settle_time_s, (unsigned)config->measure_time_s,
+          config->adaptive_windows ? "true" : "false",
+          (unsigned)config->min_settle_time_s,
+          (unsigned)config->min_measure_time_s,
+          (double)config->target_ci_pa, (double)config->max_drift_pa_s,
+          (unsigned)config->baseline_time_s, (double)config->max_baseline_pa,
+          (unsigned)config->reference_pressure_pa,
+          (unsigned)config->min_points_required,
+          config->enforce_iso_9972_rules ? "true" : "false",
+          blower_leakage_fit_method_name(
+              (blower_leakage_fit_method_t)config->fit_method),
+          config->capture_raw_samples ? "true" : "false",
+          (unsigned)config->fan_range_count,
+          (unsigned)config->fan_range_index)) {
+    return false;
+  }
+
+  for (index = 0u; index < config->pressure_points_count &&
+                   index < BLOWER_TEST_MAX_PRESSURE_POINTS;
+       ++index) {
+    if (!web_json_appendf(payload, payload_size, &offset, "%s%.1f",
+                          index == 0u ? "" : ",",
+                          (double)config->pressure_points_pa[index])) {
+      return false;
+    }
+  }
+
+  return web_json_appendf(payload, payload_size, &offset, "]}");
+}
+
+static void web_apply_test_config_json(const char *body,
+                                       blower_test_config_t *config) {
+  float points[BLOWER_TEST_MAX_PRESSURE_POINTS];
+  size_t point_count = 0u;
+  uint32_t uint_value = 0u;
+  char fit_method[16];
+
+  (void)json_extract_float_field(body, "building_volume_m3",
+                                 &config->building_volume_m3);
+  (void)json_extract_float_field(body, "floor_area_m2", &config->floor_area_m2);
+  (void)json_extract_float_field(body, "envelope_area_m2",
+                                 &config->envelope_area_m2);
+  (void)json_extract_float_field(body, "building_height_m",
+                                 &config->building_height_m);
+  (void)json_extract_float_field(body, "dimensions_uncertainty_pct",
+                                 &config->dimensions_uncertainty_pct);
+  (void)json_extract_float_field(body, "altitude_m", &config->altitude_m);
+  (void)json_extract_float_field(body, "fan_aperture_cm",
+                                 &config->fan_aperture_cm);
+  (void)json_extract_float_field(body, "fan_curve_c", &config->fan_curve_c);
+  (void)json_extract_float_field(body, "fan_curve_n", &config->fan_curve_n);
+  (void)json_extract_float_field(body, "target_tolerance_pa",
+                                 &config->target_tolerance_pa);
+  (void)json_extract_bool_field(body, "enforce_iso_9972_rules",
+                                &config->enforce_iso_9972_rules);
+  (void)json_extract_bool_field(body, "adaptive_windows",
+                                &config->adaptive_windows);
+  (void)json_extract_bool_field(body, "capture_raw_samples",
+                                &config->capture_raw_samples);
+  (void)json_extract_float_field(body, "target_ci_pa", &config->target_ci_pa);
+  (void)json_extract_float_field(body, "max_drift_pa_s",
+                                 &config->max_drift_pa_s);
+  (void)json_extract_float_field(body, "max_baseline_pa",
+                                 &config->max_baseline_pa);
+
+  if (json_extract_string_field(body, "fit_method", fit_method,
+                                sizeof(fit_method))) {
+    uint8_t method = 0u;
+    /* Unknown names are left out of range so validation rejects them. */
+    config->fit_method = 0xffu;
+    for (method = 0u; method <= (uint8_t)BLOWER_LEAKAGE_FIT_THEIL_SEN;
+         ++method) {
+      if (strcmp(fit_method, blower_leakage_fit_method_name(
+                                 (blower_leakage_fit_method_t)method)) == 0) {
+        config->fit_method = method;
+        break;
+      }
+    }
+  }
+
+  if (json_extract_uint32_field(body, "settle_time_s", &uint_value)) {
+    config->settle_time_s =
+        uint_value > 0xffffu ? 0xffffu : (uint16_t)uint_value;
+  }
+  if (json_extract_uint32_field(body, "measure_time_s", &uint_value)) {
+    config->measure_time_s =
+        uint_value > 0xffffu ? 0xffffu : (uint16_t)uint_value;
+  }
+  if (json_extract_uint32_field(body, "min_settle_time_s", &uint_value)) {
+    config->min_settle_time_s =
+        uint_value > 0xffffu ? 0xffffu : (uint16_t)uint_value;
+  }
+  if (json_extract_uint32_field(body, "min_measure_time_s", &uint_value)) {
+    config->min_measure_time_s =
+        uint_value > 0xffffu ? 0xffffu : (uint16_t)uint_value;
+  }
+  if (json_extract_uint32_field(body, "baseline_time_s", &uint_value)) {
+    config->baseline_time_s =
+        uint_value > 0xffffu ? 0xffffu : (uint16_t)uint_value;
+  }
+  if (json_extract_uint32_field(body, "reference_pressure_pa", &uint_value)) {
+    config->reference_pressure_pa =
+        uint_value > 0xffu ? 0xffu : (uint8_t)uint_value;
+  }
+  if (json_extract_uint32_field(body, "min_points_required", &uint_value)) {
+    config->min_points_required =
+        uint_value > 0xffu ? 0xffu : (uint8_t)uint_value;
+  }
+
+  if (json_extract_float_array_field(body, "pressure_points_pa", points,
+                                     BLOWER_TEST_MAX_PRESSURE_POINTS,
+                                     &point_count)) {
+    memset(config->pressure_points_pa, 0, sizeof(config->pressure_points_pa));
+    memcpy(config->pressure_points_pa, points, point_count * sizeof(points[0]));
+    config->pressure_points_count = (uint8_t)point_count;
+  }
+}
+
+static bool http_handle_test_report_route(struct netconn *connection,
+                                          const http_request_t *request) {
+  const bool is_latest_route =
+      strcmp(request->path, "/api/test/report/latest") == 0;
+  bool is_active = false;
+  bool has_report = false;
+  size_t offset = 0u;
+  bool payload_ok = false;
+
+  if (is_latest_route) {
+    has_report = blower_test_service_get_latest_report(&g_test_report_snapshot);
+    payload_ok = web_json_appendf(g_test_report_payload,
+                                  sizeof(g_test_report_payload), &offset,
+                                  "{\"report\":");
+  } else {
+    has_report = blower_test_service_get_report_snapshot(
+        &g_test_report_snapshot, &is_active);
+    payload_ok = web_json_appendf(
+        g_test_report_payload, sizeof(g_test_report_payload), &offset,
+        "{\"active\":%s,\"report\":", is_active ? "true" : "false");
+  }
+
+  payload_ok = payload_ok &&
+               web_format_test_report_json(
+                   has_report ? &g_test_report_snapshot : NULL,
+                   g_test_report_payload, sizeof(g_test_report_payload),
+                   &offset) &&
+               web_json_appendf(g_test_report_payload,
+                                sizeof(g_test_report_payload), &offset, "}");
+
+  if (!payload_ok) {
+    http_send_text_response(connection, "500 Internal Server Error",
+                            "application/json", "{\"error\":\"report\"}");
+    return false;
+  }
+
+  if (request->method == HTTP_METHOD_HEAD) {
+    http_send_headers_only(connection, "200 OK", "application/json", offset);
+    return false;
+  }
+
+  http_send_response(connection, "200 OK", "application/json",
+                     (const uint8_t *)g_test_report_payload, offset);
+  return false;
+}
+
+static bool web_format_test_direction_csv(
+    const blower_test_report_t *report,
+    const blower_test_direction_report_t *direction, char *payload,
+    size_t payload_size, size_t *inout_offset) {
+  const blower_test_curve_summary_t *summary = &direction->summary;
+  char summary_columns[128];
+  uint8_t index = 0u;
+
+  if (summary->valid) {
+    (void)snprintf(summary_columns, sizeof(summary_columns),
+                   "%s,%.4f,%.4f,%.5f,%.2f,%.3f,%.2f",
+                   blower_leakage_fit_method_name(
+                       (blower_leakage_fit_method_t)summary->fit_method),
+                   (double)safe_json_float(summary->cl_m3h_pan),
+                   (double)safe_json_float(summary->exponent_n),
+                   (double)safe_json_float(summary->correlation_r),
+                   (double)safe_json_float(summary->q_ref_m3h),
+                   (double)safe_json_float(summary->ach_ref_h1),
+                   (double)safe_json_float(summary->uncertainty_pct));
+  } else {
+    strcpy(summary_columns, ",,,,,,");
+  }
+
+  for (index = 0u; index < direction->point_count &&
+                   index < BLOWER_TEST_MAX_PRESSURE_POINTS;
+       ++index) {
+    const blower_test_point_result_t *point = &direction->points[index];
+    if (!web_json_appendf(
+            payload, payload_size, inout_offset,
+            "%lu,%lu,%u,%.3f,%s,%s,%.1f,%.2f,%.2f,%.3f,%.2f,%.3f,%.2f,%.2f,"
+            "%.1f,%u,%u,%u,%u\r\n",
+            (unsigned long)report->report_id,
+            (unsigned long)report->completed_tick_ms,
+            (unsigned)report->reference_pressure_pa,
+            (double)safe_json_float(report->baseline.bias_pa),
+            blower_test_direction_name(direction->direction), summary_columns,
+            (double)safe_json_float(point->target_pressure_pa),
+            (double)safe_json_float(point->avg_pressure_pa),
+            (double)safe_json_float(point->raw_avg_pressure_pa),
+            (double)safe_json_float(point->pressure_std_error_pa),
+            (double)safe_json_float(point->avg_fan_flow_m3h),
+            (double)safe_json_float(point->flow_std_error_m3h),
+            (double)safe_json_float(point->avg_fan_temperature_c),
+            (double)safe_json_float(point->avg_envelope_temperature_c),
+            (double)safe_json_float(point->avg_pwm_percent),
+            (unsigned)point->sample_count, (unsigned)point->fan_range_index,
+            point->fan_in_range ? 1u : 0u, point->valid ? 1u : 0u)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * GET /api/test/reports?format=json|csv&limit=N&before=ID
+ * Pages through the report log newest first; before is the cursor (the
+ * next page starts below the last id returned). The response is sent with
+ * chunked encoding one report at a time, so memory use does not grow with
+ * the page size.
+ */
+static bool http_handle_test_reports_route(struct netconn *connection,
+                                           const http_request_t *request) {
+  static const char k_csv_header[] =
+      "report_id,completed_ms,reference_pa,baseline_pa,direction,fit_method,"
+      "cl_m3h_pan,n,r,q_ref_m3h,ach_ref_h1,uncertainty_pct,target_pa,"
+      "pressure_pa,raw_pressure_pa,pressure_se_pa,flow_m3h,flow_se_m3h,"
+      "fan_temp_c,env_temp_c,pwm_pct,samples,fan_range,fan_in_range,"
+      "valid\r\n";
+  uint32_t ids[HTTP_TEST_REPORTS_MAX_LIMIT + 1u];
+  char format[8] = "json";
+  char value[16];
+  const char *opening = NULL;
+  char extra_headers[48] = "";
+  uint32_t limit = HTTP_TEST_REPORTS_DEFAULT_LIMIT;
+  uint32_t before_report_id = 0u;
+  uint32_t next_before = 0u;
+  uint32_t sent_count = 0u;
+  size_t id_count = 0u;
+  size_t page_count = 0u;
+  size_t index = 0u;
+  size_t offset = 0u;
+  bool is_csv = false;
+  bool query_ok = true;
+  bool payload_ok = false;
+
+  (void)http_query_get_param(request->query, "format", format, sizeof(format));
+  is_csv = strcmp(format, "csv") == 0;
+  query_ok = is_csv || strcmp(format, "json") == 0;
+  if (http_query_get_param(request->query, "limit", value, sizeof(value))) {
+    query_ok = query_ok &&
+               http_query_get_uint32(request->query, "limit", &limit) &&
+               limit > 0u;
+  }
+  if (http_query_get_param(request->query, "before", value, sizeof(value))) {
+    query_ok = query_ok && http_query_get_uint32(request->query, "before",
+                                                 &before_report_id);
+  }
+  if (!query_ok) {
+    http_send_text_response(connection, "400 Bad Request", "application/json",
+                            "{\"error\":\"query\"}");
+    return false;
+  }
+  if (limit > HTTP_TEST_REPORTS_MAX_LIMIT) {
+    limit = HTTP_TEST_REPORTS_MAX_LIMIT;
+  }
+
+  /* One id past the page tells whether another page follows. */
+  id_count = blower_report_log_list(before_report_id, ids, limit + 1u);
+  page_count = id_count > limit ? limit : id_count;
+  if (id_count > limit) {
+    next_before = ids[page_count - 1u];
+    (void)snprintf(extra_headers, sizeof(extra_headers),
+                   "X-Next-Before: %lu\r\n", (unsigned long)next_before);
+  }
+
+  if (!http_send_chunked_headers(connection, "200 OK",
+                                 is_csv ? "text/csv" : "application/json",
+                                 extra_headers)) {
+    return false;
+  }
+  if (request->method == HTTP_METHOD_HEAD) {
+    return false;
+  }
+
+  opening = is_csv ? k_csv_header : "{\"reports\":[";
+  if (!http_send_chunk(connection, opening, strlen(opening))) {
+    return false;
+  }
+
+  for (index = 0u; index < page_count; ++index) {
+    /* A report recycled since the listing is simply left out. */
+    if (!blower_report_log_read(ids[index], &g_test_report_snapshot)) {
+      continue;
+    }
+
+    offset = 0u;
+    if (is_csv) {
+      payload_ok =
+          web_format_test_direction_csv(
+              &g_test_report_snapshot, &g_test_report_snapshot.pressurization,
+              g_test_report_payload, sizeof(g_test_report_payload),
+              &offset) &&
+          web_format_test_direction_csv(
+              &g_test_report_snapshot,
+              &g_test_report_snapshot.depressurization, g_test_report_payload,
+              sizeof(g_test_report_payload), &offset);
+    } else {
+      payload_ok =
+          (sent_count == 0u ||
+           web_json_appendf(g_test_report_payload,
+                            sizeof(g_test_report_payload), &offset, ",")) &&
+          web_format_test_report_json(&g_test_report_snapshot,
+                                      g_test_report_payload,
+                                      sizeof(g_test_report_payload), &offset);
+    }
+
+    /* Dropping the connection without the last chunk marks the body bad. */
+    if (!payload_ok ||
+        !http_send_chunk(connection, g_test_report_payload, offset)) {
+      return false;
+    }
+    sent_count += 1u;
+  }
+
+  if (!is_csv) {
+    offset = 0u;
+    payload_ok = web_json_appendf(
+        g_test_report_payload, sizeof(g_test_report_payload), &offset,
+        "],\"count\":%lu,\"total\":%lu,\"next_before\":",
+        (unsigned long)sent_count, (unsigned long)blower_report_log_count());
+    payload_ok = payload_ok &&
+                 (next_before != 0u
+                      ? web_json_appendf(g_test_report_payload,
+                                         sizeof(g_test_report_payload),
+                                         &offset, "%lu}",
+                                         (unsigned long)next_before)
+                      : web_json_appendf(g_test_report_payload,
+                                         sizeof(g_test_report_payload),
+                                         &offset, "null}"));
+    if (!payload_ok ||
+        !http_send_chunk(connection, g_test_report_payload, offset)) {
+      return false;
+    }
+  }
+
+  (void)http_send_last_chunk(connection);
+  return false;
+}
+
+typedef struct {
+  struct netconn *connection;
+  size_t offset;
+  bool ok;
+} http_test_samples_stream_t;
+
+static bool http_test_samples_visit(
+    const blower_sample_capture_sample_t *sample, void *context) {
+  http_test_samples_stream_t *stream = (http_test_samples_stream_t *)context;
+
+  stream->ok = web_json_appendf(
+      g_test_report_payload, sizeof(g_test_report_payload), &stream->offset,
+      "%lu,%s,%u,%lu,%.2f,%.2f,%.2f,%.2f,%.1f\r\n",
+      (unsigned long)sample->report_id,
+      blower_test_direction_name((blower_test_direction_t)sample->direction),
+      (unsigned)sample->point_index, (unsigned long)sample->tick_ms,
+      (double)sample->envelope_pressure_cpa / 100.0,
+      (double)sample->fan_pressure_cpa / 100.0,
+      (double)sample->fan_temperature_cc / 100.0,
+      (double)sample->envelope_temperature_cc / 100.0,
+      (double)sample->power_permille / 10.0);
+  if (stream->ok && stream->offset >= HTTP_TEST_SAMPLES_FLUSH_BYTES) {
+    stream->ok = http_send_chunk(stream->connection, g_test_report_payload,
+                                 stream->offset);
+    stream->offset = 0u;
+  }
+
+  return stream->ok;
+}
+
+/*
+ * GET /api/test/samples?id=N
+ * Raw samples captured during the measuring windows of report N, oldest
+ * first, as CSV. The body is decoded from the sample log page by page and
+ * streamed with chunked encoding.
+ */
+static bool http_handle_test_samples_route(struct netconn *connection,
+                                           const http_request_t *request) {
+  static const char k_csv_header[] =
+      "report_id,direction,point,tick_ms,envelope_pa,fan_pa,fan_temp_c,"
+      "env_temp_c,power_pct\r\n";
+  blower_sample_capture_stats_t stats = {0};
+  http_test_samples_stream_t stream = {
+      .connection = connection,
+      .offset = 0u,
+      .ok = true,
+  };
+  char extra_headers[48] = "";
+  uint32_t report_id = 0u;
+
+  if (!http_query_get_uint32(request->query, "id", &report_id) ||
+      report_id == 0u) {
+    http_send_text_response(connection, "400 Bad Request", "application/json",
+                            "{\"error\":\"query\"}");
+    return false;
+  }
+  if (!blower_sample_capture_has_report(report_id)) {
+    http_send_text_response(connection, "404 Not Found", "application/json",
+                            "{\"error\":\"not_found\"}");
+    return false;
+  }
+
+  blower_sample_capture_get_stats(&stats);
+  (void)snprintf(extra_headers, sizeof(extra_headers),
+                 "X-Capture-Dropped: %lu\r\n",
+                 (unsigned long)stats.dropped_samples);
+  if (!http_send_chunked_headers(connection, "200 OK", "text/csv",
+                                 extra_headers)) {
+    return false;
+  }
+  if (request->method == HTTP_METHOD_HEAD) {
+    return false;
+  }
+
+  if (!http_send_chunk(connection, k_csv_header, sizeof(k_csv_header) - 1u)) {
+    return false;
+  }
+
+  (void)blower_sample_capture_for_each(report_id, http_test_samples_visit,
+                                       &stream);
+  if (!stream.ok || (stream.offset > 0u &&
+                     !http_send_chunk(connection, g_test_report_payload,
+                                      stream.offset))) {
+    return false;
+  }
+
+  (void)http_send_last_chunk(connection);
+  return false;
+}
+
+static bool web_format_fan_ranges_json(const blower_test_config_t *config,
+                                       char *payload, size_t payload_size) {
+  size_t offset = 0u;
+  uint8_t index = 0u;
+  uint8_t point = 0u;
+
+  if (!web_json_appendf(payload, payload_size, &offset,
+                        "{\"index\":%u,\"count\":%u,\"max_ranges\":%u,"
+                        "\"ranges\":[",
+                        (unsigned)config->fan_range_index,
+                        (unsigned)config->fan_range_count,
+                        (unsigned)BLOWER_FAN_CALIBRATION_MAX_RANGES)) {
+    return false;
+  }
+
+  for (index = 0u; index < config->fan_range_count &&
+                   index < BLOWER_FAN_CALIBRATION_MAX_RANGES;
+       ++index) {
+    const blower_fan_calibration_range_t *range = &config->fan_ranges[index];
+
+    if (!web_json_appendf(
+            payload, payload_size, &offset,
+            "%s{\"kind\":\"%s\",\"min_pa\":%.2f,\"max_pa\":%.2f,"
+            "\"c\":%.4f,\"n\":%.4f,\"table_pa\":[",
+            index == 0u ? "" : ",",
+            blower_fan_calibration_kind_name(
+                (blower_fan_calibration_kind_t)range->kind),
+            (double)safe_json_float(range->min_pressure_pa),
+            (double)safe_json_float(range->max_pressure_pa),
+            (double)safe_json_float(range->c),
+            (double)safe_json_float(range->n))) {
+      return false;
+    }
+    for (point = 0u; point < range->table_count; ++point) {
+      if (!web_json_appendf(payload, payload_size, &offset, "%s%.2f",
+                            point == 0u ? "" : ",",
+                            (double)range->table_pressure_pa[point])) {
+        return false;
+      }
+    }
+    if (!web_json_appendf(payload, payload_size, &offset,
+                          "],\"table_m3h\":[")) {
+      return false;
+    }
+    for (point = 0u; point < range->table_count; ++point) {
+      if (!web_json_appendf(payload, payload_size, &offset, "%s%.2f",
+                            point == 0u ? "" : ",",
+                            (double)range->table_flow_m3h[point])) {
+        return false;
+      }
+    }
+    if (!web_json_appendf(payload, payload_size, &offset, "]}")) {
+      return false;
+    }
+  }
+
+  return web_json_appendf(payload, payload_size, &offset, "]}");
+}
+
+/*
+ * Fields of one fan range from a flat JSON body; absent fields keep their
+ * value. Returns false for an unknown kind or mismatched table arrays.
+ */
+static bool web_apply_fan_range_json(const char *body,
+                                     blower_fan_calibration_range_t *range) {
+  float pressures[BLOWER_FAN_CALIBRATION_MAX_TABLE_POINTS];
+  float flows[BLOWER_FAN_CALIBRATION_MAX_TABLE_POINTS];
+  size_t pressure_count = 0u;
+  size_t flow_count = 0u;
+  bool has_pressures = false;
+  bool has_flows = false;
+  char kind[16];
+
+  if (json_extract_string_field(body, "kind", kind, sizeof(kind))) {
+    if (strcmp(kind, blower_fan_calibration_kind_name(
+                         BLOWER_FAN_CALIBRATION_POWER_LAW)) == 0) {
+      range->kind = (uint8_t)BLOWER_FAN_CALIBRATION_POWER_LAW;
+    } else if (strcmp(kind, blower_fan_calibration_kind_name(
+                                BLOWER_FAN_CALIBRATION_TABLE)) == 0) {
+      range->kind = (uint8_t)BLOWER_FAN_CALIBRATION_TABLE;
+    } else {
+      return false;
+    }
+  }
+  (void)json_extract_float_field(body, "min_pa", &range->min_pressure_pa);
+  (void)json_extract_float_field(body, "max_pa", &range->max_pressure_pa);
+  (void)json_extract_float_field(body, "c", &range->c);
+  (void)json_extract_float_field(body, "n", &range->n);
+
+  has_pressures = json_extract_float_array_field(
+      body, "table_pa", pressures, BLOWER_FAN_CALIBRATION_MAX_TABLE_POINTS,
+      &pressure_count);
+  has_flows = json_extract_float_array_field(
+      body, "table_m3h", flows, BLOWER_FAN_CALIBRATION_MAX_TABLE_POINTS,
+      &flow_count);
+  if (has_pressures != has_flows) {
+    return false;
+  }
+  if (has_pressures) {
+    if (pressure_count != flow_count) {
+      return false;
+    }
+    memset(range->table_pressure_pa, 0, sizeof(range->table_pressure_pa));
+    memset(range->table_flow_m3h, 0, sizeof(range->table_flow_m3h));
+    memcpy(range->table_pressure_pa, pressures,
+           pressure_count * sizeof(pressures[0]));
+    memcpy(range->table_flow_m3h, flows, flow_count * sizeof(flows[0]));
+    range->table_count = (uint8_t)pressure_count;
+  }
+  return true;
+}
+
+/*
+ * GET  /api/test/fan_ranges                 registry and mounted range
+ * POST /api/test/fan_ranges?index=N         sets range N (N == count adds
+ *                                           one); {"remove":true} drops it
+ * POST /api/test/fan_ranges/select?index=N  mounts range N; resumes a test
+ *                                           waiting in ring_change
+ */
+static bool http_handle_fan_ranges_route(struct netconn *connection,
+                                         const http_request_t *request) {
+  blower_test_config_t config;
+  uint32_t range_index = 0u;
+
+  if (request->method == HTTP_METHOD_POST &&
+      !http_query_get_uint32(request->query, "index", &range_index)) {
+    http_send_text_response(connection, "400 Bad Request", "application/json",
+                            "{\"error\":\"query\"}");
+    return false;
+  }
+
+  if (request->method == HTTP_METHOD_POST &&
+      strcmp(request->path, "/api/test/fan_ranges/select") == 0) {
+    if (range_index > 0xffu ||
+        !blower_test_service_select_fan_range((uint8_t)range_index)) {
+      http_send_text_response(
+          connection, "409 Conflict", "application/json",
+          "{\"status\":\"error\",\"reason\":\"index_or_active\"}");
+      return false;
+    }
+    debug_logs_append("CMD TEST FAN RANGE SELECTED");
+  } else if (request->method == HTTP_METHOD_POST) {
+    bool remove = false;
+
+    blower_test_service_get_config(&config);
+    (void)json_extract_bool_field(request->body, "remove", &remove);
+    if (range_index >= BLOWER_FAN_CALIBRATION_MAX_RANGES ||
+        range_index > config.fan_range_count ||
+        (remove && range_index == config.fan_range_count)) {
+      http_send_text_response(connection, "400 Bad Request",
+                              "application/json",
+                              "{\"status\":\"error\",\"reason\":\"index\"}");
+      return false;
+    }
+
+    if (remove) {
+      memmove(&config.fan_ranges[range_index],
+              &config.fan_ranges[range_index + 1u],
+              (config.fan_range_count - range_index - 1u) *
+                  sizeof(config.fan_ranges[0]));
+      config.fan_range_count -= 1u;
+      if (config.fan_range_index > range_index) {
+        config.fan_range_index -= 1u;
+      } else if (config.fan_range_index == range_index) {
+        config.fan_range_index = 0u;
+      }
+    } else {
+      if (range_index == config.fan_range_count) {
+        config.fan_ranges[range_index] = (blower_fan_calibration_range_t){
+            .kind = (uint8_t)BLOWER_FAN_CALIBRATION_POWER_LAW,
+        };
+        config.fan_range_count += 1u;
+      }
+      if (!web_apply_fan_range_json(request->body,
+                                    &config.fan_ranges[range_index])) {
+        http_send_text_response(
+            connection, "400 Bad Request", "application/json",
+            "{\"status\":\"error\",\"reason\":\"range\"}");
+        return false;
+      }
+    }
+
+    if (!blower_test_service_set_config(&config)) {
+      http_send_text_response(
+          connection, "400 Bad Request", "application/json",
+          "{\"status\":\"error\",\"reason\":\"invalid_or_active\"}");
+      return false;
+    }
+    debug_logs_append("CMD TEST FAN RANGES UPDATED");
+  }
+
+  blower_test_service_get_config(&config);
+  if (!web_format_fan_ranges_json(&config, g_test_report_payload,
+                                  sizeof(g_test_report_payload))) {
+    http_send_text_response(connection, "500 Internal Server Error",
+                            "application/json", "{\"error\":\"test\"}");
+    return false;
+  }
+
+  if (request->method == HTTP_METHOD_HEAD) {
+    http_send_headers_only(connection, "200 OK", "application/json",
+                           strlen(g_test_report_payload));
+    return false;
+  }
+
+  http_send_response(connection, "200 OK", "application/json",
+                     (const uint8_t *)g_test_report_payload,
+                     strlen(g_test_report_payload));
+  return false;
+}
+
+static bool http_handle_test_route(struct netconn *connection,
+                                   const http_request_t *request) {
+  char payload[HTTP_RESPONSE_PAYLOAD_BUFFER_SIZE];
+  bool payload_ok = false;
+
+  if (strcmp(request->path, "/api/test/start") == 0) {
+    int mode = (int)BLOWER_TEST_MODE_BOTH;
+
+    (void)json_extract_int_field(request->body, "mode", &mode);
+    if (mode < (int)BLOWER_TEST_MODE_PRESSURIZATION ||
+        mode > (int)BLOWER_TEST_MODE_BOTH) {
+      http_send_text_response(connection, "400 Bad Request", "application/json",
+                              "{\"status\":\"error\",\"reason\":\"mode\"}");
+      return false;
+    }
+    if (!blower_test_service_start((blower_test_mode_t)mode)) {
+      http_send_text_response(connection, "409 Conflict", "application/json",
+                              "{\"status\":\"error\",\"reason\":\"busy\"}");
+      return false;
+    }
+    debug_logs_append("CMD TEST START");
+  } else if (strcmp(request->path, "/api/test/stop") == 0) {
+    blower_test_service_stop();
+    debug_logs_append("CMD TEST STOP");
+  } else if (strcmp(request->path, "/api/test/config/reset") == 0) {
+    blower_test_service_reset_config_to_defaults();
+  } else if (strcmp(request->path, "/api/test/config") == 0 &&
+             request->method == HTTP_METHOD_POST) {
+    blower_test_config_t config;
+
+    blower_test_service_get_config(&config);
+    web_apply_test_config_json(request->body, &config);
+    if (!blower_test_service_set_config(&config)) {
+      http_send_text_response(
+          connection, "400 Bad Request", "application/json",
+          "{\"status\":\"error\",\"reason\":\"invalid_or_active\"}");
+      return false;
+    }
+    debug_logs_append("CMD TEST CONFIG UPDATED");
+  }
+
+  if (strncmp(request->path, "/api/test/config", 16u) == 0) {
+    blower_test_config_t config;
+
+    blower_test_service_get_config(&config);
+    payload_ok = web_format_test_config_json(&config, payload, sizeof(payload));
+  } else {
+    blower_test_runtime_status_t runtime;
+
+    blower_test_service_get_runtime(&runtime);
+    payload_ok =
+        web_format_test_status_json(&runtime, payload, sizeof(payload));
+  }
+
+  if (!payload_ok) {
+    http_send_text_response(connection, "500 Internal Server Error",
+                            "application/json", "{\"error\":\"test\"}");
+    return false;
+  }
+
+  if (request->method == HTTP_METHOD_HEAD) {
+    http_send_headers_only(connection, "200 OK", "application/json",
+                           strlen(payload));
+    return false;
+  }
+
+  http_send_response(connection, "200 OK", "application/json",
+                     (const uint8_t *)payload, strlen(payload));
+  return false;
+}
+
+static bool web_format_control_params_json(
+    const blower_control_params_t *params, char *payload, size_t payload_size) {
+  size_t offset = 0u;
+  size_t index = 0u;
+  int written = snprintf(payload, payload_size,
+                         "{\"schema\":%u,\"revision\":%lu,\"params\":{",
+                         (unsigned)BLOWER_CONTROL_PARAMS_SCHEMA_VERSION,
+                         (unsigned long)params->revision);
+
+  if (written <= 0 || (size_t)written >= payload_size) {
+    return false;
+  }
+  offset = (size_t)written;
+
+  for (index = 0u; index < blower_control_params_field_count(); ++index) {
+    const blower_control_param_field_t *field =
+        blower_control_params_field(index);
+    const float value = blower_control_params_field_get(params, field);
+
+    if (field->type == BLOWER_CONTROL_PARAM_TYPE_UINT32) {
+      written = snprintf(payload + offset, payload_size - offset,
+                         "%s\"%s\":%lu", index == 0u ? "" : ",", field->name,
+                         (unsigned long)value);
+    } else {
+      written = snprintf(payload + offset, payload_size - offset,
+                         "%s\"%s\":%.6g", index == 0u ? "" : ",", field->name,
+                         (double)value);
+    }
+    if (written <= 0 || (size_t)written >= payload_size - offset) {
+      return false;
+    }
+    offset += (size_t)written;
+  }
+
+  written = snprintf(payload + offset, payload_size - offset, "}}");
+  return written > 0 && (size_t)written < payload_size - offset;
+}
+
+static bool http_handle_control_params_route(struct netconn *connection,
+                                             const http_request_t *request) {
+  blower_control_params_t params;
+  char payload[HTTP_CONTROL_PARAMS_PAYLOAD_BUFFER_SIZE];
+
+  if (request->method == HTTP_METHOD_POST) {
+    blower_control_params_result_t result = BLOWER_CONTROL_PARAMS_OK;
+    const char *invalid_field = NULL;
+    uint32_t expected_revision = 0u;
+    size_t index = 0u;
+
+    if (strcmp(request->path, "/api/control/params/reset") == 0) {
+      blower_control_params_defaults(&params);
+    } else {
+      blower_control_params_service_get(&params);
+      for (index = 0u; index < blower_control_params_field_count(); ++index) {
+        const blower_control_param_field_t *field =
+            blower_control_params_field(index);
+        float value = 0.0f;
+
+        if (json_extract_float_field(request->body, field->name, &value)) {
+          blower_control_params_field_set(&params, field, value);
+        }
+      }
+    }
+
+    (void)json_extract_uint32_field(request->body, "revision",
+                                    &expected_revision);
+    result = blower_control_params_service_set(&params, expected_revision,
+                                               &invalid_field);
+
+    if (result == BLOWER_CONTROL_PARAMS_INVALID) {
+      const int written = snprintf(
+          payload, sizeof(payload),
+          "{\"status\":\"error\",\"reason\":\"invalid\",\"field\":\"%s\"}",
+          invalid_field != NULL ? invalid_field : "");
+      if (written <= 0 || (size_t)written >= sizeof(payload)) {
+        http_send_text_response(connection, "500 Internal Server Error",
+                                "application/json", "{\"status\":\"error\"}");
+        return false;
+      }
+      http_send_response(connection, "400 Bad Request", "application/json",
+                         (const uint8_t *)payload, strlen(payload));
+      return false;
+    }
+    if (result == BLOWER_CONTROL_PARAMS_STALE_REVISION) {
+      http_send_text_response(
+          connection, "409 Conflict", "application/json",
+          "{\"status\":\"error\",\"reason\":\"stale_revision\"}");
+      return false;
+    }
+    if (result == BLOWER_CONTROL_PARAMS_BUSY) {
+      http_send_text_response(connection, "503 Service Unavailable",
+                              "application/json",
+                              "{\"status\":\"error\",\"reason\":\"busy\"}");
+      return false;
+    }
+
+    debug_logs_append("CMD CONTROL PARAMS UPDATED");
+  }
+
+  blower_control_params_service_get(&params);
+  if (!web_format_control_params_json(&params, payload, sizeof(payload))) {
+    http_send_text_response(connection, "500 Internal Server Error",
+                            "application/json", "{\"error\":\"params\"}");
+    return false;
+  }
+
+  if (request->method == HTTP_METHOD_HEAD) {
+    http_send_headers_only(connection, "200 OK", "application/json",
+                           strlen(payload));
+    return false;
+  }
+
+  http_send_response(connection, "200 OK", "application/json",
+                     (const uint8_t *)payload, strlen(payload));
+  return false;
+}
+
+static bool http_handle_api_post_route(struct netconn *connection,
+                                       const http_request_t *request) {
+  int value = 0;
+  bool accepted = false;
+  char response_payload[192];
+
+  if (request->method != HTTP_METHOD_POST) {
+    http_send_text_response(connection, "405 Method Not Allowed", "text/plain",
+                            "Method Not Allowed");
+    return false;
+  }
+
+  if (strcmp(request->path, "/api/calibrate") == 0) {
+    blower_metrics_snapshot_t metrics_snapshot = {0};
+    const bool has_metrics = blower_metrics_service_get_snapshot(&metrics_snapshot);
+    int written = 0;
+
+    if (!has_metrics || (!metrics_snapshot.fan_sample_valid &&
+                        !metrics_snapshot.envelope_sample_valid)) {
+      const char *reason = !has_metrics ? "metrics_unavailable" : "no_valid_samples";
+      written = snprintf(
+          response_payload, sizeof(response_payload),
+          "{\"status\":\"error\",\"reason\":\"%s\",\"fan_ok\":false,\"envelope_ok\":false}",
+          reason);
+      if (written <= 0 || (size_t)written >= sizeof(response_payload)) {
+        http_send_text_response(connection, "500 Internal Server Error",
+                                "application/json", "{\"status\":\"error\"}");
+        return false;
+      }
+      http_send_response(connection, "409 Conflict",
+                         "application/json", (const uint8_t *)response_payload,
+                         strlen(response_payload));
+      return false;
+    }
+
+    blower_metrics_service_begin_calibration();
+
+    written = snprintf(
+        response_payload, sizeof(response_payload),
+        "{\"status\":\"ok\",\"reason\":\"calibration_started\","
+        "\"fan_ok\":%s,\"envelope_ok\":%s}",
+        metrics_snapshot.fan_sample_valid ? "true" : "false",
+        metrics_snapshot.envelope_sample_valid ? "true" : "false");
+
+    if (written <= 0 || (size_t)written >= sizeof(response_payload)) {
       http_send_text_response(connection, "500 Internal Server Error",
                               "application/json", "{\"status\":\"error\"}");
       return false;
@@ -1447,7 +2689,7 @@ static bool http_handle_api_post_route(struct netconn *connection,
                               "PWM value must be between 0 and 100");
       return false;
     }
-    blower_control_set_manual_pwm_percent((uint8_t)value);
+    accepted = blower_control_set_manual_pwm_percent((uint8_t)value);
     debug_logs_append("CMD PWM updated");
   } else if (strcmp(request->path, "/api/led") == 0) {
     if (value != 0 && value != 1) {
@@ -1455,15 +2697,26 @@ static bool http_handle_api_post_route(struct netconn *connection,
                               "LED value must be 0 or 1");
       return false;
     }
-    blower_control_set_auto_hold_enabled(value == 1);
+    accepted = blower_control_set_auto_hold_enabled(value == 1);
     debug_logs_append(value == 1 ? "CMD AUTO_HOLD ON" : "CMD AUTO_HOLD OFF");
+  } else if (strcmp(request->path, "/api/mode") == 0) {
+    if (value < (int)BLOWER_CONTROL_MODE_MANUAL_PERCENT ||
+        value > (int)BLOWER_CONTROL_MODE_PREDICTIVE_TARGET) {
+      http_send_text_response(connection, "400 Bad Request", "text/plain",
+                              "Mode value must be between 0 and 3");
+      return false;
+    }
+    accepted = blower_control_set_mode((blower_control_mode_t)value);
+    debug_logs_append(value == (int)BLOWER_CONTROL_MODE_PREDICTIVE_TARGET
+                          ? "CMD MODE PREDICTIVE"
+                          : "CMD MODE UPDATED");
   } else if (strcmp(request->path, "/api/relay") == 0) {
     if (value != 0 && value != 1) {
       http_send_text_response(connection, "400 Bad Request", "text/plain",
                               "Relay value must be 0 or 1");
       return false;
     }
-    blower_control_set_relay_enabled(value == 1);
+    accepted = blower_control_set_relay_enabled(value == 1);
     debug_logs_append(value == 1 ? "CMD RELAY ON" : "CMD RELAY OFF");
   } else {
     http_send_text_response(connection, "404 Not Found", "text/plain",
@@ -1471,100 +2724,729 @@ static bool http_handle_api_post_route(struct netconn *connection,
     return false;
   }
 
-  {
-    const int written =
-        snprintf(response_payload, sizeof(response_payload),
-                 "{\"status\":\"ok\",\"value\":%d}", value);
-    if (written <= 0 || (size_t)written >= sizeof(response_payload)) {
-      http_send_text_response(connection, "500 Internal Server Error",
-                              "application/json", "{\"status\":\"error\"}");
-      return false;
+  if (!accepted) {
+    debug_logs_append("CMD rejected: control queue full");
+    http_send_text_response(connection, "503 Service Unavailable",
+                            "application/json",
+                            "{\"status\":\"error\",\"reason\":\"queue_full\"}");
+    return false;
+  }
+
+  {
+    const int written =
+        snprintf(response_payload, sizeof(response_payload),
+                 "{\"status\":\"ok\",\"value\":%d}", value);
+    if (written <= 0 || (size_t)written >= sizeof(response_payload)) {
+      http_send_text_response(connection, "500 Internal Server Error",
+                              "application/json", "{\"status\":\"error\"}");
+      return false;
+    }
+  }
+
+  http_send_response(connection, "200 OK", "application/json",
+                     (const uint8_t *)response_payload, strlen(response_payload));
+  return false;
+}
+
+static bool http_handle_debug_route(struct netconn *connection,
+                                    const http_request_t *request) {
+#if APP_ENABLE_DEBUG_HTTP_ROUTES
+  if (strcmp(request->path, "/debug/stream") == 0 &&
+      request->method == HTTP_METHOD_POST) {
+    bool enabled = false;
+    char payload[64];
+
+    if (!json_extract_bool_field(request->body, "enabled", &enabled)) {
+      http_send_text_response(connection, "400 Bad Request", "text/plain",
+                              "Missing or invalid 'enabled'");
+      return false;
+    }
+
+    debug_logs_enabled_set(enabled);
+    if (!enabled) {
+      debug_logs_clear();
+    }
+
+    {
+      const int written = snprintf(
+          payload, sizeof(payload), "{\"status\":\"ok\",\"logs_enabled\":%s}",
+          enabled ? "true" : "false");
+      if (written <= 0 || (size_t)written >= sizeof(payload)) {
+        http_send_text_response(connection, "500 Internal Server Error",
+                                "application/json", "{\"status\":\"error\"}");
+        return false;
+      }
+    }
+
+    http_send_response(connection, "200 OK", "application/json",
+                       (const uint8_t *)payload, strlen(payload));
+    return false;
+  }
+
+  if (strcmp(request->path, "/debug/stream") == 0 &&
+      request->method == HTTP_METHOD_GET) {
+    const bool enabled = debug_logs_enabled_get();
+    char payload[64];
+    const int written =
+        snprintf(payload, sizeof(payload), "{\"logs_enabled\":%s}",
+                 enabled ? "true" : "false");
+    if (written <= 0 || (size_t)written >= sizeof(payload)) {
+      http_send_text_response(connection, "500 Internal Server Error",
+                              "application/json", "{\"status\":\"error\"}");
+      return false;
+    }
+    http_send_response(connection, "200 OK", "application/json",
+                       (const uint8_t *)payload, strlen(payload));
+    return false;
+  }
+
+  if (strcmp(request->path, "/debug/clear") == 0 &&
+      request->method == HTTP_METHOD_POST) {
+    static const char k_ok_payload[] =
+        "{\"status\":\"ok\",\"message\":\"Debug buffer cleared\"}";
+    debug_logs_clear();
+    http_send_response(connection, "200 OK", "application/json",
+                       (const uint8_t *)k_ok_payload, sizeof(k_ok_payload) - 1u);
+    return false;
+  }
+
+  if (strcmp(request->path, "/debug/logs") == 0 &&
+      request->method == HTTP_METHOD_GET) {
+    debug_logs_copy(g_test_report_payload, sizeof(g_test_report_payload));
+    http_send_response(connection, "200 OK", "text/plain; charset=utf-8",
+                       (const uint8_t *)g_test_report_payload,
+                       strlen(g_test_report_payload));
+    return false;
+  }
+
+  http_send_text_response(connection, "404 Not Found", "text/plain", "Not Found");
+  return false;
+#else
+  (void)request;
+  http_send_text_response(connection, "404 Not Found", "text/plain", "Not Found");
+  return false;
+#endif
+}
+
+static bool web_format_sys_tasks_json(
+    const sys_task_stats_snapshot_t *snapshot, char *payload,
+    size_t payload_size) {
+  const sys_task_stats_heap_t *heap = &snapshot->heap;
+  size_t offset = 0u;
+  uint32_t index = 0u;
+
+  if (!web_json_appendf(payload, payload_size, &offset,
+                        "{\"uptime_ms\":%lu,\"window_us\":%lu,"
+                        "\"cpu_load_permille\":%u,\"task_count\":%lu,"
+                        "\"truncated\":%s,\"tasks\":[",
+                        (unsigned long)to_ms_since_boot(get_absolute_time()),
+                        (unsigned long)snapshot->window_us,
+                        (unsigned)snapshot->cpu_load_permille,
+                        (unsigned long)snapshot->task_count,
+                        snapshot->truncated ? "true" : "false")) {
+    return false;
+  }
+
+  for (index = 0u; index < snapshot->task_count; ++index) {
+    const sys_task_stats_task_t *task = &snapshot->tasks[index];
+    char name_escaped[(SYS_TASK_STATS_NAME_LEN * 2u) + 1u];
+
+    if (!json_escape_string(task->name, name_escaped, sizeof(name_escaped)) ||
+        !web_json_appendf(
+            payload, payload_size, &offset,
+            "%s{\"name\":\"%s\",\"number\":%lu,\"state\":\"%s\","
+            "\"priority\":%u,\"base_priority\":%u,\"idle\":%s,"
+            "\"stack_size_words\":%lu,\"stack_high_water_words\":%lu,"
+            "\"stack_min_free_bytes\":%lu,\"run_time_us\":%lu,"
+            "\"cpu_permille\":%u}",
+            index == 0u ? "" : ",", name_escaped,
+            (unsigned long)task->number,
+            sys_task_stats_state_name(task->state),
+            (unsigned)task->priority, (unsigned)task->base_priority,
+            task->idle ? "true" : "false",
+            (unsigned long)task->stack_size_words,
+            (unsigned long)task->stack_high_water_words,
+            (unsigned long)(task->stack_high_water_words * sizeof(uint32_t)),
+            (unsigned long)task->run_time_us,
+            (unsigned)task->cpu_permille)) {
+      return false;
+    }
+  }
+
+  return web_json_appendf(
+      payload, payload_size, &offset,
+      "],\"heap\":{\"total_bytes\":%lu,\"free_bytes\":%lu,"
+      "\"min_ever_free_bytes\":%lu,\"largest_free_block_bytes\":%lu,"
+      "\"smallest_free_block_bytes\":%lu,\"free_blocks\":%lu,"
+      "\"allocations\":%lu,\"frees\":%lu,"
+      "\"fragmentation_permille\":%u}}",
+      (unsigned long)heap->total_bytes, (unsigned long)heap->free_bytes,
+      (unsigned long)heap->min_ever_free_bytes,
+      (unsigned long)heap->largest_free_block_bytes,
+      (unsigned long)heap->smallest_free_block_bytes,
+      (unsigned long)heap->free_blocks, (unsigned long)heap->allocations,
+      (unsigned long)heap->frees, (unsigned)heap->fragmentation_permille);
+}
+
+static bool http_handle_sys_tasks_route(struct netconn *connection,
+                                        const http_request_t *request) {
+  static sys_task_stats_snapshot_t snapshot;
+
+  sys_task_stats_collect(&snapshot);
+  if (!web_format_sys_tasks_json(&snapshot, g_test_report_payload,
+                                 sizeof(g_test_report_payload))) {
+    http_send_text_response(connection, "500 Internal Server Error",
+                            "application/json", "{\"error\":\"sys_tasks\"}");
+    return false;
+  }
+
+  if (request->method == HTTP_METHOD_HEAD) {
+    http_send_headers_only(connection, "200 OK", "application/json",
+                           strlen(g_test_report_payload));
+    return false;
+  }
+
+  http_send_response(connection, "200 OK", "application/json",
+                     (const uint8_t *)g_test_report_payload,
+                     strlen(g_test_report_payload));
+  return false;
+}
+
+static bool web_append_log2_histogram_json(char *payload, size_t payload_size,
+                                           size_t *inout_offset,
+                                           const sys_histogram_t *histogram) {
+  uint32_t bucket = 0u;
+
+  if (!web_json_appendf(payload, payload_size, inout_offset,
+                        "\"log2_histogram\":[")) {
+    return false;
+  }
+  for (bucket = 0u; bucket < SYS_HISTOGRAM_BUCKET_COUNT; ++bucket) {
+    if (!web_json_appendf(payload, payload_size, inout_offset, "%s%lu",
+                          bucket == 0u ? "" : ",",
+                          (unsigned long)histogram->buckets[bucket])) {
+      return false;
+    }
+  }
+  return web_json_appendf(payload, payload_size, inout_offset, "]");
+}
+
+static bool web_format_sys_profile_json(
+    const sys_profiler_snapshot_t *snapshot, char *payload,
+    size_t payload_size) {
+  const float cycles_per_us =
+      snapshot->cpu_hz > 0u ? (float)snapshot->cpu_hz / 1000000.0f : 1.0f;
+  size_t offset = 0u;
+  uint32_t index = 0u;
+
+  if (!web_json_appendf(payload, payload_size, &offset,
+                        "{\"enabled\":%s,\"cycle_counter\":%s,"
+                        "\"cpu_hz\":%lu,\"probes\":[",
+                        snapshot->enabled ? "true" : "false",
+                        snapshot->cycle_counter ? "true" : "false",
+                        (unsigned long)snapshot->cpu_hz)) {
+    return false;
+  }
+
+  for (index = 0u; snapshot->enabled && index < SYS_PROFILE_PROBE_COUNT;
+       ++index) {
+    const sys_histogram_t *stats = &snapshot->probes[index];
+    const uint32_t mean_cycles = sys_histogram_mean(stats);
+    const uint32_t p50_cycles = sys_histogram_percentile(stats, 0.5f);
+    const uint32_t p99_cycles = sys_histogram_percentile(stats, 0.99f);
+
+    if (!web_json_appendf(
+            payload, payload_size, &offset,
+            "%s{\"name\":\"%s\",\"count\":%lu,\"min_cycles\":%lu,"
+            "\"mean_cycles\":%lu,\"p50_cycles\":%lu,\"p99_cycles\":%lu,"
+            "\"max_cycles\":%lu,\"min_us\":%.2f,\"mean_us\":%.2f,"
+            "\"p50_us\":%.2f,\"p99_us\":%.2f,\"max_us\":%.2f,",
+            index == 0u ? "" : ",",
+            sys_profiler_probe_name((sys_profile_probe_t)index),
+            (unsigned long)stats->count, (unsigned long)stats->min,
+            (unsigned long)mean_cycles, (unsigned long)p50_cycles,
+            (unsigned long)p99_cycles, (unsigned long)stats->max,
+            (double)((float)stats->min / cycles_per_us),
+            (double)((float)mean_cycles / cycles_per_us),
+            (double)((float)p50_cycles / cycles_per_us),
+            (double)((float)p99_cycles / cycles_per_us),
+            (double)((float)stats->max / cycles_per_us)) ||
+        !web_append_log2_histogram_json(payload, payload_size, &offset,
+                                        stats) ||
+        !web_json_appendf(payload, payload_size, &offset, "}")) {
+      return false;
+    }
+  }
+
+  return web_json_appendf(payload, payload_size, &offset, "]}");
+}
+
+static bool http_handle_sys_profile_route(struct netconn *connection,
+                                          const http_request_t *request) {
+  static sys_profiler_snapshot_t snapshot;
+
+  if (request->method == HTTP_METHOD_POST) {
+    sys_profiler_reset();
+    debug_logs_append("CMD PROFILER RESET");
+  }
+
+  sys_profiler_get_snapshot(&snapshot);
+  if (!web_format_sys_profile_json(&snapshot, g_test_report_payload,
+                                   sizeof(g_test_report_payload))) {
+    http_send_text_response(connection, "500 Internal Server Error",
+                            "application/json",
+                            "{\"error\":\"sys_profile\"}");
+    return false;
+  }
+
+  if (request->method == HTTP_METHOD_HEAD) {
+    http_send_headers_only(connection, "200 OK", "application/json",
+                           strlen(g_test_report_payload));
+    return false;
+  }
+
+  http_send_response(connection, "200 OK", "application/json",
+                     (const uint8_t *)g_test_report_payload,
+                     strlen(g_test_report_payload));
+  return false;
+}
+
+static bool web_format_sys_latency_json(
+    const sys_latency_snapshot_t *snapshot, char *payload,
+    size_t payload_size) {
+  size_t offset = 0u;
+  uint32_t index = 0u;
+
+  if (!web_json_appendf(payload, payload_size, &offset,
+                        "{\"superseded\":%lu,\"stages\":[",
+                        (unsigned long)snapshot->superseded)) {
+    return false;
+  }
+
+  for (index = 0u; index < SYS_LATENCY_STAGE_COUNT; ++index) {
+    const sys_histogram_t *stats = &snapshot->stages[index];
+
+    if (!web_json_appendf(
+            payload, payload_size, &offset,
+            "%s{\"name\":\"%s\",\"count\":%lu,\"min_us\":%lu,"
+            "\"mean_us\":%lu,\"p50_us\":%lu,\"p99_us\":%lu,"
+            "\"max_us\":%lu,",
+            index == 0u ? "" : ",",
+            sys_latency_stage_name((sys_latency_stage_t)index),
+            (unsigned long)stats->count, (unsigned long)stats->min,
+            (unsigned long)sys_histogram_mean(stats),
+            (unsigned long)sys_histogram_percentile(stats, 0.5f),
+            (unsigned long)sys_histogram_percentile(stats, 0.99f),
+            (unsigned long)stats->max) ||
+        !web_append_log2_histogram_json(payload, payload_size, &offset,
+                                        stats) ||
+        !web_json_appendf(payload, payload_size, &offset, "}")) {
+      return false;
+    }
+  }
+
+  return web_json_appendf(payload, payload_size, &offset, "]}");
+}
+
+static bool http_handle_sys_latency_route(struct netconn *connection,
+                                          const http_request_t *request) {
+  static sys_latency_snapshot_t snapshot;
+
+  if (request->method == HTTP_METHOD_POST) {
+    sys_latency_reset();
+    debug_logs_append("CMD LATENCY RESET");
+  }
+
+  sys_latency_get_snapshot(&snapshot);
+  if (!web_format_sys_latency_json(&snapshot, g_test_report_payload,
+                                   sizeof(g_test_report_payload))) {
+    http_send_text_response(connection, "500 Internal Server Error",
+                            "application/json",
+                            "{\"error\":\"sys_latency\"}");
+    return false;
+  }
+
+  if (request->method == HTTP_METHOD_HEAD) {
+    http_send_headers_only(connection, "200 OK", "application/json",
+                           strlen(g_test_report_payload));
+    return false;
+  }
+
+  http_send_response(connection, "200 OK", "application/json",
+                     (const uint8_t *)g_test_report_payload,
+                     strlen(g_test_report_payload));
+  return false;
+}
+
+static bool web_append_jitter_json(char *payload, size_t payload_size,
+                                   size_t *inout_offset, const char *name,
+                                   const dimmer_timing_jitter_t *jitter) {
+  uint32_t bin = 0u;
+
+  if (!web_json_appendf(payload, payload_size, inout_offset,
+                        "\"%s\":{\"count\":%lu,\"min_us\":%ld,"
+                        "\"max_us\":%ld,\"underflow\":%lu,"
+                        "\"overflow\":%lu,\"bins\":[",
+                        name, (unsigned long)jitter->count,
+                        (long)jitter->min_us, (long)jitter->max_us,
+                        (unsigned long)jitter->underflow,
+                        (unsigned long)jitter->overflow)) {
+    return false;
+  }
+  for (bin = 0u; bin < DIMMER_TIMING_BIN_COUNT; ++bin) {
+    if (!web_json_appendf(payload, payload_size, inout_offset, "%s%lu",
+                          bin == 0u ? "" : ",",
+                          (unsigned long)jitter->bins[bin])) {
+      return false;
+    }
+  }
+  return web_json_appendf(payload, payload_size, inout_offset, "]}");
+}
+
+static bool web_format_dimmer_timing_json(
+    const dimmer_timing_snapshot_t *snapshot, char *payload,
+    size_t payload_size) {
+  const sys_histogram_t *lateness = &snapshot->gate_lateness;
+  size_t offset = 0u;
+
+  return web_json_appendf(
+             payload, payload_size, &offset,
+             "{\"bin_us\":%u,\"bin_count\":%u,\"period_mean_us\":%lu,"
+             "\"period_min_us\":%lu,\"period_max_us\":%lu,"
+             "\"resyncs\":%lu,",
+             (unsigned)APP_DIMMER_TIMING_BIN_US,
+             (unsigned)DIMMER_TIMING_BIN_COUNT,
+             (unsigned long)snapshot->period_mean_us,
+             (unsigned long)snapshot->period_min_us,
+             (unsigned long)snapshot->period_max_us,
+             (unsigned long)snapshot->resyncs) &&
+         web_append_jitter_json(payload, payload_size, &offset,
+                                "period_deviation",
+                                &snapshot->period_deviation) &&
+         web_json_appendf(payload, payload_size, &offset, ",") &&
+         web_append_jitter_json(payload, payload_size, &offset, "edge_phase",
+                                &snapshot->edge_phase) &&
+         web_json_appendf(
+             payload, payload_size, &offset,
+             ",\"gate_lateness\":{\"count\":%lu,\"min_us\":%lu,"
+             "\"mean_us\":%lu,\"p50_us\":%lu,\"p99_us\":%lu,"
+             "\"max_us\":%lu,",
+             (unsigned long)lateness->count, (unsigned long)lateness->min,
+             (unsigned long)sys_histogram_mean(lateness),
+             (unsigned long)sys_histogram_percentile(lateness, 0.5f),
+             (unsigned long)sys_histogram_percentile(lateness, 0.99f),
+             (unsigned long)lateness->max) &&
+         web_append_log2_histogram_json(payload, payload_size, &offset,
+                                        lateness) &&
+         web_json_appendf(payload, payload_size, &offset, "}}");
+}
+
+static bool http_handle_dimmer_timing_route(struct netconn *connection,
+                                            const http_request_t *request) {
+  static dimmer_timing_snapshot_t snapshot;
+
+  if (request->method == HTTP_METHOD_POST) {
+    dimmer_timing_reset();
+    debug_logs_append("CMD DIMMER TIMING RESET");
+  }
+
+  dimmer_timing_get_snapshot(&snapshot);
+  if (!web_format_dimmer_timing_json(&snapshot, g_test_report_payload,
+                                     sizeof(g_test_report_payload))) {
+    http_send_text_response(connection, "500 Internal Server Error",
+                            "application/json",
+                            "{\"error\":\"dimmer_timing\"}");
+    return false;
+  }
+
+  if (request->method == HTTP_METHOD_HEAD) {
+    http_send_headers_only(connection, "200 OK", "application/json",
+                           strlen(g_test_report_payload));
+    return false;
+  }
+
+  http_send_response(connection, "200 OK", "application/json",
+                     (const uint8_t *)g_test_report_payload,
+                     strlen(g_test_report_payload));
+  return false;
+}
+
+static size_t web_trace_put_u16(uint8_t *out, size_t offset, uint16_t value) {
+  out[offset] = (uint8_t)value;
+  out[offset + 1u] = (uint8_t)(value >> 8);
+  return offset + 2u;
+}
+
+static size_t web_trace_put_u32(uint8_t *out, size_t offset, uint32_t value) {
+  offset = web_trace_put_u16(out, offset, (uint16_t)value);
+  return web_trace_put_u16(out, offset, (uint16_t)(value >> 16));
+}
+
+/*
+ * Little-endian dump header followed by the task name table:
+ * magic[4] version:u16 event_size:u16 event_count:u32 overwritten:u32
+ * missed:u32 now_us:u32 task_count:u16 task_size:u16 capacity:u32, then
+ * task_count x {number:u32 name[16]}. Events follow as sys_trace_event_t.
+ */
+static size_t web_format_trace_header(const sys_trace_dump_t *dump,
+                                      uint8_t *out, size_t out_size) {
+  const size_t task_size = 4u + SYS_TRACE_TASK_NAME_LEN;
+  size_t offset = 0u;
+  uint32_t index = 0u;
+
+  if (out_size < 32u + dump->task_count * task_size) {
+    return 0u;
+  }
+  memcpy(out, SYS_TRACE_MAGIC, 4u);
+  offset = web_trace_put_u16(out, 4u, SYS_TRACE_FORMAT_VERSION);
+  offset = web_trace_put_u16(out, offset, sizeof(sys_trace_event_t));
+  offset = web_trace_put_u32(
+      out, offset, dump->segment_counts[0] + dump->segment_counts[1]);
+  offset = web_trace_put_u32(out, offset, dump->overwritten);
+  offset = web_trace_put_u32(out, offset, dump->missed);
+  offset = web_trace_put_u32(out, offset, dump->now_us);
+  offset = web_trace_put_u16(out, offset, (uint16_t)dump->task_count);
+  offset = web_trace_put_u16(out, offset, (uint16_t)task_size);
+  offset = web_trace_put_u32(out, offset, APP_TRACE_BUFFER_EVENTS);
+  for (index = 0u; index < dump->task_count; ++index) {
+    offset = web_trace_put_u32(out, offset, dump->tasks[index].number);
+    memcpy(&out[offset], dump->tasks[index].name, SYS_TRACE_TASK_NAME_LEN);
+    offset += SYS_TRACE_TASK_NAME_LEN;
+  }
+  return offset;
+}
+
+static bool http_handle_sys_trace_route(struct netconn *connection,
+                                        const http_request_t *request) {
+  static sys_trace_dump_t dump;
+  size_t header_length = 0u;
+  uint32_t segment = 0u;
+  bool ok = true;
+
+  if (request->method == HTTP_METHOD_POST) {
+    sys_trace_reset();
+    debug_logs_append("CMD TRACE RESET");
+    http_send_text_response(connection, "200 OK", "application/json",
+                            "{\"status\":\"ok\",\"message\":"
+                            "\"Trace cleared\"}");
+    return false;
+  }
+
+  /* Recording stays paused until the dump has been streamed out. */
+  sys_trace_freeze(&dump);
+  if (!dump.enabled) {
+    http_send_text_response(connection, "404 Not Found", "application/json",
+                            "{\"error\":\"trace_disabled\"}");
+    return false;
+  }
+
+  header_length = web_format_trace_header(
+      &dump, (uint8_t *)g_test_report_payload, sizeof(g_test_report_payload));
+  ok = header_length > 0u &&
+       http_send_chunked_headers(connection, "200 OK",
+                                 "application/octet-stream", NULL);
+  if (ok && request->method != HTTP_METHOD_HEAD) {
+    ok = http_send_chunk(connection, g_test_report_payload, header_length);
+    for (segment = 0u; ok && segment < 2u; ++segment) {
+      ok = http_send_chunk(connection, (const char *)dump.segments[segment],
+                           dump.segment_counts[segment] *
+                               sizeof(sys_trace_event_t));
     }
+    ok = ok && http_send_last_chunk(connection);
   }
+  sys_trace_thaw();
 
-  http_send_response(connection, "200 OK", "application/json",
-                     (const uint8_t *)response_payload, strlen(response_payload));
+  if (header_length == 0u) {
+    http_send_text_response(connection, "500 Internal Server Error",
+                            "application/json", "{\"error\":\"trace\"}");
+  }
   return false;
 }
 
-static bool http_handle_debug_route(struct netconn *connection,
-                                    const http_request_t *request) {
-#if APP_ENABLE_DEBUG_HTTP_ROUTES
-  if (strcmp(request->path, "/debug/stream") == 0 &&
-      request->method == HTTP_METHOD_POST) {
-    bool enabled = false;
-    char payload[64];
+static bool web_format_sys_crash_json(const sys_crash_record_t *record,
+                                      bool present, char *payload,
+                                      size_t payload_size) {
+  static char log_escaped[(SYS_CRASH_LOG_TAIL_CHARS * 2u) + 1u];
+  char task_escaped[(SYS_CRASH_TEXT_LEN * 2u) + 1u];
+  char message_escaped[(SYS_CRASH_TEXT_LEN * 2u) + 1u];
+  char version_escaped[(SYS_CRASH_TEXT_LEN * 2u) + 1u];
+  size_t offset = 0u;
+  uint32_t index = 0u;
+
+  if (!present) {
+    return web_json_appendf(payload, payload_size, &offset,
+                            "{\"present\":false}");
+  }
+  if (!json_escape_string(record->task_name, task_escaped,
+                          sizeof(task_escaped)) ||
+      !json_escape_string(record->message, message_escaped,
+                          sizeof(message_escaped)) ||
+      !json_escape_string(record->firmware_version, version_escaped,
+                          sizeof(version_escaped)) ||
+      !json_escape_string(record->log_tail, log_escaped,
+                          sizeof(log_escaped))) {
+    return false;
+  }
 
-    if (!json_extract_bool_field(request->body, "enabled", &enabled)) {
-      http_send_text_response(connection, "400 Bad Request", "text/plain",
-                              "Missing or invalid 'enabled'");
+  if (!web_json_appendf(
+          payload, payload_size, &offset,
+          "{\"present\":true,\"reason\":\"%s\",\"message\":\"%s\","
+          "\"task\":\"%s\",\"firmware_version\":\"%s\","
+          "\"uptime_us\":%lu,\"has_frame\":%s,"
+          "\"registers\":{\"r0\":\"0x%08lx\",\"r1\":\"0x%08lx\","
+          "\"r2\":\"0x%08lx\",\"r3\":\"0x%08lx\",\"r12\":\"0x%08lx\","
+          "\"lr\":\"0x%08lx\",\"pc\":\"0x%08lx\",\"xpsr\":\"0x%08lx\","
+          "\"exc_return\":\"0x%08lx\"},",
+          sys_crash_reason_name((sys_crash_reason_t)record->reason),
+          message_escaped, task_escaped, version_escaped,
+          (unsigned long)record->uptime_us,
+          record->has_frame ? "true" : "false", (unsigned long)record->r0,
+          (unsigned long)record->r1, (unsigned long)record->r2,
+          (unsigned long)record->r3, (unsigned long)record->r12,
+          (unsigned long)record->lr, (unsigned long)record->pc,
+          (unsigned long)record->xpsr, (unsigned long)record->exc_return) ||
+      !web_json_appendf(
+          payload, payload_size, &offset,
+          "\"fault_status\":{\"cfsr\":\"0x%08lx\",\"hfsr\":\"0x%08lx\","
+          "\"mmfar\":\"0x%08lx\",\"bfar\":\"0x%08lx\"},"
+          "\"stack_address\":\"0x%08lx\",\"stack\":[",
+          (unsigned long)record->cfsr, (unsigned long)record->hfsr,
+          (unsigned long)record->mmfar, (unsigned long)record->bfar,
+          (unsigned long)record->stack_address)) {
+    return false;
+  }
+
+  for (index = 0u; index < record->stack_word_count &&
+                   index < SYS_CRASH_STACK_WORDS;
+       ++index) {
+    if (!web_json_appendf(payload, payload_size, &offset, "%s\"0x%08lx\"",
+                          index == 0u ? "" : ",",
+                          (unsigned long)record->stack[index])) {
       return false;
     }
-
-    debug_logs_enabled_set(enabled);
-    if (!enabled) {
-      debug_logs_clear();
+  }
+  if (!web_json_appendf(payload, payload_size, &offset, "],\"trace\":[")) {
+    return false;
+  }
+  for (index = 0u; index < record->trace_count &&
+                   index < SYS_CRASH_TRACE_EVENTS;
+       ++index) {
+    const sys_trace_event_t *event = &record->trace[index];
+
+    if (!web_json_appendf(payload, payload_size, &offset,
+                          "%s{\"t_us\":%lu,\"type\":%u,\"id\":%u,"
+                          "\"payload\":%u}",
+                          index == 0u ? "" : ",",
+                          (unsigned long)event->timestamp_us,
+                          (unsigned int)event->type, (unsigned int)event->id,
+                          (unsigned int)event->payload)) {
+      return false;
     }
+  }
+  return web_json_appendf(payload, payload_size, &offset,
+                          "],\"log_tail\":\"%s\"}", log_escaped);
+}
 
-    {
-      const int written = snprintf(
-          payload, sizeof(payload), "{\"status\":\"ok\",\"logs_enabled\":%s}",
-          enabled ? "true" : "false");
-      if (written <= 0 || (size_t)written >= sizeof(payload)) {
-        http_send_text_response(connection, "500 Internal Server Error",
-                                "application/json", "{\"status\":\"error\"}");
-        return false;
-      }
-    }
+static bool http_handle_sys_crash_route(struct netconn *connection,
+                                        const http_request_t *request) {
+  static sys_crash_record_t record;
+  bool present = false;
 
-    http_send_response(connection, "200 OK", "application/json",
-                       (const uint8_t *)payload, strlen(payload));
+  if (request->method == HTTP_METHOD_POST) {
+    sys_crash_clear();
+    debug_logs_append("CMD CRASH CLEAR");
+  }
+
+  present = sys_crash_get_last(&record);
+  if (!web_format_sys_crash_json(&record, present, g_test_report_payload,
+                                 sizeof(g_test_report_payload))) {
+    http_send_text_response(connection, "500 Internal Server Error",
+                            "application/json", "{\"error\":\"crash\"}");
     return false;
   }
 
-  if (strcmp(request->path, "/debug/stream") == 0 &&
-      request->method == HTTP_METHOD_GET) {
-    const bool enabled = debug_logs_enabled_get();
-    char payload[64];
-    const int written =
-        snprintf(payload, sizeof(payload), "{\"logs_enabled\":%s}",
-                 enabled ? "true" : "false");
-    if (written <= 0 || (size_t)written >= sizeof(payload)) {
-      http_send_text_response(connection, "500 Internal Server Error",
-                              "application/json", "{\"status\":\"error\"}");
+  if (request->method == HTTP_METHOD_HEAD) {
+    http_send_headers_only(connection, "200 OK", "application/json",
+                           strlen(g_test_report_payload));
+    return false;
+  }
+
+  http_send_response(connection, "200 OK", "application/json",
+                     (const uint8_t *)g_test_report_payload,
+                     strlen(g_test_report_payload));
+  return false;
+}
+
+static bool web_format_sys_watchdog_json(
+    const sys_watchdog_snapshot_t *snapshot, char *payload,
+    size_t payload_size) {
+  size_t offset = 0u;
+  size_t index = 0u;
+  bool first = true;
+
+  if (!web_json_appendf(
+          payload, payload_size, &offset,
+          "{\"running\":%s,\"tripped\":%s,\"released\":%s,"
+          "\"reset_by_watchdog\":%s,\"timeout_ms\":%lu,"
+          "\"check_period_ms\":%lu,\"feeds\":%lu,\"trips\":%lu,"
+          "\"tasks\":[",
+          snapshot->running ? "true" : "false",
+          snapshot->tripped ? "true" : "false",
+          snapshot->released ? "true" : "false",
+          snapshot->reset_by_watchdog ? "true" : "false",
+          (unsigned long)snapshot->timeout_ms,
+          (unsigned long)snapshot->check_period_ms,
+          (unsigned long)snapshot->feeds, (unsigned long)snapshot->trips)) {
+    return false;
+  }
+
+  for (index = 0u; index < SYS_WATCHDOG_SLOT_COUNT; ++index) {
+    const sys_watchdog_task_snapshot_t *task = &snapshot->tasks[index];
+
+    if (task->name == NULL) {
+      continue;
+    }
+    if (!web_json_appendf(
+            payload, payload_size, &offset,
+            "%s{\"name\":\"%s\",\"supervised\":%s,\"deadline_ms\":%lu,"
+            "\"last_beat_age_ms\":%lu,\"max_gap_ms\":%lu,"
+            "\"deadline_misses\":%lu}",
+            first ? "" : ",", task->name,
+            task->registered ? "true" : "false",
+            (unsigned long)task->deadline_ms,
+            (unsigned long)task->last_beat_age_ms,
+            (unsigned long)task->max_gap_ms,
+            (unsigned long)task->deadline_misses)) {
       return false;
     }
-    http_send_response(connection, "200 OK", "application/json",
-                       (const uint8_t *)payload, strlen(payload));
-    return false;
+    first = false;
   }
+  return web_json_appendf(payload, payload_size, &offset, "]}");
+}
 
-  if (strcmp(request->path, "/debug/clear") == 0 &&
-      request->method == HTTP_METHOD_POST) {
-    static const char k_ok_payload[] =
-        "{\"status\":\"ok\",\"message\":\"Debug buffer cleared\"}";
-    debug_logs_clear();
-    http_send_response(connection, "200 OK", "application/json",
-                       (const uint8_t *)k_ok_payload, sizeof(k_ok_payload) - 1u);
+static bool http_handle_sys_watchdog_route(struct netconn *connection,
+                                           const http_request_t *request) {
+  static sys_watchdog_snapshot_t snapshot;
+
+  sys_watchdog_get_snapshot(&snapshot);
+  if (!web_format_sys_watchdog_json(&snapshot, g_test_report_payload,
+                                    sizeof(g_test_report_payload))) {
+    http_send_text_response(connection, "500 Internal Server Error",
+                            "application/json",
+                            "{\"error\":\"sys_watchdog\"}");
     return false;
   }
 
-  if (strcmp(request->path, "/debug/logs") == 0 &&
-      request->method == HTTP_METHOD_GET) {
-    char logs[DEBUG_LOG_BUFFER_SIZE];
-    debug_logs_copy(logs, sizeof(logs));
-    http_send_response(connection, "200 OK", "text/plain; charset=utf-8",
-                       (const uint8_t *)logs, strlen(logs));
+  if (request->method == HTTP_METHOD_HEAD) {
+    http_send_headers_only(connection, "200 OK", "application/json",
+                           strlen(g_test_report_payload));
     return false;
   }
 
-  http_send_text_response(connection, "404 Not Found", "text/plain", "Not Found");
-  return false;
-#else
-  (void)request;
-  http_send_text_response(connection, "404 Not Found", "text/plain", "Not Found");
+  http_send_response(connection, "200 OK", "application/json",
+                     (const uint8_t *)g_test_report_payload,
+                     strlen(g_test_report_payload));
   return false;
-#endif
 }
 
 static bool http_handle_ota_status_route(struct netconn *connection,
@@ -1738,6 +3620,514 @@ static bool http_handle_ota_post_route(struct netconn *connection,
   return false;
 }
 
+static const char *web_http_route_name(web_http_route_t route) {
+  switch (route) {
+  case WEB_HTTP_ROUTE_STATUS:
+    return "status";
+  case WEB_HTTP_ROUTE_CONTROL:
+    return "control";
+  case WEB_HTTP_ROUTE_TEST:
+    return "test";
+  case WEB_HTTP_ROUTE_SYS:
+    return "sys";
+  case WEB_HTTP_ROUTE_OTA:
+    return "ota";
+  case WEB_HTTP_ROUTE_EVENTS:
+    return "events";
+  case WEB_HTTP_ROUTE_DEBUG:
+    return "debug";
+  case WEB_HTTP_ROUTE_METRICS:
+    return "metrics";
+  case WEB_HTTP_ROUTE_STATIC:
+    return "static";
+  case WEB_HTTP_ROUTE_BAD_REQUEST:
+    return "bad_request";
+  default:
+    return "unknown";
+  }
+}
+
+static web_http_route_t web_http_classify_route(const char *path) {
+  static const struct {
+    const char *prefix;
+    web_http_route_t route;
+  } k_prefixes[] = {
+      {"/api/status", WEB_HTTP_ROUTE_STATUS},
+      {"/api/control", WEB_HTTP_ROUTE_CONTROL},
+      {"/api/pwm", WEB_HTTP_ROUTE_CONTROL},
+      {"/api/led", WEB_HTTP_ROUTE_CONTROL},
+      {"/api/mode", WEB_HTTP_ROUTE_CONTROL},
+      {"/api/relay", WEB_HTTP_ROUTE_CONTROL},
+      {"/api/calibrate", WEB_HTTP_ROUTE_CONTROL},
+      {"/api/test", WEB_HTTP_ROUTE_TEST},
+      {"/api/sys", WEB_HTTP_ROUTE_SYS},
+      {"/api/ota", WEB_HTTP_ROUTE_OTA},
+      {"/events", WEB_HTTP_ROUTE_EVENTS},
+      {"/debug", WEB_HTTP_ROUTE_DEBUG},
+      {"/metrics", WEB_HTTP_ROUTE_METRICS},
+  };
+  size_t index = 0u;
+
+  for (index = 0u; index < sizeof(k_prefixes) / sizeof(k_prefixes[0]);
+       ++index) {
+    if (strncmp(path, k_prefixes[index].prefix,
+                strlen(k_prefixes[index].prefix)) == 0) {
+      return k_prefixes[index].route;
+    }
+  }
+  return WEB_HTTP_ROUTE_STATIC;
+}
+
+static void web_http_route_record(web_http_route_t route,
+                                  uint32_t duration_us) {
+  if (route >= WEB_HTTP_ROUTE_COUNT) {
+    return;
+  }
+  g_http_route_stats[route].requests += 1u;
+  sys_histogram_add(&g_http_route_stats[route].duration_us, duration_us);
+}
+
+static void web_metrics_flush(web_metrics_writer_t *writer) {
+  if (writer->ok && writer->length > 0u) {
+    writer->ok =
+        http_send_chunk(writer->connection, writer->buffer, writer->length);
+  }
+  writer->length = 0u;
+}
+
+static void web_metrics_printf(web_metrics_writer_t *writer,
+                               const char *format, ...) {
+  va_list args;
+  int written = 0;
+
+  if (!writer->ok) {
+    return;
+  }
+
+  va_start(args, format);
+  written = vsnprintf(writer->buffer + writer->length,
+                      sizeof(writer->buffer) - writer->length, format, args);
+  va_end(args);
+  if (written >= 0 &&
+      (size_t)written >= sizeof(writer->buffer) - writer->length) {
+    /* Did not fit: send what is buffered and format again from the start. */
+    web_metrics_flush(writer);
+    if (!writer->ok) {
+      return;
+    }
+    va_start(args, format);
+    written = vsnprintf(writer->buffer, sizeof(writer->buffer), format, args);
+    va_end(args);
+  }
+  if (written < 0 ||
+      (size_t)written >= sizeof(writer->buffer) - writer->length) {
+    writer->ok = false;
+    return;
+  }
+  writer->length += (size_t)written;
+}
+
+static void web_metrics_family(web_metrics_writer_t *writer, const char *name,
+                               const char *type, const char *help) {
+  web_metrics_printf(writer, "# TYPE %s %s\n# HELP %s %s\n", name, type, name,
+                     help);
+}
+
+/* Label values escape backslash, double quote and newline. */
+static void web_metrics_escape_label(const char *input, char *output,
+                                     size_t output_size) {
+  size_t write_index = 0u;
+
+  while (input != NULL && *input != '\0' && write_index + 2u < output_size) {
+    const char ch = *input++;
+
+    if (ch == '\\' || ch == '"') {
+      output[write_index++] = '\\';
+      output[write_index++] = ch;
+    } else if (ch == '\n') {
+      output[write_index++] = '\\';
+      output[write_index++] = 'n';
+    } else {
+      output[write_index++] = ch;
+    }
+  }
+  output[write_index] = '\0';
+}
+
+/*
+ * Emits a sys_histogram_t as cumulative buckets at 2^bit - 1 units for
+ * bit = first_bit, first_bit + step_bits, ... up to last_bit, then +Inf.
+ * Bucket b of the histogram holds values below 2^b, so every bound is
+ * exact; unit_seconds converts units (us, cycles) to seconds. labels is
+ * "" or 'name="value"' pairs without braces.
+ */
+static void web_metrics_log2_histogram(web_metrics_writer_t *writer,
+                                       const char *name, const char *labels,
+                                       const sys_histogram_t *histogram,
+                                       double unit_seconds, uint32_t first_bit,
+                                       uint32_t last_bit, uint32_t step_bits) {
+  const char *separator = labels[0] != '\0' ? "," : "";
+  uint32_t cumulative = 0u;
+  uint32_t bucket = 0u;
+
+  for (bucket = 0u; bucket <= last_bit && bucket < SYS_HISTOGRAM_BUCKET_COUNT;
+       ++bucket) {
+    cumulative += histogram->buckets[bucket];
+    if (bucket >= first_bit && ((bucket - first_bit) % step_bits) == 0u) {
+      web_metrics_printf(writer, "%s_bucket{%s%sle=\"%.9g\"} %lu\n", name,
+                         labels, separator,
+                         (double)((1ull << bucket) - 1ull) * unit_seconds,
+                         (unsigned long)cumulative);
+    }
+  }
+  web_metrics_printf(writer, "%s_bucket{%s%sle=\"+Inf\"} %lu\n", name,
+                     labels, separator, (unsigned long)histogram->count);
+  web_metrics_printf(writer, "%s_count{%s} %lu\n", name, labels,
+                     (unsigned long)histogram->count);
+  web_metrics_printf(writer, "%s_sum{%s} %.9g\n", name, labels,
+                     (double)histogram->total * unit_seconds);
+}
+
+static void web_metrics_write_sensors(web_metrics_writer_t *writer) {
+  static const struct {
+    const char *status;
+    size_t offset;
+  } k_status_fields[] = {
+      {"ok", offsetof(adp910_diag_t, ok)},
+      {"invalid_argument", offsetof(adp910_diag_t, invalid_argument)},
+      {"bus_error", offsetof(adp910_diag_t, bus_error)},
+      {"not_ready", offsetof(adp910_diag_t, not_ready)},
+      {"crc_mismatch", offsetof(adp910_diag_t, crc_mismatch)},
+      {"other", offsetof(adp910_diag_t, other)},
+  };
+  adp910_diag_t diag[ADP910_DIAG_CHANNEL_COUNT];
+  blower_metrics_snapshot_t snapshot = {0};
+  const bool has_snapshot = blower_metrics_service_get_snapshot(&snapshot);
+  size_t channel = 0u;
+  size_t field = 0u;
+
+  for (channel = 0u; channel < ADP910_DIAG_CHANNEL_COUNT; ++channel) {
+    adp910_diag_get((adp910_diag_channel_t)channel, &diag[channel]);
+  }
+
+  web_metrics_family(writer, "blower_adp910_results", "counter",
+                     "ADP910 init and read results by status.");
+  for (channel = 0u; channel < ADP910_DIAG_CHANNEL_COUNT; ++channel) {
+    for (field = 0u;
+         field < sizeof(k_status_fields) / sizeof(k_status_fields[0]);
+         ++field) {
+      const uint32_t *count =
+          (const uint32_t *)((const uint8_t *)&diag[channel] +
+                             k_status_fields[field].offset);
+      web_metrics_printf(
+          writer, "blower_adp910_results_total{sensor=\"%s\",status=\"%s\"} "
+                  "%lu\n",
+          adp910_diag_channel_name((adp910_diag_channel_t)channel),
+          k_status_fields[field].status, (unsigned long)*count);
+    }
+  }
+
+  web_metrics_family(writer, "blower_adp910_ready", "gauge",
+                     "1 while the sensor is initialized.");
+  for (channel = 0u; channel < ADP910_DIAG_CHANNEL_COUNT; ++channel) {
+    web_metrics_printf(
+        writer, "blower_adp910_ready{sensor=\"%s\"} %u\n",
+        adp910_diag_channel_name((adp910_diag_channel_t)channel),
+        diag[channel].ready ? 1u : 0u);
+  }
+
+  if (!has_snapshot) {
+    return;
+  }
+  web_metrics_family(writer, "blower_pressure_pascals", "gauge",
+                     "Latest calibrated differential pressure.");
+  web_metrics_printf(writer,
+                     "blower_pressure_pascals{sensor=\"fan\"} %.3f\n"
+                     "blower_pressure_pascals{sensor=\"envelope\"} %.3f\n",
+                     (double)snapshot.fan_pressure_pa,
+                     (double)snapshot.envelope_pressure_pa);
+  web_metrics_family(writer, "blower_sample_valid", "gauge",
+                     "1 when the latest sample of the sensor is valid.");
+  web_metrics_printf(writer,
+                     "blower_sample_valid{sensor=\"fan\"} %u\n"
+                     "blower_sample_valid{sensor=\"envelope\"} %u\n",
+                     snapshot.fan_sample_valid ? 1u : 0u,
+                     snapshot.envelope_sample_valid ? 1u : 0u);
+  web_metrics_family(writer, "blower_metrics_updates", "counter",
+                     "Sampling cycles published to the metrics service.");
+  web_metrics_printf(writer, "blower_metrics_updates_total %lu\n",
+                     (unsigned long)snapshot.update_sequence);
+}
+
+static void web_metrics_write_control(web_metrics_writer_t *writer) {
+  static sys_profiler_snapshot_t profile;
+  blower_control_snapshot_t control = {0};
+  uint32_t probe = 0u;
+
+  blower_control_get_snapshot(&control);
+  web_metrics_family(writer, "blower_control_period_seconds", "gauge",
+                     "Control loop period.");
+  web_metrics_printf(writer, "blower_control_period_seconds %.3f\n",
+                     (double)APP_CONTROL_LOOP_PERIOD_MS / 1000.0);
+  web_metrics_family(writer, "blower_control_mode", "gauge",
+                     "Control mode: 0 manual, 1 semi-auto target, "
+                     "2 auto test, 3 predictive target.");
+  web_metrics_printf(writer, "blower_control_mode %u\n",
+                     (unsigned)control.mode);
+  web_metrics_family(writer, "blower_control_output_ratio", "gauge",
+                     "Commanded fan power, 0 to 1.");
+  web_metrics_printf(writer, "blower_control_output_ratio %.2f\n",
+                     (double)control.output_pwm_percent / 100.0);
+  web_metrics_family(writer, "blower_control_target_pressure_pascals",
+                     "gauge", "Pressure setpoint of the target modes.");
+  web_metrics_printf(writer, "blower_control_target_pressure_pascals %.3f\n",
+                     (double)control.target_pressure_pa);
+  web_metrics_family(writer, "blower_control_relay_enabled", "gauge",
+                     "1 while the fan relay is closed.");
+  web_metrics_printf(writer, "blower_control_relay_enabled %u\n",
+                     control.relay_enabled ? 1u : 0u);
+  web_metrics_family(writer, "blower_line_sync", "gauge",
+                     "1 while zero crossings arrive.");
+  web_metrics_printf(writer, "blower_line_sync %u\n",
+                     control.line_sync ? 1u : 0u);
+  web_metrics_family(writer, "blower_line_frequency_hertz", "gauge",
+                     "Measured mains frequency.");
+  web_metrics_printf(writer, "blower_line_frequency_hertz %.3f\n",
+                     (double)control.line_frequency_hz);
+  web_metrics_family(writer, "blower_control_dropped_commands", "counter",
+                     "Setter commands lost to a full control queue.");
+  web_metrics_printf(writer, "blower_control_dropped_commands_total %lu\n",
+                     (unsigned long)control.dropped_commands);
+
+  sys_profiler_get_snapshot(&profile);
+  if (!profile.enabled || profile.cpu_hz == 0u) {
+    return;
+  }
+  web_metrics_family(writer, "blower_profile_duration_seconds", "histogram",
+                     "Hot-path probe durations (control_step is one "
+                     "control loop step).");
+  for (probe = 0u; probe < SYS_PROFILE_PROBE_COUNT; ++probe) {
+    char labels[48];
+
+    snprintf(labels, sizeof(labels), "probe=\"%s\"",
+             sys_profiler_probe_name((sys_profile_probe_t)probe));
+    /* 255 cycles to 16.7M cycles: ~1.7 us to ~0.1 s at 150 MHz. */
+    web_metrics_log2_histogram(writer, "blower_profile_duration_seconds",
+                               labels, &profile.probes[probe],
+                               1.0 / (double)profile.cpu_hz, 8u, 24u, 2u);
+  }
+}
+
+static void web_metrics_write_web(web_metrics_writer_t *writer) {
+  uint32_t route = 0u;
+
+  web_metrics_family(writer, "blower_sse_clients", "gauge",
+                     "Connected /events clients (at most one).");
+  web_metrics_printf(writer, "blower_sse_clients %u\n",
+                     g_sse_active ? 1u : 0u);
+  web_metrics_family(writer, "blower_sse_connections", "counter",
+                     "/events streams started.");
+  web_metrics_printf(writer, "blower_sse_connections_total %lu\n",
+                     (unsigned long)g_sse_connections_total);
+  web_metrics_family(writer, "blower_sse_rejected", "counter",
+                     "/events requests refused (busy or out of memory).");
+  web_metrics_printf(writer, "blower_sse_rejected_total %lu\n",
+                     (unsigned long)g_sse_rejected_total);
+  web_metrics_family(writer, "blower_sse_events", "counter",
+                     "Status events written to /events clients.");
+  web_metrics_printf(writer, "blower_sse_events_total %lu\n",
+                     (unsigned long)g_sse_events_total);
+
+  web_metrics_family(writer, "blower_http_requests", "counter",
+                     "HTTP requests served, by route class.");
+  for (route = 0u; route < WEB_HTTP_ROUTE_COUNT; ++route) {
+    web_metrics_printf(writer, "blower_http_requests_total{route=\"%s\"} %lu\n",
+                       web_http_route_name((web_http_route_t)route),
+                       (unsigned long)g_http_route_stats[route].requests);
+  }
+  web_metrics_family(writer, "blower_http_request_duration_seconds",
+                     "histogram",
+                     "Accept to close, by route class (/events: until the "
+                     "stream task takes over).");
+  for (route = 0u; route < WEB_HTTP_ROUTE_COUNT; ++route) {
+    char labels[32];
+
+    snprintf(labels, sizeof(labels), "route=\"%s\"",
+             web_http_route_name((web_http_route_t)route));
+    /* 1 ms to 4.2 s. */
+    web_metrics_log2_histogram(writer, "blower_http_request_duration_seconds",
+                               labels, &g_http_route_stats[route].duration_us,
+                               1e-6, 10u, 22u, 2u);
+  }
+}
+
+static void web_metrics_write_ota(web_metrics_writer_t *writer) {
+  ota_update_status_t status = {0};
+  uint32_t state = 0u;
+
+  ota_update_service_get_status(&status);
+  web_metrics_family(writer, "blower_ota_state", "stateset",
+                     "OTA update state.");
+  for (state = OTA_UPDATE_STATE_IDLE; state <= OTA_UPDATE_STATE_ERROR;
+       ++state) {
+    web_metrics_printf(
+        writer, "blower_ota_state{blower_ota_state=\"%s\"} %u\n",
+        ota_update_service_state_name((ota_update_state_t)state),
+        status.state == (ota_update_state_t)state ? 1u : 0u);
+  }
+  web_metrics_family(writer, "blower_ota_received_bytes", "counter",
+                     "Image bytes accepted since boot.");
+  web_metrics_printf(writer, "blower_ota_received_bytes_total %lu\n",
+                     (unsigned long)status.total_received_bytes);
+  web_metrics_family(writer, "blower_ota_chunks", "counter",
+                     "Image chunks accepted since boot.");
+  web_metrics_printf(writer, "blower_ota_chunks_total %lu\n",
+                     (unsigned long)status.total_chunks);
+  web_metrics_family(writer, "blower_ota_progress_ratio", "gauge",
+                     "Received share of the current image.");
+  web_metrics_printf(writer, "blower_ota_progress_ratio %.4f\n",
+                     status.expected_size_bytes == 0u
+                         ? 0.0
+                         : (double)status.received_size_bytes /
+                               (double)status.expected_size_bytes);
+  web_metrics_family(writer, "blower_ota_receive_bytes_per_second", "gauge",
+                     "Mean upload rate of the current image.");
+  web_metrics_printf(writer, "blower_ota_receive_bytes_per_second %.1f\n",
+                     status.receive_elapsed_ms == 0u
+                         ? 0.0
+                         : (double)status.received_size_bytes * 1000.0 /
+                               (double)status.receive_elapsed_ms);
+}
+
+static void web_metrics_write_system(web_metrics_writer_t *writer) {
+  static sys_task_stats_snapshot_t tasks;
+  static sys_watchdog_snapshot_t watchdog;
+  const sys_task_stats_heap_t *heap = &tasks.heap;
+  uint32_t index = 0u;
+
+  sys_task_stats_read(&tasks);
+  web_metrics_family(writer, "blower_heap_size_bytes", "gauge",
+                     "FreeRTOS heap size.");
+  web_metrics_printf(writer, "blower_heap_size_bytes %lu\n",
+                     (unsigned long)heap->total_bytes);
+  web_metrics_family(writer, "blower_heap_free_bytes", "gauge",
+                     "Free FreeRTOS heap.");
+  web_metrics_printf(writer, "blower_heap_free_bytes %lu\n",
+                     (unsigned long)heap->free_bytes);
+  web_metrics_family(writer, "blower_heap_min_free_bytes", "gauge",
+                     "Lowest free heap since boot.");
+  web_metrics_printf(writer, "blower_heap_min_free_bytes %lu\n",
+                     (unsigned long)heap->min_ever_free_bytes);
+  web_metrics_family(writer, "blower_heap_largest_free_block_bytes", "gauge",
+                     "Largest allocation that can currently succeed.");
+  web_metrics_printf(writer, "blower_heap_largest_free_block_bytes %lu\n",
+                     (unsigned long)heap->largest_free_block_bytes);
+  web_metrics_family(writer, "blower_heap_allocations", "counter",
+                     "Successful heap allocations.");
+  web_metrics_printf(writer, "blower_heap_allocations_total %lu\n",
+                     (unsigned long)heap->allocations);
+  web_metrics_family(writer, "blower_heap_frees", "counter", "Heap frees.");
+  web_metrics_printf(writer, "blower_heap_frees_total %lu\n",
+                     (unsigned long)heap->frees);
+
+  web_metrics_family(writer, "blower_task_cpu_seconds", "counter",
+                     "Task run time since the task was created.");
+  for (index = 0u; index < tasks.task_count; ++index) {
+    char name[(SYS_TASK_STATS_NAME_LEN * 2u) + 1u];
+
+    web_metrics_escape_label(tasks.tasks[index].name, name, sizeof(name));
+    web_metrics_printf(writer, "blower_task_cpu_seconds_total{task=\"%s\"} "
+                               "%.6f\n",
+                       name,
+                       (double)tasks.tasks[index].total_run_time_us / 1e6);
+  }
+  web_metrics_family(writer, "blower_task_stack_free_bytes", "gauge",
+                     "Lowest free stack of the task since it started.");
+  for (index = 0u; index < tasks.task_count; ++index) {
+    char name[(SYS_TASK_STATS_NAME_LEN * 2u) + 1u];
+
+    web_metrics_escape_label(tasks.tasks[index].name, name, sizeof(name));
+    web_metrics_printf(
+        writer, "blower_task_stack_free_bytes{task=\"%s\"} %lu\n", name,
+        (unsigned long)(tasks.tasks[index].stack_high_water_words *
+                        sizeof(uint32_t)));
+  }
+
+  sys_watchdog_get_snapshot(&watchdog);
+  web_metrics_family(writer, "blower_watchdog_trips", "counter",
+                     "Watchdog resets forced by a missed heartbeat since "
+                     "power-on.");
+  web_metrics_printf(writer, "blower_watchdog_trips_total %lu\n",
+                     (unsigned long)watchdog.trips);
+  web_metrics_family(writer, "blower_watchdog_heartbeat_age_seconds",
+                     "gauge", "Time since the supervised task last beat.");
+  for (index = 0u; index < SYS_WATCHDOG_SLOT_COUNT; ++index) {
+    if (watchdog.tasks[index].name != NULL &&
+        watchdog.tasks[index].registered) {
+      web_metrics_printf(
+          writer, "blower_watchdog_heartbeat_age_seconds{task=\"%s\"} "
+                  "%.3f\n",
+          watchdog.tasks[index].name,
+          (double)watchdog.tasks[index].last_beat_age_ms / 1000.0);
+    }
+  }
+  web_metrics_family(writer, "blower_watchdog_deadline_misses", "counter",
+                     "Heartbeat deadlines the supervised task missed since "
+                     "power-on.");
+  for (index = 0u; index < SYS_WATCHDOG_SLOT_COUNT; ++index) {
+    if (watchdog.tasks[index].name != NULL) {
+      web_metrics_printf(
+          writer, "blower_watchdog_deadline_misses_total{task=\"%s\"} %lu\n",
+          watchdog.tasks[index].name,
+          (unsigned long)watchdog.tasks[index].deadline_misses);
+    }
+  }
+  web_metrics_family(writer, "blower_log_dropped_records", "counter",
+                     "Deferred log records lost to a full ring.");
+  web_metrics_printf(writer, "blower_log_dropped_records_total %lu\n",
+                     (unsigned long)sys_log_dropped());
+}
+
+static bool http_handle_metrics_route(struct netconn *connection,
+                                      const http_request_t *request) {
+  web_metrics_writer_t *writer = &g_metrics_writer;
+  char version[64];
+
+  if (!http_send_chunked_headers(
+          connection, "200 OK",
+          "application/openmetrics-text; version=1.0.0; charset=utf-8",
+          "Cache-Control: no-store\r\n") ||
+      request->method == HTTP_METHOD_HEAD) {
+    return false;
+  }
+
+  *writer = (web_metrics_writer_t){
+      .connection = connection,
+      .length = 0u,
+      .ok = true,
+  };
+  web_metrics_escape_label(ota_update_service_get_firmware_version(), version,
+                           sizeof(version));
+  web_metrics_family(writer, "blower_build", "info", "Firmware build.");
+  web_metrics_printf(writer, "blower_build_info{version=\"%s\"} 1\n", version);
+  web_metrics_family(writer, "blower_uptime_seconds", "gauge",
+                     "Time since boot.");
+  web_metrics_printf(writer, "blower_uptime_seconds %.3f\n",
+                     (double)to_ms_since_boot(get_absolute_time()) / 1000.0);
+
+  web_metrics_write_sensors(writer);
+  web_metrics_write_control(writer);
+  web_metrics_write_web(writer);
+  web_metrics_write_ota(writer);
+  web_metrics_write_system(writer);
+  web_metrics_printf(writer, "# EOF\n");
+  web_metrics_flush(writer);
+  if (writer->ok) {
+    (void)http_send_last_chunk(connection);
+  }
+  return false;
+}
+
 static bool http_path_equals_any(const char *path, const char *const *candidates,
                                  size_t candidates_count) {
   size_t index = 0u;
@@ -1758,14 +4148,20 @@ static bool http_path_equals_any(const char *path, const char *const *candidates
 static bool http_server_serve_connection(struct netconn *connection) {
   http_request_t request;
   static const char *const k_control_post_routes[] = {"/api/pwm", "/api/led",
+                                                       "/api/mode",
                                                        "/api/relay",
                                                        "/api/calibrate"};
   static const char *const k_ota_post_routes[] = {"/api/ota/begin",
                                                    "/api/ota/chunk",
                                                    "/api/ota/finish",
                                                    "/api/ota/apply"};
+  static const char *const k_test_post_routes[] = {"/api/test/start",
+                                                    "/api/test/stop",
+                                                    "/api/test/config",
+                                                    "/api/test/config/reset"};
   bool method_is_get_or_head = false;
 
+  g_http_current_route = WEB_HTTP_ROUTE_BAD_REQUEST;
   if (!http_parse_request(connection, &request)) {
     http_send_text_response(connection, "400 Bad Request", "text/plain",
                             "Bad Request");
@@ -1775,6 +4171,7 @@ static bool http_server_serve_connection(struct netconn *connection) {
 
   method_is_get_or_head = request.method == HTTP_METHOD_GET ||
                           request.method == HTTP_METHOD_HEAD;
+  g_http_current_route = web_http_classify_route(request.path);
 
   if (strcmp(request.path, "/favicon.ico") == 0) {
     http_send_headers_only(connection, "204 No Content", "image/x-icon", 0u);
@@ -1788,6 +4185,84 @@ static bool http_server_serve_connection(struct netconn *connection) {
     return false;
   }
 
+  if ((method_is_get_or_head || request.method == HTTP_METHOD_POST) &&
+      strcmp(request.path, "/api/control/params") == 0) {
+    (void)http_handle_control_params_route(connection, &request);
+    netconn_close(connection);
+    return false;
+  }
+
+  if (request.method == HTTP_METHOD_POST &&
+      strcmp(request.path, "/api/control/params/reset") == 0) {
+    (void)http_handle_control_params_route(connection, &request);
+    netconn_close(connection);
+    return false;
+  }
+
+  if (method_is_get_or_head && strcmp(request.path, "/api/sys/tasks") == 0) {
+    (void)http_handle_sys_tasks_route(connection, &request);
+    netconn_close(connection);
+    return false;
+  }
+
+  if ((method_is_get_or_head &&
+       strcmp(request.path, "/api/sys/profile") == 0) ||
+      (request.method == HTTP_METHOD_POST &&
+       strcmp(request.path, "/api/sys/profile/reset") == 0)) {
+    (void)http_handle_sys_profile_route(connection, &request);
+    netconn_close(connection);
+    return false;
+  }
+
+  if ((method_is_get_or_head &&
+       strcmp(request.path, "/api/sys/latency") == 0) ||
+      (request.method == HTTP_METHOD_POST &&
+       strcmp(request.path, "/api/sys/latency/reset") == 0)) {
+    (void)http_handle_sys_latency_route(connection, &request);
+    netconn_close(connection);
+    return false;
+  }
+
+  if ((method_is_get_or_head &&
+       strcmp(request.path, "/api/sys/dimmer_timing") == 0) ||
+      (request.method == HTTP_METHOD_POST &&
+       strcmp(request.path, "/api/sys/dimmer_timing/reset") == 0)) {
+    (void)http_handle_dimmer_timing_route(connection, &request);
+    netconn_close(connection);
+    return false;
+  }
+
+  if ((method_is_get_or_head &&
+       strcmp(request.path, "/api/sys/trace") == 0) ||
+      (request.method == HTTP_METHOD_POST &&
+       strcmp(request.path, "/api/sys/trace/reset") == 0)) {
+    (void)http_handle_sys_trace_route(connection, &request);
+    netconn_close(connection);
+    return false;
+  }
+
+  if ((method_is_get_or_head &&
+       strcmp(request.path, "/api/sys/crash") == 0) ||
+      (request.method == HTTP_METHOD_POST &&
+       strcmp(request.path, "/api/sys/crash/clear") == 0)) {
+    (void)http_handle_sys_crash_route(connection, &request);
+    netconn_close(connection);
+    return false;
+  }
+
+  if (method_is_get_or_head &&
+      strcmp(request.path, "/api/sys/watchdog") == 0) {
+    (void)http_handle_sys_watchdog_route(connection, &request);
+    netconn_close(connection);
+    return false;
+  }
+
+  if (method_is_get_or_head && strcmp(request.path, "/metrics") == 0) {
+    (void)http_handle_metrics_route(connection, &request);
+    netconn_close(connection);
+    return false;
+  }
+
   if (method_is_get_or_head && strcmp(request.path, "/api/ota/status") == 0) {
     (void)http_handle_ota_status_route(connection, &request);
     netconn_close(connection);
@@ -1797,7 +4272,41 @@ static bool http_server_serve_connection(struct netconn *connection) {
   if (method_is_get_or_head &&
       (strcmp(request.path, "/api/test/report") == 0 ||
        strcmp(request.path, "/api/test/report/latest") == 0)) {
-    (void)http_handle_test_report_compat_route(connection, &request);
+    (void)http_handle_test_report_route(connection, &request);
+    netconn_close(connection);
+    return false;
+  }
+
+  if (method_is_get_or_head && strcmp(request.path, "/api/test/reports") == 0) {
+    (void)http_handle_test_reports_route(connection, &request);
+    netconn_close(connection);
+    return false;
+  }
+
+  if (method_is_get_or_head && strcmp(request.path, "/api/test/samples") == 0) {
+    (void)http_handle_test_samples_route(connection, &request);
+    netconn_close(connection);
+    return false;
+  }
+
+  if ((method_is_get_or_head &&
+       strcmp(request.path, "/api/test/fan_ranges") == 0) ||
+      (request.method == HTTP_METHOD_POST &&
+       (strcmp(request.path, "/api/test/fan_ranges") == 0 ||
+        strcmp(request.path, "/api/test/fan_ranges/select") == 0))) {
+    (void)http_handle_fan_ranges_route(connection, &request);
+    netconn_close(connection);
+    return false;
+  }
+
+  if ((method_is_get_or_head &&
+       (strcmp(request.path, "/api/test/status") == 0 ||
+        strcmp(request.path, "/api/test/config") == 0)) ||
+      (request.method == HTTP_METHOD_POST &&
+       http_path_equals_any(request.path, k_test_post_routes,
+                            sizeof(k_test_post_routes) /
+                                sizeof(k_test_post_routes[0])))) {
+    (void)http_handle_test_route(connection, &request);
     netconn_close(connection);
     return false;
   }
@@ -1886,9 +4395,11 @@ static bool wifi_connect_station_mode(void) {
 
   cyw43_arch_enable_sta_mode();
 
+  /* Each attempt blocks up to WIFI_CONNECT_TIMEOUT_MS between beats. */
   while (cyw43_arch_wifi_connect_timeout_ms(
              WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK,
              WIFI_CONNECT_TIMEOUT_MS) != 0) {
+    sys_watchdog_heartbeat(SYS_WATCHDOG_SLOT_WIFI);
     vTaskDelay(pdMS_TO_TICKS(WIFI_RETRY_DELAY_MS));
   }
 
@@ -1923,6 +4434,7 @@ static struct netconn *http_server_create_listener(void) {
 void wifi_task_entry(void *params) {
   struct netconn *listener = NULL;
   bool led_state = false;
+  uint32_t task_stats_refresh_ms = 0u;
 
   (void)params;
   debug_logs_clear();
@@ -1930,6 +4442,7 @@ void wifi_task_entry(void *params) {
   ota_update_service_init();
 
   if (!wifi_connect_station_mode()) {
+    sys_watchdog_unregister(SYS_WATCHDOG_SLOT_WIFI);
     vTaskDelete(NULL);
     return;
   }
@@ -1937,20 +4450,43 @@ void wifi_task_entry(void *params) {
   listener = http_server_create_listener();
   if (listener == NULL) {
     printf("[WiFi] HTTP init failed\n");
+    sys_watchdog_unregister(SYS_WATCHDOG_SLOT_WIFI);
     vTaskDelete(NULL);
     return;
   }
+  /* Accept wakes up idle so the loop can beat the watchdog. */
+  netconn_set_recvtimeout(listener, HTTP_ACCEPT_TIMEOUT_MS);
 
   while (1) {
     struct netconn *client_connection = NULL;
-    const err_t accept_status = netconn_accept(listener, &client_connection);
+    err_t accept_status = ERR_OK;
+    const uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+
+    sys_watchdog_heartbeat(SYS_WATCHDOG_SLOT_WIFI);
+    /* Keeps the 64-bit CPU totals of /metrics ahead of the counter wrap. */
+    if (now_ms - task_stats_refresh_ms >= APP_TASK_STATS_REFRESH_PERIOD_MS) {
+      task_stats_refresh_ms = now_ms;
+      sys_task_stats_refresh();
+    }
+    accept_status = netconn_accept(listener, &client_connection);
+    if (accept_status == ERR_TIMEOUT) {
+      continue;
+    }
 
     led_state = !led_state;
     cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, led_state);
 
     if (accept_status == ERR_OK && client_connection != NULL) {
+      /* A silent or stalled client must not hold the server loop. */
+      netconn_set_recvtimeout(client_connection, HTTP_CLIENT_IO_TIMEOUT_MS);
+      netconn_set_sendtimeout(client_connection, HTTP_CLIENT_IO_TIMEOUT_MS);
+      const uint32_t request_start_us = time_us_32();
+      SYS_TRACE_SPAN_BEGIN(SYS_TRACE_SPAN_HTTP_REQUEST);
       const bool handed_to_worker =
           http_server_serve_connection(client_connection);
+      SYS_TRACE_SPAN_END(SYS_TRACE_SPAN_HTTP_REQUEST);
+      web_http_route_record(g_http_current_route,
+                            time_us_32() - request_start_us);
       if (!handed_to_worker) {
         netconn_delete(client_connection);
       }
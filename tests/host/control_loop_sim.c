@@ -0,0 +1,305 @@
+/*
+ * Closed-loop simulation of blower_control against a synthetic plant, run
+ * on the host with the firmware's own control sources.
+ *
+ * Plant: the fan speed follows the TRIAC power with a first-order lag, the
+ * fan pressure rises with the square of the speed (fan law) up to
+ * max_pa at 100 %, and the envelope follows it through a transport delay
+ * and a second lag. The envelope reading carries uniform noise.
+ *
+ *   control_loop_sim                  default cases, table on stdout
+ *   control_loop_sim FAN ENV DEAD [MAX_PA [TARGET [NOISE]]]
+ *                                     one plant (seconds, Pa, Pa pk-pk)
+ *   control_loop_sim --check          ctest entry: fails when a limit in
+ *                                     k_check_limits is missed or a warm
+ *                                     approach is not faster than a cold one
+ *
+ * The plant is only a model. Fit FAN/ENV/DEAD/MAX_PA from a logged step
+ * on the real rig (the predictive mode's identified K, tau and theta are
+ * a good start) before reading much into absolute settle times.
+ */
+#include "host_flash.h"
+#include "services/blower_control.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_STEP_S 0.02
+#define SIM_STEP_MS 20u
+#define SIM_DURATION_STEPS 3000
+#define SIM_WARMUP_STEPS 1500
+#define SIM_DELAY_SLOTS 256
+#define SIM_SETTLE_BAND 0.05
+#define SIM_TAIL_STEPS 500
+
+typedef struct {
+  double fan_tau_s;
+  double envelope_tau_s;
+  double dead_time_s;
+  double max_pa;
+  double noise_pa;
+  /* The PID gains suit this plant, so --check holds PID to limits too. */
+  bool pid_settles;
+} sim_plant_config_t;
+
+typedef struct {
+  sim_plant_config_t config;
+  double fan_speed;
+  double envelope_pa;
+  double delay[SIM_DELAY_SLOTS];
+  int delay_head;
+  int delay_steps;
+  uint32_t noise_state;
+} sim_plant_t;
+
+typedef struct {
+  double settle_s;
+  bool settled;
+  double overshoot_pct;
+  double tail_rms_pa;
+  blower_control_snapshot_t snapshot;
+} sim_result_t;
+
+static const sim_plant_config_t k_default_plants[] = {
+    {.fan_tau_s = 1.2, .envelope_tau_s = 0.4, .dead_time_s = 0.3,
+     .max_pa = 90.0, .noise_pa = 0.6},
+    {.fan_tau_s = 2.0, .envelope_tau_s = 1.0, .dead_time_s = 0.6,
+     .max_pa = 90.0, .noise_pa = 0.6},
+    {.fan_tau_s = 0.8, .envelope_tau_s = 0.2, .dead_time_s = 0.1,
+     .max_pa = 90.0, .noise_pa = 0.6, .pid_settles = true},
+    {.fan_tau_s = 1.5, .envelope_tau_s = 0.8, .dead_time_s = 0.4,
+     .max_pa = 60.0, .noise_pa = 0.6},
+};
+
+/*
+ * Limits for --check; the predictive mode has to settle on every plant,
+ * PID on the plants marked pid_settles. A cold PID start overshoots on the
+ * startup boost before any feedforward exists, hence its own limit.
+ */
+static const struct {
+  double max_settle_s;
+  double max_overshoot_pct;
+  double max_pid_cold_overshoot_pct;
+} k_check_limits = {
+    .max_settle_s = 30.0,
+    .max_overshoot_pct = 10.0,
+    .max_pid_cold_overshoot_pct = 75.0,
+};
+
+static double sim_noise(sim_plant_t *plant) {
+  plant->noise_state = plant->noise_state * 1103515245u + 12345u;
+  return (double)((plant->noise_state >> 8) & 0xffffu) / 65535.0 - 0.5;
+}
+
+static void sim_plant_reset(sim_plant_t *plant,
+                            const sim_plant_config_t *config) {
+  memset(plant, 0, sizeof(*plant));
+  plant->config = *config;
+  plant->delay_steps = (int)(config->dead_time_s / SIM_STEP_S + 0.5);
+  if (plant->delay_steps >= SIM_DELAY_SLOTS) {
+    plant->delay_steps = SIM_DELAY_SLOTS - 1;
+  }
+  plant->noise_state = 1u;
+}
+
+static double sim_plant_step(sim_plant_t *plant, double power_percent) {
+  const double speed = power_percent / 100.0;
+  double fan_pa = 0.0;
+  double delayed_pa = 0.0;
+
+  plant->fan_speed +=
+      (speed - plant->fan_speed) * SIM_STEP_S / plant->config.fan_tau_s;
+  fan_pa = plant->config.max_pa * plant->fan_speed * plant->fan_speed;
+  plant->delay[plant->delay_head] = fan_pa;
+  delayed_pa = plant->delay[(plant->delay_head + SIM_DELAY_SLOTS -
+                             plant->delay_steps) %
+                            SIM_DELAY_SLOTS];
+  plant->delay_head = (plant->delay_head + 1) % SIM_DELAY_SLOTS;
+  plant->envelope_pa += (delayed_pa - plant->envelope_pa) * SIM_STEP_S /
+                        plant->config.envelope_tau_s;
+  return plant->envelope_pa + plant->config.noise_pa * sim_noise(plant);
+}
+
+/*
+ * warm: run once first so the feedforward map and the identified model
+ * exist, then cycle the relay and measure the second approach.
+ */
+static sim_result_t sim_run(blower_control_mode_t mode,
+                            const sim_plant_config_t *config,
+                            double target_pa, bool warm) {
+  static double trace[SIM_DURATION_STEPS];
+  sim_plant_t plant;
+  sim_result_t result = {0};
+  double measured_pa = 0.0;
+  double peak_pa = 0.0;
+  double tail_sum = 0.0;
+  uint32_t now_ms = 1000u;
+  int index = 0;
+
+  host_flash_erase_all();
+  sim_plant_reset(&plant, config);
+  blower_control_initialize();
+  (void)blower_control_set_target_pressure_pa((float)target_pa);
+  (void)blower_control_set_mode(mode);
+  (void)blower_control_set_relay_enabled(true);
+
+  if (warm) {
+    for (index = 0; index < SIM_WARMUP_STEPS; ++index) {
+      const uint8_t power =
+          blower_control_step((float)measured_pa, true, now_ms);
+      measured_pa = sim_plant_step(&plant, power);
+      now_ms += SIM_STEP_MS;
+    }
+    (void)blower_control_set_relay_enabled(false);
+    (void)blower_control_step(0.0f, true, now_ms);
+    now_ms += SIM_STEP_MS;
+    sim_plant_reset(&plant, config);
+    measured_pa = 0.0;
+    (void)blower_control_set_relay_enabled(true);
+  }
+
+  for (index = 0; index < SIM_DURATION_STEPS; ++index) {
+    const uint8_t power = blower_control_step((float)measured_pa, true, now_ms);
+    measured_pa = sim_plant_step(&plant, power);
+    now_ms += SIM_STEP_MS;
+    trace[index] = plant.envelope_pa;
+    if (plant.envelope_pa > peak_pa) {
+      peak_pa = plant.envelope_pa;
+    }
+  }
+
+  result.settled = true;
+  result.settle_s = 0.0;
+  for (index = SIM_DURATION_STEPS - 1; index >= 0; --index) {
+    if (fabs(trace[index] - target_pa) > SIM_SETTLE_BAND * target_pa) {
+      result.settled = index < SIM_DURATION_STEPS - SIM_TAIL_STEPS;
+      result.settle_s = (double)(index + 1) * SIM_STEP_S;
+      break;
+    }
+  }
+  for (index = SIM_DURATION_STEPS - SIM_TAIL_STEPS;
+       index < SIM_DURATION_STEPS; ++index) {
+    tail_sum += (trace[index] - target_pa) * (trace[index] - target_pa);
+  }
+  result.tail_rms_pa = sqrt(tail_sum / SIM_TAIL_STEPS);
+  result.overshoot_pct = (peak_pa - target_pa) / target_pa * 100.0;
+  blower_control_get_snapshot(&result.snapshot);
+  return result;
+}
+
+static const char *sim_mode_name(blower_control_mode_t mode) {
+  return mode == BLOWER_CONTROL_MODE_PREDICTIVE_TARGET ? "smith" : "pid";
+}
+
+static void sim_print(blower_control_mode_t mode,
+                      const sim_plant_config_t *config, bool warm,
+                      const sim_result_t *result) {
+  printf("%-5s %-4s fan=%.1fs env=%.1fs dead=%.2fs max=%.0fPa: ",
+         sim_mode_name(mode), warm ? "warm" : "cold", config->fan_tau_s,
+         config->envelope_tau_s, config->dead_time_s, config->max_pa);
+  if (result->settled) {
+    printf("settle=%.2fs", result->settle_s);
+  } else {
+    printf("settle=never");
+  }
+  printf(" overshoot=%.1f%% tail_rms=%.2fPa", result->overshoot_pct,
+         result->tail_rms_pa);
+  if (result->snapshot.model_valid) {
+    printf(" model(K=%.2f tau=%.2f theta=%.2f)",
+           result->snapshot.model_gain_pa_per_percent,
+           result->snapshot.model_time_constant_s,
+           result->snapshot.model_dead_time_s);
+  }
+  printf("\n");
+}
+
+static bool sim_run_plant(const sim_plant_config_t *config, double target_pa,
+                          bool check) {
+  static const blower_control_mode_t k_modes[] = {
+      BLOWER_CONTROL_MODE_SEMI_AUTO_TARGET,
+      BLOWER_CONTROL_MODE_PREDICTIVE_TARGET,
+  };
+  bool passed = true;
+  size_t mode_index = 0u;
+  int warm = 0;
+
+  for (mode_index = 0u; mode_index < sizeof(k_modes) / sizeof(k_modes[0]);
+       ++mode_index) {
+    const bool predictive =
+        k_modes[mode_index] == BLOWER_CONTROL_MODE_PREDICTIVE_TARGET;
+    const bool checked = check && (predictive || config->pid_settles);
+    sim_result_t cold = {0};
+
+    for (warm = 0; warm <= 1; ++warm) {
+      const sim_result_t result =
+          sim_run(k_modes[mode_index], config, target_pa, warm != 0);
+      const double max_overshoot_pct =
+          predictive || warm != 0 ? k_check_limits.max_overshoot_pct
+                                  : k_check_limits.max_pid_cold_overshoot_pct;
+
+      sim_print(k_modes[mode_index], config, warm != 0, &result);
+      if (checked &&
+          (!result.settled || result.settle_s > k_check_limits.max_settle_s ||
+           result.overshoot_pct > max_overshoot_pct)) {
+        printf("  FAIL: limits are %.0fs / %.0f%%\n",
+               k_check_limits.max_settle_s, max_overshoot_pct);
+        passed = false;
+      }
+      if (warm == 0) {
+        cold = result;
+      } else if (checked && result.settle_s >= cold.settle_s) {
+        printf("  FAIL: warm start is not faster than cold (%.2fs)\n",
+               cold.settle_s);
+        passed = false;
+      }
+    }
+  }
+  return passed;
+}
+
+int main(int argc, char **argv) {
+  const double default_target_pa = 50.0;
+  const bool check = argc == 2 && strcmp(argv[1], "--check") == 0;
+  bool passed = true;
+  size_t index = 0u;
+
+  if (argc >= 4 && !check) {
+    sim_plant_config_t config = k_default_plants[0];
+
+    config.fan_tau_s = atof(argv[1]);
+    config.envelope_tau_s = atof(argv[2]);
+    config.dead_time_s = atof(argv[3]);
+    if (argc >= 5) {
+      config.max_pa = atof(argv[4]);
+    }
+    if (argc >= 7) {
+      config.noise_pa = atof(argv[6]);
+    }
+    if (config.fan_tau_s <= 0.0 || config.envelope_tau_s <= 0.0 ||
+        config.dead_time_s < 0.0 || config.max_pa <= 0.0) {
+      fprintf(stderr, "invalid plant parameters\n");
+      return 2;
+    }
+    (void)sim_run_plant(&config, argc >= 6 ? atof(argv[5]) : default_target_pa,
+                        false);
+    return 0;
+  }
+  if (argc != 1 && !check) {
+    fprintf(stderr,
+            "usage: %s [--check | FAN ENV DEAD [MAX_PA [TARGET [NOISE]]]]\n",
+            argv[0]);
+    return 2;
+  }
+
+  for (index = 0u;
+       index < sizeof(k_default_plants) / sizeof(k_default_plants[0]);
+       ++index) {
+    passed =
+        sim_run_plant(&k_default_plants[index], default_target_pa, check) &&
+        passed;
+  }
+  return passed ? 0 : 1;
+}
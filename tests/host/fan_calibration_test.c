@@ -0,0 +1,121 @@
+/*
+ * Checks the compiled sqrt(dP) lookup of blower_fan_calibration against
+ * the exact model over the whole valid span, for power laws across the
+ * accepted exponents and for a calibration table.
+ */
+#include "services/blower_fan_calibration.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define SCAN_STEPS 20000u
+
+static unsigned int g_failures;
+
+/* Largest relative LUT error over [min, max], scanned in sqrt(dP). */
+static float scan_max_error(const blower_fan_calibration_range_t *range) {
+  blower_fan_calibration_curve_t curve;
+  const float sqrt_min = sqrtf(range->min_pressure_pa);
+  const float sqrt_max = sqrtf(range->max_pressure_pa);
+  float worst = 0.0f;
+  uint32_t index = 0u;
+
+  blower_fan_calibration_compile(range, &curve);
+  if (!curve.valid) {
+    return INFINITY;
+  }
+  for (index = 0u; index <= SCAN_STEPS; ++index) {
+    const float root =
+        sqrt_min + (sqrt_max - sqrt_min) * (float)index / (float)SCAN_STEPS;
+    const float pressure =
+        fminf(fmaxf(root * root, range->min_pressure_pa),
+              range->max_pressure_pa);
+    const double exact = blower_fan_calibration_model_m3h(range, pressure);
+    bool in_range = false;
+    const double lut =
+        blower_fan_calibration_evaluate(&curve, pressure, &in_range);
+
+    if (!in_range) {
+      return INFINITY;
+    }
+    worst = fmaxf(worst, (float)fabs(lut / exact - 1.0));
+  }
+  return worst;
+}
+
+static void check_range(const char *name,
+                        const blower_fan_calibration_range_t *range,
+                        float limit) {
+  blower_fan_calibration_range_t normalized = *range;
+  float error = INFINITY;
+  bool ok = false;
+
+  if (blower_fan_calibration_range_normalize(&normalized)) {
+    error = scan_max_error(&normalized);
+  }
+  ok = error <= limit;
+  printf("%-4s %-36s max error %.4f%% (limit %.4f%%)\n", ok ? "ok" : "FAIL",
+         name, error * 100.0f, limit * 100.0f);
+  if (!ok) {
+    g_failures += 1u;
+  }
+}
+
+static void test_power_laws(void) {
+  static const float k_exponents[] = {0.45f, 0.5f, 0.6f, 0.7f,
+                                      1.0f,  1.5f, 2.0f};
+  static const float k_spans[][2] = {
+      {0.5f, 2000.0f}, {0.5f, 50.0f}, {10.0f, 500.0f}, {25.0f, 1500.0f}};
+  size_t exponent = 0u;
+  size_t span = 0u;
+
+  for (exponent = 0u; exponent < sizeof(k_exponents) / sizeof(k_exponents[0]);
+       ++exponent) {
+    for (span = 0u; span < sizeof(k_spans) / sizeof(k_spans[0]); ++span) {
+      const blower_fan_calibration_range_t range = {
+          .kind = (uint8_t)BLOWER_FAN_CALIBRATION_POWER_LAW,
+          .min_pressure_pa = k_spans[span][0],
+          .max_pressure_pa = k_spans[span][1],
+          .c = 120.0f,
+          .n = k_exponents[exponent],
+      };
+      char name[64];
+
+      snprintf(name, sizeof(name), "power law n=%.2f %.1f-%.0f Pa",
+               k_exponents[exponent], k_spans[span][0], k_spans[span][1]);
+      check_range(name, &range, BLOWER_FAN_CALIBRATION_LUT_MAX_ERROR);
+    }
+  }
+}
+
+/*
+ * A table also bends at its calibration points, which the curvature bound
+ * does not cover; a ring calibration with a gently drifting exponent
+ * still stays inside it.
+ */
+static void test_table(void) {
+  const blower_fan_calibration_range_t range = {
+      .kind = (uint8_t)BLOWER_FAN_CALIBRATION_TABLE,
+      .table_count = 5u,
+      .min_pressure_pa = 0.5f,
+      .max_pressure_pa = 2000.0f,
+      .table_pressure_pa = {5.0f, 25.0f, 100.0f, 400.0f, 1200.0f},
+      .table_flow_m3h = {280.0f, 640.0f, 1300.0f, 2620.0f, 4480.0f},
+  };
+
+  check_range("table, n 0.49-0.51 0.5-2000 Pa", &range,
+              BLOWER_FAN_CALIBRATION_LUT_MAX_ERROR);
+}
+
+int main(void) {
+  test_power_laws();
+  test_table();
+
+  if (g_failures > 0u) {
+    printf("%u check(s) failed\n", g_failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,192 @@
+/*
+ * Unit checks for blower_feedforward_map: bin insertion and merging,
+ * folding a new observation into the nearest bin once the table is full,
+ * interpolation and extrapolation from the nearest bins, and the flash
+ * round trip through the host flash image.
+ */
+#include "app/app_config.h"
+#include "hardware/regs/addressmap.h"
+#include "host_flash.h"
+#include "services/blower_feedforward_map.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define PRESS BLOWER_FEEDFORWARD_DIRECTION_PRESSURIZATION
+#define DEPRESS BLOWER_FEEDFORWARD_DIRECTION_DEPRESSURIZATION
+#define EXTRAPOLATE_PA APP_CONTROL_FEEDFORWARD_MAP_EXTRAPOLATE_PA
+#define MIN_CHANGE APP_CONTROL_FEEDFORWARD_MAP_MIN_CHANGE_PERCENT
+
+static unsigned int g_failures;
+
+static void check_near(const char *name, float actual, float expected,
+                       float tolerance) {
+  const bool ok = fabsf(actual - expected) <= tolerance;
+
+  printf("%-4s %-46s %9.4f (expected %.4f +/- %.4f)\n", ok ? "ok" : "FAIL",
+         name, actual, expected, tolerance);
+  if (!ok) {
+    g_failures += 1u;
+  }
+}
+
+static void check_true(const char *name, bool condition) {
+  printf("%-4s %s\n", condition ? "ok" : "FAIL", name);
+  if (!condition) {
+    g_failures += 1u;
+  }
+}
+
+static float lookup(const blower_feedforward_map_t *map,
+                    blower_feedforward_direction_t direction,
+                    float target_pa) {
+  float pwm = NAN;
+
+  return blower_feedforward_map_lookup(map, direction, target_pa, &pwm)
+             ? pwm
+             : NAN;
+}
+
+static bool is_sorted(const blower_feedforward_map_t *map,
+                      blower_feedforward_direction_t direction) {
+  uint8_t index = 0u;
+
+  for (index = 1u; index < map->entry_count[direction]; ++index) {
+    if (map->entries[direction][index].target_pressure_pa <
+        map->entries[direction][index - 1u].target_pressure_pa) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void test_single_bin(void) {
+  blower_feedforward_map_t map;
+  float pwm = 0.0f;
+
+  blower_feedforward_map_reset(&map);
+  check_true("empty: no estimate",
+             !blower_feedforward_map_lookup(&map, PRESS, 50.0f, &pwm));
+  check_true("record: first bin is new",
+             blower_feedforward_map_record(&map, PRESS, 50.0f, 60.0f));
+  check_near("single bin: at its target", lookup(&map, PRESS, 50.0f), 60.0f,
+             1.0e-4f);
+  check_near("single bin: within the extrapolation span",
+             lookup(&map, PRESS, 50.0f + EXTRAPOLATE_PA), 60.0f, 1.0e-4f);
+  check_true("single bin: no slope, no estimate further out",
+             isnan(lookup(&map, PRESS, 50.5f + EXTRAPOLATE_PA)));
+  check_true("directions are separate", isnan(lookup(&map, DEPRESS, 50.0f)));
+}
+
+static void test_merge(void) {
+  blower_feedforward_map_t map;
+  const float near_pa = 50.0f + 0.9f * APP_CONTROL_FEEDFORWARD_MAP_MERGE_PA;
+  const float first_pwm = 60.0f;
+  const float merged_pwm =
+      first_pwm + APP_CONTROL_FEEDFORWARD_MAP_ALPHA * (70.0f - first_pwm);
+
+  blower_feedforward_map_reset(&map);
+  (void)blower_feedforward_map_record(&map, PRESS, 50.0f, first_pwm);
+  check_true("merge: large change is worth persisting",
+             blower_feedforward_map_record(&map, PRESS, near_pa, 70.0f));
+  check_true("merge: no new bin", map.entry_count[PRESS] == 1u);
+  check_near("merge: bin keeps its target",
+             map.entries[PRESS][0].target_pressure_pa, 50.0f, 1.0e-4f);
+  check_near("merge: output moves by alpha", map.entries[PRESS][0].pwm_percent,
+             merged_pwm, 1.0e-4f);
+  check_true("merge: change below the minimum is not persisted",
+             !blower_feedforward_map_record(&map, PRESS, 50.0f,
+                                            merged_pwm + 0.5f * MIN_CHANGE));
+  check_true("merge: out-of-range output is clamped",
+             blower_feedforward_map_record(&map, PRESS, 50.0f, 250.0f) &&
+                 map.entries[PRESS][0].pwm_percent <= 100.0f);
+  check_true("record: rejects a non-positive target",
+             !blower_feedforward_map_record(&map, PRESS, 0.0f, 10.0f));
+}
+
+static void test_interpolation(void) {
+  blower_feedforward_map_t map;
+
+  blower_feedforward_map_reset(&map);
+  (void)blower_feedforward_map_record(&map, PRESS, 50.0f, 60.0f);
+  (void)blower_feedforward_map_record(&map, PRESS, 20.0f, 30.0f);
+  (void)blower_feedforward_map_record(&map, PRESS, 80.0f, 75.0f);
+  check_true("insert: three bins", map.entry_count[PRESS] == 3u);
+  check_true("insert: kept sorted by target", is_sorted(&map, PRESS));
+  check_near("lookup: between bins", lookup(&map, PRESS, 35.0f), 45.0f,
+             1.0e-4f);
+  check_near("lookup: upper segment", lookup(&map, PRESS, 65.0f), 67.5f,
+             1.0e-4f);
+  check_near("extrapolate: below from the two lowest bins",
+             lookup(&map, PRESS, 10.0f), 20.0f, 1.0e-4f);
+  check_near("extrapolate: above from the two highest bins",
+             lookup(&map, PRESS, 100.0f), 85.0f, 1.0e-4f);
+  check_near("extrapolate: clamped to 100 %", lookup(&map, PRESS, 400.0f),
+             100.0f, 1.0e-4f);
+}
+
+static void test_full_table(void) {
+  blower_feedforward_map_t map;
+  const float fold_pa = 25.0f;
+  uint8_t index = 0u;
+
+  blower_feedforward_map_reset(&map);
+  for (index = 0u; index < BLOWER_FEEDFORWARD_MAP_CAPACITY; ++index) {
+    (void)blower_feedforward_map_record(&map, PRESS, 10.0f * (index + 1u),
+                                        5.0f * (index + 1u));
+  }
+  check_true("full: capacity reached",
+             map.entry_count[PRESS] == BLOWER_FEEDFORWARD_MAP_CAPACITY);
+
+  /* 25 Pa is beyond the merge distance of both 20 and 30 Pa. */
+  check_true("full: folding an old sample is persisted",
+             blower_feedforward_map_record(&map, PRESS, fold_pa, 40.0f));
+  check_true("full: no bin added",
+             map.entry_count[PRESS] == BLOWER_FEEDFORWARD_MAP_CAPACITY);
+  check_near("full: nearest bin moves halfway to the sample",
+             map.entries[PRESS][1].target_pressure_pa, 22.5f, 1.0e-4f);
+  check_near("full: nearest bin output moves by alpha",
+             map.entries[PRESS][1].pwm_percent,
+             10.0f + APP_CONTROL_FEEDFORWARD_MAP_ALPHA * (40.0f - 10.0f),
+             1.0e-4f);
+  check_true("full: still sorted", is_sorted(&map, PRESS));
+}
+
+static void test_storage(void) {
+  blower_feedforward_map_t map;
+  blower_feedforward_map_t loaded;
+
+  host_flash_erase_all();
+  blower_feedforward_map_reset(&map);
+  check_true("load: erased flash holds no map",
+             !blower_feedforward_map_load(&loaded));
+  (void)blower_feedforward_map_record(&map, PRESS, 50.0f, 60.0f);
+  (void)blower_feedforward_map_record(&map, DEPRESS, 30.0f, 40.0f);
+  check_true("store", blower_feedforward_map_store(&map));
+  check_true("load: round trip", blower_feedforward_map_load(&loaded));
+  check_near("load: pressurization bin", lookup(&loaded, PRESS, 50.0f), 60.0f,
+             0.0f);
+  check_near("load: depressurization bin", lookup(&loaded, DEPRESS, 30.0f),
+             40.0f, 0.0f);
+
+  /* One flipped bit in the stored map must fail the CRC. */
+  g_host_flash[APP_CONTROL_FEEDFORWARD_STORAGE_OFFSET_BYTES + 16u] ^= 0x01u;
+  check_true("load: corrupt record rejected",
+             !blower_feedforward_map_load(&loaded));
+}
+
+int main(void) {
+  test_single_bin();
+  test_merge();
+  test_interpolation();
+  test_full_table();
+  test_storage();
+
+  if (g_failures > 0u) {
+    printf("%u check(s) failed\n", g_failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
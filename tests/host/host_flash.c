@@ -0,0 +1,29 @@
+#include "hardware/flash.h"
+#include "hardware/regs/addressmap.h"
+#include "hardware/sync.h"
+#include <string.h>
+
+/* Flash as the firmware sees it through XIP: erased bytes read 0xff. */
+uint8_t g_host_flash[PICO_FLASH_SIZE_BYTES];
+
+void host_flash_erase_all(void) {
+  memset(g_host_flash, 0xff, sizeof(g_host_flash));
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+  memset(&g_host_flash[flash_offs], 0xff, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data,
+                         size_t count) {
+  size_t index = 0u;
+
+  /* Programming can only clear bits, as on the real part. */
+  for (index = 0u; index < count; ++index) {
+    g_host_flash[flash_offs + index] &= data[index];
+  }
+}
+
+uint32_t save_and_disable_interrupts(void) { return 0u; }
+
+void restore_interrupts(uint32_t status) { (void)status; }
@@ -0,0 +1,7 @@
+#ifndef HOST_FLASH_H
+#define HOST_FLASH_H
+
+/* Resets the simulated flash to the erased state. */
+void host_flash_erase_all(void);
+
+#endif
@@ -0,0 +1,175 @@
+/*
+ * Reference checks for blower_leakage_fit against Anscombe's quartet
+ * (F. J. Anscombe, "Graphs in Statistical Analysis", The American
+ * Statistician 27(1), 1973). The fit works on ln dP and ln Q, so each
+ * published (x, y) pair is fed in as dP = e^x, Q = e^y and the fitted n
+ * and ln C compare directly with the published slope and intercept.
+ *
+ *   Set I, OLS:   y = 3.00 + 0.500 x, r = 0.816, SE(slope) = 0.118
+ *   Set III:      ten points lie on y = 4.0056 + 0.34539 x; one outlier
+ *                 at x = 13. Huber and Theil-Sen must recover that line.
+ *
+ * There is no published dataset with ln-space inverse-variance weights,
+ * so WLS is checked by identity against the OLS reference: equal standard
+ * errors must reproduce set I, and a weight of two must match OLS with
+ * the point entered twice.
+ */
+#include "services/blower_leakage_fit.h"
+#include "services/blower_running_stats.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define ANSCOMBE_POINTS 11u
+
+static const float k_anscombe_x[ANSCOMBE_POINTS] = {
+    10.0f, 8.0f, 13.0f, 9.0f, 11.0f, 14.0f, 6.0f, 4.0f, 12.0f, 7.0f, 5.0f};
+static const float k_anscombe_y1[ANSCOMBE_POINTS] = {
+    8.04f, 6.95f, 7.58f, 8.81f, 8.33f, 9.96f,
+    7.24f, 4.26f, 10.84f, 4.82f, 5.68f};
+static const float k_anscombe_y3[ANSCOMBE_POINTS] = {
+    7.46f, 6.77f, 12.74f, 7.11f, 7.81f, 8.84f,
+    6.08f, 5.39f, 8.15f, 6.42f, 5.73f};
+
+static blower_leakage_fit_workspace_t g_workspace;
+static unsigned int g_failures;
+
+static void check_near(const char *name, float actual, float expected,
+                       float tolerance) {
+  const bool ok = fabsf(actual - expected) <= tolerance;
+
+  printf("%-4s %-34s %10.5f (expected %.5f +/- %.5f)\n", ok ? "ok" : "FAIL",
+         name, actual, expected, tolerance);
+  if (!ok) {
+    g_failures += 1u;
+  }
+}
+
+static void check_true(const char *name, bool condition) {
+  printf("%-4s %s\n", condition ? "ok" : "FAIL", name);
+  if (!condition) {
+    g_failures += 1u;
+  }
+}
+
+static uint8_t load_points(const float *y, blower_leakage_fit_point_t *points,
+                           float rel_std_error) {
+  uint8_t index = 0u;
+
+  for (index = 0u; index < ANSCOMBE_POINTS; ++index) {
+    const float flow = expf(y[index]);
+    points[index] = (blower_leakage_fit_point_t){
+        .pressure_pa = expf(k_anscombe_x[index]),
+        .flow_m3h = flow,
+        .flow_std_error_m3h = rel_std_error * flow,
+    };
+  }
+  return (uint8_t)ANSCOMBE_POINTS;
+}
+
+static bool fit(const blower_leakage_fit_point_t *points, uint8_t count,
+                blower_leakage_fit_method_t method,
+                blower_leakage_fit_result_t *out_result) {
+  return blower_leakage_fit(points, count, method, &g_workspace, out_result);
+}
+
+static void test_ols_anscombe_i(void) {
+  blower_leakage_fit_point_t points[ANSCOMBE_POINTS];
+  blower_leakage_fit_result_t result = {0};
+  const uint8_t count = load_points(k_anscombe_y1, points, 0.0f);
+
+  check_true("ols: set I fit", fit(points, count, BLOWER_LEAKAGE_FIT_OLS,
+                                   &result));
+  check_near("ols: slope", result.n, 0.50009f, 1.0e-4f);
+  check_near("ols: intercept", logf(result.c), 3.00009f, 1.0e-3f);
+  check_near("ols: r", result.correlation_r, 0.81642f, 1.0e-4f);
+  check_near("ols: n_ci95 = t(9) * SE(slope)", result.n_ci95,
+             blower_running_stats_t95(9u) * 0.117906f, 1.0e-4f);
+}
+
+static void test_wls_anscombe_i(void) {
+  blower_leakage_fit_point_t points[ANSCOMBE_POINTS + 1u];
+  blower_leakage_fit_result_t wls = {0};
+  blower_leakage_fit_result_t ols = {0};
+  uint8_t count = load_points(k_anscombe_y1, points, 0.05f);
+  uint8_t index = 0u;
+
+  check_true("wls: equal errors fit",
+             fit(points, count, BLOWER_LEAKAGE_FIT_WLS, &wls));
+  check_near("wls: equal errors slope", wls.n, 0.50009f, 1.0e-4f);
+  check_near("wls: equal errors intercept", logf(wls.c), 3.00009f, 1.0e-3f);
+
+  /* Variance halved on the first point: weight two, same as a duplicate. */
+  points[0].flow_std_error_m3h = 0.05f / sqrtf(2.0f) * points[0].flow_m3h;
+  check_true("wls: weighted fit",
+             fit(points, count, BLOWER_LEAKAGE_FIT_WLS, &wls));
+  for (index = 0u; index < count; ++index) {
+    points[index].flow_std_error_m3h = 0.0f;
+  }
+  points[count] = points[0];
+  count += 1u;
+  check_true("wls: duplicated ols fit",
+             fit(points, count, BLOWER_LEAKAGE_FIT_OLS, &ols));
+  check_near("wls: weight 2 slope = duplicate", wls.n, ols.n, 1.0e-4f);
+  check_near("wls: weight 2 intercept = duplicate", logf(wls.c),
+             logf(ols.c), 1.0e-3f);
+}
+
+static void test_robust_anscombe_iii(blower_leakage_fit_method_t method) {
+  blower_leakage_fit_point_t points[ANSCOMBE_POINTS];
+  blower_leakage_fit_result_t result = {0};
+  const uint8_t count = load_points(k_anscombe_y3, points, 0.0f);
+  const char *name = blower_leakage_fit_method_name(method);
+  char label[48];
+  double sse = 0.0;
+  double syy = 0.0;
+  double y_mean = 0.0;
+  uint8_t index = 0u;
+
+  snprintf(label, sizeof(label), "%s: set III fit", name);
+  check_true(label, fit(points, count, method, &result));
+  snprintf(label, sizeof(label), "%s: slope", name);
+  check_near(label, result.n, 0.34539f, 2.0e-3f);
+  snprintf(label, sizeof(label), "%s: intercept", name);
+  check_near(label, logf(result.c), 4.00565f, 2.0e-2f);
+  if (method == BLOWER_LEAKAGE_FIT_HUBER) {
+    snprintf(label, sizeof(label), "%s: outlier downweighted", name);
+    check_true(label, result.downweighted_count >= 1u);
+    return;
+  }
+
+  snprintf(label, sizeof(label), "%s: n interval holds the line", name);
+  check_true(label, result.n_ci95 > 0.0f &&
+                        fabsf(result.n - 0.34539f) <= result.n_ci95);
+
+  /* r from the method's own residuals, not the OLS value 0.8163. */
+  for (index = 0u; index < count; ++index) {
+    y_mean += k_anscombe_y3[index];
+  }
+  y_mean /= (double)count;
+  for (index = 0u; index < count; ++index) {
+    const double predicted =
+        logf(result.c) + result.n * k_anscombe_x[index];
+    const double residual = k_anscombe_y3[index] - predicted;
+    sse += residual * residual;
+    syy += (k_anscombe_y3[index] - y_mean) * (k_anscombe_y3[index] - y_mean);
+  }
+  snprintf(label, sizeof(label), "%s: r from own residuals", name);
+  check_near(label, result.correlation_r, (float)sqrt(1.0 - sse / syy),
+             1.0e-3f);
+}
+
+int main(void) {
+  test_ols_anscombe_i();
+  test_wls_anscombe_i();
+  test_robust_anscombe_iii(BLOWER_LEAKAGE_FIT_HUBER);
+  test_robust_anscombe_iii(BLOWER_LEAKAGE_FIT_THEIL_SEN);
+
+  if (g_failures > 0u) {
+    printf("%u check(s) failed\n", g_failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
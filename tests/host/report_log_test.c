@@ -0,0 +1,218 @@
+/*
+ * Checks blower_report_log on the host flash image: reports survive a
+ * reboot and the index is rebuilt from flash, the log wraps by erasing
+ * the oldest sector ahead of the head, and a torn or corrupted final
+ * record is dropped at boot and never programmed over without an erase.
+ *
+ * The module is included directly so a reboot can drop its RAM state
+ * (the index and the mutex) the way a reset does.
+ */
+#include "../../src/services/blower_report_log.c"
+
+#include "host_flash.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define SLOT_COUNT BLOWER_REPORT_LOG_SLOT_COUNT
+#define SLOTS_PER_SECTOR BLOWER_REPORT_LOG_SLOTS_PER_SECTOR
+
+static unsigned int g_failures;
+
+static void check_true(const char *name, bool condition) {
+  printf("%-4s %s\n", condition ? "ok" : "FAIL", name);
+  if (!condition) {
+    g_failures += 1u;
+  }
+}
+
+static void check_u32(const char *name, uint32_t actual, uint32_t expected) {
+  const bool ok = actual == expected;
+
+  printf("%-4s %-44s %8u (expected %u)\n", ok ? "ok" : "FAIL", name,
+         (unsigned int)actual, (unsigned int)expected);
+  if (!ok) {
+    g_failures += 1u;
+  }
+}
+
+static void reboot(void) {
+  memset(&g_log, 0, sizeof(g_log));
+  blower_report_log_init();
+}
+
+static blower_test_report_t make_report(uint32_t report_id) {
+  blower_test_report_t report;
+
+  memset(&report, 0, sizeof(report));
+  report.report_id = report_id;
+  report.completed_tick_ms = report_id * 1000u + 7u;
+  report.reference_pressure_pa = 50u;
+  report.has_pressurization = (report_id & 1u) != 0u;
+  report.baseline.bias_pa = 0.25f * (float)report_id;
+  return report;
+}
+
+static void drain(void) {
+  while (blower_report_log_persist_step()) {
+  }
+}
+
+static bool append_and_persist(uint32_t report_id) {
+  const blower_test_report_t report = make_report(report_id);
+
+  if (!blower_report_log_append(&report)) {
+    return false;
+  }
+  drain();
+  return true;
+}
+
+static bool is_readable(uint32_t report_id) {
+  blower_test_report_t report;
+
+  return blower_report_log_read(report_id, &report);
+}
+
+static bool read_matches(uint32_t report_id) {
+  const blower_test_report_t expected = make_report(report_id);
+  blower_test_report_t report;
+
+  return blower_report_log_read(report_id, &report) &&
+         memcmp(&report, &expected, sizeof(report)) == 0;
+}
+
+static void test_reboot_rebuilds_index(void) {
+  uint32_t ids[4] = {0};
+  const blower_test_report_t queued = make_report(3u);
+
+  host_flash_erase_all();
+  reboot();
+  check_true("empty: available", blower_report_log_is_available());
+  check_u32("empty: count", blower_report_log_count(), 0u);
+  check_u32("empty: newest id", blower_report_log_newest_id(), 0u);
+
+  check_true("append 1", append_and_persist(1u));
+  check_true("append 2", append_and_persist(2u));
+  check_true("append 3 (left queued)", blower_report_log_append(&queued));
+  check_u32("queued report counted", blower_report_log_count(), 3u);
+  check_true("queued report readable", read_matches(3u));
+  drain();
+
+  reboot();
+  check_u32("reboot: count", blower_report_log_count(), 3u);
+  check_u32("reboot: newest id", blower_report_log_newest_id(), 3u);
+  check_u32("reboot: list size", (uint32_t)blower_report_log_list(0u, ids, 4u),
+            3u);
+  check_true("reboot: listed newest first",
+             ids[0] == 3u && ids[1] == 2u && ids[2] == 1u);
+  check_u32("reboot: list before id 3",
+            (uint32_t)blower_report_log_list(3u, ids, 4u), 2u);
+  check_true("reboot: reports read back",
+             read_matches(1u) && read_matches(2u) && read_matches(3u));
+
+  check_true("append after reboot", append_and_persist(4u));
+  reboot();
+  check_u32("appended after reboot: newest id", blower_report_log_newest_id(),
+            4u);
+  check_true("appended after reboot: reads back", read_matches(4u));
+}
+
+static void test_wrap_erases_oldest_sector(void) {
+  const uint32_t capacity = blower_report_log_capacity();
+  const uint32_t total = SLOT_COUNT + 2u * SLOTS_PER_SECTOR;
+  const uint32_t oldest_kept = total - capacity + 1u;
+  uint32_t report_id = 0u;
+  uint32_t newest = 0u;
+  bool appended = true;
+
+  host_flash_erase_all();
+  reboot();
+  check_u32("capacity keeps one sector erased", capacity,
+            SLOT_COUNT - SLOTS_PER_SECTOR);
+  for (report_id = 1u; report_id <= total; ++report_id) {
+    appended = append_and_persist(report_id) && appended;
+  }
+  check_true("wrap: every append accepted", appended);
+  check_u32("wrap: count held at capacity", blower_report_log_count(),
+            capacity);
+  check_true("wrap: sector ahead of the head erased",
+             blower_report_log_sector_is_erased(g_log.head_slot /
+                                                SLOTS_PER_SECTOR));
+  check_true("wrap: oldest reports collected",
+             !is_readable(oldest_kept - 1u));
+  check_true("wrap: oldest kept report reads back", read_matches(oldest_kept));
+
+  reboot();
+  check_u32("wrap reboot: count", blower_report_log_count(), capacity);
+  check_u32("wrap reboot: newest id", blower_report_log_newest_id(), total);
+  check_true("wrap reboot: newest and oldest read back",
+             read_matches(total) && read_matches(oldest_kept));
+  (void)blower_report_log_list(0u, &newest, 1u);
+  check_u32("wrap reboot: list starts at the newest", newest, total);
+
+  check_true("wrap reboot: append continues", append_and_persist(total + 1u));
+  check_u32("wrap reboot: count still at capacity", blower_report_log_count(),
+            capacity);
+  check_true("wrap reboot: next oldest collected",
+             !is_readable(oldest_kept));
+}
+
+static void test_torn_final_record(void) {
+  const blower_test_report_t torn = make_report(3u);
+  uint32_t torn_slot = 0u;
+  uint32_t page = 0u;
+
+  host_flash_erase_all();
+  reboot();
+  check_true("torn: append 1", append_and_persist(1u));
+  check_true("torn: append 2", append_and_persist(2u));
+
+  /* Reset after the first pages of record 3 reached flash. */
+  torn_slot = g_log.head_slot;
+  check_true("torn: append 3", blower_report_log_append(&torn));
+  for (page = 0u; page < BLOWER_REPORT_LOG_PAGES_PER_SLOT / 2u; ++page) {
+    (void)blower_report_log_persist_step();
+  }
+  reboot();
+  check_u32("torn: truncated record dropped", blower_report_log_count(), 2u);
+  check_u32("torn: newest id", blower_report_log_newest_id(), 2u);
+  check_true("torn: sector erased first or skipped",
+             g_log.head_sector_needs_erase ||
+                 g_log.head_slot / SLOTS_PER_SECTOR !=
+                     torn_slot / SLOTS_PER_SECTOR);
+
+  check_true("torn: append 3 again", append_and_persist(3u));
+  reboot();
+  check_u32("torn: count after rewrite", blower_report_log_count(), 3u);
+  check_true("torn: rewritten record reads back", read_matches(3u));
+
+  /* A fully written final record with one cleared payload bit. */
+  torn_slot = g_log.head_slot;
+  check_true("bad crc: append 4", append_and_persist(4u));
+  g_host_flash[blower_report_log_slot_offset(torn_slot) +
+               sizeof(blower_report_log_header_t) + 4u] &= 0xfeu;
+  reboot();
+  check_u32("bad crc: record rejected", blower_report_log_count(), 3u);
+  check_u32("bad crc: newest id", blower_report_log_newest_id(), 3u);
+  check_true("bad crc: not readable", !is_readable(4u));
+
+  check_true("bad crc: append 5", append_and_persist(5u));
+  reboot();
+  check_u32("bad crc: count after append", blower_report_log_count(), 4u);
+  check_true("bad crc: record 5 reads back", read_matches(5u));
+  check_true("bad crc: record 4 stays gone", !is_readable(4u));
+}
+
+int main(void) {
+  test_reboot_rebuilds_index();
+  test_wrap_erases_oldest_sector();
+  test_torn_final_record();
+
+  if (g_failures > 0u) {
+    printf("%u check(s) failed\n", g_failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
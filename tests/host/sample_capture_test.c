@@ -0,0 +1,213 @@
+/*
+ * Round trip of the blower_sample_capture page codec: samples pushed
+ * through the delta/zigzag varint encoder are read back exactly, staged
+ * and again after they moved to the host flash image. The signal mixes
+ * small steps, sign flips, clamped full-scale jumps and a tick wrap, and
+ * is long enough to split across many pages; only every
+ * APP_TEST_SAMPLE_CAPTURE_DECIMATION-th push of a window is kept.
+ *
+ * Inputs are multiples of 0.25 (0.5 for power), so the fixed-point value
+ * each one stores is known exactly.
+ */
+#include "app/app_config.h"
+#include "host_flash.h"
+#include "services/blower_sample_capture.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_SAMPLES 1024u
+#define WINDOW_PUSHES 1500u
+#define OTHER_PUSHES 50u
+#define VALUE_LIMIT 0x3fffffff
+
+typedef struct {
+  blower_sample_capture_sample_t samples[MAX_SAMPLES];
+  uint32_t count;
+} sample_list_t;
+
+static sample_list_t g_expected;
+static sample_list_t g_decoded;
+static uint32_t g_random_state = 12345u;
+static unsigned int g_failures;
+
+static void check_true(const char *name, bool condition) {
+  printf("%-4s %s\n", condition ? "ok" : "FAIL", name);
+  if (!condition) {
+    g_failures += 1u;
+  }
+}
+
+static void check_u32(const char *name, uint32_t actual, uint32_t expected) {
+  const bool ok = actual == expected;
+
+  printf("%-4s %-40s %8u (expected %u)\n", ok ? "ok" : "FAIL", name,
+         (unsigned int)actual, (unsigned int)expected);
+  if (!ok) {
+    g_failures += 1u;
+  }
+}
+
+static int32_t random_range(int32_t magnitude) {
+  g_random_state = g_random_state * 1103515245u + 12345u;
+  return (int32_t)((g_random_state >> 4) % (2u * (uint32_t)magnitude + 1u)) -
+         magnitude;
+}
+
+/* Quarter-unit steps; a full-scale value stands for a clamped input. */
+static float quarter_input(int32_t quarters, int32_t *out_fixed) {
+  if (quarters == INT32_MAX || quarters == -INT32_MAX) {
+    *out_fixed = quarters > 0 ? VALUE_LIMIT : -VALUE_LIMIT;
+    return quarters > 0 ? 1.0e9f : -1.0e9f;
+  }
+  *out_fixed = quarters * 25;
+  return (float)quarters * 0.25f;
+}
+
+/*
+ * Sample k of a window: small noise, sign flips every other sample, a
+ * large step every 7th, full-scale swings every 23rd.
+ */
+static int32_t signal_quarters(uint32_t k, uint32_t field) {
+  if (k % 23u == 11u) {
+    return (k + field) % 2u == 0u ? INT32_MAX : -INT32_MAX;
+  }
+  if (k % 7u == 3u) {
+    return random_range(300000);
+  }
+  if (field == 1u) {
+    return (k % 2u == 0u ? 1 : -1) * (400 + random_range(40));
+  }
+  return 200 + random_range(8);
+}
+
+static void push_window(uint32_t report_id, uint8_t direction,
+                        uint8_t point_index, uint32_t first_tick_ms,
+                        uint32_t pushes) {
+  uint32_t push = 0u;
+  uint32_t tick_ms = first_tick_ms;
+
+  blower_sample_capture_begin_window(report_id, direction, point_index);
+  for (push = 0u; push < pushes; ++push) {
+    const uint32_t k = push / APP_TEST_SAMPLE_CAPTURE_DECIMATION;
+    blower_sample_capture_sample_t expected = {
+        .report_id = report_id,
+        .tick_ms = tick_ms,
+        .direction = direction,
+        .point_index = point_index,
+    };
+    float inputs[5];
+    int32_t fixed[5];
+    uint32_t field = 0u;
+
+    for (field = 0u; field < 4u; ++field) {
+      inputs[field] = quarter_input(signal_quarters(k, field), &fixed[field]);
+    }
+    /* Power is stored in permille: half-percent steps, 5 per step. */
+    fixed[4] = (int32_t)(k % 201u) * 5;
+    inputs[4] = (float)(k % 201u) * 0.5f;
+
+    blower_sample_capture_push(tick_ms, inputs[0], inputs[1], inputs[2],
+                               inputs[3], inputs[4]);
+    if (push % APP_TEST_SAMPLE_CAPTURE_DECIMATION == 0u &&
+        g_expected.count < MAX_SAMPLES) {
+      expected.envelope_pressure_cpa = fixed[0];
+      expected.fan_pressure_cpa = fixed[1];
+      expected.fan_temperature_cc = fixed[2];
+      expected.envelope_temperature_cc = fixed[3];
+      expected.power_permille = fixed[4];
+      g_expected.samples[g_expected.count++] = expected;
+    }
+    /* Mostly 20 ms apart, with the odd long gap. */
+    tick_ms += push % 97u == 50u ? 3600000u : 20u;
+  }
+  blower_sample_capture_end_window();
+}
+
+static bool collect(const blower_sample_capture_sample_t *sample,
+                    void *context) {
+  sample_list_t *list = context;
+
+  if (list->count >= MAX_SAMPLES) {
+    return false;
+  }
+  list->samples[list->count++] = *sample;
+  return true;
+}
+
+static bool sample_equal(const blower_sample_capture_sample_t *a,
+                         const blower_sample_capture_sample_t *b) {
+  return a->report_id == b->report_id && a->tick_ms == b->tick_ms &&
+         a->direction == b->direction && a->point_index == b->point_index &&
+         a->envelope_pressure_cpa == b->envelope_pressure_cpa &&
+         a->fan_pressure_cpa == b->fan_pressure_cpa &&
+         a->fan_temperature_cc == b->fan_temperature_cc &&
+         a->envelope_temperature_cc == b->envelope_temperature_cc &&
+         a->power_permille == b->power_permille;
+}
+
+static void check_round_trip(const char *stage, uint32_t report_id) {
+  char name[64];
+  uint32_t index = 0u;
+  uint32_t mismatches = 0u;
+  uint32_t visited = 0u;
+
+  memset(&g_decoded, 0, sizeof(g_decoded));
+  visited = blower_sample_capture_for_each(report_id, collect, &g_decoded);
+  snprintf(name, sizeof(name), "%s: samples visited", stage);
+  check_u32(name, visited, g_expected.count);
+  for (index = 0u; index < g_expected.count && index < g_decoded.count;
+       ++index) {
+    if (!sample_equal(&g_expected.samples[index], &g_decoded.samples[index])) {
+      if (mismatches == 0u) {
+        printf("     first mismatch at sample %u\n", (unsigned int)index);
+      }
+      mismatches += 1u;
+    }
+  }
+  snprintf(name, sizeof(name), "%s: mismatched samples", stage);
+  check_u32(name, mismatches, 0u);
+}
+
+int main(void) {
+  blower_sample_capture_stats_t stats;
+  const uint32_t report_id = 7u;
+
+  host_flash_erase_all();
+  blower_sample_capture_init();
+
+  /* Another report's window is written first and must not leak in. */
+  push_window(report_id - 1u, 1u, 0u, 1000u, OTHER_PUSHES);
+  g_expected.count = 0u;
+
+  push_window(report_id, 1u, 0u, 5000u, WINDOW_PUSHES);
+  /* Wraps the 32-bit tick inside the window. */
+  push_window(report_id, 2u, 3u, 0xffffff00u, WINDOW_PUSHES);
+
+  blower_sample_capture_get_stats(&stats);
+  check_u32("decimated samples captured",
+            stats.captured_samples -
+                OTHER_PUSHES / APP_TEST_SAMPLE_CAPTURE_DECIMATION,
+            g_expected.count);
+  check_u32("no sample dropped", stats.dropped_samples, 0u);
+  check_true("windows split across many pages", stats.staged_pages > 8u);
+  check_true("report is known", blower_sample_capture_has_report(report_id));
+  check_round_trip("staged", report_id);
+
+  while (blower_sample_capture_persist_step()) {
+  }
+  blower_sample_capture_get_stats(&stats);
+  check_u32("all pages moved to flash", stats.staged_pages, 0u);
+  check_round_trip("flash", report_id);
+  check_true("unknown report has no samples",
+             blower_sample_capture_for_each(report_id + 1u, collect,
+                                            &g_decoded) == 0u);
+
+  if (g_failures > 0u) {
+    printf("%u check(s) failed\n", g_failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,15 @@
+#ifndef HOST_STUB_HARDWARE_FLASH_H
+#define HOST_STUB_HARDWARE_FLASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FLASH_SECTOR_SIZE 4096u
+#define FLASH_PAGE_SIZE 256u
+#define PICO_FLASH_SIZE_BYTES (4u * 1024u * 1024u)
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data,
+                         size_t count);
+
+#endif
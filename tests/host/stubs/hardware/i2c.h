@@ -0,0 +1,11 @@
+#ifndef HOST_STUB_HARDWARE_I2C_H
+#define HOST_STUB_HARDWARE_I2C_H
+
+/*
+ * Only the types app/hardware_map.h and the adp910 sensor config name;
+ * nothing on the host talks I2C. uint comes from pico/types.h on target.
+ */
+typedef unsigned int uint;
+typedef struct i2c_inst i2c_inst_t;
+
+#endif
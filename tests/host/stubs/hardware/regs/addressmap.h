@@ -0,0 +1,10 @@
+#ifndef HOST_STUB_HARDWARE_REGS_ADDRESSMAP_H
+#define HOST_STUB_HARDWARE_REGS_ADDRESSMAP_H
+
+#include <stdint.h>
+
+/* The XIP window maps onto the RAM image in host_flash.c. */
+extern uint8_t g_host_flash[];
+#define XIP_BASE ((uintptr_t)g_host_flash)
+
+#endif
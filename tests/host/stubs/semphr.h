@@ -0,0 +1,41 @@
+#ifndef HOST_STUB_SEMPHR_H
+#define HOST_STUB_SEMPHR_H
+
+#include "FreeRTOS.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/*
+ * Host tests are single-threaded: a mutex only tracks whether it is held,
+ * so a take that would block on the target fails here instead.
+ */
+typedef struct {
+  bool held;
+} host_semaphore_t;
+
+typedef host_semaphore_t *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+  return calloc(1u, sizeof(host_semaphore_t));
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore,
+                                        TickType_t ticks_to_wait) {
+  (void)ticks_to_wait;
+  if (semaphore == NULL || semaphore->held) {
+    return pdFALSE;
+  }
+  semaphore->held = true;
+  return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  if (semaphore == NULL || !semaphore->held) {
+    return pdFALSE;
+  }
+  semaphore->held = false;
+  return pdTRUE;
+}
+
+#endif